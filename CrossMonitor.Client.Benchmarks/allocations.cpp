@@ -0,0 +1,66 @@
+#include "allocations.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+static atomic<unsigned long long> allocated{ 0 };
+
+static void* allocate(size_t size) noexcept {
+	allocated.fetch_add(1, memory_order_relaxed);
+	return malloc(size != 0 ? size : 1);
+}
+
+void* operator new(size_t size) {
+	void* p = allocate(size);
+	if (!p) {
+		throw bad_alloc();
+	}
+	return p;
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+	return allocate(size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+	return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, const nothrow_t&) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p, const nothrow_t&) noexcept {
+	free(p);
+}
+
+namespace crossover {
+namespace monitor {
+
+unsigned long long allocations() noexcept {
+	return allocated.load(memory_order_relaxed);
+}
+
+void count_allocations(benchmark::State& state, unsigned long long before) {
+	state.counters["allocs/op"] = benchmark::Counter(
+		static_cast<double>(allocations() - before),
+		benchmark::Counter::kAvgIterations);
+}
+
+} //namespace monitor
+} //namespace crossover
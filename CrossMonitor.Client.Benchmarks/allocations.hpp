@@ -0,0 +1,22 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+namespace crossover {
+namespace monitor {
+
+/**
+ * Heap allocations made through operator new by every thread since the
+ * benchmarks started; the benchmark executable replaces the global
+ * operator new to count them.
+ */
+unsigned long long allocations() noexcept;
+
+/**
+ * Sets the "allocs/op" counter of state to the allocations made since
+ * allocations() returned before, divided by the iterations run.
+ */
+void count_allocations(benchmark::State& state, unsigned long long before);
+
+} //namespace monitor
+} //namespace crossover
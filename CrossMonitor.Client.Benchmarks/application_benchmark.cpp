@@ -0,0 +1,70 @@
+#include <benchmark/benchmark.h>
+
+#include "allocations.hpp"
+
+#include <application.hpp>
+#include <os.hpp>
+
+#include <chrono>
+#include <string>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Reaches the private steps of application's sampling loop.
+ */
+class application_benchmark final {
+public:
+	static data collect(application& app) {
+		return app.CollectData();
+	}
+	static const string& to_json(application& app, const data& d) {
+		return app.data_to_json(d);
+	}
+};
+
+// The OS backend alone: every source read once.
+static void BM_OsSample(benchmark::State& state) {
+	os::snapshot s;
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		os::sample(s);
+		benchmark::DoNotOptimize(s.cpu_percent);
+	}
+	count_allocations(state, before);
+}
+BENCHMARK(BM_OsSample);
+
+// A sample as the collector thread takes it; minus BM_OsSample, the
+// application's own overhead.
+static void BM_CollectData(benchmark::State& state) {
+	application app(chrono::seconds(1));
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		const data d = application_benchmark::collect(app);
+		benchmark::DoNotOptimize(d.get_cpu_percent());
+	}
+	count_allocations(state, before);
+}
+BENCHMARK(BM_CollectData);
+
+// A sample to the JSON line the sink thread logs and sends.
+static void BM_DataToJson(benchmark::State& state) {
+	application app(chrono::seconds(1));
+	const data d(12.3f, 123123213, 60150145, 101, 123123, 123123);
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		const string& json = application_benchmark::to_json(app, d);
+		benchmark::DoNotOptimize(json.data());
+	}
+	count_allocations(state, before);
+}
+BENCHMARK(BM_DataToJson);
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+
+#include <cpu_cores.hpp>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+// Deltas of state.range(0) CPUs, ticks advancing as on a loaded machine.
+static void BM_CoreUsage(benchmark::State& state) {
+	const size_t cpus = static_cast<size_t>(state.range(0));
+	os::core_ticks previous, current;
+	previous.resize(cpus);
+	current.resize(cpus);
+	for (size_t i = 0; i < cpus; ++i) {
+		previous.user[i] = 1000000 + i * 7;
+		previous.system[i] = 500000 + i * 3;
+		previous.idle[i] = 9000000 + i * 11;
+		previous.iowait[i] = 20000 + i;
+		previous.steal[i] = 1000;
+		current.user[i] = previous.user[i] + 40 + i % 50;
+		current.system[i] = previous.system[i] + 10 + i % 7;
+		current.idle[i] = previous.idle[i] + 140 - i % 50;
+		current.iowait[i] = previous.iowait[i] + i % 3;
+		current.steal[i] = previous.steal[i] + i % 2;
+	}
+	core_usage usage;
+	while (state.KeepRunning()) {
+		cpu_cores::compute(previous, current, usage);
+		benchmark::DoNotOptimize(usage.busy.data());
+	}
+	state.SetItemsProcessed(state.iterations() * cpus);
+}
+BENCHMARK(BM_CoreUsage)->Arg(8)->Arg(64)->Arg(256);
+
+// Whole sample, reading the ticks from the OS.
+static void BM_CoreSample(benchmark::State& state) {
+	cpu_cores cores;
+	core_usage usage;
+	while (state.KeepRunning()) {
+		benchmark::DoNotOptimize(cores.sample(usage));
+	}
+}
+BENCHMARK(BM_CoreSample);
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
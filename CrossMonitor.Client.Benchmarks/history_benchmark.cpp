@@ -0,0 +1,94 @@
+#include <benchmark/benchmark.h>
+
+#include <history.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+static const unsigned long long start = 1500000000000ull;
+static const unsigned long long day = 24ull * 60 * 60 * 1000;
+
+/**
+ * A day of 1 second samples of a busy host, written once and shared by
+ * the query benchmarks.
+ */
+static const history& day_history() {
+	static unique_ptr<history> h;
+	if (!h) {
+		const boost::filesystem::path path =
+			boost::filesystem::temp_directory_path() / "history_benchmark.bin";
+		boost::filesystem::remove(path);
+		h.reset(new history(path.string(), 1024));
+		mt19937 random(42);
+		uniform_int_distribution<int> change(-10, 10);
+		uniform_int_distribution<int> bytes(0, 256);
+		float cpu = 20;
+		unsigned long long used = 8ull << 30;
+		unsigned long long read = 1ull << 30;
+		unsigned long long write = 1ull << 29;
+		for (unsigned long long t = start; t < start + day; t += 1000) {
+			cpu = min(100.0f, max(0.0f, cpu + change(random) / 10.0f));
+			used += static_cast<long long>(change(random)) * 4096 * 16;
+			read += static_cast<unsigned long long>(bytes(random)) * 4096;
+			write += static_cast<unsigned long long>(bytes(random)) * 512;
+			h->push(record(t, data(cpu, used, 16ull << 30, 200, read, write)));
+		}
+	}
+	return *h;
+}
+
+// One field of the whole day in buckets of state.range(0) seconds.
+static void BM_HistoryQueryField(benchmark::State& state) {
+	const history& h = day_history();
+	const unsigned long long step = state.range(0) * 1000ull;
+	vector<history_bucket> buckets;
+	while (state.KeepRunning()) {
+		buckets.clear();
+		h.query("cpu_percent", start, start + day, step, buckets);
+		benchmark::DoNotOptimize(buckets.data());
+	}
+	state.SetItemsProcessed(state.iterations() * (day / 1000));
+}
+BENCHMARK(BM_HistoryQueryField)->Arg(60)->Arg(3600)
+	->Unit(benchmark::kMillisecond);
+
+// A field that never changes, aggregated from the block headers.
+static void BM_HistoryQueryConstant(benchmark::State& state) {
+	const history& h = day_history();
+	vector<history_bucket> buckets;
+	while (state.KeepRunning()) {
+		buckets.clear();
+		h.query("total_memory_in_bytes", start, start + day, 3600000, buckets);
+		benchmark::DoNotOptimize(buckets.data());
+	}
+	state.SetItemsProcessed(state.iterations() * (day / 1000));
+}
+BENCHMARK(BM_HistoryQueryConstant)->Unit(benchmark::kMillisecond);
+
+// Every field of the whole day, as raw samples.
+static void BM_HistoryQueryRecords(benchmark::State& state) {
+	const history& h = day_history();
+	vector<record> records;
+	while (state.KeepRunning()) {
+		records.clear();
+		h.query(start, start + day, records);
+		benchmark::DoNotOptimize(records.data());
+	}
+	state.SetItemsProcessed(state.iterations() * (day / 1000));
+}
+BENCHMARK(BM_HistoryQueryRecords)->Unit(benchmark::kMillisecond);
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
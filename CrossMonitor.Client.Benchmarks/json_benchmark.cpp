@@ -0,0 +1,115 @@
+#include <benchmark/benchmark.h>
+
+#include "allocations.hpp"
+
+#include <data.hpp>
+#include <delta_frame.hpp>
+#include <json_writer.hpp>
+#include <record.hpp>
+#include <cpprest/json.h>
+
+#include <vector>
+
+using namespace web;
+
+namespace crossover {
+namespace monitor {
+
+// Typical sample, cpu_percent is rarely integral when read from counters.
+static const data sample(12.3f, 123123213, 60150145, 101, 123123, 123123);
+
+// Serialization as application::data_to_json did it with cpprest.
+static void BM_CpprestJson(benchmark::State& state) {
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		json::value v(json::value::object());
+		json::object& o(v.as_object());
+		o[U("cpu_percent")] = sample.get_cpu_percent();
+		o[U("used_memory_in_bytes")] = sample.get_used_memory();
+		o[U("total_memory_in_bytes")] = sample.get_total_memory();
+		o[U("process_count")] = sample.get_process_count();
+		o[U("total_disk_read")] = sample.get_total_disk_read();
+		o[U("total_disk_write")] = sample.get_total_disk_write();
+		const utility::string_t text(v.to_string());
+		benchmark::DoNotOptimize(text.data());
+	}
+	count_allocations(state, before);
+}
+BENCHMARK(BM_CpprestJson);
+
+static void BM_JsonWriter(benchmark::State& state) {
+	json_writer writer;
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		writer.clear();
+		writer.write(sample);
+		benchmark::DoNotOptimize(writer.c_str());
+	}
+	count_allocations(state, before);
+	state.SetBytesProcessed(state.iterations() * writer.size());
+}
+BENCHMARK(BM_JsonWriter);
+
+static void BM_JsonWriterIntegral(benchmark::State& state) {
+	const data integral(12, 123123213, 60150145, 101, 123123, 123123);
+	json_writer writer;
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		writer.clear();
+		writer.write(integral);
+		benchmark::DoNotOptimize(writer.c_str());
+	}
+	count_allocations(state, before);
+	state.SetBytesProcessed(state.iterations() * writer.size());
+}
+BENCHMARK(BM_JsonWriterIntegral);
+
+// A batch of a minute of samples of an idle machine: memory and processes
+// mostly steady, cpu_percent moving a little and the disk counters growing.
+static std::vector<record> idle_batch() {
+	std::vector<record> batch;
+	unsigned long long read = 52428800000ull;
+	unsigned long long write = 10485760000ull;
+	for (unsigned i = 0; i < 60; ++i) {
+		read += i % 4 == 0 ? 65536 : 0;
+		write += 4096 * (i % 3);
+		batch.push_back(record(1500000000000ull + i * 1000ull,
+			data(2.5f + static_cast<float>(i % 5) * 0.25f,
+				 4294967296ull + 4096ull * (i / 10), 17179869184ull,
+				 101 + i / 30, read, write), 1000));
+	}
+	return batch;
+}
+
+// Batch bytes per record with a keyframe every range(0) records, 1 being
+// the plain records, and with a 1% cpu_percent dead-band for range(1) = 1.
+static void BM_JsonDeltaBatch(benchmark::State& state) {
+	const std::vector<record> batch = idle_batch();
+	delta_options options;
+	options.keyframe_every = static_cast<unsigned>(state.range(0));
+	if (state.range(1) != 0) {
+		options.set_deadband("cpu_percent", 1);
+	}
+	delta_encoder encoder(options);
+	delta_frame frame;
+	json_writer writer;
+	while (state.KeepRunning()) {
+		writer.clear();
+		writer.begin_array();
+		encoder.reset();
+		for (const record& r : batch) {
+			encoder.encode(r, frame);
+			writer.write(frame);
+		}
+		writer.end_array();
+		benchmark::DoNotOptimize(writer.c_str());
+	}
+	state.counters["bytes/record"] = benchmark::Counter(
+		static_cast<double>(writer.size()) / batch.size());
+	state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_JsonDeltaBatch)->Args({ 1, 0 })->Args({ 10, 0 })->Args({ 60, 0 })
+	->Args({ 60, 1 });
+
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+
+#include "allocations.hpp"
+
+#include <log.hpp>
+
+#include <boost/filesystem.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/expressions.hpp>
+
+#include <string>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+
+// A report line, about the size application logs for every sample.
+static const string line("{\"cpu_percent\":12.3,\"used_memory_in_bytes\":123123213,"
+	"\"total_memory_in_bytes\":60150145,\"process_count\":101,"
+	"\"total_disk_read\":123123,\"total_disk_write\":123123}");
+
+// A record handed to the log file writer thread, as the sink thread logs.
+static void BM_LogRecord(benchmark::State& state) {
+	log::file_options options;
+	options.filename = (boost::filesystem::temp_directory_path() /
+		"log_benchmark.log").string();
+	options.queue_bytes = 16 * 1024 * 1024;
+	log::set_file(options);
+	const unsigned long long dropped = log::dropped_records();
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		LOG(info) << line;
+	}
+	count_allocations(state, before);
+	log::flush();
+	state.counters["dropped/op"] = benchmark::Counter(
+		static_cast<double>(log::dropped_records() - dropped),
+		benchmark::Counter::kAvgIterations);
+	state.SetBytesProcessed(state.iterations() * line.size());
+	log::shutdown();
+	boost::filesystem::remove(options.filename);
+}
+BENCHMARK(BM_LogRecord);
+
+// A record below the severity filter, e.g. debug output in production.
+static void BM_LogFiltered(benchmark::State& state) {
+	boost::log::core::get()->set_filter(
+		boost::log::trivial::severity >= boost::log::trivial::warning);
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		LOG(debug) << line;
+	}
+	count_allocations(state, before);
+	boost::log::core::get()->reset_filter();
+}
+BENCHMARK(BM_LogFiltered);
+
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,137 @@
+#include <benchmark/benchmark.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Mean CPU time and allocations of a benchmark over its runs.
+ */
+struct result final {
+	double cpu_time = 0;
+	double allocs = 0;
+	unsigned runs = 0;
+};
+
+/**
+ * Reads the results of a --benchmark_out_format=json file by benchmark
+ * name, leaving out the aggregates of repeated runs.
+ */
+static map<string, result> read_results(const string& path) {
+	boost::property_tree::ptree root;
+	boost::property_tree::read_json(path, root);
+	map<string, result> results;
+	for (const auto& entry : root.get_child("benchmarks")) {
+		const boost::property_tree::ptree& run = entry.second;
+		if (run.get<string>("run_type", "iteration") != "iteration") {
+			continue;
+		}
+		result& r = results[run.get<string>("name")];
+		r.cpu_time += run.get<double>("cpu_time");
+		r.allocs += run.get<double>("allocs/op", 0);
+		++r.runs;
+	}
+	for (auto& r : results) {
+		r.second.cpu_time /= r.second.runs;
+		r.second.allocs /= r.second.runs;
+	}
+	return results;
+}
+
+/**
+ * Prints the benchmarks of current slower than in baseline by more than
+ * tolerance percent or allocating more.
+ * @return false if there are any.
+ */
+static bool compare(const string& baseline, const string& current,
+					double tolerance) {
+	const map<string, result> before = read_results(baseline);
+	const map<string, result> after = read_results(current);
+	bool passed = true;
+	for (const auto& r : after) {
+		const auto b = before.find(r.first);
+		if (b == before.end()) {
+			cout << "New: " << r.first << endl;
+			continue;
+		}
+		const double change =
+			(r.second.cpu_time / b->second.cpu_time - 1) * 100;
+		if (change > tolerance) {
+			cout << "Slower: " << r.first << " +" << change << "%" << endl;
+			passed = false;
+		}
+		// Allocations do not depend on the machine, half of one is noise
+		// from a lazy initialization amortized over the iterations
+		if (r.second.allocs > b->second.allocs + 0.5) {
+			cout << "More allocations: " << r.first << " "
+				 << b->second.allocs << " -> " << r.second.allocs << endl;
+			passed = false;
+		}
+	}
+	cout << (passed ? "No regression against " : "Regressions against ")
+		 << baseline << endl;
+	return passed;
+}
+
+/**
+ * Google Benchmark's main with two more flags:
+ * --baseline=FILE saves the results to FILE as JSON when it does not
+ * exist, otherwise saves them to FILE.new and fails if a benchmark got
+ * slower by more than --tolerance=PERCENT (10) or allocates more.
+ */
+int main(int argc, char* argv[]) {
+	string baseline;
+	double tolerance = 10;
+	vector<char*> args;
+	for (int i = 0; i < argc; ++i) {
+		if (strncmp(argv[i], "--baseline=", 11) == 0) {
+			baseline = argv[i] + 11;
+		} else if (strncmp(argv[i], "--tolerance=", 12) == 0) {
+			tolerance = atof(argv[i] + 12);
+		} else {
+			args.push_back(argv[i]);
+		}
+	}
+
+	const bool compared =
+		!baseline.empty() && boost::filesystem::exists(baseline);
+	const string out = compared ? baseline + ".new" : baseline;
+	string out_arg = "--benchmark_out=" + out;
+	string format_arg = "--benchmark_out_format=json";
+	if (!baseline.empty()) {
+		args.push_back(&out_arg[0]);
+		args.push_back(&format_arg[0]);
+	}
+
+	int count = static_cast<int>(args.size());
+	args.push_back(nullptr);
+	benchmark::Initialize(&count, args.data());
+	if (benchmark::ReportUnrecognizedArguments(count, args.data())) {
+		return EXIT_FAILURE;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+
+	if (baseline.empty()) {
+		return EXIT_SUCCESS;
+	}
+	if (!compared) {
+		cout << "Baseline saved to " << baseline << endl;
+		return EXIT_SUCCESS;
+	}
+	try {
+		return compare(baseline, out, tolerance) ? EXIT_SUCCESS : EXIT_FAILURE;
+	} catch (const exception& e) {
+		cerr << "Failed to compare with " << baseline << ": " << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,71 @@
+#include <benchmark/benchmark.h>
+
+#include <scheduler.hpp>
+#include <utils.hpp>
+
+#include <atomic>
+#include <chrono>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+/**
+ * Sets the counters of a benchmark whose iterations each wait for a
+ * deadline: "late_us", the mean time woken up after it, and "wakeups/s",
+ * the thread wakeups per second of wall time.
+ */
+static void wakeup_counters(benchmark::State& state, chrono::nanoseconds late,
+							unsigned long long wakeups,
+							chrono::nanoseconds elapsed) {
+	state.counters["late_us"] = benchmark::Counter(
+		chrono::duration<double, micro>(late).count(),
+		benchmark::Counter::kAvgIterations);
+	state.counters["wakeups/s"] = benchmark::Counter(
+		wakeups / chrono::duration<double>(elapsed).count());
+}
+
+// Sleeps of state.range(0) ms polling every state.range(1) ms, as the
+// sampling loop did before deadline_scheduler.
+static void BM_InterruptibleSleep(benchmark::State& state) {
+	const chrono::milliseconds time(state.range(0));
+	const chrono::milliseconds check(state.range(1));
+	const atomic<bool> interrupt{ false };
+	// One wakeup per check period, the last one cut short by the deadline
+	const unsigned long long per_sleep = (time.count() + check.count() - 1) /
+		check.count();
+	chrono::nanoseconds late(0);
+	const auto start = chrono::steady_clock::now();
+	while (state.KeepRunning()) {
+		const auto deadline = chrono::steady_clock::now() + time;
+		interruptible_sleep(time, check, interrupt);
+		late += chrono::steady_clock::now() - deadline;
+	}
+	wakeup_counters(state, late, state.iterations() * per_sleep,
+		chrono::steady_clock::now() - start);
+}
+BENCHMARK(BM_InterruptibleSleep)->Args({ 10, 1 })->Args({ 100, 10 })
+	->Args({ 100, 100 })->UseRealTime();
+
+// Periods of state.range(0) ms, one wakeup each.
+static void BM_SchedulerWait(benchmark::State& state) {
+	deadline_scheduler scheduler(chrono::milliseconds(state.range(0)));
+	scheduler.wait_next();
+	chrono::nanoseconds late(0);
+	const auto start = chrono::steady_clock::now();
+	while (state.KeepRunning()) {
+		scheduler.wait_next();
+		late += chrono::steady_clock::now() - scheduler.last_deadline();
+	}
+	wakeup_counters(state, late, state.iterations(),
+		chrono::steady_clock::now() - start);
+	state.counters["missed"] =
+		static_cast<double>(scheduler.missed_deadlines());
+}
+BENCHMARK(BM_SchedulerWait)->Arg(10)->Arg(100)->UseRealTime();
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,135 @@
+#include <benchmark/benchmark.h>
+
+#include "allocations.hpp"
+
+#include <data.hpp>
+#include <delta_frame.hpp>
+#include <json_writer.hpp>
+#include <record.hpp>
+#include <wire_format.hpp>
+
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+
+// The sample of the JSON benchmarks, BM_JsonWriter writing what
+// application::data_to_json did.
+static const data sample(12.3f, 123123213, 60150145, 101, 123123, 123123);
+
+/**
+ * Sets the size counters: bytes of the binary document and of the same
+ * values as JSON.
+ */
+static void size_counters(benchmark::State& state, size_t binary, size_t json) {
+	state.counters["bytes"] = benchmark::Counter(static_cast<double>(binary));
+	state.counters["json_bytes"] = benchmark::Counter(static_cast<double>(json));
+}
+
+static void BM_BinaryWriter(benchmark::State& state) {
+	binary_writer writer;
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		writer.begin(wire_kind::data);
+		writer.write(sample);
+		benchmark::DoNotOptimize(writer.bytes().data());
+	}
+	count_allocations(state, before);
+	json_writer json;
+	json.write(sample);
+	size_counters(state, writer.size(), json.size());
+	state.SetBytesProcessed(state.iterations() * writer.size());
+}
+BENCHMARK(BM_BinaryWriter);
+
+static void BM_BinaryReader(benchmark::State& state) {
+	binary_writer writer;
+	writer.begin(wire_kind::data);
+	writer.write(sample);
+	const vector<unsigned char>& bytes = writer.bytes();
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		binary_reader reader(bytes.data(), bytes.size());
+		const data d = reader.read_data();
+		benchmark::DoNotOptimize(&d);
+	}
+	count_allocations(state, before);
+	state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_BinaryReader);
+
+// A minute of 1 second samples, the disk counters growing steadily.
+static vector<record> minute_batch() {
+	vector<record> batch;
+	for (unsigned i = 0; i < 60; ++i) {
+		batch.push_back(record(1500000000000ull + i * 1000ull,
+			data(2.5f + static_cast<float>(i % 5) * 0.25f,
+				 4294967296ull + 4096ull * (i / 10), 17179869184ull,
+				 101 + i / 30, 52428800000ull + 65536ull * (i / 4),
+				 10485760000ull + 4096ull * i), 1000));
+	}
+	return batch;
+}
+
+// Batch encoding with a keyframe every range(0) records, 1 being the plain
+// records; bytes per record against the JSON of the same frames.
+static void BM_BinaryBatch(benchmark::State& state) {
+	const vector<record> batch = minute_batch();
+	delta_options options;
+	options.keyframe_every = static_cast<unsigned>(state.range(0));
+	delta_encoder encoder(options);
+	delta_frame frame;
+	binary_writer writer;
+	const unsigned long long before = allocations();
+	while (state.KeepRunning()) {
+		writer.begin(wire_kind::batch);
+		encoder.reset();
+		for (const record& r : batch) {
+			encoder.encode(r, frame);
+			writer.write(frame);
+		}
+		benchmark::DoNotOptimize(writer.bytes().data());
+	}
+	count_allocations(state, before);
+
+	json_writer json;
+	json.begin_array();
+	encoder.reset();
+	for (const record& r : batch) {
+		encoder.encode(r, frame);
+		json.write(frame);
+	}
+	json.end_array();
+	state.counters["bytes/record"] = benchmark::Counter(
+		static_cast<double>(writer.size()) / batch.size());
+	state.counters["json_bytes/record"] = benchmark::Counter(
+		static_cast<double>(json.size()) / batch.size());
+	state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_BinaryBatch)->Arg(1)->Arg(60);
+
+static void BM_BinaryBatchDecode(benchmark::State& state) {
+	const vector<record> batch = minute_batch();
+	binary_writer writer;
+	writer.begin(wire_kind::batch);
+	for (const record& r : batch) {
+		writer.write(r);
+	}
+	const vector<unsigned char>& bytes = writer.bytes();
+	delta_frame frame;
+	while (state.KeepRunning()) {
+		binary_reader reader(bytes.data(), bytes.size());
+		delta_decoder decoder;
+		while (reader.next(frame)) {
+			const record r = decoder.decode(frame);
+			benchmark::DoNotOptimize(&r);
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * batch.size());
+}
+BENCHMARK(BM_BinaryBatchDecode);
+
+} //namespace monitor
+} //namespace crossover
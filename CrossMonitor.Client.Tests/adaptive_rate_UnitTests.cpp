@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+
+#include <adaptive_rate.hpp>
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static adaptive_options options(chrono::milliseconds max_period) {
+				adaptive_options o;
+				o.max_period = max_period;
+				o.threshold = 0.2;
+				o.stable_samples = 3;
+				return o;
+			}
+
+			static data sample(float cpu, unsigned long long read = 0) {
+				return data(cpu, 4000, 8000, 100, read, 0);
+			}
+
+			TEST(CrossMonitorAdaptiveRate, InvalidOptions) {
+				ASSERT_THROW(adaptive_rate r(chrono::seconds(2), options(chrono::seconds(1))),
+					std::invalid_argument);
+				ASSERT_THROW(adaptive_rate r(chrono::seconds(0), options(chrono::seconds(1))),
+					std::invalid_argument);
+				adaptive_options o = options(chrono::seconds(10));
+				o.threshold = 0;
+				ASSERT_THROW(adaptive_rate r(chrono::seconds(1), o), std::invalid_argument);
+				o = options(chrono::seconds(10));
+				o.stable_samples = 0;
+				ASSERT_THROW(adaptive_rate r(chrono::seconds(1), o), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorAdaptiveRate, StableBacksOff) {
+				adaptive_rate r(chrono::seconds(1), options(chrono::seconds(8)));
+				ASSERT_EQ(r.period(), chrono::seconds(1));
+				chrono::milliseconds period = r.period();
+				unsigned samples = 0;
+				while (period < chrono::seconds(8)) {
+					const chrono::milliseconds next = r.next(sample(10), period);
+					ASSERT_TRUE(next == period || next == period * 2);
+					period = next;
+					ASSERT_LT(++samples, 20u);
+				}
+				// Doubling after every 3 quiet samples
+				ASSERT_EQ(samples, 9u);
+				for (int i = 0; i < 10; ++i) {
+					ASSERT_EQ(r.next(sample(10), period), chrono::seconds(8));
+				}
+			}
+
+			TEST(CrossMonitorAdaptiveRate, SpikeReturnsToShortest) {
+				adaptive_rate r(chrono::seconds(1), options(chrono::seconds(8)));
+				for (int i = 0; i < 12; ++i) {
+					r.next(sample(10), r.period());
+				}
+				ASSERT_EQ(r.period(), chrono::seconds(8));
+				ASSERT_EQ(r.next(sample(80), r.period()), chrono::seconds(1));
+				// Below the threshold but volatile: stays fast
+				ASSERT_EQ(r.next(sample(75), r.period()), chrono::seconds(1));
+				ASSERT_GE(r.volatility(), 0.1);
+
+				r.reset();
+				ASSERT_EQ(r.period(), chrono::seconds(1));
+				ASSERT_EQ(r.volatility(), 0);
+			}
+
+			TEST(CrossMonitorAdaptiveRate, SmallChangesDoNotTrigger) {
+				adaptive_rate r(chrono::seconds(1), options(chrono::seconds(4)));
+				// Noise around zero is compared to 1, not to itself
+				for (int i = 0; i < 12; ++i) {
+					r.next(sample(i % 2 ? 0.1f : 0.05f), r.period());
+				}
+				ASSERT_EQ(r.period(), chrono::seconds(4));
+			}
+
+			TEST(CrossMonitorAdaptiveRate, IdleHostBacksOff) {
+				adaptive_rate r(chrono::seconds(1), options(chrono::seconds(8)));
+				// What an idle host looks like: CPU between 3% and 9%, a few
+				// MB of memory and processes coming and going, disks reading
+				// up to 100 KB/s
+				const unsigned long long total = 8ull << 30;
+				unsigned long long read = 0;
+				unsigned noise = 12345;
+				unsigned samples = 0;
+				while (r.period() < chrono::seconds(8)) {
+					noise = noise * 1103515245 + 12345;
+					const unsigned jitter = (noise >> 16) % 100;
+					const chrono::milliseconds period = r.period();
+					read += jitter * 1024 * static_cast<unsigned long long>(period.count()) / 1000;
+					r.next(data(3 + jitter * 0.06f, (2ull << 30) + jitter * (64 << 10),
+								total, 200 + jitter % 5, read, 0), period);
+					ASSERT_LT(++samples, 30u);
+				}
+				ASSERT_LT(r.volatility(), 0.1);
+			}
+
+			TEST(CrossMonitorAdaptiveRate, CountersComparedByRate) {
+				adaptive_rate r(chrono::seconds(1), options(chrono::seconds(8)));
+				// 1 MB/s whatever the period
+				unsigned long long read = 0;
+				for (int i = 0; i < 12; ++i) {
+					const chrono::milliseconds period = r.period();
+					read += 1000 * static_cast<unsigned long long>(period.count());
+					r.next(sample(10, read), period);
+				}
+				ASSERT_EQ(r.period(), chrono::seconds(8));
+				read += 3 * 1000 * 8000;
+				ASSERT_EQ(r.next(sample(10, read), chrono::seconds(8)), chrono::seconds(1));
+			}
+
+		}
+	}
+}
@@ -2,18 +2,33 @@
 
 #include <application.hpp>
 #include <cstdlib>
+#include <cstring>
 #include <stdexcept>
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <thread>
 #include <process.h>
 #include <Windows.h>
 #include <data.hpp>
+#include <data_fields.hpp>
 #include <os.hpp>
 #include <os_mock.hpp>
 #include <log.hpp>
+#include <utils.hpp>
 #include <cpprest/json.h>
 
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <mutex>
+#include <sstream>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 using namespace crossover::monitor;
 using namespace web;
@@ -36,6 +51,14 @@ namespace crossover {
 				ASSERT_NO_THROW(client::application app{ chrono::seconds(1) });
 			}
 
+			TEST(CrossMonitorTest, SubSecondSampling) {
+				ASSERT_NO_THROW(client::application app(chrono::milliseconds(10), chrono::milliseconds(1000)));
+				ASSERT_NO_THROW(client::application app(chrono::milliseconds(100), chrono::milliseconds(100)));
+				ASSERT_THROW(client::application app(chrono::milliseconds(5), chrono::milliseconds(1000)), std::invalid_argument);
+				ASSERT_THROW(client::application app(chrono::milliseconds(100), chrono::milliseconds(50)), std::invalid_argument);
+				ASSERT_THROW(client::application app(chrono::milliseconds(30), chrono::milliseconds(1000)), std::invalid_argument);
+			}
+
 			TEST(CrossMonitorTest, CreateRun) {
 				ASSERT_NO_THROW(client::application app{ chrono::seconds(1) });
 			}
@@ -68,6 +91,139 @@ namespace crossover {
 				WaitForSingleObject(thr, INFINITE);
 			}
 
+			TEST(CrossMonitorTest, SlowSinkDoesNotDelayCollection) {
+				client::application app(chrono::milliseconds(10), chrono::milliseconds(100));
+				// The first batch fails after 250 ms and the sink thread then waits
+				// in a long backoff until stop()
+				sender_options options;
+				options.url = "http://localhost:34569/ingest";
+				options.batch_size = 25;
+				options.min_backoff = chrono::seconds(60);
+				options.max_backoff = chrono::seconds(60);
+				app.enable_sending(options);
+
+				thread runner([&app] { app.run(); });
+				this_thread::sleep_for(chrono::milliseconds(500));
+				app.stop();
+				runner.join();
+				ASSERT_EQ(app.missed_deadlines(), 0u);
+				ASSERT_EQ(app.dropped_samples(), 0u);
+			}
+
+			TEST(CrossMonitorTest, SlowServerDoesNotDelayLogging) {
+				const boost::filesystem::path path =
+					boost::filesystem::temp_directory_path() / "crossmonitor_slow_server.log";
+				boost::filesystem::remove(path);
+				log::set_file(path.string());
+				utils::scope_exit close([] {
+					log::shutdown();
+				});
+
+				client::application app(chrono::milliseconds(10), chrono::milliseconds(100));
+				// The sender waits in a long backoff from 250 ms on
+				sender_options options;
+				options.url = "http://localhost:34569/ingest";
+				options.batch_size = 25;
+				options.min_backoff = chrono::seconds(60);
+				options.max_backoff = chrono::seconds(60);
+				app.enable_sending(options);
+
+				thread runner([&app] { app.run(); });
+				this_thread::sleep_for(chrono::milliseconds(1000));
+				log::flush();
+				ifstream in(path.string());
+				stringstream text;
+				text << in.rdbuf();
+				app.stop();
+				runner.join();
+
+				// A report every 100 ms, the log keeps up
+				size_t reports = 0;
+				const string summary = "{\"cpu_percent\":{\"last\":";
+				for (size_t at = text.str().find(summary); at != string::npos;
+					 at = text.str().find(summary, at + 1)) {
+					++reports;
+				}
+				ASSERT_GE(reports, 7u) << text.str();
+			}
+
+			TEST(CrossMonitorTest, ReportsEverySampleInSecondsMode) {
+				// One sample per report: every sample ends a report, so the
+				// collectors logged after each report run on every sample.
+				const boost::filesystem::path path =
+					boost::filesystem::temp_directory_path() / "crossmonitor_reports.log";
+				boost::filesystem::remove(path);
+				log::set_file(path.string());
+				utils::scope_exit close([] {
+					log::shutdown();
+				});
+
+				client::application app(chrono::seconds(1));
+				app.enable_process_top(3);
+				thread runner([&app] { app.run(); });
+				this_thread::sleep_for(chrono::milliseconds(1500));
+				app.stop();
+				runner.join();
+				log::flush();
+
+				ifstream in(path.string());
+				stringstream text;
+				text << in.rdbuf();
+				ASSERT_NE(text.str().find("{\"processes\":"), string::npos) << text.str();
+			}
+
+#ifndef _WIN32
+			// Linux hands a process-directed signal to any thread not blocking
+			// it, Windows runs console control handlers on a thread of their own.
+			static mutex terminated_m;
+			static client::application* terminated_app = nullptr;
+
+			/**
+			 * Runs until a process-directed SIGTERM, in the order main sets
+			 * things up, and exits with 0 once the log is drained.
+			 */
+			static void run_until_terminated() {
+				crossover::monitor::os::set_termination_handler([] {
+					const lock_guard<mutex> lock(terminated_m);
+					if (terminated_app) {
+						terminated_app->stop();
+					}
+				});
+				const boost::filesystem::path path =
+					boost::filesystem::temp_directory_path() / "crossmonitor_terminated.log";
+				boost::filesystem::remove(path);
+				// Both start threads: the log writer and the probe workers
+				log::set_file(path.string());
+				os::set_process_count(50);
+				os::set_total_memory(101);
+				client::application app(chrono::seconds(1));
+				app.enable_process_top(3);
+				{
+					const lock_guard<mutex> lock(terminated_m);
+					terminated_app = &app;
+				}
+
+				thread terminator([] {
+					this_thread::sleep_for(chrono::milliseconds(1500));
+					kill(getpid(), SIGTERM);
+				});
+				app.run();
+				terminator.join();
+				log::shutdown();
+
+				ifstream in(path.string());
+				stringstream text;
+				text << in.rdbuf();
+				exit(text.str().find("Exiting application loop") != string::npos ?
+					EXIT_SUCCESS : EXIT_FAILURE);
+			}
+
+			TEST(CrossMonitorDeathTest, TerminationSignalStopsGracefully) {
+				::testing::FLAGS_gtest_death_test_style = "threadsafe";
+				EXPECT_EXIT(run_until_terminated(), ::testing::ExitedWithCode(EXIT_SUCCESS), "");
+			}
+#endif
+
 			TEST(CrossMonitorData, Create) {
 				data d(100, 101, 102, 103, 104, 105);
 				ASSERT_EQ(d.get_cpu_percent(), 100);
@@ -87,6 +243,44 @@ namespace crossover {
 				ASSERT_THROW(data d2(0,0,0,0,0,0), std::invalid_argument);
 			}
 
+			TEST(CrossMonitorData, Fields) {
+				data d(10, 101, 102, 103, 104, 105);
+				ASSERT_EQ(d.get<fields::cpu_percent>(), 10);
+				ASSERT_EQ(d.get<fields::total_disk_write>(), 105u);
+				d.set<fields::used_memory>(201);
+				ASSERT_EQ(d.get_used_memory(), 201u);
+				fields::total_memory::set(d, 202);
+				ASSERT_EQ(fields::total_memory::get(d), 202u);
+				ASSERT_THROW(d.set<fields::cpu_percent>(101), std::invalid_argument);
+				ASSERT_THROW(d.set<fields::process_count>(0), std::invalid_argument);
+				ASSERT_STREQ(fields::cpu_percent::unit(), "percent");
+				static_assert(!fields::used_memory::counter, "used_memory is a gauge");
+				static_assert(fields::total_disk_read::counter, "total_disk_read is a counter");
+
+				const data copy(data::values(10.0f, 103u, 104ull, 105ull, 202ull, 201ull));
+				for_each_field(data_fields{}, [&](auto field) {
+					typedef decltype(field) F;
+					ASSERT_EQ(F::get(copy), F::get(d)) << F::name();
+				});
+				ASSERT_THROW(data(data::values(10.0f, 0u, 1ull, 2ull, 3ull, 4ull)),
+					std::invalid_argument);
+			}
+
+			TEST(CrossMonitorData, Pack) {
+				static_assert(data::packed_size == 40, "fields packed without padding");
+				const data d(12.5f, 101, 102, 103, 104, 105);
+				unsigned char packed[data::packed_size];
+				d.pack(packed);
+				const data unpacked = data::unpack(packed);
+				for_each_field(data_fields{}, [&](auto field) {
+					typedef decltype(field) F;
+					ASSERT_EQ(F::get(unpacked), F::get(d)) << F::name();
+				});
+				// process_count follows cpu_percent
+				memset(packed + 4, 0, 4);
+				ASSERT_THROW(data::unpack(packed), std::invalid_argument);
+			}
+
 
 			TEST(CrossMonitorClient, JsonData) {
 				EXPECT_NO_THROW(os::set_cpu_use_percent(10));
@@ -97,7 +291,8 @@ namespace crossover {
 				EXPECT_NO_THROW(os::set_total_disk_write(103));
 				client::application app(chrono::seconds(1));
 				data d = app.CollectData();
-				web::json::value j = app.data_to_json(d);
+				web::json::value j = web::json::value::parse(
+					utility::conversions::to_string_t(app.data_to_json(d)));
 				web::json::value var=j.at(U("cpu_percent"));
 				ASSERT_EQ(var.as_integer(), 10);
 				var = j.at(U("process_count")); 
@@ -112,6 +307,148 @@ namespace crossover {
 				ASSERT_EQ(var.as_integer(), 103);			
 			}
 
+			TEST(CrossMonitorClient, JsonSummary) {
+				client::application app(chrono::milliseconds(100), chrono::milliseconds(1000));
+				sample_buffer samples(10);
+				samples.push(data(10, 100, 1000, 50, 102, 103));
+				samples.push(data(30, 300, 1000, 60, 202, 203));
+				data_summary summary;
+				samples.summarize(summary);
+				web::json::value j = web::json::value::parse(
+					utility::conversions::to_string_t(app.summary_to_json(summary)));
+				ASSERT_EQ(j.at(U("samples")).as_integer(), 2);
+				web::json::value cpu = j.at(U("cpu_percent"));
+				ASSERT_EQ(cpu.at(U("min")).as_integer(), 10);
+				ASSERT_EQ(cpu.at(U("max")).as_integer(), 30);
+				ASSERT_EQ(cpu.at(U("mean")).as_integer(), 20);
+				ASSERT_EQ(cpu.at(U("last")).as_integer(), 30);
+				web::json::value used = j.at(U("used_memory_in_bytes"));
+				ASSERT_EQ(used.at(U("min")).as_integer(), 100);
+				ASSERT_EQ(used.at(U("max")).as_integer(), 300);
+			}
+
+			TEST(CrossMonitorClient, JsonRollingStats) {
+				client::application app(chrono::seconds(1));
+				rolling_stats stats({ 2, 10 });
+				stats.push(data(10, 100, 1000, 50, 102, 103));
+				stats.push(data(30, 300, 1000, 60, 202, 203));
+				stats.push(data(20, 200, 1000, 70, 302, 303));
+				web::json::value j = web::json::value::parse(
+					utility::conversions::to_string_t(app.stats_to_json(stats)));
+				auto windows = j.at(U("windows")).as_array();
+				ASSERT_EQ(windows.size(), 2u);
+				// The short window only holds the last two samples
+				ASSERT_EQ(windows[0].at(U("length")).as_integer(), 2);
+				ASSERT_EQ(windows[0].at(U("samples")).as_integer(), 2);
+				web::json::value cpu = windows[0].at(U("cpu_percent"));
+				ASSERT_EQ(cpu.at(U("min")).as_integer(), 20);
+				ASSERT_EQ(cpu.at(U("max")).as_integer(), 30);
+				ASSERT_EQ(cpu.at(U("mean")).as_integer(), 25);
+				ASSERT_EQ(cpu.at(U("variance")).as_integer(), 25);
+				ASSERT_EQ(windows[1].at(U("length")).as_integer(), 10);
+				ASSERT_EQ(windows[1].at(U("samples")).as_integer(), 3);
+				web::json::value count = windows[1].at(U("process_count"));
+				ASSERT_EQ(count.at(U("min")).as_integer(), 50);
+				ASSERT_EQ(count.at(U("max")).as_integer(), 70);
+				ASSERT_EQ(count.at(U("mean")).as_integer(), 60);
+			}
+
+			TEST(CrossMonitorClient, JsonSketches) {
+				client::application app(chrono::milliseconds(100), chrono::milliseconds(1000));
+				data_sketches sketches;
+				// Disk counters grow by 1000 bytes per 100 ms, except for one
+				// 100 KB burst
+				unsigned long long read = 0;
+				for (unsigned i = 1; i <= 100; ++i) {
+					read += i == 50 ? 100000 : 1000;
+					sketches.push(record(i * 100, data(static_cast<float>(i), 100, 1000, 50, read, 7)));
+				}
+				web::json::value j = web::json::value::parse(
+					utility::conversions::to_string_t(app.sketches_to_json(sketches)));
+				ASSERT_EQ(j.at(U("samples")).as_integer(), 100);
+				web::json::value cpu = j.at(U("cpu_percent"));
+				ASSERT_EQ(cpu.at(U("count")).as_integer(), 100);
+				ASSERT_EQ(cpu.at(U("min")).as_integer(), 1);
+				ASSERT_EQ(cpu.at(U("max")).as_integer(), 100);
+				ASSERT_NEAR(cpu.at(U("p50")).as_double(), 50, 0.5);
+				ASSERT_NEAR(cpu.at(U("p99")).as_double(), 99, 1);
+				ASSERT_EQ(cpu.at(U("keys")).as_array().size(), cpu.at(U("counts")).as_array().size());
+				size_t binned = 0;
+				for (const auto& count : cpu.at(U("counts")).as_array()) {
+					binned += count.as_integer();
+				}
+				ASSERT_EQ(binned, 100u);
+				// Rates start with the second record
+				web::json::value rate = j.at(U("total_disk_read"));
+				ASSERT_EQ(rate.at(U("count")).as_integer(), 99);
+				ASSERT_NEAR(rate.at(U("p50")).as_double(), 10000, 100);
+				ASSERT_EQ(rate.at(U("max")).as_integer(), 1000000);
+				web::json::value idle = j.at(U("total_disk_write"));
+				ASSERT_EQ(idle.at(U("zeros")).as_integer(), 99);
+				ASSERT_EQ(idle.at(U("p99")).as_integer(), 0);
+			}
+
+			TEST(CrossMonitorClient, JsonSelfMetrics) {
+				client::application app(chrono::seconds(1));
+				ASSERT_THROW(app.enable_self_metrics(chrono::seconds(0)), std::invalid_argument);
+				app.enable_self_metrics(chrono::seconds(60));
+				for (int i = 0; i < 10; ++i) {
+					app.data_to_json(app.CollectData());
+				}
+				web::json::value j = web::json::value::parse(
+					utility::conversions::to_string_t(app.self_to_json()));
+				web::json::value agent = j.at(U("agent"));
+				ASSERT_GT(agent.at(U("resident_bytes")).as_number().to_uint64(), 0u);
+				ASSERT_GT(agent.at(U("handles")).as_integer(), 0);
+				ASSERT_GE(agent.at(U("cpu_percent")).as_double(), 0);
+				web::json::value latency = j.at(U("latency_us"));
+				ASSERT_EQ(latency.at(U("cpu")).at(U("count")).as_integer(), 10);
+				ASSERT_EQ(latency.at(U("disk")).at(U("count")).as_integer(), 10);
+				ASSERT_EQ(latency.at(U("serialize")).at(U("count")).as_integer(), 10);
+				ASSERT_GE(latency.at(U("serialize")).at(U("max")).as_double(),
+					latency.at(U("serialize")).at(U("p50")).as_double());
+				ASSERT_FALSE(latency.has_field(U("send")));
+
+				// Each record starts a new period
+				j = web::json::value::parse(
+					utility::conversions::to_string_t(app.self_to_json()));
+				ASSERT_EQ(j.at(U("latency_us")).at(U("cpu")).at(U("count")).as_integer(), 0);
+				ASSERT_EQ(j.at(U("stale")).at(U("disk")).as_integer(), 0);
+			}
+
+			TEST(CrossMonitorClient, ProbeDeadlines) {
+				client::application app(chrono::seconds(1));
+				probe_deadlines deadlines;
+				deadlines.fill(chrono::milliseconds(0));
+				ASSERT_THROW(app.set_probe_deadlines(deadlines), std::invalid_argument);
+				deadlines.fill(chrono::seconds(1));
+				deadlines[static_cast<size_t>(os::probe::disk)] = chrono::milliseconds(20);
+				app.set_probe_deadlines(deadlines);
+				app.enable_self_metrics(chrono::seconds(60));
+
+				os::set_process_count(70);
+				os::set_probe_delay(os::probe::disk, chrono::milliseconds(200));
+				utils::scope_exit reset([] {
+					os::set_probe_delay(os::probe::disk, chrono::milliseconds(0));
+				});
+				// Never read yet: the sample is left out rather than zeroed
+				auto start = chrono::steady_clock::now();
+				ASSERT_THROW(app.CollectData(), std::runtime_error);
+				ASSERT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(150));
+
+				// Then late samples repeat the last reading
+				this_thread::sleep_for(chrono::milliseconds(250));
+				start = chrono::steady_clock::now();
+				const data d = app.CollectData();
+				ASSERT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(150));
+				ASSERT_EQ(d.get_process_count(), 70u);
+
+				web::json::value j = web::json::value::parse(
+					utility::conversions::to_string_t(app.self_to_json()));
+				ASSERT_EQ(j.at(U("stale")).at(U("disk")).as_integer(), 2);
+				ASSERT_EQ(j.at(U("stale")).at(U("cpu")).as_integer(), 0);
+			}
+
 			TEST(CrossMonitorOSMocks, GetOSParameters) {
 				os::set_cpu_use_percent(10);
 				ASSERT_EQ(os::cpu_use_percent(), 10);
@@ -127,6 +464,23 @@ namespace crossover {
 				ASSERT_EQ(os::total_disk_write(), 103);
 			}
 
+			TEST(CrossMonitorOSMocks, Sample) {
+				os::set_cpu_use_percent(20);
+				os::set_process_count(60);
+				os::set_used_memory(200);
+				os::set_total_memory(201);
+				os::set_total_disk_read(202);
+				os::set_total_disk_write(203);
+				os::snapshot s;
+				os::sample(s);
+				ASSERT_EQ(s.cpu_percent, 20);
+				ASSERT_EQ(s.process_count, 60);
+				ASSERT_EQ(s.used_memory, 200);
+				ASSERT_EQ(s.total_memory, 201);
+				ASSERT_EQ(s.total_disk_read, 202);
+				ASSERT_EQ(s.total_disk_write, 203);
+			}
+
 			int main(int argc, char* argv[]) {
 				::testing::InitGoogleTest(&argc, argv);
 				int val = RUN_ALL_TESTS();
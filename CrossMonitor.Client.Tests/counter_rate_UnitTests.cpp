@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+
+#include <counter_rate.hpp>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace utils {
+
+			static counter_rate::clock::time_point at(double seconds) {
+				return counter_rate::clock::time_point() +
+					chrono::duration_cast<counter_rate::clock::duration>(
+						chrono::duration<double>(seconds));
+			}
+
+			TEST(CrossMonitorCounterRate, Rates) {
+				counter_rate counter;
+				ASSERT_EQ(counter.update(1000, at(1)), counter_change::first);
+				ASSERT_EQ(counter.delta(), 0u);
+				ASSERT_DOUBLE_EQ(counter.rate(), 0);
+
+				ASSERT_EQ(counter.update(1500, at(3)), counter_change::increased);
+				ASSERT_EQ(counter.delta(), 500u);
+				ASSERT_DOUBLE_EQ(counter.rate(), 250);
+
+				// Unchanged
+				ASSERT_EQ(counter.update(1500, at(4)), counter_change::increased);
+				ASSERT_DOUBLE_EQ(counter.rate(), 0);
+
+				// Missed samples only make the interval longer
+				ASSERT_EQ(counter.update(11500, at(14)), counter_change::increased);
+				ASSERT_DOUBLE_EQ(counter.rate(), 1000);
+
+				// Not newer than the previous reading
+				ASSERT_EQ(counter.update(20000, at(14)), counter_change::repeated);
+				ASSERT_DOUBLE_EQ(counter.rate(), 1000);
+				ASSERT_EQ(counter.update(11600, at(15)), counter_change::increased);
+				ASSERT_DOUBLE_EQ(counter.rate(), 100);
+			}
+
+			TEST(CrossMonitorCounterRate, Wraps) {
+				counter_rate counter(UINT_MAX);
+				counter.update(UINT_MAX - 99ull, at(0));
+				ASSERT_EQ(counter.update(100, at(1)), counter_change::wrapped);
+				ASSERT_EQ(counter.delta(), 200u);
+				ASSERT_DOUBLE_EQ(counter.rate(), 200);
+
+				// Far from the top: a reset, not a wrap
+				ASSERT_EQ(counter.update(1000000, at(2)), counter_change::increased);
+				ASSERT_EQ(counter.update(10, at(3)), counter_change::reset);
+				ASSERT_EQ(counter.delta(), 0u);
+
+				// 64 bits counters wrap the same way
+				counter_rate wide;
+				wide.update(ULLONG_MAX - 9, at(0));
+				ASSERT_EQ(wide.update(10, at(1)), counter_change::wrapped);
+				ASSERT_EQ(wide.delta(), 20u);
+			}
+
+			TEST(CrossMonitorCounterRate, Resets) {
+				counter_rate counter;
+				counter.update(5000000, at(0));
+				// Rebooted: a new baseline, no rate
+				ASSERT_EQ(counter.update(300, at(1)), counter_change::reset);
+				ASSERT_EQ(counter.delta(), 0u);
+				ASSERT_DOUBLE_EQ(counter.rate(), 0);
+				ASSERT_EQ(counter.update(400, at(2)), counter_change::increased);
+				ASSERT_DOUBLE_EQ(counter.rate(), 100);
+
+				// Reopened: the jump up is not a spike
+				ASSERT_EQ(counter.update(900000000, at(3), 1), counter_change::reset);
+				ASSERT_DOUBLE_EQ(counter.rate(), 0);
+				ASSERT_EQ(counter.update(900000100, at(4), 1), counter_change::increased);
+				ASSERT_DOUBLE_EQ(counter.rate(), 100);
+
+				counter.restart();
+				ASSERT_EQ(counter.update(0, at(5), 1), counter_change::first);
+				ASSERT_EQ(counter.update(50, at(6), 1), counter_change::increased);
+				ASSERT_DOUBLE_EQ(counter.rate(), 50);
+			}
+
+			TEST(CrossMonitorCounterRate, TakeRate) {
+				counter_rate counter;
+				ASSERT_DOUBLE_EQ(counter.take_rate(), 0);
+				counter.update(0, at(0));
+				counter.update(100, at(1));
+				// The reset interval counts neither its change nor its time
+				counter.update(5, at(2));
+				counter.update(405, at(4));
+				ASSERT_DOUBLE_EQ(counter.take_rate(), 500.0 / 3);
+				ASSERT_DOUBLE_EQ(counter.take_rate(), 0);
+
+				counter.update(505, at(5));
+				// Restarting keeps what was counted
+				counter.restart();
+				counter.update(0, at(6));
+				ASSERT_DOUBLE_EQ(counter.take_rate(), 100);
+			}
+
+		}
+	}
+}
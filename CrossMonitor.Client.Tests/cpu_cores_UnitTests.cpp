@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+
+#include <cpu_cores.hpp>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static void set(os::core_ticks& ticks, size_t cpu,
+				unsigned long long user, unsigned long long system,
+				unsigned long long idle, unsigned long long iowait = 0,
+				unsigned long long steal = 0) {
+				if (ticks.size() <= cpu) {
+					ticks.resize(cpu + 1);
+				}
+				ticks.user[cpu] = user;
+				ticks.system[cpu] = system;
+				ticks.idle[cpu] = idle;
+				ticks.iowait[cpu] = iowait;
+				ticks.steal[cpu] = steal;
+			}
+
+			TEST(CrossMonitorCpuCores, Deltas) {
+				os::core_ticks previous, current;
+				set(previous, 0, 100, 100, 100, 100, 100);
+				set(previous, 1, 0, 0, 0);
+				set(current, 0, 150, 110, 120, 110, 110);
+				set(current, 1, 0, 0, 0);
+
+				core_usage usage;
+				cpu_cores::compute(previous, current, usage);
+				ASSERT_EQ(usage.size(), 2u);
+				ASSERT_FLOAT_EQ(usage.user[0], 50);
+				ASSERT_FLOAT_EQ(usage.system[0], 10);
+				ASSERT_FLOAT_EQ(usage.iowait[0], 10);
+				ASSERT_FLOAT_EQ(usage.steal[0], 10);
+				// iowait counts as idle
+				ASSERT_FLOAT_EQ(usage.busy[0], 70);
+				// No time passed
+				ASSERT_FLOAT_EQ(usage.busy[1], 0);
+			}
+
+			TEST(CrossMonitorCpuCores, Summary) {
+				os::core_ticks previous, current;
+				for (size_t cpu = 0; cpu < 4; ++cpu) {
+					set(previous, cpu, 0, 0, 0);
+					set(current, cpu, 0, 0, 100);
+				}
+				set(current, 2, 100, 0, 0);
+
+				core_usage usage;
+				cpu_cores::compute(previous, current, usage);
+				ASSERT_FLOAT_EQ(usage.max_busy, 100);
+				ASSERT_FLOAT_EQ(usage.mean_busy, 25);
+				ASSERT_FLOAT_EQ(usage.imbalance, 75);
+				ASSERT_EQ(usage.busiest, 2u);
+			}
+
+			TEST(CrossMonitorCpuCores, CountersFromZero) {
+				os::core_ticks previous, current;
+				set(previous, 0, 1000, 1000, 1000, 500);
+				// iowait went backwards: unchanged, not its whole value
+				set(current, 0, 1100, 1000, 1300, 400);
+
+				core_usage usage;
+				cpu_cores::compute(previous, current, usage);
+				ASSERT_FLOAT_EQ(usage.user[0], 25);
+				ASSERT_FLOAT_EQ(usage.system[0], 0);
+				ASSERT_FLOAT_EQ(usage.iowait[0], 0);
+				ASSERT_FLOAT_EQ(usage.busy[0], 25);
+
+				// idle jittered backwards: unchanged
+				set(current, 0, 1100, 1100, 990, 500);
+				cpu_cores::compute(previous, current, usage);
+				ASSERT_FLOAT_EQ(usage.user[0], 50);
+				ASSERT_FLOAT_EQ(usage.busy[0], 100);
+
+				// A CPU added: every counter counts from zero
+				set(current, 0, 30, 10, 60);
+				set(current, 1, 50, 0, 50);
+				cpu_cores::compute(previous, current, usage);
+				ASSERT_EQ(usage.size(), 2u);
+				ASSERT_FLOAT_EQ(usage.busy[0], 40);
+				ASSERT_FLOAT_EQ(usage.busy[1], 50);
+
+				// No CPUs at all
+				cpu_cores::compute(previous, os::core_ticks(), usage);
+				ASSERT_EQ(usage.size(), 0u);
+				ASSERT_FLOAT_EQ(usage.max_busy, 0);
+				ASSERT_FLOAT_EQ(usage.mean_busy, 0);
+			}
+
+			TEST(CrossMonitorCpuCores, Sample) {
+				cpu_cores cores;
+				core_usage usage;
+				ASSERT_TRUE(cores.sample(usage));
+				ASSERT_GT(usage.size(), 0u);
+				ASSERT_TRUE(cores.sample(usage));
+				for (size_t cpu = 0; cpu < usage.size(); ++cpu) {
+					ASSERT_GE(usage.busy[cpu], 0);
+					ASSERT_LE(usage.busy[cpu], 100.01f);
+				}
+				ASSERT_LT(usage.busiest, usage.size());
+			}
+
+			TEST(CrossMonitorCpuCores, Json) {
+				core_usage usage;
+				usage.busy = { 12.6f, 0.2f };
+				usage.user = { 10, 0 };
+				usage.system = { 2.6f, 0.2f };
+				usage.iowait = { 0, 0 };
+				usage.steal = { 0, 0 };
+				usage.max_busy = 12.5f;
+				usage.mean_busy = 6.25f;
+				usage.imbalance = 6.25f;
+				json_writer writer;
+				usage.write(writer);
+				ASSERT_EQ(writer.str(),
+					"{\"cpus\":2,\"max_busy\":12.5,\"mean_busy\":6.25,"
+					"\"imbalance\":6.25,\"busiest\":0,\"busy\":[13,0],"
+					"\"user\":[10,0],\"system\":[3,0],\"iowait\":[0,0],"
+					"\"steal\":[0,0]}");
+			}
+
+		}
+	}
+}
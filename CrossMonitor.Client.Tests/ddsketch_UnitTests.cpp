@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <ddsketch.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace utils {
+
+			static double exact_quantile(vector<double> values, double q) {
+				sort(values.begin(), values.end());
+				return values[static_cast<size_t>(q * (values.size() - 1))];
+			}
+
+			TEST(CrossMonitorDDSketch, InvalidArguments) {
+				ASSERT_THROW(ddsketch s(0), std::invalid_argument);
+				ASSERT_THROW(ddsketch s(1), std::invalid_argument);
+				ASSERT_THROW(ddsketch s(0.01, 0), std::invalid_argument);
+				ddsketch a(0.01);
+				ddsketch b(0.02);
+				ASSERT_THROW(a.merge(b), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorDDSketch, Empty) {
+				ddsketch s;
+				ASSERT_TRUE(s.empty());
+				ASSERT_EQ(s.quantile(0.5), 0);
+				ASSERT_EQ(s.min(), 0);
+				ASSERT_EQ(s.max(), 0);
+				ASSERT_GT(s.min_key(), s.max_key());
+			}
+
+			TEST(CrossMonitorDDSketch, ZerosAndInvalidValues) {
+				ddsketch s;
+				s.add(0);
+				s.add(-5);
+				s.add(numeric_limits<double>::quiet_NaN());
+				s.add(numeric_limits<double>::infinity());
+				s.add(100);
+				ASSERT_EQ(s.count(), 3u);
+				ASSERT_EQ(s.zero_count(), 2u);
+				ASSERT_EQ(s.quantile(0), 0);
+				ASSERT_EQ(s.quantile(0.5), 0);
+				ASSERT_EQ(s.quantile(1), 100);
+				ASSERT_EQ(s.min(), 0);
+				ASSERT_EQ(s.max(), 100);
+			}
+
+			TEST(CrossMonitorDDSketch, RelativeError) {
+				const double accuracy = 0.01;
+				ddsketch s(accuracy);
+				mt19937 random(42);
+				lognormal_distribution<double> distribution(10, 3);
+				vector<double> values;
+				for (int i = 0; i < 100000; ++i) {
+					const double v = distribution(random);
+					values.push_back(v);
+					s.add(v);
+				}
+				ASSERT_EQ(s.count(), values.size());
+				for (double q : { 0.0, 0.01, 0.25, 0.5, 0.75, 0.95, 0.99, 0.999, 1.0 }) {
+					const double expected = exact_quantile(values, q);
+					ASSERT_NEAR(s.quantile(q), expected, expected * accuracy) << q;
+				}
+			}
+
+			TEST(CrossMonitorDDSketch, Merge) {
+				mt19937 random(7);
+				uniform_real_distribution<double> low(1, 100);
+				uniform_real_distribution<double> high(1e6, 1e9);
+				ddsketch a;
+				ddsketch b;
+				ddsketch both;
+				for (int i = 0; i < 10000; ++i) {
+					const double x = low(random);
+					const double y = high(random);
+					a.add(x);
+					b.add(y);
+					both.add(x);
+					both.add(y);
+				}
+				b.add(0);
+				both.add(0);
+				a.merge(b);
+				ASSERT_EQ(a.count(), both.count());
+				ASSERT_EQ(a.zero_count(), both.zero_count());
+				ASSERT_EQ(a.min(), both.min());
+				ASSERT_EQ(a.max(), both.max());
+				for (int k = both.min_key(); k <= both.max_key(); ++k) {
+					ASSERT_EQ(a.bin(k), both.bin(k)) << k;
+				}
+				for (double q : { 0.1, 0.5, 0.9, 0.99 }) {
+					ASSERT_EQ(a.quantile(q), both.quantile(q)) << q;
+				}
+
+				a.merge(a);
+				ASSERT_EQ(a.count(), 2 * both.count());
+				ASSERT_EQ(a.quantile(0.99), both.quantile(0.99));
+			}
+
+			TEST(CrossMonitorDDSketch, BoundedBins) {
+				// 64 bins of 2% cover a range of about 3.5x, far less than
+				// the values span: the low ones collapse, the high
+				// quantiles keep their accuracy.
+				const double accuracy = 0.01;
+				ddsketch s(accuracy, 64);
+				vector<double> values;
+				for (int i = 1; i <= 10000; ++i) {
+					values.push_back(i);
+				}
+				// Descending and ascending runs make the window move both ways
+				for (auto it = values.rbegin(); it != values.rend(); ++it) {
+					s.add(*it);
+				}
+				for (double v : values) {
+					s.add(v);
+				}
+				ASSERT_LE(s.max_key() - s.min_key(), 63);
+				ASSERT_EQ(s.count(), 20000u);
+				for (double q : { 0.9, 0.95, 0.99 }) {
+					const double expected = exact_quantile(values, q);
+					ASSERT_NEAR(s.quantile(q), expected, expected * accuracy) << q;
+				}
+				ASSERT_EQ(s.quantile(1), 10000);
+			}
+
+			TEST(CrossMonitorDDSketch, WeightedAdd) {
+				ddsketch weighted;
+				ddsketch repeated;
+				for (int v = 1; v <= 100; ++v) {
+					weighted.add(v, 3);
+					for (int i = 0; i < 3; ++i) {
+						repeated.add(v);
+					}
+				}
+				weighted.add(0, 5);
+				repeated.add(0, 5);
+				weighted.add(50, 0);
+				ASSERT_EQ(weighted.count(), 305u);
+				ASSERT_EQ(weighted.zero_count(), 5u);
+				for (const double q : { 0.0, 0.1, 0.5, 0.95, 1.0 }) {
+					ASSERT_EQ(weighted.quantile(q), repeated.quantile(q)) << q;
+				}
+			}
+
+			TEST(CrossMonitorDDSketch, Clear) {
+				ddsketch s;
+				s.add(10);
+				s.add(0);
+				s.clear();
+				ASSERT_TRUE(s.empty());
+				ASSERT_EQ(s.zero_count(), 0u);
+				ASSERT_EQ(s.bin(s.max_key()), 0u);
+				s.add(1000);
+				ASSERT_EQ(s.count(), 1u);
+				ASSERT_EQ(s.quantile(0.5), 1000);
+			}
+
+		}
+	}
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+
+#include <delta_frame.hpp>
+#include <json_writer.hpp>
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static record test_record(unsigned i, float cpu,
+				unsigned long long used, unsigned long long read) {
+				return record(1500000000000ull + i * 1000ull,
+					data(cpu, used, 1ull << 33, 200, read, 4096ull * i), 1000);
+			}
+
+			static unsigned bit(size_t index) {
+				return 1u << index;
+			}
+
+			TEST(CrossMonitorDeltaFrame, InvalidOptions) {
+				delta_options options;
+				options.keyframe_every = 0;
+				ASSERT_THROW(delta_encoder e{ options }, std::invalid_argument);
+
+				options = delta_options();
+				ASSERT_THROW(options.set_deadband("cpu", 1), std::invalid_argument);
+				ASSERT_THROW(options.set_deadband("cpu_percent", -1), std::invalid_argument);
+				options.set_deadband("cpu_percent", 2.5);
+				const size_t cpu = field_index<fields::cpu_percent, data_fields>::value;
+				ASSERT_EQ(options.deadbands[cpu], 2.5);
+
+				delta_decoder decoder;
+				delta_frame frame;
+				frame.keyframe = false;
+				ASSERT_THROW(decoder.decode(frame), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorDeltaFrame, OnlyChangedFields) {
+				delta_options options;
+				options.keyframe_every = 4;
+				delta_encoder encoder(options);
+				delta_frame frame;
+
+				encoder.encode(test_record(0, 10, 5000, 100), frame);
+				ASSERT_TRUE(frame.keyframe);
+				ASSERT_EQ(frame.mask, bit(data_fields::size) - 1);
+
+				encoder.encode(test_record(1, 10, 5000, 150), frame);
+				ASSERT_FALSE(frame.keyframe);
+				const size_t read = field_index<fields::total_disk_read, data_fields>::value;
+				const size_t write = field_index<fields::total_disk_write, data_fields>::value;
+				ASSERT_EQ(frame.mask, bit(read) | bit(write));
+				// Counters as changes
+				ASSERT_EQ(get<read>(frame.values), 50u);
+				ASSERT_EQ(get<write>(frame.values), 4096u);
+
+				encoder.encode(test_record(2, 10, 5000, 150), frame);
+				encoder.encode(test_record(3, 10, 5000, 150), frame);
+				ASSERT_EQ(frame.mask, bit(write));
+				encoder.encode(test_record(4, 10, 5000, 150), frame);
+				ASSERT_TRUE(frame.keyframe);
+
+				encoder.encode(test_record(5, 10, 5000, 150), frame);
+				ASSERT_FALSE(frame.keyframe);
+				encoder.reset();
+				encoder.encode(test_record(6, 10, 5000, 150), frame);
+				ASSERT_TRUE(frame.keyframe);
+			}
+
+			TEST(CrossMonitorDeltaFrame, ExactRoundTrip) {
+				delta_options options;
+				options.keyframe_every = 16;
+				delta_encoder encoder(options);
+				delta_decoder decoder;
+				delta_frame frame;
+
+				unsigned long long read = 0xfffffffffffff000ull;
+				for (unsigned i = 0; i < 40; ++i) {
+					// The read counter wraps, then is reset
+					read = i == 30 ? 7 : read + 1024 * (i % 3);
+					record r = test_record(i, static_cast<float>(i % 5) * 0.1f,
+						5000 + (i / 4), read);
+					r.stale = i % 6 == 1 ? 8 : 0;
+					encoder.encode(r, frame);
+					const record rebuilt = decoder.decode(frame);
+					ASSERT_EQ(rebuilt.timestamp, r.timestamp);
+					ASSERT_EQ(rebuilt.period_ms, r.period_ms);
+					ASSERT_EQ(rebuilt.stale, r.stale);
+					ASSERT_EQ(rebuilt.sample.get_cpu_percent(), r.sample.get_cpu_percent());
+					ASSERT_EQ(rebuilt.sample.get_used_memory(), r.sample.get_used_memory());
+					ASSERT_EQ(rebuilt.sample.get_total_memory(), r.sample.get_total_memory());
+					ASSERT_EQ(rebuilt.sample.get_process_count(), r.sample.get_process_count());
+					ASSERT_EQ(rebuilt.sample.get_total_disk_read(), r.sample.get_total_disk_read());
+					ASSERT_EQ(rebuilt.sample.get_total_disk_write(), r.sample.get_total_disk_write());
+				}
+			}
+
+			TEST(CrossMonitorDeltaFrame, DeadbandBoundsError) {
+				delta_options options;
+				options.keyframe_every = 1000;
+				options.set_deadband("cpu_percent", 1);
+				options.set_deadband("used_memory_in_bytes", 4096);
+				delta_encoder encoder(options);
+				delta_decoder decoder;
+				delta_frame frame;
+
+				unsigned sent = 0;
+				for (unsigned i = 0; i < 200; ++i) {
+					// A slow drift is sent once it adds up past the dead-band
+					const record r = test_record(i, 10 + 0.05f * i, 100000 + 100ull * i, 0);
+					encoder.encode(r, frame);
+					const size_t cpu = field_index<fields::cpu_percent, data_fields>::value;
+					if (!frame.keyframe && (frame.mask & bit(cpu))) {
+						++sent;
+					}
+					const record rebuilt = decoder.decode(frame);
+					ASSERT_LE(abs(rebuilt.sample.get_cpu_percent() - r.sample.get_cpu_percent()), 1.0f);
+					ASSERT_LE(r.sample.get_used_memory() - rebuilt.sample.get_used_memory(), 4096u);
+				}
+				ASSERT_GE(sent, 8u);
+				ASSERT_LE(sent, 10u);
+			}
+
+			TEST(CrossMonitorDeltaFrame, Json) {
+				delta_options options;
+				options.keyframe_every = 2;
+				delta_encoder encoder(options);
+				delta_frame frame;
+				json_writer keyframe;
+				json_writer plain;
+				json_writer delta;
+
+				const record first = test_record(0, 10, 5000, 100);
+				encoder.encode(first, frame);
+				keyframe.write(frame);
+				plain.write(first);
+				// Keyframes are the plain records
+				ASSERT_EQ(keyframe.str(), plain.str());
+
+				// A counter reset goes as a negative change
+				encoder.encode(test_record(1, 10, 6000, 40), frame);
+				delta.write(frame);
+				ASSERT_EQ(delta.str(), "{\"timestamp\":1500000001000,\"period_ms\":1000,\"delta\":1,"
+					"\"total_disk_read\":-60,\"total_disk_write\":4096,\"used_memory_in_bytes\":6000}");
+			}
+
+		}
+	}
+}
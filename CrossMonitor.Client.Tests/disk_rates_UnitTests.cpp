@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <disk_rates.hpp>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static disk_reading reading(double seconds, unsigned long long bytes,
+				unsigned long long operations, unsigned generation = 0) {
+				disk_reading r;
+				r.time = chrono::steady_clock::time_point() +
+					chrono::duration_cast<chrono::steady_clock::duration>(
+						chrono::duration<double>(seconds));
+				r.read_bytes = bytes;
+				r.write_bytes = bytes / 2;
+				r.reads = operations;
+				r.writes = operations / 2;
+				r.generation = generation;
+				return r;
+			}
+
+			TEST(CrossMonitorDiskRates, Rates) {
+				disk_rates rates;
+				disk_usage usage;
+				rates.update(reading(0, 1000000, 1000));
+				rates.update(reading(1, 1100000, 1100));
+				rates.update(reading(2, 1300000, 1300));
+				rates.take(usage);
+				ASSERT_DOUBLE_EQ(usage.read_bytes, 150000);
+				ASSERT_DOUBLE_EQ(usage.write_bytes, 75000);
+				ASSERT_DOUBLE_EQ(usage.reads, 150);
+				ASSERT_DOUBLE_EQ(usage.writes, 75);
+				ASSERT_EQ(usage.resets, 0u);
+
+				// Nothing since the previous take
+				rates.take(usage);
+				ASSERT_DOUBLE_EQ(usage.read_bytes, 0);
+			}
+
+			TEST(CrossMonitorDiskRates, NoSpikes) {
+				disk_rates rates;
+				disk_usage usage;
+				rates.update(reading(0, 1000000, 1000));
+				rates.update(reading(1, 1001000, 1010));
+				// A disk added, its lifetime counters join the sums
+				rates.update(reading(2, 900000000, 90000, 1));
+				rates.update(reading(3, 900001000, 90010, 1));
+				// Counters restarted
+				rates.update(reading(4, 0, 0, 1));
+				rates.update(reading(5, 1000, 10, 1));
+				rates.take(usage);
+				ASSERT_DOUBLE_EQ(usage.read_bytes, 1000);
+				ASSERT_DOUBLE_EQ(usage.reads, 10);
+				ASSERT_EQ(usage.resets, 2u);
+
+				rates.restart();
+				rates.update(reading(100, 0, 0));
+				rates.take(usage);
+				ASSERT_DOUBLE_EQ(usage.read_bytes, 0);
+				ASSERT_EQ(usage.resets, 0u);
+			}
+
+			TEST(CrossMonitorDiskRates, Json) {
+				disk_usage usage;
+				usage.read_bytes = 1500.4;
+				usage.write_bytes = 99.6;
+				usage.reads = 2.5;
+				usage.resets = 1;
+				json_writer writer;
+				usage.write(writer);
+				ASSERT_EQ(writer.str(),
+					"{\"read_bytes\":1500,\"write_bytes\":100,\"reads\":3,"
+					"\"writes\":0,\"resets\":1}");
+			}
+
+		}
+	}
+}
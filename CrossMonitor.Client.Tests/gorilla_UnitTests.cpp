@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+
+#include <gorilla.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace utils {
+
+			static const unsigned widths[3] = { 7, 9, 12 };
+
+			TEST(CrossMonitorGorilla, Bits) {
+				unsigned char buffer[16];
+				bit_writer writer(buffer, sizeof(buffer));
+				writer.write(1, 1);
+				writer.write(0x2a, 7);
+				writer.write(0x123456789abcdef0ull, 64);
+				writer.write(5, 3);
+				ASSERT_EQ(writer.bits(), 75u);
+				ASSERT_EQ(writer.bytes(), 10u);
+
+				bit_reader reader(buffer, writer.bits());
+				uint64_t v = 0;
+				ASSERT_TRUE(reader.read(1, v));
+				ASSERT_EQ(v, 1u);
+				ASSERT_TRUE(reader.read(7, v));
+				ASSERT_EQ(v, 0x2au);
+				ASSERT_TRUE(reader.read(64, v));
+				ASSERT_EQ(v, 0x123456789abcdef0ull);
+				ASSERT_TRUE(reader.read(3, v));
+				ASSERT_EQ(v, 5u);
+				ASSERT_FALSE(reader.read(1, v));
+			}
+
+			TEST(CrossMonitorGorilla, RegularTimestamps) {
+				vector<unsigned char> buffer(1024);
+				bit_writer writer(buffer.data(), buffer.size());
+				delta_encoder encoder(widths);
+				const uint64_t start = 1500000000000ull;
+				for (uint64_t i = 0; i < 1000; ++i) {
+					encoder.write(writer, start + i * 1000);
+				}
+				// Whole first value, one bucket for the first delta, then
+				// one bit per timestamp
+				ASSERT_EQ(writer.bits(), 64u + 4 + 12 + 998);
+
+				bit_reader reader(buffer.data(), writer.bits());
+				delta_decoder decoder(widths);
+				for (uint64_t i = 0; i < 1000; ++i) {
+					uint64_t v = 0;
+					ASSERT_TRUE(decoder.read(reader, v));
+					ASSERT_EQ(v, start + i * 1000);
+				}
+				uint64_t v = 0;
+				ASSERT_FALSE(decoder.read(reader, v));
+			}
+
+			TEST(CrossMonitorGorilla, DeltaBuckets) {
+				const vector<uint64_t> values{
+					0, 5, 3, 200, 100000, 0, numeric_limits<uint64_t>::max(),
+					7, 7, 7, 1ull << 40, 2
+				};
+				vector<unsigned char> buffer(256);
+				bit_writer writer(buffer.data(), buffer.size());
+				delta_encoder encoder(widths);
+				for (const auto v : values) {
+					encoder.write(writer, v);
+				}
+				bit_reader reader(buffer.data(), writer.bits());
+				delta_decoder decoder(widths);
+				for (const auto expected : values) {
+					uint64_t v = 0;
+					ASSERT_TRUE(decoder.read(reader, v));
+					ASSERT_EQ(v, expected);
+				}
+			}
+
+			TEST(CrossMonitorGorilla, Floats) {
+				const vector<float> values{
+					12.5f, 12.5f, 12.75f, 0, 100, 3.14159f, -1,
+					numeric_limits<float>::min(), 99.9f, 99.9f
+				};
+				vector<unsigned char> buffer(256);
+				bit_writer writer(buffer.data(), buffer.size());
+				xor_encoder encoder;
+				for (const auto v : values) {
+					encoder.write(writer, v);
+				}
+				bit_reader reader(buffer.data(), writer.bits());
+				xor_decoder decoder;
+				for (const auto expected : values) {
+					float v = 0;
+					ASSERT_TRUE(decoder.read(reader, v));
+					ASSERT_EQ(v, expected);
+				}
+				float v = 0;
+				ASSERT_FALSE(decoder.read(reader, v));
+			}
+
+			TEST(CrossMonitorGorilla, RepeatedFloatsTakeOneBit) {
+				vector<unsigned char> buffer(64);
+				bit_writer writer(buffer.data(), buffer.size());
+				xor_encoder encoder;
+				for (int i = 0; i < 100; ++i) {
+					encoder.write(writer, 42.5f);
+				}
+				ASSERT_EQ(writer.bits(), 32u + 99);
+			}
+
+		}
+	}
+}
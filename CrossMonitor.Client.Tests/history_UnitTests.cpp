@@ -0,0 +1,324 @@
+#include <gtest/gtest.h>
+
+#include <history.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static string history_path(const char* name) {
+				const boost::filesystem::path path =
+					boost::filesystem::temp_directory_path() / name;
+				boost::filesystem::remove(path);
+				return path.string();
+			}
+
+			static const unsigned long long start = 1500000000000ull;
+
+			/**
+			 * A busy host sampled every second, with jitter on the timestamps.
+			 */
+			class sample_source final {
+			public:
+				record next() {
+					timestamp_ += 1000 + jitter_(random_);
+					cpu_ = min(100.0f, max(0.0f, cpu_ + change_(random_) / 10.0f));
+					used_ += static_cast<long long>(change_(random_)) * 4096 * 16;
+					processes_ += static_cast<unsigned>(change_(random_) > 8 ? 1 : 0);
+					read_ += static_cast<unsigned long long>(bytes_(random_)) * 4096;
+					write_ += static_cast<unsigned long long>(bytes_(random_)) * 512;
+					return record(timestamp_, data(cpu_, used_, 16ull << 30,
+						processes_, read_, write_));
+				}
+
+			private:
+				mt19937 random_{ 42 };
+				uniform_int_distribution<int> jitter_{ 0, 3 };
+				uniform_int_distribution<int> change_{ -10, 10 };
+				uniform_int_distribution<int> bytes_{ 0, 256 };
+				unsigned long long timestamp_ = start;
+				float cpu_ = 20;
+				unsigned long long used_ = 8ull << 30;
+				unsigned processes_ = 200;
+				unsigned long long read_ = 1ull << 30;
+				unsigned long long write_ = 1ull << 29;
+			};
+
+			static void expect_equal(const record& a, const record& b) {
+				ASSERT_EQ(a.timestamp, b.timestamp);
+				ASSERT_EQ(a.sample.get_cpu_percent(), b.sample.get_cpu_percent());
+				ASSERT_EQ(a.sample.get_used_memory(), b.sample.get_used_memory());
+				ASSERT_EQ(a.sample.get_total_memory(), b.sample.get_total_memory());
+				ASSERT_EQ(a.sample.get_process_count(), b.sample.get_process_count());
+				ASSERT_EQ(a.sample.get_total_disk_read(), b.sample.get_total_disk_read());
+				ASSERT_EQ(a.sample.get_total_disk_write(), b.sample.get_total_disk_write());
+			}
+
+			TEST(CrossMonitorHistory, InvalidArguments) {
+				const string path = history_path("crossmonitor_invalid.history");
+				ASSERT_THROW(history h(path, 0), std::invalid_argument);
+				ASSERT_THROW(history h(path, 1), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorHistory, PushQuery) {
+				history h(history_path("crossmonitor_query.history"), 64);
+				sample_source source;
+				vector<record> pushed;
+				for (int i = 0; i < 3000; ++i) {
+					pushed.push_back(source.next());
+					h.push(pushed.back());
+				}
+				ASSERT_GT(h.blocks(), 1u);
+				ASSERT_EQ(h.size(), 3000u);
+				ASSERT_EQ(h.first_timestamp(), pushed.front().timestamp);
+				ASSERT_EQ(h.last_timestamp(), pushed.back().timestamp);
+
+				// Everything, from the file and the block being filled
+				vector<record> out;
+				ASSERT_EQ(h.query(0, ~0ull, out), 3000u);
+				for (size_t i = 0; i < out.size(); ++i) {
+					expect_equal(out[i], pushed[i]);
+				}
+
+				// A range spanning blocks, bounds included
+				out.clear();
+				ASSERT_EQ(h.query(pushed[1000].timestamp, pushed[2499].timestamp,
+					out), 1500u);
+				expect_equal(out.front(), pushed[1000]);
+				expect_equal(out.back(), pushed[2499]);
+
+				out.clear();
+				ASSERT_EQ(h.query(0, start, out), 0u);
+			}
+
+			TEST(CrossMonitorHistory, Reopen) {
+				const string path = history_path("crossmonitor_reopen.history");
+				sample_source source;
+				vector<record> pushed;
+				{
+					history h(path, 64);
+					for (int i = 0; i < 1000; ++i) {
+						pushed.push_back(source.next());
+						h.push(pushed.back());
+					}
+				}
+				history h(path, 64);
+				ASSERT_EQ(h.size(), 1000u);
+				for (int i = 0; i < 1000; ++i) {
+					pushed.push_back(source.next());
+					h.push(pushed.back());
+				}
+				vector<record> out;
+				ASSERT_EQ(h.query(0, ~0ull, out), 2000u);
+				for (size_t i = 0; i < out.size(); ++i) {
+					expect_equal(out[i], pushed[i]);
+				}
+			}
+
+			TEST(CrossMonitorHistory, OverwritesOldest) {
+				history h(history_path("crossmonitor_wrap.history"), 4);
+				sample_source source;
+				vector<record> pushed;
+				for (int i = 0; i < 5000; ++i) {
+					pushed.push_back(source.next());
+					h.push(pushed.back());
+				}
+				ASSERT_EQ(h.blocks(), 4u);
+				ASSERT_LT(h.size(), 5000u);
+
+				// The newest samples, in order
+				vector<record> out;
+				ASSERT_EQ(h.query(0, ~0ull, out), h.size());
+				ASSERT_EQ(out.front().timestamp, h.first_timestamp());
+				const size_t first = pushed.size() - out.size();
+				for (size_t i = 0; i < out.size(); ++i) {
+					expect_equal(out[i], pushed[first + i]);
+				}
+			}
+
+			TEST(CrossMonitorHistory, SkipsCorruptBlock) {
+				const string path = history_path("crossmonitor_corrupt.history");
+				sample_source source;
+				vector<record> pushed;
+				{
+					history h(path, 64);
+					for (int i = 0; i < 2000; ++i) {
+						pushed.push_back(source.next());
+						h.push(pushed.back());
+					}
+				}
+				{
+					// Flip a byte in the streams of the first block
+					fstream f(path, ios::in | ios::out | ios::binary);
+					f.seekp(4096 + 100);
+					f.put('\x5a');
+				}
+				history h(path, 64);
+				ASSERT_EQ(h.corrupted(), 1u);
+				vector<record> out;
+				h.query(0, ~0ull, out);
+				ASSERT_FALSE(out.empty());
+				ASSERT_GT(out.front().timestamp, pushed.front().timestamp);
+				expect_equal(out.back(), pushed.back());
+			}
+
+			TEST(CrossMonitorHistory, CapacityChangeStartsOver) {
+				const string path = history_path("crossmonitor_resize.history");
+				{
+					history h(path, 16);
+					h.push(record(start, data(1, 2, 3, 4, 5, 6)));
+				}
+				history h(path, 32);
+				ASSERT_EQ(h.size(), 0u);
+				ASSERT_EQ(h.capacity(), 32u);
+			}
+
+			/**
+			 * Buckets computed from the decoded records.
+			 */
+			static vector<history_bucket> expected_buckets(const vector<record>& records,
+				double(*get)(const data&), unsigned long long from,
+				unsigned long long step) {
+				vector<history_bucket> buckets;
+				vector<double> values;
+				for (size_t i = 0; i < records.size(); ++i) {
+					const double v = get(records[i].sample);
+					const unsigned long long start =
+						from + (records[i].timestamp - from) / step * step;
+					if (buckets.empty() || buckets.back().start != start) {
+						buckets.emplace_back();
+						buckets.back().start = start;
+						buckets.back().min = buckets.back().max = v;
+					}
+					history_bucket& b = buckets.back();
+					++b.count;
+					b.min = min(b.min, v);
+					b.max = max(b.max, v);
+					b.avg += v;
+				}
+				for (auto& b : buckets) {
+					b.avg /= b.count;
+				}
+				return buckets;
+			}
+
+			static double cpu(const data& d) {
+				return d.get_cpu_percent();
+			}
+
+			static double total_memory(const data& d) {
+				return static_cast<double>(d.get_total_memory());
+			}
+
+			TEST(CrossMonitorHistory, Buckets) {
+				history h(history_path("crossmonitor_buckets.history"), 64);
+				sample_source source;
+				for (int i = 0; i < 3000; ++i) {
+					h.push(source.next());
+				}
+				vector<record> records;
+				const unsigned long long from = start + 100000;
+				const unsigned long long to = start + 2900000;
+				h.query(from, to, records);
+
+				const struct {
+					const char* name;
+					double(*get)(const data&);
+				} fields[] = { { "cpu_percent", cpu },
+					// Constant: whole blocks aggregated from their header
+					{ "total_memory_in_bytes", total_memory } };
+				// Buckets shorter and longer than a block
+				for (const unsigned long long step : { 60000ull, 1800000ull }) {
+					for (const auto& field : fields) {
+						vector<history_bucket> buckets;
+						const size_t n = h.query(field.name, from, to, step, buckets);
+						const vector<history_bucket> expected =
+							expected_buckets(records, field.get, from, step);
+						ASSERT_EQ(n, expected.size()) << field.name;
+						ASSERT_EQ(buckets.size(), expected.size());
+						for (size_t i = 0; i < buckets.size(); ++i) {
+							ASSERT_EQ(buckets[i].start, expected[i].start);
+							ASSERT_EQ(buckets[i].count, expected[i].count);
+							ASSERT_EQ(buckets[i].min, expected[i].min);
+							ASSERT_EQ(buckets[i].max, expected[i].max);
+							ASSERT_NEAR(buckets[i].avg, expected[i].avg,
+								expected[i].avg * 1e-12);
+							ASSERT_GE(buckets[i].p95, buckets[i].min * 0.99);
+							ASSERT_LE(buckets[i].p95, buckets[i].max * 1.01);
+						}
+					}
+				}
+			}
+
+			TEST(CrossMonitorHistory, InvalidQueries) {
+				history h(history_path("crossmonitor_badquery.history"), 4);
+				vector<history_bucket> buckets;
+				ASSERT_THROW(h.query("nope", 0, 1, 1, buckets), std::invalid_argument);
+				ASSERT_THROW(h.query("cpu_percent", 0, 1, 0, buckets),
+					std::invalid_argument);
+				ASSERT_THROW(h.query("cpu_percent", 2, 1, 1, buckets),
+					std::invalid_argument);
+				ASSERT_EQ(h.query("cpu_percent", 0, ~0ull, 1000, buckets), 0u);
+			}
+
+			TEST(CrossMonitorHistory, ReadOnly) {
+				const string path = history_path("crossmonitor_readonly.history");
+				ASSERT_THROW(history h(path), std::runtime_error);
+				sample_source source;
+				history writer(path, 16);
+				for (int i = 0; i < 1000; ++i) {
+					writer.push(source.next());
+				}
+				writer.flush();
+
+				history reader(path);
+				ASSERT_EQ(reader.capacity(), 16u);
+				ASSERT_EQ(reader.size(), 1000u);
+				vector<history_bucket> buckets;
+				ASSERT_EQ(reader.query("process_count", 0, ~0ull, ~0ull, buckets), 1u);
+				ASSERT_EQ(buckets[0].count, 1000u);
+				ASSERT_THROW(reader.push(source.next()), std::logic_error);
+			}
+
+			TEST(CrossMonitorHistory, BucketJson) {
+				history_bucket b;
+				b.start = 1000;
+				b.count = 2;
+				b.min = 1;
+				b.max = 3;
+				b.avg = 2;
+				b.p95 = 2.5;
+				json_writer writer;
+				b.write(writer);
+				ASSERT_EQ(writer.str(), "{\"start\":1000,\"count\":2,\"min\":1,"
+					"\"max\":3,\"avg\":2,\"p95\":2.5}");
+			}
+
+			TEST(CrossMonitorHistory, Compression) {
+				// A day of 1 second samples
+				history h(history_path("crossmonitor_day.history"), 4096);
+				sample_source source;
+				for (int i = 0; i < 86400; ++i) {
+					h.push(source.next());
+				}
+				h.flush();
+				const double bytes_per_sample =
+					static_cast<double>(h.blocks() * history_block_size) / h.size();
+				// 48 bytes in the spool, far more as a JSON log line
+				ASSERT_LT(bytes_per_sample, 16);
+				RecordProperty("bytes_per_sample", to_string(bytes_per_sample));
+			}
+
+		}
+	}
+}
@@ -0,0 +1,190 @@
+#include <ingest_server.hpp>
+
+#include <delta_frame.hpp>
+#include <gzip.hpp>
+#include <log.hpp>
+#include <wire_format.hpp>
+
+#include <cpprest/http_listener.h>
+#include <cpprest/json.h>
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+using namespace web;
+using namespace web::http;
+using namespace web::http::experimental::listener;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+struct ingest_server::impl final {
+	explicit impl(const string& url) :
+		listener(utility::conversions::to_string_t(url)) {
+	}
+
+	void handle(http_request request);
+
+	http_listener listener;
+	mutable mutex m;
+	ingest_server::stats stats;
+	unsigned failures = 0;
+	unsigned short failure_status = 503;
+	vector<record> received;
+};
+
+static void read_value(const json::value& v, bool delta, float& out) {
+	(void)delta;
+	out = static_cast<float>(v.as_double());
+}
+
+static void read_value(const json::value& v, bool delta, unsigned& out) {
+	(void)delta;
+	out = v.as_number().to_uint32();
+}
+
+static void read_value(const json::value& v, bool delta,
+					   unsigned long long& out) {
+	// Counter changes are signed, kept modulo 2^64 like the encoder does
+	out = delta ? static_cast<unsigned long long>(v.as_number().to_int64()) :
+		v.as_number().to_uint64();
+}
+
+/**
+ * Parses a record or a delta frame; the fields of a keyframe are required.
+ */
+static delta_frame parse_frame(const json::value& r) {
+	delta_frame frame;
+	frame.timestamp = r.at(U("timestamp")).as_number().to_uint64();
+	if (r.has_field(U("period_ms"))) {
+		frame.period_ms = r.at(U("period_ms")).as_number().to_uint32();
+	}
+	if (r.has_field(U("stale"))) {
+		frame.stale = r.at(U("stale")).as_number().to_uint32();
+	}
+	frame.keyframe = !r.has_field(U("delta"));
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		const size_t index = field_index<F, data_fields>::value;
+		const utility::string_t name =
+			utility::conversions::to_string_t(F::name());
+		if (frame.keyframe || r.has_field(name)) {
+			read_value(r.at(name), F::counter && !frame.keyframe,
+					   get<index>(frame.values));
+			frame.mask |= 1u << index;
+		}
+	});
+	return frame;
+}
+
+void ingest_server::impl::handle(http_request request) {
+	const vector<unsigned char> body = request.extract_vector().get();
+	const bool compressed = request.headers().has(U("Content-Encoding")) &&
+		request.headers()[U("Content-Encoding")] == U("gzip");
+	const bool binary = request.headers().content_type() ==
+		utility::conversions::to_string_t(wire_content_type);
+	string key;
+	if (request.headers().has(U("X-Api-Key"))) {
+		key = utility::conversions::to_utf8string(
+			request.headers()[U("X-Api-Key")]);
+	}
+
+	{
+		lock_guard<mutex> l(m);
+		++stats.requests;
+		stats.body_bytes += body.size();
+		if (failures > 0) {
+			--failures;
+			request.reply(failure_status);
+			return;
+		}
+	}
+
+	string document;
+	vector<record> records;
+	try {
+		if (compressed) {
+			utils::gzip_decompress(body.data(), body.size(), document);
+		} else {
+			document.assign(body.begin(), body.end());
+		}
+		// Deltas never span requests
+		delta_decoder decoder;
+		if (binary) {
+			binary_reader reader(
+				reinterpret_cast<const unsigned char*>(document.data()),
+				document.size());
+			delta_frame frame;
+			while (reader.next(frame)) {
+				records.push_back(decoder.decode(frame));
+			}
+		} else {
+			const json::value batch = json::value::parse(
+				utility::conversions::to_string_t(document));
+			for (const json::value& r : batch.as_array()) {
+				records.push_back(decoder.decode(parse_frame(r)));
+			}
+		}
+	} catch (const std::exception& e) {
+		LOG(warning) << "Ingest server rejected a request: " << e.what();
+		request.reply(status_codes::BadRequest);
+		return;
+	}
+
+	{
+		lock_guard<mutex> l(m);
+		++stats.accepted;
+		stats.records += records.size();
+		stats.encoded_bytes += document.size();
+		if (compressed) {
+			++stats.compressed_requests;
+		}
+		if (!records.empty()) {
+			stats.last_timestamp = records.back().timestamp;
+		}
+		stats.last_key = key;
+		received.insert(received.end(), records.begin(), records.end());
+	}
+	request.reply(status_codes::OK);
+}
+
+ingest_server::ingest_server(const string& url) : pimpl_(new impl(url)) {
+	impl* p = pimpl_.get();
+	pimpl_->listener.support(methods::POST, [p](http_request request) {
+		p->handle(request);
+	});
+	pimpl_->listener.open().wait();
+}
+
+ingest_server::~ingest_server() {
+	try {
+		pimpl_->listener.close().wait();
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to close ingest server: " << e.what();
+	}
+}
+
+void ingest_server::fail_next(unsigned count, unsigned short status) {
+	lock_guard<mutex> l(pimpl_->m);
+	pimpl_->failures = count;
+	pimpl_->failure_status = status;
+}
+
+ingest_server::stats ingest_server::get_stats() const {
+	lock_guard<mutex> l(pimpl_->m);
+	return pimpl_->stats;
+}
+
+vector<record> ingest_server::received() const {
+	lock_guard<mutex> l(pimpl_->m);
+	return pimpl_->received;
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
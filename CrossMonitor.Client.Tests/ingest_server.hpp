@@ -0,0 +1,69 @@
+#pragma once
+
+#include <record.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Local stand-in for the monitoring server, accepting the batches POSTed
+ * by sender so it can be tested and measured without a network.
+ * Bodies are decompressed when gzip encoded and parsed as JSON arrays of
+ * records or delta frames, or as binary batches (see binary_writer), which
+ * are rebuilt into records the way the server would; requests that do not
+ * parse are answered 400.
+ */
+class ingest_server final : public boost::noncopyable {
+public:
+	struct stats final {
+		unsigned long long requests = 0;
+		unsigned long long accepted = 0;
+		unsigned long long records = 0;
+		/**
+		 * Request body bytes as received.
+		 */
+		unsigned long long body_bytes = 0;
+		/**
+		 * Request body bytes after decompression, JSON or binary.
+		 */
+		unsigned long long encoded_bytes = 0;
+		unsigned long long compressed_requests = 0;
+		unsigned long long last_timestamp = 0;
+		std::string last_key;
+	};
+
+	/**
+	 * Starts listening. Throws std::exception derived exceptions if the
+	 * URL cannot be bound.
+	 * @param url e.g. http://localhost:34568/ingest
+	 */
+	explicit ingest_server(const std::string& url);
+	~ingest_server();
+
+	/**
+	 * Answers the next count requests with status instead of accepting
+	 * them.
+	 */
+	void fail_next(unsigned count, unsigned short status = 503);
+
+	stats get_stats() const;
+	/**
+	 * Every record of the accepted requests, in the order received.
+	 */
+	std::vector<record> received() const;
+
+private:
+	struct impl;
+	std::unique_ptr<impl> pimpl_;
+}; //class ingest_server
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+
+#include <json_writer.hpp>
+#include <data.hpp>
+#include <cpprest/json.h>
+
+#include <string>
+
+using namespace std;
+using namespace web;
+
+namespace crossover {
+	namespace monitor {
+
+		// Reference serialization, as done with cpprest before json_writer.
+		static string cpprest_json(const data& data) {
+			json::value v(json::value::object());
+			json::object& o(v.as_object());
+			o[U("cpu_percent")] = data.get_cpu_percent();
+			o[U("used_memory_in_bytes")] = data.get_used_memory();
+			o[U("total_memory_in_bytes")] = data.get_total_memory();
+			o[U("process_count")] = data.get_process_count();
+			o[U("total_disk_read")] = data.get_total_disk_read();
+			o[U("total_disk_write")] = data.get_total_disk_write();
+			return utility::conversions::to_utf8string(v.to_string());
+		}
+
+		TEST(CrossMonitorJsonWriter, IntegralValues) {
+			json_writer w;
+			w.write(data(10, 100, 101, 50, 102, 103));
+			ASSERT_EQ(w.str(),
+				"{\"cpu_percent\":10,\"process_count\":50,"
+				"\"total_disk_read\":102,\"total_disk_write\":103,"
+				"\"total_memory_in_bytes\":101,\"used_memory_in_bytes\":100}");
+		}
+
+		TEST(CrossMonitorJsonWriter, Records) {
+			json_writer w;
+			w.write(record(1500000000000ull, data(10, 100, 101, 50, 102, 103)));
+			ASSERT_EQ(w.str(),
+				"{\"timestamp\":1500000000000,\"cpu_percent\":10,\"process_count\":50,"
+				"\"total_disk_read\":102,\"total_disk_write\":103,"
+				"\"total_memory_in_bytes\":101,\"used_memory_in_bytes\":100}");
+			w.clear();
+			w.write(record(1500000000000ull, data(10, 100, 101, 50, 102, 103), 4000));
+			ASSERT_EQ(w.str().compare(0, 48,
+				"{\"timestamp\":1500000000000,\"period_ms\":4000,\"cpu"), 0) << w.str();
+			w.clear();
+			w.write(record(1500000000000ull, data(10, 100, 101, 50, 102, 103), 4000, 8));
+			ASSERT_EQ(w.str().compare(0, 58,
+				"{\"timestamp\":1500000000000,\"period_ms\":4000,\"stale\":8,\"cpu"), 0) << w.str();
+		}
+
+		TEST(CrossMonitorJsonWriter, MatchesCpprest) {
+			const data samples[] = {
+				data(0, 0, 0, 1, 0, 0),
+				data(100, 1, 2, 3, 4, 5),
+				data(12.3f, 123123213, 60150145, 101, 123123, 123123),
+				data(1.1905339956283569f, 18446744073709551615ull,
+					 18446744073709551615ull, 4294967295u,
+					 18446744073709551615ull, 9007199254740993ull),
+				data(0.000123f, 9, 99, 999, 9999, 99999)
+			};
+			json_writer w;
+			for (const auto& d : samples) {
+				w.clear();
+				w.write(d);
+				ASSERT_EQ(w.str(), cpprest_json(d));
+			}
+		}
+
+		TEST(CrossMonitorJsonWriter, Nesting) {
+			json_writer w;
+			w.begin_object();
+			w.key("a");
+			w.begin_array();
+			w.value(1u);
+			w.value(2.5);
+			w.begin_object();
+			w.end_object();
+			w.end_array();
+			w.key("b");
+			w.value(3ull);
+			w.end_object();
+			ASSERT_EQ(w.str(), "{\"a\":[1,2.5,{}],\"b\":3}");
+			w.clear();
+			ASSERT_EQ(w.size(), 0u);
+		}
+
+		TEST(CrossMonitorJsonWriter, SignedValues) {
+			json_writer w;
+			w.begin_array();
+			w.value(0ll);
+			w.value(-7ll);
+			w.value(1234ll);
+			w.value(-9223372036854775807ll - 1);
+			w.end_array();
+			ASSERT_EQ(w.str(), "[0,-7,1234,-9223372036854775808]");
+		}
+
+		TEST(CrossMonitorJsonWriter, Strings) {
+			json_writer w;
+			w.begin_object();
+			w.key("name");
+			w.value("a \"b\"\\c\n\x01");
+			w.end_object();
+			ASSERT_EQ(w.str(), "{\"name\":\"a \\\"b\\\"\\\\c\\u000a\\u0001\"}");
+			json::value parsed = json::value::parse(utility::conversions::to_string_t(w.str()));
+			ASSERT_EQ(utility::conversions::to_utf8string(parsed.at(U("name")).as_string()),
+					  "a \"b\"\\c\n\x01");
+		}
+
+	}
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <latency_histogram.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace utils {
+
+			TEST(CrossMonitorLatencyHistogram, Buckets) {
+				ASSERT_EQ(latency_histogram::bucket(0), 0u);
+				ASSERT_EQ(latency_histogram::bucket(15), 15u);
+				ASSERT_EQ(latency_histogram::bucket(31), 31u);
+				ASSERT_EQ(latency_histogram::bucket(32), 32u);
+				ASSERT_EQ(latency_histogram::bucket(33), 32u);
+				ASSERT_EQ(latency_histogram::bucket(~0ull),
+					latency_histogram::bucket_count - 1);
+				// Buckets are contiguous and each value falls in its own
+				for (size_t b = 0; b + 1 < latency_histogram::bucket_count; ++b) {
+					const unsigned long long low = latency_histogram::bucket_low(b);
+					const unsigned long long width = latency_histogram::bucket_width(b);
+					ASSERT_EQ(latency_histogram::bucket(low), b);
+					ASSERT_EQ(latency_histogram::bucket(low + width - 1), b);
+					ASSERT_EQ(latency_histogram::bucket_low(b + 1), low + width);
+					ASSERT_LE(width * 16, max(16ull, low));
+				}
+			}
+
+			TEST(CrossMonitorLatencyHistogram, Empty) {
+				latency_histogram h;
+				ASSERT_EQ(h.count(), 0u);
+				ASSERT_EQ(h.max(), 0u);
+				ASSERT_EQ(h.mean(), 0);
+				ASSERT_EQ(h.quantile(0.5), 0u);
+			}
+
+			TEST(CrossMonitorLatencyHistogram, Quantiles) {
+				// Log-uniform from 100 ns to 100 ms, as probe latencies spread
+				mt19937 random(7);
+				uniform_real_distribution<double> exponent(2, 8);
+				vector<unsigned long long> values;
+				latency_histogram h;
+				for (int i = 0; i < 100000; ++i) {
+					values.push_back(static_cast<unsigned long long>(
+						pow(10.0, exponent(random))));
+					h.record(values.back());
+				}
+				sort(values.begin(), values.end());
+				ASSERT_EQ(h.count(), values.size());
+				ASSERT_EQ(h.max(), values.back());
+				for (double q : { 0.01, 0.5, 0.9, 0.99, 0.999 }) {
+					const double exact = static_cast<double>(values[
+						static_cast<size_t>(ceil(q * values.size())) - 1]);
+					ASSERT_NEAR(static_cast<double>(h.quantile(q)), exact,
+						exact / 32) << q;
+				}
+				ASSERT_EQ(h.quantile(1), values.back());
+			}
+
+			TEST(CrossMonitorLatencyHistogram, Reset) {
+				latency_histogram h;
+				h.record(1000);
+				h.record(3000);
+				ASSERT_DOUBLE_EQ(h.mean(), 2000);
+				ASSERT_EQ(h.max(), 3000u);
+				h.reset();
+				ASSERT_EQ(h.count(), 0u);
+				ASSERT_EQ(h.quantile(0.5), 0u);
+				h.record(5);
+				ASSERT_EQ(h.quantile(0.5), 5u);
+			}
+
+			TEST(CrossMonitorLatencyHistogram, ConcurrentRecording) {
+				latency_histogram h;
+				vector<thread> threads;
+				for (unsigned t = 1; t <= 4; ++t) {
+					threads.emplace_back([&h, t] {
+						for (unsigned i = 0; i < 10000; ++i) {
+							h.record(t * 1000 + i % 7);
+						}
+					});
+				}
+				for (auto& t : threads) {
+					t.join();
+				}
+				ASSERT_EQ(h.count(), 40000u);
+				ASSERT_EQ(h.max(), 4006u);
+				ASSERT_NEAR(static_cast<double>(h.quantile(0.5)), 2000, 2000 / 32.0);
+			}
+
+		}
+	}
+}
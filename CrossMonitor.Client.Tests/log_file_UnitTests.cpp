@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <log_file.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace log {
+
+			static string log_path(const char* name) {
+				const boost::filesystem::path path =
+					boost::filesystem::temp_directory_path() / name;
+				boost::filesystem::remove(path);
+				for (int i = 1; i <= 3; ++i) {
+					boost::filesystem::remove(path.string() + "." + to_string(i));
+				}
+				return path.string();
+			}
+
+			static string read_file(const string& path) {
+				ifstream in(path);
+				stringstream text;
+				text << in.rdbuf();
+				return text.str();
+			}
+
+			TEST(CrossMonitorLogFile, InvalidOptions) {
+				file_options options;
+				ASSERT_THROW(async_file_writer w(options), std::invalid_argument);
+				options.filename = log_path("crossmonitor_log_invalid.log");
+				options.queue_bytes = 0;
+				ASSERT_THROW(async_file_writer w(options), std::invalid_argument);
+				options.queue_bytes = 1024;
+				options.flush_interval = chrono::milliseconds(0);
+				ASSERT_THROW(async_file_writer w(options), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorLogFile, WritesAndFlushes) {
+				file_options options;
+				options.filename = log_path("crossmonitor_log_writes.log");
+				// Long enough that only flush() writes
+				options.flush_interval = chrono::hours(1);
+				async_file_writer writer(options);
+				ASSERT_TRUE(writer.write("first", 5));
+				ASSERT_TRUE(writer.write("second", 6));
+				writer.flush();
+				ASSERT_EQ(writer.written(), 2u);
+				ASSERT_EQ(read_file(options.filename), "first\nsecond\n");
+			}
+
+			TEST(CrossMonitorLogFile, FlushInterval) {
+				file_options options;
+				options.filename = log_path("crossmonitor_log_interval.log");
+				options.flush_interval = chrono::milliseconds(10);
+				async_file_writer writer(options);
+				ASSERT_TRUE(writer.write("record", 6));
+				for (int i = 0; i < 500 && writer.written() == 0; ++i) {
+					this_thread::sleep_for(chrono::milliseconds(10));
+				}
+				ASSERT_EQ(writer.written(), 1u);
+				ASSERT_EQ(read_file(options.filename), "record\n");
+			}
+
+			TEST(CrossMonitorLogFile, DropsWhenFull) {
+				file_options options;
+				options.filename = log_path("crossmonitor_log_full.log");
+				options.queue_bytes = 16;
+				async_file_writer writer(options);
+				const string big(64, 'x');
+				ASSERT_FALSE(writer.write(big.data(), big.size()));
+				ASSERT_TRUE(writer.write("small", 5));
+				writer.flush();
+				ASSERT_EQ(writer.dropped(), 1u);
+				ASSERT_EQ(writer.written(), 1u);
+				ASSERT_EQ(read_file(options.filename), "small\n");
+			}
+
+			TEST(CrossMonitorLogFile, Rotation) {
+				file_options options;
+				options.filename = log_path("crossmonitor_log_rotation.log");
+				options.rotation_bytes = 5;
+				options.max_files = 2;
+				async_file_writer writer(options);
+				for (int i = 0; i < 4; ++i) {
+					const string text = "record " + to_string(i);
+					ASSERT_TRUE(writer.write(text.data(), text.size()));
+					writer.flush();
+				}
+				ASSERT_EQ(writer.rotations(), 4u);
+				ASSERT_EQ(read_file(options.filename), "");
+				ASSERT_EQ(read_file(options.filename + ".1"), "record 3\n");
+				ASSERT_EQ(read_file(options.filename + ".2"), "record 2\n");
+				ASSERT_FALSE(boost::filesystem::exists(options.filename + ".3"));
+			}
+
+			TEST(CrossMonitorLogFile, ConcurrentWriters) {
+				file_options options;
+				options.filename = log_path("crossmonitor_log_concurrent.log");
+				{
+					async_file_writer writer(options);
+					vector<thread> threads;
+					for (int t = 0; t < 4; ++t) {
+						threads.emplace_back([&writer]() {
+							for (int i = 0; i < 1000; ++i) {
+								writer.write("0123456789", 10);
+							}
+						});
+					}
+					for (auto& t : threads) {
+						t.join();
+					}
+					writer.flush();
+					ASSERT_EQ(writer.written() + writer.dropped(), 4000u);
+				}
+				// The destructor writes what was queued
+				const string text = read_file(options.filename);
+				ASSERT_EQ(text.size() % 11, 0u);
+				ASSERT_GT(text.size(), 0u);
+			}
+
+		}
+	}
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+
+#include <net_rates.hpp>
+#include <os_mock.hpp>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static os::interface_stats stats(const string& name,
+				unsigned long long rx_bytes, unsigned long long tx_bytes,
+				unsigned long long packets = 0, unsigned long long errors = 0) {
+				os::interface_stats s;
+				s.name = name;
+				s.rx_bytes = rx_bytes;
+				s.tx_bytes = tx_bytes;
+				s.rx_packets = packets;
+				s.tx_packets = packets;
+				s.rx_errors = errors;
+				s.tx_errors = errors;
+				s.rx_drops = errors;
+				s.tx_drops = errors;
+				return s;
+			}
+
+			static chrono::steady_clock::time_point at(double seconds) {
+				return chrono::steady_clock::time_point() +
+					chrono::duration_cast<chrono::steady_clock::duration>(
+						chrono::duration<double>(seconds));
+			}
+
+			TEST(CrossMonitorNetRates, Deltas) {
+				net_rates rates;
+				net_usage usage;
+				rates.update({
+					stats("eth0", 1000, 2000, 10, 1),
+					stats("lo", 500, 500)
+				}, at(0), usage);
+				ASSERT_EQ(usage.interfaces.size(), 2u);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].rx_bytes, 0);
+
+				rates.update({
+					stats("eth0", 3000, 2500, 30, 3),
+					stats("lo", 500, 500)
+				}, at(2), usage);
+				ASSERT_EQ(usage.interfaces.size(), 2u);
+				ASSERT_EQ(usage.interfaces[0].name, "eth0");
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].rx_bytes, 1000);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].tx_bytes, 250);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].rx_packets, 10);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].tx_errors, 1);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].rx_drops, 1);
+				ASSERT_DOUBLE_EQ(usage.interfaces[1].rx_bytes, 0);
+				ASSERT_EQ(usage.total.name, "total");
+				ASSERT_DOUBLE_EQ(usage.total.rx_bytes, 1000);
+				ASSERT_DOUBLE_EQ(usage.total.tx_packets, 10);
+			}
+
+			TEST(CrossMonitorNetRates, InterfacesChanged) {
+				net_rates rates;
+				net_usage usage;
+				rates.update({
+					stats("eth0", 1000, 1000),
+					stats("veth1", 100, 100),
+					stats("veth2", 200, 200)
+				}, at(0), usage);
+				// veth1 removed, veth3 added, veth2 moved and recreated
+				rates.update({
+					stats("veth2", 50, 250),
+					stats("eth0", 1100, 1000),
+					stats("veth3", 70000000, 0)
+				}, at(1), usage);
+				ASSERT_EQ(usage.interfaces.size(), 3u);
+				ASSERT_EQ(usage.interfaces[0].name, "veth2");
+				// Went backwards: a baseline, not a spike
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].rx_bytes, 0);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].tx_bytes, 50);
+				ASSERT_EQ(usage.interfaces[1].name, "eth0");
+				ASSERT_DOUBLE_EQ(usage.interfaces[1].rx_bytes, 100);
+				ASSERT_DOUBLE_EQ(usage.interfaces[1].tx_bytes, 0);
+				// New: a baseline, however long it has been up
+				ASSERT_EQ(usage.interfaces[2].name, "veth3");
+				ASSERT_DOUBLE_EQ(usage.interfaces[2].rx_bytes, 0);
+				ASSERT_DOUBLE_EQ(usage.total.rx_bytes, 100);
+
+				// From the new baselines on
+				rates.update({
+					stats("veth2", 60, 260),
+					stats("eth0", 1200, 1000),
+					stats("veth3", 70000070, 0)
+				}, at(2), usage);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].rx_bytes, 10);
+				ASSERT_DOUBLE_EQ(usage.interfaces[2].rx_bytes, 70);
+				ASSERT_DOUBLE_EQ(usage.total.rx_bytes, 180);
+
+				// Another adapter under the same name: a baseline
+				os::interface_stats replaced = stats("eth0", 900000000, 1000);
+				replaced.generation = 1;
+				rates.update({ replaced }, at(3), usage);
+				ASSERT_EQ(usage.interfaces.size(), 1u);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].rx_bytes, 0);
+
+				// No interfaces at all
+				rates.update(vector<os::interface_stats>(), at(4), usage);
+				ASSERT_EQ(usage.interfaces.size(), 0u);
+				ASSERT_DOUBLE_EQ(usage.total.rx_bytes, 0);
+			}
+
+			TEST(CrossMonitorNetRates, Sample) {
+				net_rates rates;
+				net_usage usage;
+				os::set_interfaces(vector<os::interface_stats>());
+				ASSERT_FALSE(rates.sample(usage));
+
+				os::set_interfaces({ stats("eth0", 1000000, 1000000) });
+				// The first sample only reads the counters
+				ASSERT_TRUE(rates.sample(usage));
+				ASSERT_EQ(usage.interfaces.size(), 1u);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].rx_bytes, 0);
+
+				os::set_interfaces({ stats("eth0", 1000100, 1000000) });
+				ASSERT_TRUE(rates.sample(usage));
+				ASSERT_GT(usage.interfaces[0].rx_bytes, 0);
+				ASSERT_DOUBLE_EQ(usage.interfaces[0].tx_bytes, 0);
+				os::set_interfaces(vector<os::interface_stats>());
+			}
+
+			TEST(CrossMonitorNetRates, Json) {
+				net_usage usage;
+				usage.interfaces.resize(2);
+				usage.interfaces[0].name = "eth0";
+				usage.interfaces[0].rx_bytes = 1500.4;
+				usage.interfaces[0].tx_bytes = 99.6;
+				usage.interfaces[0].rx_packets = 3;
+				// Idle, left out
+				usage.interfaces[1].name = "veth0";
+				usage.total = usage.interfaces[0];
+				usage.total.name = "total";
+				json_writer writer;
+				usage.write(writer);
+				ASSERT_EQ(writer.str(),
+					"{\"interfaces\":2,\"rx_bytes\":1500,\"tx_bytes\":100,"
+					"\"rx_packets\":3,\"tx_packets\":0,\"rx_errors\":0,"
+					"\"tx_errors\":0,\"rx_drops\":0,\"tx_drops\":0,"
+					"\"active\":[{\"name\":\"eth0\",\"rx_bytes\":1500,"
+					"\"tx_bytes\":100,\"rx_packets\":3,\"tx_packets\":0,"
+					"\"rx_errors\":0,\"tx_errors\":0,\"rx_drops\":0,"
+					"\"tx_drops\":0}]}");
+			}
+
+		}
+	}
+}
@@ -1,18 +1,27 @@
 #include <os.hpp>
+#include <os_mock.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 
 namespace crossover {
 namespace monitor {
 namespace client {
 namespace os {
 
-// Mock values
-unsigned int _process_count = 0;
-float _cpu_use_percent = 0;
-float _memory_use_percent = 0;
-unsigned long long used_memory_ = 0;
-unsigned long long total_memory_ = 0;
-unsigned long long total_disk_read_ = 0;
-unsigned long long total_disk_write_ = 0;
+// Mock values, read by the probe threads
+std::atomic<unsigned int> _process_count(0);
+std::atomic<float> _cpu_use_percent(0);
+std::atomic<float> _memory_use_percent(0);
+std::atomic<unsigned long long> used_memory_(0);
+std::atomic<unsigned long long> total_memory_(0);
+std::atomic<unsigned long long> total_disk_read_(0);
+std::atomic<unsigned long long> total_disk_write_(0);
+std::atomic<long long> probe_delays_[probe_count];
+std::mutex interfaces_mutex_;
+std::vector<interface_stats> interfaces_;
 
 void set_process_count(unsigned int n) {
 	_process_count = n;
@@ -54,6 +63,42 @@ void set_total_disk_write(unsigned long long total_disk_write) {
 	total_disk_write_ = total_disk_write;
 }
 
+void set_interfaces(const std::vector<interface_stats>& interfaces) {
+	std::lock_guard<std::mutex> guard(interfaces_mutex_);
+	interfaces_ = interfaces;
+}
+
+void set_probe_delay(probe p, std::chrono::milliseconds delay) {
+	probe_delays_[static_cast<size_t>(p)] = delay.count();
+}
+
+void sample(probe p, snapshot& s) noexcept {
+	std::this_thread::sleep_for(std::chrono::milliseconds(
+		probe_delays_[static_cast<size_t>(p)].load()));
+	switch (p) {
+	case probe::cpu:
+		s.cpu_percent = _cpu_use_percent;
+		break;
+	case probe::memory:
+		s.used_memory = used_memory_;
+		s.total_memory = total_memory_;
+		break;
+	case probe::process_count:
+		s.process_count = _process_count;
+		break;
+	case probe::disk:
+		s.total_disk_read = total_disk_read_;
+		s.total_disk_write = total_disk_write_;
+		break;
+	}
+}
+
+void sample(snapshot& s) noexcept {
+	for (size_t p = 0; p < probe_count; ++p) {
+		sample(static_cast<probe>(p), s);
+	}
+}
+
 /*
 * Get total physical memory available
 */
@@ -78,6 +123,14 @@ unsigned long long total_disk_read() noexcept {
 unsigned long long total_disk_write() noexcept {
 	return total_disk_write_;
 }
+/*
+* Get the counters of every network interface
+*/
+bool interfaces(std::vector<interface_stats>& out) noexcept {
+	std::lock_guard<std::mutex> guard(interfaces_mutex_);
+	out = interfaces_;
+	return !out.empty();
+}
 
 } //namespace os
 } //namespace client
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <os.hpp>
+
+#include <chrono>
+#include <vector>
+
 namespace crossover {
 namespace monitor {
 namespace client {
@@ -11,6 +16,14 @@ void set_used_memory(unsigned long long used_memory);
 void set_total_memory(unsigned long long total_memory);
 void set_total_disk_read(unsigned long long total_disk_read);
 void set_total_disk_write(unsigned long long total_disk_write);
+/**
+ * Sets what interfaces(out) reports, interfaces(out) fails while empty.
+ */
+void set_interfaces(const std::vector<interface_stats>& interfaces);
+/**
+ * Makes sample(p, s) sleep for delay before filling its fields.
+ */
+void set_probe_delay(probe p, std::chrono::milliseconds delay);
 
 } //namespace os
 } //namespace client
@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <probe_runner.hpp>
+#include <os_mock.hpp>
+#include <utils.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static const unsigned disk_bit = 1u << static_cast<unsigned>(os::probe::disk);
+
+			static probe_deadlines deadlines(chrono::milliseconds all,
+				chrono::milliseconds disk) {
+				probe_deadlines d;
+				d.fill(all);
+				d[static_cast<size_t>(os::probe::disk)] = disk;
+				return d;
+			}
+
+			static void set_values() {
+				os::set_cpu_use_percent(10);
+				os::set_used_memory(100);
+				os::set_total_memory(200);
+				os::set_process_count(50);
+				os::set_total_disk_read(1000);
+				os::set_total_disk_write(2000);
+			}
+
+			static void set_delays(chrono::milliseconds all, chrono::milliseconds disk) {
+				os::set_probe_delay(os::probe::cpu, all);
+				os::set_probe_delay(os::probe::memory, all);
+				os::set_probe_delay(os::probe::process_count, all);
+				os::set_probe_delay(os::probe::disk, disk);
+			}
+
+			static chrono::milliseconds timed_sample(probe_runner& runner, os::snapshot& s) {
+				const auto start = chrono::steady_clock::now();
+				runner.sample(s);
+				return chrono::duration_cast<chrono::milliseconds>(
+					chrono::steady_clock::now() - start);
+			}
+
+			TEST(CrossMonitorProbeRunner, InvalidDeadlines) {
+				ASSERT_THROW(probe_runner r(deadlines(chrono::milliseconds(100),
+					chrono::milliseconds(0))), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorProbeRunner, ProbesRunInParallel) {
+				set_values();
+				set_delays(chrono::milliseconds(200), chrono::milliseconds(200));
+				utils::scope_exit reset([] {
+					set_delays(chrono::milliseconds(0), chrono::milliseconds(0));
+				});
+				probe_runner runner(deadlines(chrono::seconds(5), chrono::seconds(5)));
+				os::snapshot s;
+				// 800 ms one after another
+				ASSERT_LT(timed_sample(runner, s).count(), 600);
+				ASSERT_EQ(s.stale, 0u);
+				ASSERT_EQ(s.cpu_percent, 10);
+				ASSERT_EQ(s.used_memory, 100u);
+				ASSERT_EQ(s.total_memory, 200u);
+				ASSERT_EQ(s.process_count, 50u);
+				ASSERT_EQ(s.total_disk_read, 1000u);
+				ASSERT_EQ(s.total_disk_write, 2000u);
+			}
+
+			TEST(CrossMonitorProbeRunner, SlowProbeIsStale) {
+				set_values();
+				set_delays(chrono::milliseconds(0), chrono::milliseconds(500));
+				utils::scope_exit reset([] {
+					set_delays(chrono::milliseconds(0), chrono::milliseconds(0));
+				});
+				probe_runner runner(deadlines(chrono::seconds(5), chrono::milliseconds(50)));
+				os::snapshot s;
+				ASSERT_LT(timed_sample(runner, s).count(), 400);
+				ASSERT_EQ(s.stale, disk_bit);
+				ASSERT_EQ(runner.missed(os::probe::disk), 1u);
+				ASSERT_EQ(runner.missed(os::probe::cpu), 0u);
+				ASSERT_EQ(s.disk_ns, 50000000u);
+				// Never read yet
+				ASSERT_EQ(s.total_disk_read, 0u);
+				ASSERT_EQ(s.process_count, 50u);
+
+				// Still running: not started again, the sample is on time and
+				// incomplete until the probe first returns
+				const auto start = chrono::steady_clock::now();
+				ASSERT_FALSE(runner.sample(s));
+				ASSERT_LT(chrono::steady_clock::now() - start, chrono::milliseconds(400));
+				ASSERT_EQ(s.stale, disk_bit);
+				ASSERT_EQ(runner.missed(os::probe::disk), 2u);
+
+				// Once it returned its value is the last known one
+				this_thread::sleep_for(chrono::milliseconds(600));
+				os::set_total_disk_read(3000);
+				os::set_probe_delay(os::probe::disk, chrono::milliseconds(500));
+				ASSERT_TRUE(runner.sample(s));
+				ASSERT_EQ(s.stale, disk_bit);
+				ASSERT_EQ(s.total_disk_read, 1000u);
+
+				// Back within its deadline
+				this_thread::sleep_for(chrono::milliseconds(600));
+				os::set_probe_delay(os::probe::disk, chrono::milliseconds(0));
+				runner.sample(s);
+				ASSERT_EQ(s.stale, 0u);
+				ASSERT_EQ(s.total_disk_read, 3000u);
+				ASSERT_EQ(runner.missed(os::probe::disk), 3u);
+			}
+
+			TEST(CrossMonitorProbeRunner, Names) {
+				ASSERT_STREQ(probe_name(os::probe::cpu), "cpu");
+				ASSERT_STREQ(probe_name(os::probe::process_count), "process_count");
+				ASSERT_STREQ(probe_name(os::probe::disk), "disk");
+			}
+
+		}
+	}
+}
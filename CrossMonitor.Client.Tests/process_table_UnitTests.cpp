@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include <process_table.hpp>
+
+#include <Windows.h>
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static os::process_counters counters(unsigned pid,
+				unsigned long long start_time, unsigned long long cpu_time,
+				unsigned long long resident_bytes,
+				unsigned long long read_bytes = 0,
+				unsigned long long write_bytes = 0) {
+				os::process_counters c;
+				c.pid = pid;
+				c.start_time = start_time;
+				c.cpu_time = cpu_time;
+				c.resident_bytes = resident_bytes;
+				c.read_bytes = read_bytes;
+				c.write_bytes = write_bytes;
+				snprintf(c.name, sizeof(c.name), "test");
+				return c;
+			}
+
+			TEST(CrossMonitorProcessTable, InvalidTopCount) {
+				ASSERT_THROW(process_table t{ 0 }, std::invalid_argument);
+			}
+
+			TEST(CrossMonitorProcessTable, Deltas) {
+				process_table table(5, 2);
+				process_top top;
+				vector<os::process_counters> scan{
+					counters(10, 1, 1000000000, 100, 0, 0),
+					counters(20, 1, 0, 200, 5000, 1000)
+				};
+				table.update(scan, chrono::seconds(0), top);
+				ASSERT_EQ(top.processes, 2u);
+				// First seen: memory only
+				ASSERT_TRUE(top.cpu.empty());
+				ASSERT_TRUE(top.io.empty());
+				ASSERT_EQ(top.memory.size(), 2u);
+				ASSERT_EQ(top.memory[0].pid, 20u);
+				ASSERT_STREQ(top.memory[0].name, "test");
+
+				// One CPU second over two seconds of two CPUs is 25%
+				scan[0].cpu_time += 1000000000;
+				scan[1].read_bytes += 4000;
+				scan[1].write_bytes += 2000;
+				table.update(scan, chrono::seconds(2), top);
+				ASSERT_EQ(top.cpu.size(), 1u);
+				ASSERT_EQ(top.cpu[0].pid, 10u);
+				ASSERT_FLOAT_EQ(top.cpu[0].cpu_percent, 25);
+				ASSERT_EQ(top.io.size(), 1u);
+				ASSERT_EQ(top.io[0].pid, 20u);
+				ASSERT_DOUBLE_EQ(top.io[0].read_bytes_per_second, 2000);
+				ASSERT_DOUBLE_EQ(top.io[0].write_bytes_per_second, 1000);
+			}
+
+			TEST(CrossMonitorProcessTable, ReusedAndExitedPids) {
+				process_table table(5, 1);
+				process_top top;
+				vector<os::process_counters> scan{
+					counters(10, 1, 0, 100),
+					counters(20, 1, 0, 100),
+					counters(30, 1, 0, 100)
+				};
+				table.update(scan, chrono::seconds(1), top);
+				ASSERT_EQ(table.size(), 3u);
+
+				// 20 exited, 30 is another process with the same PID and 40
+				// is new: only 10 has a CPU delta
+				scan = {
+					counters(10, 1, 500000000, 100),
+					counters(30, 2, 900000000, 100),
+					counters(40, 1, 900000000, 100)
+				};
+				table.update(scan, chrono::seconds(1), top);
+				ASSERT_EQ(table.size(), 3u);
+				ASSERT_EQ(top.cpu.size(), 1u);
+				ASSERT_EQ(top.cpu[0].pid, 10u);
+				ASSERT_FLOAT_EQ(top.cpu[0].cpu_percent, 50);
+			}
+
+			TEST(CrossMonitorProcessTable, TopSelection) {
+				process_table table(3, 1);
+				process_top top;
+				vector<os::process_counters> scan;
+				for (unsigned pid = 1; pid <= 1000; ++pid) {
+					scan.push_back(counters(pid, 1, 0, (pid * 7919) % 1000));
+				}
+				table.update(scan, chrono::seconds(1), top);
+				for (unsigned pid = 1; pid <= 1000; ++pid) {
+					scan[pid - 1].cpu_time += (pid % 100) * 1000000;
+				}
+				table.update(scan, chrono::seconds(1), top);
+
+				ASSERT_EQ(top.processes, 1000u);
+				ASSERT_EQ(top.memory.size(), 3u);
+				ASSERT_EQ(top.memory[0].resident_bytes, 999u);
+				ASSERT_EQ(top.memory[1].resident_bytes, 998u);
+				ASSERT_EQ(top.memory[2].resident_bytes, 997u);
+				// Ties go to the lowest PID
+				ASSERT_EQ(top.cpu.size(), 3u);
+				ASSERT_EQ(top.cpu[0].pid, 99u);
+				ASSERT_EQ(top.cpu[1].pid, 199u);
+				ASSERT_EQ(top.cpu[2].pid, 299u);
+				ASSERT_TRUE(top.io.empty());
+			}
+
+			TEST(CrossMonitorProcessTable, ScansOwnProcess) {
+				process_table table(100000);
+				process_top top;
+				ASSERT_TRUE(table.sample(top));
+				ASSERT_GT(top.processes, 0u);
+				ASSERT_EQ(table.size(), top.processes);
+
+				const unsigned self = static_cast<unsigned>(GetCurrentProcessId());
+				bool found = false;
+				for (const process_usage& p : top.memory) {
+					if (p.pid == self) {
+						found = true;
+						ASSERT_GT(p.resident_bytes, 0u);
+						ASSERT_NE(p.name[0], '\0');
+					}
+				}
+				ASSERT_TRUE(found);
+				ASSERT_TRUE(table.sample(top));
+			}
+
+			TEST(CrossMonitorProcessTable, Json) {
+				process_top top;
+				top.processes = 7;
+				process_usage p;
+				p.pid = 42;
+				snprintf(p.name, sizeof(p.name), "a\"b");
+				p.cpu_percent = 12.5f;
+				p.resident_bytes = 1024;
+				top.cpu.push_back(p);
+				json_writer writer;
+				top.write(writer);
+				ASSERT_EQ(writer.str(),
+					"{\"processes\":7,\"cpu\":[{\"pid\":42,\"name\":\"a\\\"b\","
+					"\"cpu_percent\":12.5,\"resident_bytes\":1024,"
+					"\"read_bytes_per_second\":0,\"write_bytes_per_second\":0}],"
+					"\"memory\":[],\"io\":[]}");
+			}
+
+		}
+	}
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <rolling_window.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace utils {
+
+			TEST(CrossMonitorRollingWindow, InvalidLength) {
+				ASSERT_THROW(rolling_window w{ 0 }, std::invalid_argument);
+			}
+
+			TEST(CrossMonitorRollingWindow, Empty) {
+				rolling_window w(4);
+				ASSERT_TRUE(w.empty());
+				ASSERT_EQ(w.mean(), 0);
+				ASSERT_EQ(w.variance(), 0);
+				ASSERT_EQ(w.min(), 0);
+				ASSERT_EQ(w.max(), 0);
+			}
+
+			TEST(CrossMonitorRollingWindow, Slides) {
+				rolling_window w(3);
+				w.push(1);
+				w.push(5);
+				ASSERT_EQ(w.size(), 2u);
+				ASSERT_DOUBLE_EQ(w.mean(), 3);
+				ASSERT_DOUBLE_EQ(w.variance(), 4);
+				w.push(3);
+				w.push(2);
+				// Window is 5, 3, 2
+				ASSERT_EQ(w.size(), 3u);
+				ASSERT_DOUBLE_EQ(w.mean(), 10.0 / 3);
+				ASSERT_EQ(w.min(), 2);
+				ASSERT_EQ(w.max(), 5);
+				w.push(1);
+				// Window is 3, 2, 1
+				ASSERT_EQ(w.max(), 3);
+				ASSERT_EQ(w.min(), 1);
+				ASSERT_DOUBLE_EQ(w.variance(), 2.0 / 3);
+
+				w.clear();
+				ASSERT_TRUE(w.empty());
+				w.push(7);
+				ASSERT_EQ(w.min(), 7);
+				ASSERT_EQ(w.max(), 7);
+				ASSERT_EQ(w.mean(), 7);
+			}
+
+			TEST(CrossMonitorRollingWindow, LengthOne) {
+				rolling_window w(1);
+				for (double v : { 3.0, 1.0, 4.0 }) {
+					w.push(v);
+					ASSERT_EQ(w.mean(), v);
+					ASSERT_EQ(w.min(), v);
+					ASSERT_EQ(w.max(), v);
+					ASSERT_EQ(w.variance(), 0);
+				}
+			}
+
+			TEST(CrossMonitorRollingWindow, MatchesBruteForce) {
+				mt19937 random(42);
+				// Large offset, like byte counters, to catch rounding drift
+				uniform_real_distribution<double> values(1e11, 1e11 + 1e6);
+				for (size_t length : { 2, 7, 64 }) {
+					rolling_window w(length);
+					vector<double> all;
+					for (int i = 0; i < 5000; ++i) {
+						const double v = i % 50 < 10 ? 1e11 : values(random);
+						w.push(v);
+						all.push_back(v);
+
+						const size_t n = min(all.size(), length);
+						const auto first = all.end() - n;
+						double mean = 0;
+						for (auto it = first; it != all.end(); ++it) {
+							mean += *it;
+						}
+						mean /= n;
+						double variance = 0;
+						for (auto it = first; it != all.end(); ++it) {
+							variance += (*it - mean) * (*it - mean);
+						}
+						variance /= n;
+
+						ASSERT_EQ(w.min(), *min_element(first, all.end()));
+						ASSERT_EQ(w.max(), *max_element(first, all.end()));
+						ASSERT_NEAR(w.mean(), mean, 1e-3);
+						// Values near 1e11 carry about 1e-5 of absolute rounding
+						ASSERT_NEAR(w.variance(), variance, 1e-5 * variance + 10);
+					}
+				}
+			}
+
+		}
+	}
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <sample_buffer.hpp>
+#include <ring_buffer.hpp>
+#include <data.hpp>
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			TEST(CrossMonitorRingBuffer, Wraparound) {
+				ASSERT_THROW(utils::ring_buffer<int> r(0), std::invalid_argument);
+
+				utils::ring_buffer<int> r(3);
+				ASSERT_TRUE(r.empty());
+				r.push(1);
+				r.push(2);
+				ASSERT_EQ(r.size(), 2u);
+				ASSERT_EQ(r[0], 1);
+				ASSERT_EQ(r.back(), 2);
+				r.push(3);
+				r.push(4);
+				ASSERT_TRUE(r.full());
+				ASSERT_EQ(r[0], 2);
+				ASSERT_EQ(r[1], 3);
+				ASSERT_EQ(r[2], 4);
+				ASSERT_EQ(r.back(), 4);
+				r.clear();
+				ASSERT_TRUE(r.empty());
+				ASSERT_EQ(r.capacity(), 3u);
+			}
+
+			TEST(CrossMonitorSampleBuffer, Summarize) {
+				sample_buffer samples(4);
+				samples.push(data(10, 100, 1000, 5, 10, 20));
+				samples.push(data(40, 50, 1000, 7, 30, 40));
+				samples.push(data(25, 150, 1000, 6, 50, 60));
+
+				data_summary summary;
+				samples.summarize(summary);
+				ASSERT_EQ(summary.samples(), 3u);
+
+				const auto& cpu = summary.get<fields::cpu_percent>();
+				ASSERT_EQ(cpu.min, 10);
+				ASSERT_EQ(cpu.max, 40);
+				ASSERT_DOUBLE_EQ(cpu.mean, 25);
+				ASSERT_EQ(cpu.last, 25);
+
+				const auto& used = summary.get<fields::used_memory>();
+				ASSERT_EQ(used.min, 50u);
+				ASSERT_EQ(used.max, 150u);
+				ASSERT_DOUBLE_EQ(used.mean, 100);
+
+				const auto& read = summary.get<fields::total_disk_read>();
+				ASSERT_EQ(read.last, 50u);
+			}
+
+			TEST(CrossMonitorSampleBuffer, EmptySummary) {
+				sample_buffer samples(2);
+				data_summary summary;
+				samples.summarize(summary);
+				ASSERT_EQ(summary.samples(), 0u);
+				ASSERT_TRUE(samples.empty());
+			}
+
+		}
+	}
+}
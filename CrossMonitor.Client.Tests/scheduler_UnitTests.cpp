@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <scheduler.hpp>
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace utils {
+
+			TEST(CrossMonitorScheduler, InvalidPeriod) {
+				ASSERT_THROW(deadline_scheduler s{ chrono::milliseconds(0) }, std::invalid_argument);
+				ASSERT_THROW(deadline_scheduler s{ chrono::milliseconds(-1) }, std::invalid_argument);
+			}
+
+			TEST(CrossMonitorScheduler, StopWakesImmediately) {
+				deadline_scheduler s(chrono::milliseconds(60 * 1000));
+				const auto start = chrono::steady_clock::now();
+				thread t([&s] {
+					this_thread::sleep_for(chrono::milliseconds(20));
+					s.stop();
+				});
+				ASSERT_EQ(s.wait_next(), interruptible_sleep_result::interrupted);
+				t.join();
+				ASSERT_LT(chrono::steady_clock::now() - start, chrono::seconds(5));
+				// Stays stopped until reset
+				ASSERT_EQ(s.wait_next(), interruptible_sleep_result::interrupted);
+			}
+
+			TEST(CrossMonitorScheduler, DeadlinesDoNotDrift) {
+				const chrono::milliseconds period(20);
+				deadline_scheduler s(period);
+				ASSERT_EQ(s.wait_next(), interruptible_sleep_result::timeout);
+				const auto first = s.last_deadline();
+				for (int i = 0; i < 3; ++i) {
+					this_thread::sleep_for(chrono::milliseconds(5));
+					ASSERT_EQ(s.wait_next(), interruptible_sleep_result::timeout);
+				}
+				ASSERT_EQ(s.last_deadline() - first, 3 * period);
+				ASSERT_EQ(s.missed_deadlines(), 0u);
+			}
+
+			TEST(CrossMonitorScheduler, MissedDeadlinesAreCounted) {
+				const chrono::milliseconds period(10);
+				deadline_scheduler s(period);
+				ASSERT_EQ(s.wait_next(), interruptible_sleep_result::timeout);
+				const auto first = s.last_deadline();
+				this_thread::sleep_for(chrono::milliseconds(55));
+				ASSERT_EQ(s.wait_next(), interruptible_sleep_result::timeout);
+				ASSERT_GE(s.missed_deadlines(), 4u);
+				// Still on the original grid
+				ASSERT_EQ((s.last_deadline() - first) % period,
+						  chrono::steady_clock::duration::zero());
+			}
+
+		}
+	}
+}
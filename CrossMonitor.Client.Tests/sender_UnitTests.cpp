@@ -0,0 +1,334 @@
+#include <gtest/gtest.h>
+
+#include <sender.hpp>
+#include <ingest_server.hpp>
+#include <log.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static const char* const ingest_url = "http://localhost:34568/ingest";
+
+			static sender_options test_options(size_t batch_size) {
+				sender_options options;
+				options.url = ingest_url;
+				options.batch_size = batch_size;
+				options.batch_delay = chrono::minutes(1);
+				options.min_backoff = chrono::milliseconds(10);
+				options.max_backoff = chrono::milliseconds(40);
+				return options;
+			}
+
+			static record test_record(unsigned i) {
+				return record(1500000000000ull + i * 1000ull,
+					data(static_cast<float>(i % 100), 1000 + i, 8000, 50 + i, 100 * i, 200 * i));
+			}
+
+			TEST(CrossMonitorSender, InvalidOptions) {
+				sender_options options = test_options(10);
+				options.batch_size = 0;
+				ASSERT_THROW(sender s{ options }, std::invalid_argument);
+				options = test_options(10);
+				options.max_attempts = 0;
+				ASSERT_THROW(sender s{ options }, std::invalid_argument);
+				options = test_options(10);
+				options.max_backoff = chrono::milliseconds(1);
+				ASSERT_THROW(sender s{ options }, std::invalid_argument);
+				options = test_options(10);
+				options.url = "ftp://localhost/ingest";
+				ASSERT_THROW(sender s{ options }, std::invalid_argument);
+			}
+
+			TEST(CrossMonitorSender, BatchesBySize) {
+				ingest_server server(ingest_url);
+				sender_options options = test_options(10);
+				options.key = "secret";
+				sender s(options);
+
+				for (unsigned i = 0; i < 25; ++i) {
+					ASSERT_TRUE(s.add(test_record(i)));
+				}
+				ingest_server::stats received = server.get_stats();
+				ASSERT_EQ(received.requests, 2u);
+				ASSERT_EQ(received.records, 20u);
+
+				ASSERT_TRUE(s.flush());
+				ASSERT_TRUE(s.flush());
+				received = server.get_stats();
+				ASSERT_EQ(received.requests, 3u);
+				ASSERT_EQ(received.records, 25u);
+				ASSERT_EQ(received.compressed_requests, 3u);
+				ASSERT_EQ(received.last_timestamp, test_record(24).timestamp);
+				ASSERT_EQ(received.last_key, "secret");
+
+				const sender_stats sent = s.stats();
+				ASSERT_EQ(sent.requests, 3u);
+				ASSERT_EQ(sent.records_sent, 25u);
+				ASSERT_EQ(sent.records_dropped, 0u);
+				ASSERT_EQ(sent.bytes_sent, received.body_bytes);
+				ASSERT_EQ(sent.encoded_bytes, received.encoded_bytes);
+			}
+
+			TEST(CrossMonitorSender, BatchesByTime) {
+				ingest_server server(ingest_url);
+				sender_options options = test_options(100);
+				options.batch_delay = chrono::milliseconds(1);
+				sender s(options);
+
+				ASSERT_TRUE(s.add(test_record(0)));
+				this_thread::sleep_for(chrono::milliseconds(5));
+				ASSERT_TRUE(s.add(test_record(1)));
+				ASSERT_EQ(server.get_stats().records, 2u);
+			}
+
+			TEST(CrossMonitorSender, SendsLoneRecordWhenDue) {
+				ingest_server server(ingest_url);
+				sender_options options = test_options(100);
+				options.batch_delay = chrono::milliseconds(50);
+				sender s(options);
+
+				ASSERT_TRUE(s.add(test_record(0)));
+				ASSERT_TRUE(s.send_due());
+				ASSERT_EQ(server.get_stats().requests, 0u);
+				this_thread::sleep_for(chrono::milliseconds(100));
+				ASSERT_TRUE(s.send_due());
+				ASSERT_EQ(server.get_stats().requests, 1u);
+				ASSERT_EQ(server.get_stats().records, 1u);
+				// Nothing left to send
+				ASSERT_TRUE(s.send_due());
+				ASSERT_EQ(server.get_stats().requests, 1u);
+			}
+
+			TEST(CrossMonitorSender, CompressionSavesBytes) {
+				ingest_server server(ingest_url);
+				const unsigned count = 60;
+				vector<sender_stats> results;
+				for (bool compress : { false, true }) {
+					sender_options options = test_options(count);
+					options.compress = compress;
+					sender s(options);
+					for (unsigned i = 0; i < count; ++i) {
+						ASSERT_TRUE(s.add(test_record(i)));
+					}
+					results.push_back(s.stats());
+					LOG(info) << (compress ? "gzip: " : "plain: ")
+						<< static_cast<double>(results.back().bytes_sent) / count
+						<< " bytes per record";
+				}
+				ASSERT_EQ(results[0].bytes_sent, results[0].encoded_bytes);
+				ASSERT_LT(results[1].bytes_sent, results[0].bytes_sent / 2);
+				ASSERT_EQ(server.get_stats().records, 2u * count);
+			}
+
+			TEST(CrossMonitorSender, RetriesServerErrors) {
+				ingest_server server(ingest_url);
+				server.fail_next(2);
+				sender s(test_options(5));
+				for (unsigned i = 0; i < 5; ++i) {
+					ASSERT_TRUE(s.add(test_record(i)));
+				}
+				ASSERT_EQ(server.get_stats().requests, 3u);
+				ASSERT_EQ(server.get_stats().records, 5u);
+				ASSERT_EQ(s.stats().failed_requests, 2u);
+				ASSERT_EQ(s.stats().records_sent, 5u);
+			}
+
+			TEST(CrossMonitorSender, DropsAfterMaxAttempts) {
+				ingest_server server(ingest_url);
+				server.fail_next(10);
+				sender_options options = test_options(5);
+				options.max_attempts = 3;
+				sender s(options);
+				for (unsigned i = 0; i < 4; ++i) {
+					ASSERT_TRUE(s.add(test_record(i)));
+				}
+				ASSERT_FALSE(s.add(test_record(4)));
+				ASSERT_EQ(server.get_stats().requests, 3u);
+				ASSERT_EQ(s.stats().records_dropped, 5u);
+			}
+
+			TEST(CrossMonitorSender, DropsRejectedBatch) {
+				ingest_server server(ingest_url);
+				server.fail_next(1, 400);
+				sender s(test_options(1));
+				ASSERT_FALSE(s.add(test_record(0)));
+				ASSERT_EQ(server.get_stats().requests, 1u);
+				ASSERT_TRUE(s.add(test_record(1)));
+				ASSERT_EQ(s.stats().records_dropped, 1u);
+				ASSERT_EQ(s.stats().records_sent, 1u);
+			}
+
+			TEST(CrossMonitorSender, UnreachableServer) {
+				sender_options options = test_options(1);
+				options.max_attempts = 2;
+				sender s(options);
+				ASSERT_FALSE(s.add(test_record(0)));
+				ASSERT_EQ(s.stats().failed_requests, 2u);
+			}
+
+			TEST(CrossMonitorSender, StopCutsRetries) {
+				ingest_server server(ingest_url);
+				server.fail_next(10);
+				sender_options options = test_options(1);
+				options.min_backoff = chrono::seconds(60);
+				options.max_backoff = chrono::seconds(60);
+				sender s(options);
+				s.stop();
+				const auto start = chrono::steady_clock::now();
+				ASSERT_FALSE(s.add(test_record(0)));
+				ASSERT_LT(chrono::steady_clock::now() - start, chrono::seconds(30));
+				ASSERT_EQ(server.get_stats().requests, 1u);
+			}
+
+			TEST(CrossMonitorSender, SpoolsWhileServerIsDown) {
+				const boost::filesystem::path spool_path =
+					boost::filesystem::temp_directory_path() / "crossmonitor_sender.spool";
+				boost::filesystem::remove(spool_path);
+				sender_options options = test_options(5);
+				options.max_attempts = 1;
+				options.spool_path = spool_path.string();
+				vector<unsigned long long> timestamps;
+				sender s(options, [&timestamps](const record& r) {
+					timestamps.push_back(r.timestamp);
+				});
+
+				for (unsigned i = 0; i < 10; ++i) {
+					ASSERT_TRUE(s.add(test_record(i)));
+				}
+				ASSERT_EQ(s.stats().records_spooled, 10u);
+				ASSERT_EQ(s.stats().records_dropped, 0u);
+				ASSERT_TRUE(timestamps.empty());
+
+				// New records go behind the spooled ones, so all arrive in order
+				ingest_server server(ingest_url);
+				for (unsigned i = 10; i < 15; ++i) {
+					ASSERT_TRUE(s.add(test_record(i)));
+				}
+				ASSERT_EQ(server.get_stats().records, 15u);
+				ASSERT_EQ(server.get_stats().last_timestamp, test_record(14).timestamp);
+				ASSERT_EQ(s.stats().records_replayed, 15u);
+				ASSERT_EQ(timestamps.size(), 15u);
+				ASSERT_TRUE(is_sorted(timestamps.begin(), timestamps.end()));
+			}
+
+			TEST(CrossMonitorSender, SentCallback) {
+				ingest_server server(ingest_url);
+				vector<unsigned long long> timestamps;
+				sender s(test_options(3), [&timestamps](const record& r) {
+					timestamps.push_back(r.timestamp);
+				});
+				for (unsigned i = 0; i < 3; ++i) {
+					ASSERT_TRUE(s.add(test_record(i)));
+				}
+				ASSERT_EQ(timestamps.size(), 3u);
+				ASSERT_EQ(timestamps[2], test_record(2).timestamp);
+			}
+
+			/**
+			 * Steady gauges, growing counters and a counter reset.
+			 */
+			static vector<record> steady_records() {
+				vector<record> records;
+				for (unsigned i = 0; i < 30; ++i) {
+					records.push_back(record(1500000000000ull + i * 1000ull,
+						data(i % 7 == 0 ? 40.5f : 12.0f, 4000, 8000, 120,
+							 i < 20 ? 1000000ull * i : 512ull * i, 300ull * i), 1000,
+						i == 5 ? 8 : 0));
+				}
+				return records;
+			}
+
+			static void assert_received(const vector<record>& rebuilt,
+										const vector<record>& records) {
+				ASSERT_EQ(rebuilt.size(), records.size());
+				for (size_t i = 0; i < records.size(); ++i) {
+					ASSERT_EQ(rebuilt[i].timestamp, records[i].timestamp);
+					ASSERT_EQ(rebuilt[i].period_ms, records[i].period_ms);
+					ASSERT_EQ(rebuilt[i].stale, records[i].stale);
+					ASSERT_EQ(rebuilt[i].sample.get_cpu_percent(), records[i].sample.get_cpu_percent());
+					ASSERT_EQ(rebuilt[i].sample.get_used_memory(), records[i].sample.get_used_memory());
+					ASSERT_EQ(rebuilt[i].sample.get_total_memory(), records[i].sample.get_total_memory());
+					ASSERT_EQ(rebuilt[i].sample.get_process_count(), records[i].sample.get_process_count());
+					ASSERT_EQ(rebuilt[i].sample.get_total_disk_read(), records[i].sample.get_total_disk_read());
+					ASSERT_EQ(rebuilt[i].sample.get_total_disk_write(), records[i].sample.get_total_disk_write());
+				}
+			}
+
+			TEST(CrossMonitorSender, DeltaReporting) {
+				const vector<record> records = steady_records();
+
+				unsigned long long full_bytes = 0;
+				{
+					ingest_server server(ingest_url);
+					sender_options options = test_options(30);
+					options.compress = false;
+					sender s(options);
+					for (const record& r : records) {
+						ASSERT_TRUE(s.add(r));
+					}
+					full_bytes = server.get_stats().encoded_bytes;
+				}
+
+				ingest_server server(ingest_url);
+				sender_options options = test_options(30);
+				options.compress = false;
+				options.delta.keyframe_every = 10;
+				sender s(options);
+				for (const record& r : records) {
+					ASSERT_TRUE(s.add(r));
+				}
+				assert_received(server.received(), records);
+				// Timestamps and counters still go in every record
+				ASSERT_LT(server.get_stats().encoded_bytes * 3, full_bytes * 2);
+
+				sender_options invalid = test_options(30);
+				invalid.delta.keyframe_every = 0;
+				ASSERT_THROW(sender bad{ invalid }, std::invalid_argument);
+			}
+
+			TEST(CrossMonitorSender, BinaryBatches) {
+				const vector<record> records = steady_records();
+				unsigned long long json_bytes = 0;
+				{
+					ingest_server server(ingest_url);
+					sender s(test_options(30));
+					for (const record& r : records) {
+						ASSERT_TRUE(s.add(r));
+					}
+					json_bytes = server.get_stats().encoded_bytes;
+				}
+
+				for (unsigned keyframe_every : { 1u, 10u }) {
+					ingest_server server(ingest_url);
+					sender_options options = test_options(30);
+					options.binary = true;
+					options.delta.keyframe_every = keyframe_every;
+					sender s(options);
+					for (const record& r : records) {
+						ASSERT_TRUE(s.add(r));
+					}
+					assert_received(server.received(), records);
+					const ingest_server::stats received = server.get_stats();
+					ASSERT_EQ(received.compressed_requests, 1u);
+					ASSERT_EQ(s.stats().encoded_bytes, received.encoded_bytes);
+					ASSERT_LT(received.encoded_bytes * 4, json_bytes);
+				}
+			}
+
+		}
+	}
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+
+#include <spool.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static string spool_path(const char* name) {
+				const boost::filesystem::path path =
+					boost::filesystem::temp_directory_path() / name;
+				boost::filesystem::remove(path);
+				return path.string();
+			}
+
+			static record spool_record(unsigned i) {
+				return record(1500000000000ull + i,
+					data(static_cast<float>(i % 100), 1000 + i, 8000, 50 + i, 100 * i, 200 * i),
+					1000 * (i % 4), i % 3 == 0 ? 8 : 0);
+			}
+
+			static void expect_records(spool& s, unsigned first, unsigned count) {
+				vector<record> out;
+				ASSERT_EQ(s.peek(out, count + 10), count);
+				ASSERT_EQ(out.size(), count);
+				for (unsigned i = 0; i < count; ++i) {
+					ASSERT_EQ(out[i].timestamp, spool_record(first + i).timestamp);
+					ASSERT_EQ(out[i].period_ms, spool_record(first + i).period_ms);
+					ASSERT_EQ(out[i].stale, spool_record(first + i).stale);
+					ASSERT_EQ(out[i].sample.get_process_count(), 50 + first + i);
+					ASSERT_EQ(out[i].sample.get_total_disk_write(), 200ull * (first + i));
+				}
+			}
+
+			TEST(CrossMonitorSpool, InvalidArguments) {
+				const string path = spool_path("crossmonitor_invalid.spool");
+				ASSERT_THROW(spool s(path, 0), std::invalid_argument);
+				ASSERT_THROW(spool s(path, 10, 0), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorSpool, PushPeekPop) {
+				spool s(spool_path("crossmonitor_fifo.spool"), 16);
+				ASSERT_TRUE(s.empty());
+				for (unsigned i = 0; i < 10; ++i) {
+					s.push(spool_record(i));
+				}
+				ASSERT_EQ(s.size(), 10u);
+				expect_records(s, 0, 10);
+
+				// Peeking does not remove
+				vector<record> out;
+				ASSERT_EQ(s.peek(out, 4), 4u);
+				ASSERT_EQ(s.size(), 10u);
+				s.pop(4);
+				expect_records(s, 4, 6);
+				s.pop(100);
+				ASSERT_TRUE(s.empty());
+			}
+
+			TEST(CrossMonitorSpool, OverwritesOldest) {
+				spool s(spool_path("crossmonitor_wrap.spool"), 8);
+				for (unsigned i = 0; i < 20; ++i) {
+					s.push(spool_record(i));
+				}
+				ASSERT_EQ(s.size(), 8u);
+				ASSERT_EQ(s.overwritten(), 12u);
+				expect_records(s, 12, 8);
+			}
+
+			TEST(CrossMonitorSpool, Reopen) {
+				const string path = spool_path("crossmonitor_reopen.spool");
+				{
+					spool s(path, 64);
+					for (unsigned i = 0; i < 30; ++i) {
+						s.push(spool_record(i));
+					}
+					s.pop(5);
+				}
+				spool s(path, 64);
+				ASSERT_EQ(s.size(), 25u);
+				expect_records(s, 5, 25);
+			}
+
+			TEST(CrossMonitorSpool, RecoversUnsyncedRecords) {
+				const string path = spool_path("crossmonitor_crash.spool");
+				const string crashed = spool_path("crossmonitor_crashed.spool");
+				{
+					spool s(path, 64, 10);
+					for (unsigned i = 0; i < 15; ++i) {
+						s.push(spool_record(i));
+					}
+					// Copying the file while mapped gives what a crash leaves:
+					// the header as of the sync after 10 records and 5 more
+					// records in the slots.
+					boost::filesystem::copy_file(path, crashed);
+				}
+				spool s(crashed, 64, 10);
+				ASSERT_EQ(s.size(), 15u);
+				expect_records(s, 0, 15);
+			}
+
+			TEST(CrossMonitorSpool, StopsAtCorruptRecord) {
+				const string path = spool_path("crossmonitor_corrupt.spool");
+				const string crashed = spool_path("crossmonitor_corrupted.spool");
+				{
+					spool s(path, 64, 10);
+					for (unsigned i = 0; i < 15; ++i) {
+						s.push(spool_record(i));
+					}
+					boost::filesystem::copy_file(path, crashed);
+				}
+				{
+					// Flip a byte of record 12 (slots of 72 bytes), past the
+					// synced header
+					fstream f(crashed, ios::in | ios::out | ios::binary);
+					f.seekp(4096 + 12 * 72 + 20);
+					f.put('\xff');
+				}
+				spool s(crashed, 64, 10);
+				ASSERT_EQ(s.size(), 12u);
+				expect_records(s, 0, 12);
+			}
+
+			TEST(CrossMonitorSpool, CapacityChangeStartsOver) {
+				const string path = spool_path("crossmonitor_resize.spool");
+				{
+					spool s(path, 16);
+					s.push(spool_record(0));
+				}
+				spool s(path, 32);
+				ASSERT_TRUE(s.empty());
+				ASSERT_EQ(s.capacity(), 32u);
+			}
+
+		}
+	}
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <spsc_queue.hpp>
+
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace utils {
+
+			TEST(CrossMonitorSpscQueue, Capacity) {
+				ASSERT_THROW(spsc_queue<int> q{ 0 }, std::invalid_argument);
+				ASSERT_EQ(spsc_queue<int>(1).capacity(), 1u);
+				ASSERT_EQ(spsc_queue<int>(5).capacity(), 8u);
+				ASSERT_EQ(spsc_queue<int>(64).capacity(), 64u);
+			}
+
+			TEST(CrossMonitorSpscQueue, FifoAndDrops) {
+				spsc_queue<int> q(4);
+				ASSERT_TRUE(q.empty());
+				for (int i = 0; i < 4; ++i) {
+					ASSERT_TRUE(q.try_push(i));
+				}
+				ASSERT_FALSE(q.try_push(4));
+				ASSERT_FALSE(q.try_push(5));
+				ASSERT_EQ(q.dropped(), 2u);
+
+				vector<int> out;
+				ASSERT_EQ(q.consume_all([&out](int v) { out.push_back(v); }), 4u);
+				ASSERT_EQ(out, (vector<int>{ 0, 1, 2, 3 }));
+				ASSERT_TRUE(q.empty());
+
+				// Wraps around the storage
+				ASSERT_TRUE(q.try_push(6));
+				ASSERT_TRUE(q.try_push(7));
+				out.clear();
+				q.consume_all([&out](int v) { out.push_back(v); });
+				ASSERT_EQ(out, (vector<int>{ 6, 7 }));
+			}
+
+			TEST(CrossMonitorSpscQueue, DestroysElements) {
+				auto counter = make_shared<int>(0);
+				{
+					spsc_queue<shared_ptr<int>> q(4);
+					q.try_push(counter);
+					q.try_push(counter);
+					ASSERT_EQ(counter.use_count(), 3);
+					q.consume_all([](const shared_ptr<int>&) {});
+					ASSERT_EQ(counter.use_count(), 1);
+					q.try_push(counter);
+				}
+				ASSERT_EQ(counter.use_count(), 1);
+			}
+
+			TEST(CrossMonitorSpscQueue, ProducerConsumer) {
+				const unsigned long long count = 1000000;
+				spsc_queue<unsigned long long> q(256);
+				unsigned long long pushed = 0;
+				thread producer([&] {
+					for (unsigned long long i = 0; i < count; ++i) {
+						if (q.try_push(i)) {
+							++pushed;
+						}
+					}
+				});
+
+				unsigned long long received = 0;
+				unsigned long long last = 0;
+				bool ordered = true;
+				auto check = [&](unsigned long long v) {
+					if (received != 0 && v <= last) {
+						ordered = false;
+					}
+					last = v;
+					++received;
+				};
+				while (received + q.dropped() < count) {
+					if (q.consume_all(check) == 0) {
+						this_thread::yield();
+					}
+				}
+				producer.join();
+				q.consume_all(check);
+
+				ASSERT_TRUE(ordered);
+				ASSERT_EQ(received, pushed);
+				ASSERT_EQ(received + q.dropped(), count);
+			}
+
+		}
+	}
+}
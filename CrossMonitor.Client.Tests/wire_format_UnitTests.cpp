@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <delta_frame.hpp>
+#include <json_writer.hpp>
+#include <wire_format.hpp>
+
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+	namespace monitor {
+		namespace client {
+
+			static record test_record(unsigned i) {
+				return record(1500000000000ull + i * 1000ull - (i == 5 ? 3000 : 0),
+					data(12.3f + i, 4294967296ull + i, 17179869184ull, 101 + i % 3,
+						 52428800000ull + 65536ull * i, i == 7 ? 0 : 10485760000ull + 4096ull * i),
+					1000 * (1 + i % 2), i % 4 == 3 ? 8 : 0);
+			}
+
+			static void expect_equal(const record& a, const record& b) {
+				ASSERT_EQ(a.timestamp, b.timestamp);
+				ASSERT_EQ(a.period_ms, b.period_ms);
+				ASSERT_EQ(a.stale, b.stale);
+				ASSERT_EQ(a.sample.get_cpu_percent(), b.sample.get_cpu_percent());
+				ASSERT_EQ(a.sample.get_used_memory(), b.sample.get_used_memory());
+				ASSERT_EQ(a.sample.get_total_memory(), b.sample.get_total_memory());
+				ASSERT_EQ(a.sample.get_process_count(), b.sample.get_process_count());
+				ASSERT_EQ(a.sample.get_total_disk_read(), b.sample.get_total_disk_read());
+				ASSERT_EQ(a.sample.get_total_disk_write(), b.sample.get_total_disk_write());
+			}
+
+			static vector<record> decode_batch(const vector<unsigned char>& bytes) {
+				binary_reader reader(bytes.data(), bytes.size());
+				delta_decoder decoder;
+				delta_frame frame;
+				vector<record> records;
+				while (reader.next(frame)) {
+					records.push_back(decoder.decode(frame));
+				}
+				return records;
+			}
+
+			TEST(CrossMonitorWireFormat, Data) {
+				const data d(12.5f, 4294967296ull, 17179869184ull, 101, 123123, 0);
+				binary_writer writer;
+				writer.begin(wire_kind::data);
+				writer.write(d);
+
+				json_writer json;
+				json.write(d);
+				ASSERT_LT(writer.size() * 3, json.size());
+
+				binary_reader reader(writer.bytes().data(), writer.size());
+				ASSERT_EQ(reader.kind(), wire_kind::data);
+				const data decoded = reader.read_data();
+				expect_equal(record(0, decoded), record(0, d));
+
+				binary_reader batch(writer.bytes().data(), writer.size());
+				delta_frame frame;
+				ASSERT_THROW(batch.next(frame), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorWireFormat, Batch) {
+				vector<record> records;
+				for (unsigned i = 0; i < 10; ++i) {
+					records.push_back(test_record(i));
+				}
+				binary_writer writer;
+				writer.begin(wire_kind::batch);
+				for (const record& r : records) {
+					writer.write(r);
+				}
+				const vector<record> decoded = decode_batch(writer.bytes());
+				ASSERT_EQ(decoded.size(), records.size());
+				for (size_t i = 0; i < records.size(); ++i) {
+					expect_equal(decoded[i], records[i]);
+				}
+
+				// Reused buffer, empty batch
+				writer.begin(wire_kind::batch);
+				ASSERT_TRUE(decode_batch(writer.bytes()).empty());
+			}
+
+			TEST(CrossMonitorWireFormat, DeltaFrames) {
+				delta_options options;
+				options.keyframe_every = 4;
+				delta_encoder encoder(options);
+				delta_frame frame;
+				binary_writer writer;
+				binary_writer keyframes;
+				writer.begin(wire_kind::batch);
+				keyframes.begin(wire_kind::batch);
+				vector<record> records;
+				for (unsigned i = 0; i < 10; ++i) {
+					records.push_back(test_record(i));
+					encoder.encode(records.back(), frame);
+					writer.write(frame);
+					keyframes.write(records.back());
+				}
+				ASSERT_LT(writer.size(), keyframes.size());
+				const vector<record> decoded = decode_batch(writer.bytes());
+				ASSERT_EQ(decoded.size(), records.size());
+				for (size_t i = 0; i < records.size(); ++i) {
+					expect_equal(decoded[i], records[i]);
+				}
+			}
+
+			TEST(CrossMonitorWireFormat, InvalidHeader) {
+				binary_writer writer;
+				writer.begin(wire_kind::batch);
+				writer.write(test_record(0));
+				vector<unsigned char> bytes = writer.bytes();
+				ASSERT_THROW(binary_reader(bytes.data(), 5), std::invalid_argument);
+				bytes[0] = wire_version + 1;
+				ASSERT_THROW(binary_reader(bytes.data(), bytes.size()), std::invalid_argument);
+				bytes = writer.bytes();
+				bytes[1] ^= 1;
+				ASSERT_THROW(binary_reader(bytes.data(), bytes.size()), std::invalid_argument);
+				bytes = writer.bytes();
+				bytes[5] = 2;
+				ASSERT_THROW(binary_reader(bytes.data(), bytes.size()), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorWireFormat, Truncated) {
+				delta_options options;
+				options.keyframe_every = 3;
+				delta_encoder encoder(options);
+				delta_frame frame;
+				binary_writer writer;
+				writer.begin(wire_kind::batch);
+				for (unsigned i = 0; i < 6; ++i) {
+					encoder.encode(test_record(i), frame);
+					writer.write(frame);
+				}
+				const vector<unsigned char>& bytes = writer.bytes();
+				// Cut anywhere, a batch decodes whole frames then throws, or
+				// ends on a frame boundary; never reads past the end.
+				for (size_t size = 0; size < bytes.size(); ++size) {
+					const vector<unsigned char> cut(bytes.begin(), bytes.begin() + size);
+					try {
+						binary_reader reader(cut.data(), cut.size());
+						delta_decoder decoder;
+						while (reader.next(frame)) {
+							decoder.decode(frame);
+						}
+					} catch (const std::invalid_argument&) {
+					}
+				}
+
+				// A varint of 11 bytes
+				vector<unsigned char> overlong(bytes.begin(), bytes.begin() + 6);
+				overlong.insert(overlong.end(), 10, 0x80);
+				overlong.push_back(1);
+				binary_reader reader(overlong.data(), overlong.size());
+				ASSERT_THROW(reader.next(frame), std::invalid_argument);
+			}
+
+			TEST(CrossMonitorWireFormat, Corrupted) {
+				binary_writer writer;
+				writer.begin(wire_kind::batch);
+				for (unsigned i = 0; i < 20; ++i) {
+					writer.write(test_record(i));
+				}
+				// Flipped bytes after the header either decode or throw
+				minstd_rand random(42);
+				delta_frame frame;
+				for (int i = 0; i < 2000; ++i) {
+					vector<unsigned char> bytes = writer.bytes();
+					uniform_int_distribution<size_t> position(6, bytes.size() - 1);
+					for (int j = 0; j < 3; ++j) {
+						bytes[position(random)] = static_cast<unsigned char>(random());
+					}
+					try {
+						binary_reader reader(bytes.data(), bytes.size());
+						delta_decoder decoder;
+						while (reader.next(frame)) {
+							decoder.decode(frame);
+						}
+					} catch (const std::invalid_argument&) {
+					}
+				}
+			}
+
+		}
+	}
+}
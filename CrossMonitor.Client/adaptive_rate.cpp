@@ -0,0 +1,125 @@
+#include "adaptive_rate.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Weight of the newest sample in the volatility.
+ */
+static const double volatility_weight = 0.3;
+
+static const adaptive_options& checked_options(
+	const chrono::milliseconds& min_period, const adaptive_options& options) {
+	if (min_period <= chrono::milliseconds::zero() ||
+		options.max_period < min_period ||
+		!(options.threshold > 0) ||
+		options.stable_samples == 0) {
+		throw invalid_argument("Invalid adaptive sampling options");
+	}
+	return options;
+}
+
+/**
+ * Counter rates, bytes per second, below which a change is noise.
+ */
+static const double rate_floor = 1024 * 1024;
+
+/**
+ * What a change of field F is measured against, so ordinary idle noise,
+ * e.g. CPU going from 5% to 7%, stays well below the threshold: its
+ * previous value by default, at least 1 so values near zero do not
+ * trigger on noise.
+ */
+template <typename F>
+static double change_scale(double from, const data&) noexcept {
+	return std::max(abs(from), 1.0);
+}
+/**
+ * CPU use against its whole range.
+ */
+template <>
+double change_scale<fields::cpu_percent>(double, const data&) noexcept {
+	return 100;
+}
+/**
+ * Used memory against the total memory.
+ */
+template <>
+double change_scale<fields::used_memory>(double, const data& sample) noexcept {
+	return std::max(static_cast<double>(sample.get<fields::total_memory>()), 1.0);
+}
+
+adaptive_rate::adaptive_rate(const chrono::milliseconds& min_period,
+							 const adaptive_options& options) :
+	min_period_(min_period),
+	options_(checked_options(min_period, options)),
+	period_(min_period) {
+	reset();
+}
+
+void adaptive_rate::reset() noexcept {
+	period_ = min_period_;
+	volatility_ = 0;
+	quiet_ = 0;
+	samples_ = 0;
+	previous_.fill(0);
+	previous_rate_.fill(0);
+}
+
+double adaptive_rate::largest_change(const data& sample,
+									 double seconds) noexcept {
+	double largest = 0;
+	size_t i = 0;
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		const double value = static_cast<double>(F::get(sample));
+		if (F::counter) {
+			// A counter moves by its rate, compare the rates; a counter
+			// going back (reset, wrap) has no rate.
+			if (samples_ >= 1 && seconds > 0 && value >= previous_[i]) {
+				const double rate = (value - previous_[i]) / seconds;
+				if (samples_ >= 2) {
+					largest = std::max(largest, abs(rate - previous_rate_[i]) /
+						std::max(abs(previous_rate_[i]), rate_floor));
+				}
+				previous_rate_[i] = rate;
+			}
+		} else if (samples_ >= 1) {
+			largest = std::max(largest, abs(value - previous_[i]) /
+				change_scale<F>(previous_[i], sample));
+		}
+		previous_[i++] = value;
+	});
+	return largest;
+}
+
+chrono::milliseconds adaptive_rate::next(const data& sample,
+										 const chrono::milliseconds& elapsed) noexcept {
+	const double change = largest_change(sample,
+		chrono::duration<double>(elapsed).count());
+	++samples_;
+	volatility_ += volatility_weight * (change - volatility_);
+
+	if (change >= options_.threshold) {
+		period_ = min_period_;
+		quiet_ = 0;
+	} else if (volatility_ >= options_.threshold / 2) {
+		period_ = std::max(min_period_, period_ / 2);
+		quiet_ = 0;
+	} else if (++quiet_ >= options_.stable_samples) {
+		period_ = std::min(options_.max_period, period_ * 2);
+		quiet_ = 0;
+	}
+	return period_;
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
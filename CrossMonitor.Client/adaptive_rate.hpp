@@ -0,0 +1,99 @@
+#pragma once
+
+#include <data.hpp>
+#include <data_fields.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <array>
+#include <chrono>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Settings of adaptive sampling.
+ */
+struct adaptive_options final {
+	/**
+	 * Longest period the sampling backs off to; the shortest is the
+	 * application's sample period.
+	 */
+	std::chrono::milliseconds max_period = std::chrono::seconds(60);
+	/**
+	 * Relative change of a field between two samples that brings the
+	 * period straight back to the shortest one, e.g. 0.2 for 20%. CPU use
+	 * is relative to 100%, used memory to the total memory, counters are
+	 * compared by their rate relative to at least 1 MB/s, and other
+	 * values relative to their previous value, at least 1.
+	 */
+	double threshold = 0.2;
+	/**
+	 * Consecutive quiet samples before the period doubles.
+	 */
+	unsigned stable_samples = 3;
+};
+
+/**
+ * Decides the period of the next sample from the samples taken so far.
+ * A change of any field beyond the threshold returns to the shortest
+ * period at once, so spikes are caught at full resolution. Otherwise the
+ * volatility, a moving average of the largest relative change of each
+ * sample, halves the period while above half the threshold, and the period
+ * doubles after every stable_samples quiet samples up to max_period.
+ * Not thread safe, meant for the collector thread.
+ */
+class adaptive_rate final : public boost::noncopyable {
+public:
+	/**
+	 * Throws std::invalid_argument if max_period is shorter than
+	 * min_period, min_period is not positive, the threshold is not
+	 * positive or stable_samples is zero.
+	 */
+	adaptive_rate(const std::chrono::milliseconds& min_period,
+				  const adaptive_options& options);
+
+	/**
+	 * Takes the sample just taken, elapsed after the previous one, and
+	 * returns the period to wait before the next one.
+	 */
+	std::chrono::milliseconds next(const data& sample,
+								   const std::chrono::milliseconds& elapsed) noexcept;
+
+	std::chrono::milliseconds period() const noexcept {
+		return period_;
+	}
+	double volatility() const noexcept {
+		return volatility_;
+	}
+	/**
+	 * Forgets the samples seen and returns to the shortest period.
+	 */
+	void reset() noexcept;
+
+private:
+	/**
+	 * Largest relative change of a field since the previous sample, 0 for
+	 * the first one.
+	 */
+	double largest_change(const data& sample, double seconds) noexcept;
+
+	const std::chrono::milliseconds min_period_;
+	const adaptive_options options_;
+	std::chrono::milliseconds period_;
+	double volatility_ = 0;
+	unsigned quiet_ = 0;
+
+	/**
+	 * Per field, in data_fields order, the previous value and, for
+	 * counters, the previous rate per second.
+	 */
+	std::array<double, data_fields::size> previous_;
+	std::array<double, data_fields::size> previous_rate_;
+	unsigned samples_ = 0;
+}; //class adaptive_rate
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
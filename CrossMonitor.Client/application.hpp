@@ -5,15 +5,27 @@
 #include <memory>
 #include <string>
 #include <chrono>
+#include <cstddef>
+#include <vector>
+#include <adaptive_rate.hpp>
 #include <data.hpp>
-#include <cpprest/json.h>
-
-using namespace web;
+#include <data_sketches.hpp>
+#include <process_table.hpp>
+#include <cpu_cores.hpp>
+#include <disk_rates.hpp>
+#include <history.hpp>
+#include <net_rates.hpp>
+#include <probe_runner.hpp>
+#include <rolling_stats.hpp>
+#include <sample_buffer.hpp>
+#include <sender.hpp>
 
 namespace crossover {
 namespace monitor {
 namespace client {
 
+struct collected;
+
 /**
  * Class handling main application logic.
  * Call run() after construction to run main logic.
@@ -21,15 +33,107 @@ namespace client {
 class application final: public boost::noncopyable {
 public:
 	/**
-	 * Constructs a ready to use application object.
+	 * Constructs a ready to use application object. Starts the probe
+	 * workers, so on Linux call os::set_termination_handler before.
 	 * May throw std::exception derived exceptions.
-	 * @param period minutes between reports.
+	 * @param period seconds between reports.
 	 */
 	application(const std::chrono::seconds& period);
+	/**
+	 * Constructs an application sampling faster than it reports. Samples
+	 * are kept in a preallocated buffer and each report is a min/max/mean/
+	 * last summary of the samples taken since the previous one, followed
+	 * by the p50/p95/p99 quantile sketches of every field over the period.
+	 * May throw std::exception derived exceptions.
+	 * @param sample_period time between samples (10 ms or more).
+	 * @param report_period time between reports, a multiple of
+	 *                      sample_period.
+	 */
+	application(const std::chrono::milliseconds& sample_period,
+				const std::chrono::milliseconds& report_period);
 	~application();
 
+	/**
+	 * Sets the lengths, in samples, of the windows over which rolling
+	 * statistics of every field are kept and logged after each report.
+	 * Defaults to a single window of 10 samples. Call before run().
+	 * Throws std::invalid_argument if lengths is empty or holds a zero.
+	 */
+	void set_rolling_windows(const std::vector<std::size_t>& lengths);
+
+	/**
+	 * Sends every sample to a server in batches besides logging it, from a
+	 * thread of its own so requests and retries never hold up logging.
+	 * Call before run().
+	 * Throws std::invalid_argument if the options are invalid.
+	 */
+	void enable_sending(const sender_options& options);
+
+	/**
+	 * Logs, after each report, the count processes using the most CPU,
+	 * memory and IO since the previous report. Call before run().
+	 * Throws std::invalid_argument if count is zero.
+	 */
+	void enable_process_top(std::size_t count);
+
+	/**
+	 * Logs, after each report, the use of every logical CPU since the
+	 * previous report. Call before run().
+	 */
+	void enable_core_usage();
+
+	/**
+	 * Logs, after each report, the traffic of every network interface
+	 * since the previous report, see net_rates. Call before run().
+	 */
+	void enable_network_usage();
+
+	/**
+	 * Logs, after each report, the bytes and operations per second of
+	 * every physical disk since the previous report, see disk_rates. Call
+	 * before run().
+	 */
+	void enable_disk_rates();
+
+	/**
+	 * Keeps every sample in a compressed history file holding capacity
+	 * blocks, see history. Call before run().
+	 * Throws std::invalid_argument if capacity is less than two blocks
+	 * and std::exception derived exceptions if the file cannot be mapped.
+	 */
+	void enable_history(const std::string& path, std::size_t capacity);
+
+	/**
+	 * Times every probe of a sample, serialization and sending, and logs
+	 * every period what the agent itself costs, see self_metrics.
+	 * Call before run().
+	 * Throws std::invalid_argument if period is not positive.
+	 */
+	void enable_self_metrics(const std::chrono::seconds& period);
+
+	/**
+	 * Sets how long a sample waits for each probe, see probe_runner.
+	 * A probe past its deadline reports its last values and a warning is
+	 * logged. Defaults to half the sample period for every probe.
+	 * Call before run().
+	 * Throws std::invalid_argument if a deadline is not positive.
+	 */
+	void set_probe_deadlines(const probe_deadlines& deadlines);
+
+	/**
+	 * Adapts the sampling period to how much the fields change, between
+	 * the sample period and options.max_period, see adaptive_rate.
+	 * Reports still come every report period and each record sent carries
+	 * the period it was taken at. Call before run().
+	 * Throws std::invalid_argument if the options are invalid.
+	 */
+	void enable_adaptive_sampling(const adaptive_options& options);
+
 	/**
 	 * Runs the application logic. Blocking.
+	 * Samples are taken on the calling thread and handed through a
+	 * lock-free queue to a second thread that logs them, which hands them
+	 * through another one to a third thread that sends them.
 	 * Call stop() from any thread or signal handler to break from this
 	 * call.
 	 * May throw std::exception derived classes.
@@ -41,17 +145,52 @@ public:
 	 */
 	void stop() noexcept;
 
+	/**
+	 * Sampling deadlines skipped because collection fell behind.
+	 */
+	unsigned long long missed_deadlines() const noexcept;
+	/**
+	 * Samples dropped because logging and sending fell behind.
+	 */
+	unsigned long long dropped_samples() const noexcept;
+
 private:
 	friend class CrossMonitorTest_RunStop_Test;
 	friend class CrossMonitorClient_JsonData_Test;
+	friend class CrossMonitorClient_JsonSummary_Test;
+	friend class CrossMonitorClient_JsonRollingStats_Test;
+	friend class CrossMonitorClient_JsonSketches_Test;
+	friend class CrossMonitorClient_JsonSelfMetrics_Test;
+	friend class CrossMonitorClient_ProbeDeadlines_Test;
+	friend class application_benchmark;
 	data CollectData();
-	web::json::value data_to_json(const data& data) noexcept;
+	const std::string& data_to_json(const data& data);
+	const std::string& summary_to_json(const data_summary& summary);
+	const std::string& stats_to_json(const rolling_stats& stats);
+	const std::string& sketches_to_json(const data_sketches& sketches);
+	const std::string& processes_to_json(const process_top& top);
+	const std::string& cores_to_json(const core_usage& usage);
+	const std::string& network_to_json(const net_usage& usage);
+	const std::string& disk_rates_to_json(const disk_usage& usage);
+	const std::string& self_to_json();
+	/**
+	 * Sink thread: logs and summarizes the queued samples, and queues
+	 * them for sending, until the collector stops.
+	 */
+	void sink();
+	void consume(const collected& c);
+	/**
+	 * Sender thread: sends the records queued by the sink until it
+	 * stops, then flushes the sender.
+	 */
+	void send();
 
 
 	struct impl;
 
 	std::unique_ptr<impl> pimpl_;
-	const std::chrono::seconds period_;
+	const std::chrono::milliseconds period_;
+	const std::chrono::milliseconds report_period_;
 }; //class application
 
 } //namespace client
@@ -1,149 +1,756 @@
 #include <application.hpp>
+#include <adaptive_rate.hpp>
 #include <os.hpp>
 
+#include <data_fields.hpp>
+#include <data_sketches.hpp>
+#include <process_table.hpp>
+#include <cpu_cores.hpp>
+#include <disk_rates.hpp>
+#include <history.hpp>
+#include <json_writer.hpp>
+#include <net_rates.hpp>
+#include <latency_histogram.hpp>
+#include <probe_runner.hpp>
+#include <rolling_stats.hpp>
+#include <self_metrics.hpp>
+#include <record.hpp>
 #include <log.hpp>
 #include <utils.hpp>
-
-#include <cpprest/http_client.h>
-#include <cpprest/asyncrt_utils.h>
+#include <scheduler.hpp>
+#include <sender.hpp>
+#include <spsc_queue.hpp>
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
 #include <stdexcept>
-#include <numeric>
+#include <thread>
 
 #define LOG CROSSOVER_MONITOR_LOG
 
 using namespace std;
-using namespace web;
 
 namespace crossover {
 namespace monitor {
 namespace client {
 
+/**
+ * A sample handed from the collector thread to the sink thread.
+ */
+struct collected final {
+	record sample;
+	/**
+	 * The report period ended with this sample.
+	 */
+	bool report_due;
+	/**
+	 * Disk counters of the sample, read only when disk rates are enabled.
+	 */
+	disk_reading disk;
+};
+
+/**
+ * Thrown by CollectData() while a probe has never returned: its fields hold
+ * no reading yet, so the sample is left out.
+ */
+class probes_not_read final : public runtime_error {
+public:
+	probes_not_read() : runtime_error("Probes not read yet") {
+	}
+};
+
+/**
+ * Rolling statistics window used unless set_rolling_windows() is called.
+ */
+static const size_t default_window = 10;
+
+/**
+ * Samples the sink thread may lag behind the collector before new ones are
+ * dropped: over 10 seconds at the shortest sample period.
+ */
+static const size_t queue_capacity = 1024;
+
+/**
+ * Records the sender thread may lag behind the sink before new ones are
+ * dropped: with the sender's own retries and spool, a server outage only
+ * fills this queue while a batch is being retried.
+ */
+static const size_t outbox_capacity = 1024;
+
+/**
+ * Every probe waited for half the sample period, so a sample never takes
+ * longer than that.
+ */
+static probe_deadlines default_deadlines(const chrono::milliseconds& period) {
+	probe_deadlines deadlines;
+	deadlines.fill(period / 2);
+	return deadlines;
+}
+
+struct application::impl final {
+	impl(const chrono::milliseconds& period, size_t samples_per_report) :
+		scheduler(period),
+		samples_per_report(samples_per_report),
+		samples(samples_per_report),
+		stats(new rolling_stats(vector<size_t>{ default_window })),
+		queue(queue_capacity),
+		outbox(outbox_capacity),
+		probes(new probe_runner(default_deadlines(period))) {
+	}
+
+	utils::deadline_scheduler scheduler;
+	atomic<bool> running = false;
+	const size_t samples_per_report;
+
+	// Owned by the sink thread while running
+	sample_buffer samples;
+	unique_ptr<rolling_stats> stats;
+	data_sketches sketches;
+	unique_ptr<process_table> processes;
+	process_top top;
+	unique_ptr<cpu_cores> cores;
+	core_usage core_use;
+	unique_ptr<net_rates> network;
+	net_usage net_use;
+	unique_ptr<disk_rates> disks;
+	disk_usage disk_use;
+	unique_ptr<client::history> history;
+	json_writer writer;
+	chrono::milliseconds self_period{ 0 };
+	chrono::steady_clock::time_point self_published;
+	unsigned stale = 0;
+	unsigned period_ms = 0;
+
+	// Shared by all threads
+	unique_ptr<self_metrics> self;
+	unique_ptr<client::sender> sender;
+
+	utils::spsc_queue<collected> queue;
+	atomic<bool> collecting{ false };
+	mutex sink_m;
+	condition_variable sink_cv;
+
+	// From the sink thread to the sender thread
+	utils::spsc_queue<record> outbox;
+	atomic<bool> sinking{ false };
+	mutex send_m;
+	condition_variable send_cv;
+
+	// Owned by the collector thread while running
+	unique_ptr<probe_runner> probes;
+	unsigned last_stale = 0;
+	disk_reading last_disk;
+	unique_ptr<adaptive_rate> rate;
+};
+
 data application::CollectData() {
+	os::snapshot s;
+	const bool read = pimpl_->probes->sample(s);
+	if (pimpl_->self) {
+		pimpl_->self->record_probes(s);
+	}
+	if (!read) {
+		throw probes_not_read();
+	}
+	pimpl_->last_stale = s.stale;
+	// A stale probe repeats its last reading, which keeps its time
+	if (pimpl_->disks &&
+		(s.stale & (1u << static_cast<unsigned>(os::probe::disk))) == 0) {
+		disk_reading& disk = pimpl_->last_disk;
+		disk.time = chrono::steady_clock::now();
+		disk.read_bytes = s.total_disk_read;
+		disk.write_bytes = s.total_disk_write;
+		disk.reads = s.total_disk_reads;
+		disk.writes = s.total_disk_writes;
+		disk.generation = s.disk_generation;
+	}
 	return data{
-		os::cpu_use_percent(),
-		os::used_memory(),
-		os::total_memory(),
-		os::process_count(),
-		os::total_disk_read(),
-		os::total_disk_write()
+		s.cpu_percent,
+		s.used_memory,
+		s.total_memory,
+		s.process_count,
+		s.total_disk_read,
+		s.total_disk_write
 	};
 }
 
-web::json::value application::data_to_json(const data& data) noexcept {
-
-	json::value v(json::value::object());
-	json::object& o(v.as_object());
-	o[L"cpu_percent"] = data.get_cpu_percent();
-	o[L"used_memory_in_bytes"] = data.get_used_memory();
-	o[L"total_memory_in_bytes"] = data.get_total_memory();
-	o[L"process_count"] = data.get_process_count();
-	o[L"total_disk_read"] = data.get_total_disk_read();
-	o[L"total_disk_write"] = data.get_total_disk_write();
-	return v;
+const std::string& application::data_to_json(const data& data) {
+	utils::stopwatch watch;
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	writer.write(data);
+	if (pimpl_->self) {
+		pimpl_->self->record_serialize(watch.lap());
+	}
+	return writer.str();
 }
 
-static void send_data(const string& url, const string& key, const json::value jsondata) {
+const std::string& application::summary_to_json(const data_summary& summary) {
+	utils::stopwatch watch;
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	writer.begin_object();
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		const field_summary<F>& s = summary.template get<F>();
 
-	const uri url_full(utility::conversions::to_string_t(url));
+		writer.key(F::name());
+		writer.begin_object();
+		writer.key("last");
+		writer.value(s.last);
+		writer.key("max");
+		writer.value(s.max);
+		writer.key("mean");
+		writer.value(s.mean);
+		writer.key("min");
+		writer.value(s.min);
+		writer.end_object();
+	});
+	writer.key("samples");
+	writer.value(static_cast<unsigned long long>(summary.samples()));
+	writer.end_object();
+	if (pimpl_->self) {
+		pimpl_->self->record_serialize(watch.lap());
+	}
+	return writer.str();
+}
 
-	uri_builder builder;
-	builder.set_scheme(url_full.scheme());
-	builder.set_user_info(url_full.user_info());
-	builder.set_host(url_full.host());
-	builder.set_port(url_full.port());
+const std::string& application::stats_to_json(const rolling_stats& stats) {
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	stats.write(writer);
+	return writer.str();
+}
 
-	const uri base(builder.to_uri());
+const std::string& application::sketches_to_json(const data_sketches& sketches) {
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	sketches.write(writer);
+	return writer.str();
+}
 
-	LOG(debug) << "Base URI: " << base.to_string()
-		<< " - URI resource: " << url_full.resource().to_string();
-	
-	// Actual sending is out of scope...
-	// so reporting unconditional success here
-	LOG(info) << "Data sent successfully to " << url;
+const std::string& application::processes_to_json(const process_top& top) {
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	top.write(writer);
+	return writer.str();
 }
 
-static void report_sent_callback(const data& sent_data)
-{
-	static unsigned reports_sent = 0;
-	static float latest_cpu_values[10] = { 0 };
-	static mutex m;
+const std::string& application::cores_to_json(const core_usage& usage) {
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	usage.write(writer);
+	return writer.str();
+}
 
-	lock_guard<mutex> l(m);
+const std::string& application::network_to_json(const net_usage& usage) {
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	usage.write(writer);
+	return writer.str();
+}
 
-	latest_cpu_values[reports_sent % 10] = sent_data.get_cpu_percent();
+const std::string& application::disk_rates_to_json(const disk_usage& usage) {
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	usage.write(writer);
+	return writer.str();
+}
 
-	// Every 10 reports sent - show statistics about mean CPU usage
-	// Skip first time hit
-	if ((++reports_sent) % 10 == 0 && reports_sent != 0)
-	{
-		auto sum = std::accumulate(std::begin(latest_cpu_values), std::end(latest_cpu_values), 0.0f);
-		auto mean = sum / 10.0f;
+const std::string& application::self_to_json() {
+	json_writer& writer = pimpl_->writer;
+	writer.clear();
+	pimpl_->self->write(writer, pimpl_->sender ?
+		&pimpl_->sender->request_latency() : nullptr);
+	return writer.str();
+}
 
-		LOG(info) << "Mean CPU usage: " << mean;
+static chrono::milliseconds checked_period(
+	const chrono::milliseconds& period,
+	const chrono::milliseconds& min) {
+	if (period < min || period > chrono::seconds(INT_MAX)) {
+		throw invalid_argument("Invalid arguments to application constructor");
 	}
+	return period;
 }
 
-struct application::impl final {
-	atomic<bool> stop = false;
-	atomic<bool> running = false;
-};
-
 application::application(
 	const std::chrono::seconds& period) :
-	pimpl_(new impl),
-	period_(period) {
-	if (period_ < chrono::seconds(1) ||
-        period_ > chrono::seconds(INT_MAX)) {
-		throw invalid_argument("Invalid arguments to application constructor");
+	application(checked_period(period, chrono::seconds(1)), period) {
+}
+
+application::application(
+	const std::chrono::milliseconds& sample_period,
+	const std::chrono::milliseconds& report_period) :
+	period_(checked_period(sample_period, chrono::milliseconds(10))),
+	report_period_(checked_period(report_period, period_)) {
+	if (report_period_ % period_ != chrono::milliseconds::zero()) {
+		throw invalid_argument("Report period must be a multiple of the "
+							   "sample period");
 	}
+	pimpl_.reset(new impl(period_,
+		static_cast<size_t>(report_period_ / period_)));
 }
 
 application::~application() {
 	
 }
 
+void application::set_rolling_windows(const vector<size_t>& lengths) {
+	if (pimpl_->running) {
+		throw logic_error("Cannot change rolling windows while running");
+	}
+	pimpl_->stats.reset(new rolling_stats(lengths));
+}
+
+void application::enable_sending(const sender_options& options) {
+	if (pimpl_->running) {
+		throw logic_error("Cannot enable sending while running");
+	}
+	pimpl_->sender.reset(new client::sender(options));
+}
+
+void application::enable_process_top(size_t count) {
+	if (pimpl_->running) {
+		throw logic_error("Cannot enable process top while running");
+	}
+	pimpl_->processes.reset(new process_table(count));
+}
+
+void application::enable_core_usage() {
+	if (pimpl_->running) {
+		throw logic_error("Cannot enable core usage while running");
+	}
+	pimpl_->cores.reset(new cpu_cores());
+}
+
+void application::enable_network_usage() {
+	if (pimpl_->running) {
+		throw logic_error("Cannot enable network usage while running");
+	}
+	pimpl_->network.reset(new net_rates());
+}
+
+void application::enable_disk_rates() {
+	if (pimpl_->running) {
+		throw logic_error("Cannot enable disk rates while running");
+	}
+	pimpl_->disks.reset(new disk_rates());
+}
+
+void application::enable_history(const string& path, size_t capacity) {
+	if (pimpl_->running) {
+		throw logic_error("Cannot enable history while running");
+	}
+	pimpl_->history.reset(new client::history(path, capacity));
+}
+
+void application::enable_self_metrics(const chrono::seconds& period) {
+	if (pimpl_->running) {
+		throw logic_error("Cannot enable self metrics while running");
+	}
+	if (period <= chrono::seconds::zero()) {
+		throw invalid_argument("Self metrics period must be positive");
+	}
+	pimpl_->self_period = period;
+	pimpl_->self.reset(new self_metrics());
+}
+
+void application::set_probe_deadlines(const probe_deadlines& deadlines) {
+	if (pimpl_->running) {
+		throw logic_error("Cannot change probe deadlines while running");
+	}
+	pimpl_->probes.reset(new probe_runner(deadlines));
+}
+
+void application::enable_adaptive_sampling(const adaptive_options& options) {
+	if (pimpl_->running) {
+		throw logic_error("Cannot enable adaptive sampling while running");
+	}
+	pimpl_->rate.reset(new adaptive_rate(period_, options));
+}
+
+/**
+ * Names of the probes in mask, comma separated.
+ */
+static string probe_names(unsigned mask) {
+	string names;
+	for (size_t i = 0; i < os::probe_count; ++i) {
+		if ((mask & (1u << i)) != 0) {
+			if (!names.empty()) {
+				names += ", ";
+			}
+			names += probe_name(static_cast<os::probe>(i));
+		}
+	}
+	return names;
+}
+
+void application::consume(const collected& c) {
+	const unsigned stale = c.sample.stale;
+	if (stale != pimpl_->stale) {
+		if (stale & ~pimpl_->stale) {
+			LOG(warning) << "Probes past their deadline, reporting their "
+						 << "last values: " << probe_names(stale & ~pimpl_->stale);
+		}
+		if (pimpl_->stale & ~stale) {
+			LOG(info) << "Probes back within their deadline: "
+					  << probe_names(pimpl_->stale & ~stale);
+		}
+		pimpl_->stale = stale;
+	}
+	if (c.sample.period_ms != pimpl_->period_ms) {
+		LOG(info) << "Sampling every " << c.sample.period_ms << " ms";
+		pimpl_->period_ms = c.sample.period_ms;
+	}
+	pimpl_->stats->push(c.sample.sample);
+	if (pimpl_->samples_per_report > 1) {
+		// Only summary reports log the sketches
+		pimpl_->sketches.push(c.sample);
+	}
+	if (pimpl_->disks) {
+		pimpl_->disks->update(c.disk);
+	}
+	try {
+		if (pimpl_->samples_per_report == 1) {
+			LOG(info) << data_to_json(c.sample.sample);
+			LOG(info) << stats_to_json(*pimpl_->stats);
+		} else {
+			pimpl_->samples.push(c.sample.sample);
+		}
+		if (pimpl_->sender) {
+			// Picked up within a period, see send()
+			pimpl_->outbox.try_push(c.sample);
+		}
+	}
+	catch (const std::exception& e) {
+		LOG(error) << "Failed to report data: " << e.what();
+	}
+
+	if (pimpl_->history) {
+		try {
+			pimpl_->history->push(c.sample);
+		}
+		catch (const std::exception& e) {
+			LOG(error) << "Failed to store history: " << e.what();
+		}
+	}
+
+	if (c.report_due) {
+		try {
+			if (!pimpl_->samples.empty()) {
+				data_summary summary;
+				pimpl_->samples.summarize(summary);
+				LOG(info) << summary_to_json(summary);
+				LOG(info) << stats_to_json(*pimpl_->stats);
+				LOG(info) << sketches_to_json(pimpl_->sketches);
+			}
+		}
+		catch (const std::exception& e) {
+			LOG(error) << "Failed to report data summary: " << e.what();
+		}
+		pimpl_->samples.clear();
+		pimpl_->sketches.clear();
+
+		if (pimpl_->processes) {
+			try {
+				if (pimpl_->processes->sample(pimpl_->top)) {
+					LOG(info) << processes_to_json(pimpl_->top);
+				}
+			}
+			catch (const std::exception& e) {
+				LOG(error) << "Failed to report processes: " << e.what();
+			}
+		}
+
+		if (pimpl_->cores) {
+			try {
+				if (pimpl_->cores->sample(pimpl_->core_use)) {
+					LOG(info) << cores_to_json(pimpl_->core_use);
+				}
+			}
+			catch (const std::exception& e) {
+				LOG(error) << "Failed to report core usage: " << e.what();
+			}
+		}
+
+		if (pimpl_->network) {
+			try {
+				if (pimpl_->network->sample(pimpl_->net_use)) {
+					LOG(info) << network_to_json(pimpl_->net_use);
+				}
+			}
+			catch (const std::exception& e) {
+				LOG(error) << "Failed to report network usage: " << e.what();
+			}
+		}
+
+		if (pimpl_->disks) {
+			try {
+				pimpl_->disks->take(pimpl_->disk_use);
+				LOG(info) << disk_rates_to_json(pimpl_->disk_use);
+			}
+			catch (const std::exception& e) {
+				LOG(error) << "Failed to report disk rates: " << e.what();
+			}
+		}
+	}
+}
+
+void application::sink() {
+	unsigned long long missed = pimpl_->scheduler.missed_deadlines();
+	unsigned long long dropped = pimpl_->queue.dropped();
+	pimpl_->samples.clear();
+	pimpl_->stats->clear();
+	pimpl_->sketches.reset();
+	if (pimpl_->processes) {
+		// Base of the first report's CPU and IO deltas
+		pimpl_->processes->sample(pimpl_->top);
+	}
+	if (pimpl_->cores) {
+		pimpl_->cores->sample(pimpl_->core_use);
+	}
+	if (pimpl_->network) {
+		pimpl_->network->sample(pimpl_->net_use);
+	}
+	if (pimpl_->disks) {
+		pimpl_->disks->restart();
+	}
+	pimpl_->self_published = chrono::steady_clock::now();
+	pimpl_->stale = 0;
+	pimpl_->period_ms = static_cast<unsigned>(period_.count());
+
+	for (;;) {
+		if (pimpl_->self) {
+			pimpl_->self->wakeup();
+		}
+		// Read before draining, so samples queued right before the
+		// collector stopped are still consumed.
+		const bool collecting = pimpl_->collecting;
+		pimpl_->queue.consume_all([this](const collected& c) {
+			consume(c);
+		});
+
+		const auto total_missed = pimpl_->scheduler.missed_deadlines();
+		if (total_missed != missed) {
+			LOG(warning) << "Collection fell behind, skipped "
+						 << total_missed - missed << " deadlines";
+			missed = total_missed;
+		}
+		const auto total_dropped = pimpl_->queue.dropped();
+		if (total_dropped != dropped) {
+			LOG(warning) << "Reporting fell behind, dropped "
+						 << total_dropped - dropped << " samples";
+			dropped = total_dropped;
+		}
+
+		if (pimpl_->self && chrono::steady_clock::now() -
+			pimpl_->self_published >= pimpl_->self_period) {
+			try {
+				LOG(info) << self_to_json();
+			}
+			catch (const std::exception& e) {
+				LOG(error) << "Failed to report self metrics: " << e.what();
+			}
+			pimpl_->self_published = chrono::steady_clock::now();
+		}
+
+		if (!collecting) {
+			break;
+		}
+		// The collector notifies without taking the lock, so a wakeup can
+		// be missed; the timeout bounds the delay to one period.
+		unique_lock<mutex> l(pimpl_->sink_m);
+		pimpl_->sink_cv.wait_for(l, period_, [this] {
+			return !pimpl_->queue.empty() || !pimpl_->collecting;
+		});
+	}
+}
+
+void application::send() {
+	unsigned long long dropped = pimpl_->outbox.dropped();
+	for (;;) {
+		if (pimpl_->self) {
+			pimpl_->self->wakeup();
+		}
+		// Read before draining, so records queued right before the sink
+		// stopped are still sent.
+		const bool sinking = pimpl_->sinking;
+		pimpl_->outbox.consume_all([this](const record& r) {
+			try {
+				pimpl_->sender->add(r);
+			}
+			catch (const std::exception& e) {
+				LOG(error) << "Failed to send data to server: " << e.what();
+			}
+		});
+		// A batch that is not full waits no longer than batch_delay, even
+		// once records stop coming
+		try {
+			pimpl_->sender->send_due();
+		}
+		catch (const std::exception& e) {
+			LOG(error) << "Failed to send data to server: " << e.what();
+		}
+
+		const auto total_dropped = pimpl_->outbox.dropped();
+		if (total_dropped != dropped) {
+			LOG(warning) << "Sending fell behind, dropped "
+						 << total_dropped - dropped << " samples";
+			dropped = total_dropped;
+		}
+
+		if (!sinking) {
+			break;
+		}
+		// Records are not worth a wakeup each: polling every period delays
+		// them, and a due batch, by at most that.
+		unique_lock<mutex> l(pimpl_->send_m);
+		pimpl_->send_cv.wait_for(l, period_, [this] {
+			return !pimpl_->sinking;
+		});
+	}
+
+	try {
+		pimpl_->sender->flush();
+	}
+	catch (const std::exception& e) {
+		LOG(error) << "Failed to send remaining data: " << e.what();
+	}
+}
+
 void application::run() {
 	if (pimpl_->running) {
 		LOG(warning) << "application::run already running, ignoring call";
 		return;
 	}
 
+	pimpl_->scheduler.set_period(period_);
+	pimpl_->scheduler.reset();
+	if (pimpl_->rate) {
+		pimpl_->rate->reset();
+	}
 	pimpl_->running = true;
-
-	LOG(info) << "Starting application loop";
-	utils::scope_exit exit_guard([this] {
+	utils::scope_exit running_guard([this] {
 		pimpl_->running = false;
-		pimpl_->stop = false;
+	});
 
+	LOG(info) << "Starting application loop";
+	// Logging happens on the sink thread and sending on a thread of its
+	// own, so a slow disk never delays the next sample and a slow server
+	// delays neither the samples nor the log.
+	utils::scope_exit exit_log([] {
 		LOG(info) << "Exiting application loop";
 	});
+	thread send_thread;
+	if (pimpl_->sender) {
+		pimpl_->sinking = true;
+		send_thread = thread([this] {
+			send();
+		});
+	}
+	utils::scope_exit send_guard([this, &send_thread] {
+		if (send_thread.joinable()) {
+			pimpl_->sinking = false;
+			pimpl_->send_cv.notify_one();
+			send_thread.join();
+		}
+	});
+	pimpl_->collecting = true;
+	thread sink_thread([this] {
+		sink();
+	});
+	utils::scope_exit exit_guard([this, &sink_thread] {
+		pimpl_->collecting = false;
+		pimpl_->sink_cv.notify_one();
+		sink_thread.join();
+	});
 
-	const chrono::milliseconds resolution(100);
+	size_t ticks = 0;
+	bool report_due = false;
+	bool not_read_logged = false;
+	auto previous = chrono::steady_clock::now();
+	auto next_report = previous + report_period_;
 	do {
+		if (pimpl_->self) {
+			pimpl_->self->wakeup();
+		}
+		const auto now = chrono::steady_clock::now();
+		// Reports follow the tick count so a failed sample does not shift
+		// the report grid; the report moves to the next sample instead.
+		// With an adaptive period ticks vary, the grid follows the clock.
+		if (pimpl_->samples_per_report > 1) {
+			if (pimpl_->rate) {
+				if (now >= next_report) {
+					report_due = true;
+					next_report += ((now - next_report) / report_period_ + 1) *
+						report_period_;
+				}
+			} else if (++ticks % pimpl_->samples_per_report == 0) {
+				report_due = true;
+			}
+		} else {
+			// Every sample is a report of its own
+			report_due = true;
+		}
+
 		try {
-			using namespace web;
-			auto collected_data = CollectData();
-			const json::value jsondata(data_to_json(collected_data));
- 			LOG(info) << jsondata.to_string() ;
+			const chrono::milliseconds period = pimpl_->scheduler.period();
+			const auto timestamp = unix_milliseconds(chrono::system_clock::now());
+			const data sample = CollectData();
+			const collected c{
+				record(timestamp, sample, static_cast<unsigned>(period.count()),
+					   pimpl_->last_stale),
+				report_due,
+				pimpl_->last_disk
+			};
+			if (pimpl_->rate) {
+				const chrono::milliseconds next = pimpl_->rate->next(c.sample.sample,
+					chrono::duration_cast<chrono::milliseconds>(now - previous));
+				if (next != period) {
+					pimpl_->scheduler.set_period(next);
+				}
+			}
+			previous = now;
+			if (pimpl_->queue.try_push(c)) {
+				report_due = false;
+				pimpl_->sink_cv.notify_one();
+			}
+		}
+		catch (const probes_not_read&) {
+			// Only until the slowest probe first returns
+			if (!not_read_logged) {
+				LOG(info) << "Waiting for the first reading of every probe";
+				not_read_logged = true;
+			}
 		}
 		catch (const std::exception& e) {
-			LOG(error) << "Failed to collect and send data to server: "
-				<< e.what();
+			LOG(error) << "Failed to collect data: " << e.what();
 		}
-	} while (utils::interruptible_sleep(period_, resolution, pimpl_->stop) !=
+	} while (pimpl_->scheduler.wait_next() !=
 		utils::interruptible_sleep_result::interrupted);
 }
 
 void application::stop() noexcept {
 	if (pimpl_->running) {
 		LOG(info) << "Stop requested, waiting for tasks to finish";
-		pimpl_->stop = true;
+		pimpl_->scheduler.stop();
+		if (pimpl_->sender) {
+			pimpl_->sender->stop();
+		}
 	}
 }
 
+unsigned long long application::missed_deadlines() const noexcept {
+	return pimpl_->scheduler.missed_deadlines();
+}
+
+unsigned long long application::dropped_samples() const noexcept {
+	return pimpl_->queue.dropped();
+}
+
 } //namespace client
 } //namespace monitor
 } //namespace crossover
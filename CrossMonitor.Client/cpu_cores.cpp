@@ -0,0 +1,139 @@
+#include <cpu_cores.hpp>
+
+#include <cmath>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+void os::core_ticks::resize(size_t cpus) {
+	user.resize(cpus);
+	system.resize(cpus);
+	idle.resize(cpus);
+	iowait.resize(cpus);
+	steal.resize(cpus);
+}
+
+static void write_array(json_writer& writer, const char* name,
+						const vector<float>& values) {
+	writer.key(name);
+	writer.begin_array();
+	for (const float v : values) {
+		writer.value(static_cast<unsigned>(lround(v)));
+	}
+	writer.end_array();
+}
+
+void core_usage::write(json_writer& writer) const {
+	writer.begin_object();
+	writer.key("cpus");
+	writer.value(static_cast<unsigned long long>(size()));
+	writer.key("max_busy");
+	writer.value(max_busy);
+	writer.key("mean_busy");
+	writer.value(mean_busy);
+	writer.key("imbalance");
+	writer.value(imbalance);
+	writer.key("busiest");
+	writer.value(static_cast<unsigned long long>(busiest));
+	write_array(writer, "busy", busy);
+	write_array(writer, "user", user);
+	write_array(writer, "system", system);
+	write_array(writer, "iowait", iowait);
+	write_array(writer, "steal", steal);
+	writer.end_object();
+}
+
+bool cpu_cores::sample(core_usage& out) noexcept {
+	if (!os::read_core_ticks(current_)) {
+		return false;
+	}
+	try {
+		compute(previous_, current_, out);
+	} catch (const std::exception&) {
+		return false;
+	}
+	previous_.user.swap(current_.user);
+	previous_.system.swap(current_.system);
+	previous_.idle.swap(current_.idle);
+	previous_.iowait.swap(current_.iowait);
+	previous_.steal.swap(current_.steal);
+	return true;
+}
+
+void cpu_cores::compute(const os::core_ticks& previous,
+						const os::core_ticks& current, core_usage& out) {
+	const size_t n = current.size();
+	out.busy.resize(n);
+	out.user.resize(n);
+	out.system.resize(n);
+	out.iowait.resize(n);
+	out.steal.resize(n);
+
+	// With a different set of CPUs every counter starts from zero: the
+	// previous values are masked out instead of branching in the loop.
+	const bool same = previous.size() == n;
+	const unsigned long long keep = same ? ~0ull : 0;
+	const os::core_ticks& base = same ? previous : current;
+	const unsigned long long* const pu = base.user.data();
+	const unsigned long long* const ps = base.system.data();
+	const unsigned long long* const pi = base.idle.data();
+	const unsigned long long* const pw = base.iowait.data();
+	const unsigned long long* const pt = base.steal.data();
+	const unsigned long long* const cu = current.user.data();
+	const unsigned long long* const cs = current.system.data();
+	const unsigned long long* const ci = current.idle.data();
+	const unsigned long long* const cw = current.iowait.data();
+	const unsigned long long* const ct = current.steal.data();
+	float* const busy = out.busy.data();
+	float* const user = out.user.data();
+	float* const system = out.system.data();
+	float* const iowait = out.iowait.data();
+	float* const steal = out.steal.data();
+
+	for (size_t i = 0; i < n; ++i) {
+		// A counter going backwards counts as unchanged: proc(5) warns
+		// per CPU iowait can decrease, and counting it from zero would
+		// turn its whole value since boot into this interval's. The
+		// conditionals compile to selects.
+		const unsigned long long bu = pu[i] & keep;
+		const unsigned long long bs = ps[i] & keep;
+		const unsigned long long bi = pi[i] & keep;
+		const unsigned long long bw = pw[i] & keep;
+		const unsigned long long bt = pt[i] & keep;
+		const float u = static_cast<float>(cu[i] >= bu ? cu[i] - bu : 0);
+		const float s = static_cast<float>(cs[i] >= bs ? cs[i] - bs : 0);
+		const float d = static_cast<float>(ci[i] >= bi ? ci[i] - bi : 0);
+		const float w = static_cast<float>(cw[i] >= bw ? cw[i] - bw : 0);
+		const float t = static_cast<float>(ct[i] >= bt ? ct[i] - bt : 0);
+		const float total = u + s + d + w + t;
+		const float scale = total > 0 ? 100 / total : 0;
+		user[i] = u * scale;
+		system[i] = s * scale;
+		iowait[i] = w * scale;
+		steal[i] = t * scale;
+		busy[i] = (u + s + t) * scale;
+	}
+
+	// The summary is a separate pass to keep the loop above branch free
+	float max_busy = 0;
+	float sum = 0;
+	size_t busiest = 0;
+	for (size_t i = 0; i < n; ++i) {
+		sum += busy[i];
+		if (busy[i] > max_busy) {
+			max_busy = busy[i];
+			busiest = i;
+		}
+	}
+	out.max_busy = max_busy;
+	out.mean_busy = n == 0 ? 0 : sum / n;
+	out.imbalance = max_busy - out.mean_busy;
+	out.busiest = busiest;
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <json_writer.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+/**
+ * Cumulative time of every logical CPU, one array per kind of time so
+ * deltas are computed a whole array at a time. Units are OS specific.
+ * Nice time counts as user and interrupt time as system. Windows reports
+ * no iowait nor steal time, those stay zero there.
+ */
+struct core_ticks final {
+	std::vector<unsigned long long> user;
+	std::vector<unsigned long long> system;
+	std::vector<unsigned long long> idle;
+	std::vector<unsigned long long> iowait;
+	std::vector<unsigned long long> steal;
+
+	std::size_t size() const noexcept {
+		return user.size();
+	}
+	/**
+	 * May throw std::bad_alloc.
+	 */
+	void resize(std::size_t cpus);
+};
+
+/**
+ * Reads the ticks of every online logical CPU, reusing the storage of out.
+ * @return false if they could not be read.
+ */
+bool read_core_ticks(core_ticks& out) noexcept;
+
+} //namespace os
+
+/**
+ * Use of every logical CPU between two samples, in percent, one array per
+ * kind of time. Busy time is user, system and steal time; iowait counts
+ * as idle, as in cpu_percent.
+ */
+struct core_usage final {
+	std::vector<float> busy;
+	std::vector<float> user;
+	std::vector<float> system;
+	std::vector<float> iowait;
+	std::vector<float> steal;
+
+	float max_busy = 0;
+	float mean_busy = 0;
+	/**
+	 * max_busy - mean_busy: high when a few CPUs do all the work, e.g.
+	 * one pegged core on an otherwise idle machine.
+	 */
+	float imbalance = 0;
+	/**
+	 * Index of the busiest CPU.
+	 */
+	std::size_t busiest = 0;
+
+	std::size_t size() const noexcept {
+		return busy.size();
+	}
+
+	/**
+	 * Writes {"cpus":n,"max_busy":..,"mean_busy":..,"imbalance":..,
+	 * "busiest":i,"busy":[...],"user":[...],"system":[...],
+	 * "iowait":[...],"steal":[...]}, the per CPU percentages rounded to
+	 * integers to keep the arrays short.
+	 */
+	void write(json_writer& writer) const;
+};
+
+/**
+ * Per CPU use, from the difference between consecutive reads of the CPU
+ * ticks. The delta loops run over plain arrays with no branches, which
+ * compilers vectorize; storage is reused between samples.
+ * Not thread safe.
+ */
+class cpu_cores final : public boost::noncopyable {
+public:
+	cpu_cores() = default;
+
+	/**
+	 * Reads the ticks and computes the use since the previous call, or
+	 * since boot on the first one.
+	 * @return false if the ticks could not be read.
+	 */
+	bool sample(core_usage& out) noexcept;
+
+	/**
+	 * Computes the use between two reads of the ticks. Counters that went
+	 * backwards (per CPU iowait may, idle jitters on tickless kernels)
+	 * count as unchanged; with a changed number of CPUs every counter
+	 * counts from zero.
+	 * May throw std::bad_alloc.
+	 */
+	static void compute(const os::core_ticks& previous,
+						const os::core_ticks& current, core_usage& out);
+
+private:
+	os::core_ticks previous_;
+	os::core_ticks current_;
+}; //class cpu_cores
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,72 @@
+#include "cpu_cores.hpp"
+#include "proc_file.hpp"
+
+#include "log.hpp"
+
+#include <mutex>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+bool read_core_ticks(core_ticks& out) noexcept {
+	static proc_file file("/proc/stat");
+	// The per CPU lines follow the aggregate one at the top of the file,
+	// this covers them on machines with hundreds of CPUs.
+	static char buffer[64 * 1024];
+	static mutex m;
+
+	const lock_guard<mutex> guard(m);
+	if (file.read(buffer, sizeof(buffer)) <= 0) {
+		return false;
+	}
+
+	text_parser parser(buffer);
+	if (!parser.consume("cpu ")) {
+		LOG(error) << "Unexpected /proc/stat format";
+		return false;
+	}
+	parser.skip_line();
+
+	try {
+		// Capacity is kept, so this allocates only when CPUs are added.
+		// Offline CPUs are missing from the file and stay zero.
+		out.resize(0);
+		while (parser.consume("cpu")) {
+			unsigned long long cpu = 0;
+			if (!parser.number(cpu)) {
+				break;
+			}
+			// user nice system idle iowait irq softirq steal
+			unsigned long long fields[8] = { 0 };
+			for (auto& field : fields) {
+				if (!parser.number(field)) {
+					break;
+				}
+			}
+			if (cpu >= out.size()) {
+				out.resize(static_cast<size_t>(cpu) + 1);
+			}
+			out.user[cpu] = fields[0] + fields[1];
+			out.system[cpu] = fields[2] + fields[5] + fields[6];
+			out.idle[cpu] = fields[3];
+			out.iowait[cpu] = fields[4];
+			out.steal[cpu] = fields[7];
+			parser.skip_line();
+		}
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to read the CPU times: " << e.what();
+		return false;
+	}
+	return out.size() != 0;
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,106 @@
+#include "cpu_cores.hpp"
+
+#include "log.hpp"
+
+#include <Windows.h>
+
+#include <mutex>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+/**
+ * SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION, in 100 ns units. Kernel time
+ * includes the idle, DPC and interrupt times.
+ */
+struct processor_times final {
+	LARGE_INTEGER idle;
+	LARGE_INTEGER kernel;
+	LARGE_INTEGER user;
+	LARGE_INTEGER dpc;
+	LARGE_INTEGER interrupt;
+	ULONG interrupt_count;
+};
+
+static const ULONG system_processor_performance_information = 8;
+
+typedef LONG(WINAPI* query_system_information_ex)(ULONG, PVOID, ULONG, PVOID,
+												   ULONG, PULONG);
+
+/**
+ * NtQuerySystemInformationEx takes the processor group as input, the plain
+ * NtQuerySystemInformation stops at the 64 CPUs of the calling thread's
+ * group.
+ */
+static query_system_information_ex find_query() noexcept {
+	const HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+	const auto query = ntdll ? reinterpret_cast<query_system_information_ex>(
+		GetProcAddress(ntdll, "NtQuerySystemInformationEx")) : nullptr;
+	if (!query) {
+		LOG(error) << "NtQuerySystemInformationEx is not available";
+	}
+	return query;
+}
+
+bool read_core_ticks(core_ticks& out) noexcept {
+	static const query_system_information_ex query = find_query();
+	static vector<processor_times> times;
+	static mutex m;
+
+	if (!query) {
+		return false;
+	}
+
+	const lock_guard<mutex> guard(m);
+	const WORD groups = GetActiveProcessorGroupCount();
+	try {
+		out.resize(GetActiveProcessorCount(ALL_PROCESSOR_GROUPS));
+		times.resize(MAXIMUM_PROC_PER_GROUP);
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to read the CPU times: " << e.what();
+		return false;
+	}
+
+	size_t cpu = 0;
+	for (WORD group = 0; group < groups; ++group) {
+		USHORT input = group;
+		ULONG size = 0;
+		const LONG status = query(system_processor_performance_information,
+								  &input, sizeof(input), times.data(),
+								  static_cast<ULONG>(times.size() *
+													 sizeof(processor_times)),
+								  &size);
+		if (status < 0) {
+			LOG(error) << "Failed to read the CPU times, status: " << status;
+			return false;
+		}
+		const size_t count = size / sizeof(processor_times);
+		for (size_t i = 0; i < count && cpu < out.size(); ++i, ++cpu) {
+			const processor_times& t = times[i];
+			out.user[cpu] = static_cast<unsigned long long>(t.user.QuadPart);
+			out.system[cpu] = static_cast<unsigned long long>(
+				t.kernel.QuadPart - t.idle.QuadPart);
+			out.idle[cpu] = static_cast<unsigned long long>(t.idle.QuadPart);
+			// Windows keeps no iowait nor steal time
+			out.iowait[cpu] = 0;
+			out.steal[cpu] = 0;
+		}
+	}
+	try {
+		out.resize(cpu);
+	} catch (const std::exception&) {
+		return false;
+	}
+	return cpu != 0;
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,99 @@
+#include <data_sketches.hpp>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+data_sketches::data_sketches(double relative_accuracy, size_t max_bins) {
+	sketches_.reserve(data_fields::size);
+	for (size_t i = 0; i < data_fields::size; ++i) {
+		sketches_.emplace_back(relative_accuracy, max_bins);
+	}
+	last_.fill(0);
+}
+
+void data_sketches::push(const record& r) noexcept {
+	const bool forward = has_last_ && r.timestamp > last_timestamp_;
+	const double seconds = forward ?
+		static_cast<double>(r.timestamp - last_timestamp_) / 1000 : 0;
+
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		const size_t i = field_index<F, data_fields>::value;
+		const double value = static_cast<double>(F::get(r.sample));
+		if (!F::counter) {
+			sketches_[i].add(value);
+		} else if (forward && value >= last_[i]) {
+			sketches_[i].add((value - last_[i]) / seconds);
+		}
+		last_[i] = value;
+	});
+	last_timestamp_ = r.timestamp;
+	has_last_ = true;
+	++samples_;
+}
+
+void data_sketches::clear() noexcept {
+	for (utils::ddsketch& sketch : sketches_) {
+		sketch.clear();
+	}
+	samples_ = 0;
+}
+
+void data_sketches::reset() noexcept {
+	clear();
+	has_last_ = false;
+}
+
+void data_sketches::write(json_writer& writer) const {
+	writer.begin_object();
+	writer.key("relative_accuracy");
+	writer.value(sketches_.front().relative_accuracy());
+	writer.key("samples");
+	writer.value(static_cast<unsigned long long>(samples_));
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		const utils::ddsketch& s = this->template get<F>();
+		writer.key(F::name());
+		writer.begin_object();
+		writer.key("count");
+		writer.value(s.count());
+		writer.key("max");
+		writer.value(s.max());
+		writer.key("min");
+		writer.value(s.min());
+		writer.key("p50");
+		writer.value(s.quantile(0.5));
+		writer.key("p95");
+		writer.value(s.quantile(0.95));
+		writer.key("p99");
+		writer.value(s.quantile(0.99));
+		writer.key("zeros");
+		writer.value(s.zero_count());
+		// Only the bins holding values, most are empty
+		writer.key("keys");
+		writer.begin_array();
+		for (int k = s.min_key(); k <= s.max_key(); ++k) {
+			if (s.bin(k) != 0) {
+				writer.value(static_cast<long long>(k));
+			}
+		}
+		writer.end_array();
+		writer.key("counts");
+		writer.begin_array();
+		for (int k = s.min_key(); k <= s.max_key(); ++k) {
+			if (s.bin(k) != 0) {
+				writer.value(s.bin(k));
+			}
+		}
+		writer.end_array();
+		writer.end_object();
+	});
+	writer.end_object();
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <data_fields.hpp>
+#include <ddsketch.hpp>
+#include <json_writer.hpp>
+#include <record.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Quantile sketch of every data field over a report period. Gauges are
+ * counted as sampled; counter fields (disk bytes) are counted as their
+ * rate per second since the previous record, so the sketches give the
+ * tail of IO rates. Pushing never allocates.
+ * Owned by the thread that pushes the records; it needs no locking.
+ */
+class data_sketches final : public boost::noncopyable {
+public:
+	/**
+	 * Throws std::invalid_argument on invalid sketch arguments.
+	 * @param relative_accuracy of every quantile, see utils::ddsketch.
+	 * @param max_bins per field.
+	 */
+	explicit data_sketches(double relative_accuracy = 0.01,
+						   std::size_t max_bins = 2048);
+
+	/**
+	 * Counts the fields of r. The first record only sets the base of the
+	 * rates. A counter that went backwards, or a timestamp that did not
+	 * move forward, skips the rate and sets a new base.
+	 */
+	void push(const record& r) noexcept;
+	/**
+	 * Starts a new period, keeping the last record as the base of the
+	 * next rates.
+	 */
+	void clear() noexcept;
+	/**
+	 * Starts over, forgetting the last record too.
+	 */
+	void reset() noexcept;
+
+	/**
+	 * Records pushed since the last clear().
+	 */
+	std::size_t samples() const noexcept {
+		return samples_;
+	}
+	template <typename Field>
+	const utils::ddsketch& get() const noexcept {
+		return sketches_[field_index<Field, data_fields>::value];
+	}
+
+	/**
+	 * Writes {"relative_accuracy":a,"samples":n,"cpu_percent":{"count":n,
+	 * "max":..,"min":..,"p50":..,"p95":..,"p99":..,"zeros":n,"keys":[...],
+	 * "counts":[...]},...}. keys and counts list the bins holding values,
+	 * so the server can rebuild and merge the sketches.
+	 */
+	void write(json_writer& writer) const;
+
+private:
+	std::vector<utils::ddsketch> sketches_;
+	std::array<double, data_fields::size> last_;
+	unsigned long long last_timestamp_ = 0;
+	bool has_last_ = false;
+	std::size_t samples_ = 0;
+}; //class data_sketches
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
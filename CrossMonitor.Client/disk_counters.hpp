@@ -0,0 +1,64 @@
+#pragma once
+
+#include "os.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+/**
+ * Reads IO counters of every physical disk through handles kept open
+ * between samples. Disks are discovered on the first sample and
+ * rediscovered every rescan period or as soon as a disk disappears,
+ * so hot-plugged devices are picked up without reopening the others.
+ * Thread safe.
+ */
+class disk_counters final : public boost::noncopyable {
+public:
+	/**
+	 * May throw std::exception derived exceptions.
+	 * @param rescan_period time between device rediscoveries.
+	 */
+	explicit disk_counters(
+		const std::chrono::seconds& rescan_period = std::chrono::seconds(30));
+	~disk_counters();
+
+	/**
+	 * Reads the counters of every disk.
+	 * @param disks receives one entry per disk, its storage is reused.
+	 * @param total receives the sum of all disks.
+	 * @return false if no disk could be read.
+	 */
+	bool sample(std::vector<disk_stats>& disks, disk_stats& total) noexcept;
+	/**
+	 * Aggregate only version of sample, does not touch per disk storage.
+	 */
+	bool sample(disk_stats& total) noexcept;
+	/**
+	 * Aggregate only version of sample, also getting the generation of
+	 * the disks summed: it changes whenever a disk is added, removed or
+	 * reopened, the total then jumping by whatever that disk counted.
+	 */
+	bool sample(disk_stats& total, unsigned& generation) noexcept;
+	/**
+	 * Forces device rediscovery on the next sample.
+	 */
+	void rescan() noexcept;
+
+private:
+	struct impl;
+
+	std::unique_ptr<impl> pimpl_;
+}; //class disk_counters
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,283 @@
+#include "disk_counters.hpp"
+#include "proc_file.hpp"
+
+#include "log.hpp"
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+// Largest /proc/diskstats read, some 100000 block devices.
+static const size_t max_buffer = 16 * 1024 * 1024;
+
+struct disk_counters::impl final {
+	struct device final {
+		unsigned major;
+		unsigned minor;
+		string name;
+	};
+
+	explicit impl(const chrono::seconds& period) :
+		rescan_period(period),
+		diskstats("/proc/diskstats"),
+		buffer(64 * 1024) {
+	}
+
+	/**
+	 * Collects physical disks, i.e. entries in /sys/block backed by a
+	 * device. Partitions, loop, ram and device mapper entries are left out
+	 * so IO is not counted twice.
+	 */
+	void discover() {
+		last_scan = chrono::steady_clock::now();
+		scan_requested = false;
+
+		DIR* dir = ::opendir("/sys/block");
+		if (!dir) {
+			LOG(error) << "Failed to open /sys/block, code: " << errno;
+			return;
+		}
+
+		vector<device> found;
+		char path[512];
+		char dev_number[64];
+		while (const dirent* entry = ::readdir(dir)) {
+			if (entry->d_name[0] == '.') {
+				continue;
+			}
+			snprintf(path, sizeof(path), "/sys/block/%s/device", entry->d_name);
+			if (::access(path, F_OK) != 0) {
+				continue;
+			}
+			snprintf(path, sizeof(path), "/sys/block/%s/dev", entry->d_name);
+			proc_file dev(path);
+			if (dev.read(dev_number, sizeof(dev_number)) <= 0) {
+				continue;
+			}
+			// Format is "major:minor"
+			text_parser parser(dev_number);
+			unsigned long long major = 0;
+			unsigned long long minor = 0;
+			if (parser.number(major) && parser.consume(":") &&
+				parser.number(minor)) {
+				found.push_back(device{ static_cast<unsigned>(major),
+										static_cast<unsigned>(minor),
+										entry->d_name });
+			}
+		}
+		::closedir(dir);
+
+		if (found.size() != devices.size()) {
+			LOG(info) << "Monitoring " << found.size() << " disks";
+		}
+		if (!same_devices(found)) {
+			++generation;
+		}
+		devices.swap(found);
+	}
+
+	bool same_devices(const vector<device>& found) const noexcept {
+		if (found.size() != devices.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < found.size(); ++i) {
+			if (found[i].major != devices[i].major ||
+				found[i].minor != devices[i].minor) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * Finds a device starting at the position following the previous match,
+	 * /proc/diskstats keeps a stable order so this is O(1) in practice.
+	 */
+	const device* find(unsigned major, unsigned minor, size_t& hint) const
+		noexcept {
+		const size_t count = devices.size();
+		for (size_t i = 0; i < count; ++i) {
+			const size_t index = (hint + i) % count;
+			const device& dev = devices[index];
+			if (dev.major == major && dev.minor == minor) {
+				hint = index + 1;
+				return &dev;
+			}
+		}
+		return nullptr;
+	}
+
+	/**
+	 * Reads the whole file, growing the buffer when it was filled: a full
+	 * buffer may have cut the file short, leaving disks out of the sums.
+	 */
+	bool read_file() noexcept {
+		for (;;) {
+			const ssize_t n = diskstats.read(buffer.data(), buffer.size());
+			if (n <= 0) {
+				return false;
+			}
+			if (static_cast<size_t>(n) < buffer.size() - 1 ||
+				buffer.size() >= max_buffer) {
+				return true;
+			}
+			try {
+				buffer.resize(buffer.size() * 2);
+			} catch (const std::exception& e) {
+				LOG(error) << "Failed to grow the /proc/diskstats buffer: "
+						   << e.what();
+				return true;
+			}
+		}
+	}
+
+	bool read(vector<disk_stats>* disks, disk_stats& total,
+			  unsigned* summed_generation) noexcept {
+		const lock_guard<mutex> guard(m);
+
+		total.read_bytes = total.write_bytes = 0;
+		total.reads = total.writes = 0;
+
+		try {
+			if (scan_requested ||
+				chrono::steady_clock::now() - last_scan >= rescan_period) {
+				discover();
+			}
+		} catch (const std::exception& e) {
+			LOG(error) << "Failed to discover disks: " << e.what();
+		}
+
+		if (!read_file()) {
+			return false;
+		}
+
+		// Sector counts in /proc/diskstats are always in 512 byte units.
+		const unsigned long long sector_size = 512;
+		size_t lines = 0;
+		size_t count = 0;
+		size_t hint = 0;
+
+		text_parser parser(buffer.data());
+		for (; !parser.at_end(); parser.skip_line()) {
+			++lines;
+			unsigned long long major = 0;
+			unsigned long long minor = 0;
+			if (!parser.number(major) || !parser.number(minor)) {
+				continue;
+			}
+			const device* dev = find(static_cast<unsigned>(major),
+									 static_cast<unsigned>(minor), hint);
+			if (!dev) {
+				continue;
+			}
+
+			size_t len = 0;
+			parser.token(len);
+			// reads, reads merged, sectors read, ms reading,
+			// writes, writes merged, sectors written
+			unsigned long long fields[7] = { 0 };
+			for (auto& field : fields) {
+				if (!parser.number(field)) {
+					break;
+				}
+			}
+
+			const unsigned long long read_bytes = fields[2] * sector_size;
+			const unsigned long long write_bytes = fields[6] * sector_size;
+			total.read_bytes += read_bytes;
+			total.write_bytes += write_bytes;
+			total.reads += fields[0];
+			total.writes += fields[4];
+
+			if (disks) {
+				if (disks->size() <= count) {
+					disks->emplace_back();
+				}
+				disk_stats& stats = (*disks)[count];
+				stats.name = dev->name;
+				stats.read_bytes = read_bytes;
+				stats.write_bytes = write_bytes;
+				stats.reads = fields[0];
+				stats.writes = fields[4];
+			}
+			++count;
+		}
+
+		if (disks) {
+			disks->resize(count);
+		}
+
+		// Block devices come and go with a line in /proc/diskstats, a
+		// changed line count or a vanished disk means something was
+		// plugged or unplugged.
+		if ((line_count != 0 && lines != line_count) ||
+			count != devices.size()) {
+			scan_requested = true;
+		}
+		line_count = lines;
+		// A disk missing from the file leaves the sums until rediscovery
+		if (count != summed) {
+			++generation;
+			summed = count;
+		}
+		if (summed_generation) {
+			*summed_generation = generation;
+		}
+
+		return count != 0;
+	}
+
+	const chrono::seconds rescan_period;
+	proc_file diskstats;
+	vector<char> buffer;
+	vector<device> devices;
+	size_t line_count = 0;
+	size_t summed = 0;
+	unsigned generation = 0;
+	chrono::steady_clock::time_point last_scan;
+	bool scan_requested = true;
+	mutex m;
+};
+
+disk_counters::disk_counters(const chrono::seconds& rescan_period) :
+	pimpl_(new impl(rescan_period)) {
+}
+
+disk_counters::~disk_counters() {
+}
+
+bool disk_counters::sample(vector<disk_stats>& disks,
+						   disk_stats& total) noexcept {
+	return pimpl_->read(&disks, total, nullptr);
+}
+
+bool disk_counters::sample(disk_stats& total) noexcept {
+	return pimpl_->read(nullptr, total, nullptr);
+}
+
+bool disk_counters::sample(disk_stats& total, unsigned& generation) noexcept {
+	return pimpl_->read(nullptr, total, &generation);
+}
+
+void disk_counters::rescan() noexcept {
+	const lock_guard<mutex> guard(pimpl_->m);
+	pimpl_->scan_requested = true;
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
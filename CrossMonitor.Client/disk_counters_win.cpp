@@ -0,0 +1,203 @@
+#include "disk_counters.hpp"
+
+#include "log.hpp"
+
+#include <Windows.h>
+
+#include <mutex>
+#include <string>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+// Highest \\.\PhysicalDriveN probed while discovering disks.
+static const unsigned max_physical_drives = 64;
+
+struct disk_counters::impl final {
+	struct device final {
+		unsigned index;
+		HANDLE handle;
+		string name;
+		/**
+		 * ReadCount and WriteCount are 32 bits and wrap within days on a
+		 * busy disk, they are widened to 64 bits before being summed.
+		 */
+		bool counted;
+		DWORD read_count;
+		DWORD write_count;
+		unsigned long long reads;
+		unsigned long long writes;
+	};
+
+	explicit impl(const chrono::seconds& period) : rescan_period(period) {
+	}
+	~impl() {
+		for (auto& dev : devices) {
+			CloseHandle(dev.handle);
+		}
+	}
+
+	bool is_open(unsigned index) const noexcept {
+		for (const auto& dev : devices) {
+			if (dev.index == index) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/**
+	 * Opens drives not already open. Handles of drives still present are
+	 * kept, so only newly attached disks pay for CreateFileW.
+	 */
+	void discover() {
+		for (unsigned i = 0; i < max_physical_drives; ++i) {
+			if (is_open(i)) {
+				continue;
+			}
+			const wstring path(L"\\\\.\\PhysicalDrive" + to_wstring(i));
+			HANDLE dev = CreateFileW(path.c_str(),
+				0,
+				FILE_SHARE_READ | FILE_SHARE_WRITE,
+				NULL,
+				OPEN_EXISTING,
+				0,
+				NULL);
+			if (dev == INVALID_HANDLE_VALUE) {
+				continue;
+			}
+			LOG(info) << "Monitoring disk PhysicalDrive" << i;
+			devices.push_back(device{ i, dev, "PhysicalDrive" + to_string(i),
+									  false, 0, 0, 0, 0 });
+			++generation;
+		}
+		last_scan = chrono::steady_clock::now();
+		scan_requested = false;
+	}
+
+	bool read(vector<disk_stats>* disks, disk_stats& total,
+			  unsigned* summed_generation) noexcept {
+		const lock_guard<mutex> guard(m);
+
+		total.read_bytes = total.write_bytes = 0;
+		total.reads = total.writes = 0;
+
+		try {
+			if (scan_requested ||
+				chrono::steady_clock::now() - last_scan >= rescan_period) {
+				discover();
+			}
+		} catch (const std::exception& e) {
+			LOG(error) << "Failed to discover disks: " << e.what();
+		}
+
+		size_t count = 0;
+		for (auto it = devices.begin(); it != devices.end();) {
+			DWORD bytes = 0;
+			DISK_PERFORMANCE info = { 0 };
+			if (!DeviceIoControl(it->handle,
+								 IOCTL_DISK_PERFORMANCE,
+								 NULL,
+								 0,
+								 &info,
+								 sizeof(info),
+								 &bytes,
+								 NULL)) {
+				// Most likely removed, rediscover on the next sample.
+				LOG(warning) << "Could not read disk performance of "
+							 << it->name << ". Error: " << GetLastError();
+				CloseHandle(it->handle);
+				it = devices.erase(it);
+				scan_requested = true;
+				++generation;
+				continue;
+			}
+
+			if (it->counted) {
+				// Unsigned 32 bits subtraction, right across a wrap
+				it->reads += static_cast<DWORD>(info.ReadCount - it->read_count);
+				it->writes += static_cast<DWORD>(info.WriteCount - it->write_count);
+			} else {
+				it->reads = info.ReadCount;
+				it->writes = info.WriteCount;
+				it->counted = true;
+			}
+			it->read_count = info.ReadCount;
+			it->write_count = info.WriteCount;
+
+			total.read_bytes += info.BytesRead.QuadPart;
+			total.write_bytes += info.BytesWritten.QuadPart;
+			total.reads += it->reads;
+			total.writes += it->writes;
+
+			if (disks) {
+				if (disks->size() <= count) {
+					disks->emplace_back();
+				}
+				disk_stats& stats = (*disks)[count];
+				stats.name = it->name;
+				stats.read_bytes = info.BytesRead.QuadPart;
+				stats.write_bytes = info.BytesWritten.QuadPart;
+				stats.reads = it->reads;
+				stats.writes = it->writes;
+			}
+			++count;
+			++it;
+		}
+
+		if (disks) {
+			disks->resize(count);
+		}
+		if (summed_generation) {
+			*summed_generation = generation;
+		}
+		if (count == 0) {
+			LOG(error) << "Could not read performance of any disk";
+			return false;
+		}
+		return true;
+	}
+
+	const chrono::seconds rescan_period;
+	vector<device> devices;
+	chrono::steady_clock::time_point last_scan;
+	bool scan_requested = true;
+	unsigned generation = 0;
+	mutex m;
+};
+
+disk_counters::disk_counters(const chrono::seconds& rescan_period) :
+	pimpl_(new impl(rescan_period)) {
+}
+
+disk_counters::~disk_counters() {
+}
+
+bool disk_counters::sample(vector<disk_stats>& disks,
+						   disk_stats& total) noexcept {
+	return pimpl_->read(&disks, total, nullptr);
+}
+
+bool disk_counters::sample(disk_stats& total) noexcept {
+	return pimpl_->read(nullptr, total, nullptr);
+}
+
+bool disk_counters::sample(disk_stats& total, unsigned& generation) noexcept {
+	return pimpl_->read(nullptr, total, &generation);
+}
+
+void disk_counters::rescan() noexcept {
+	const lock_guard<mutex> guard(pimpl_->m);
+	pimpl_->scan_requested = true;
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
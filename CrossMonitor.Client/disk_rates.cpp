@@ -0,0 +1,79 @@
+#include <disk_rates.hpp>
+
+#include <cmath>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+typedef unsigned long long disk_reading::* reading_field;
+typedef double disk_usage::* usage_field;
+
+/**
+ * The counters of the disks and their rates, in the same order.
+ */
+static const reading_field reading_fields[] = {
+	&disk_reading::read_bytes,
+	&disk_reading::write_bytes,
+	&disk_reading::reads,
+	&disk_reading::writes
+};
+static const usage_field usage_fields[] = {
+	&disk_usage::read_bytes,
+	&disk_usage::write_bytes,
+	&disk_usage::reads,
+	&disk_usage::writes
+};
+static const char* const usage_names[] = {
+	"read_bytes",
+	"write_bytes",
+	"reads",
+	"writes"
+};
+static const size_t counter_count = sizeof(usage_fields) / sizeof(usage_fields[0]);
+static_assert(sizeof(reading_fields) / sizeof(reading_fields[0]) == counter_count,
+			  "A counter per rate");
+
+void disk_usage::write(json_writer& writer) const {
+	writer.begin_object();
+	for (size_t i = 0; i < counter_count; ++i) {
+		writer.key(usage_names[i]);
+		writer.value(static_cast<unsigned long long>(llround(this->*usage_fields[i])));
+	}
+	writer.key("resets");
+	writer.value(resets);
+	writer.end_object();
+}
+
+void disk_rates::update(const disk_reading& reading) noexcept {
+	bool reset = false;
+	for (size_t i = 0; i < counter_count; ++i) {
+		reset |= counters_[i].update(reading.*reading_fields[i], reading.time,
+			reading.generation) == utils::counter_change::reset;
+	}
+	if (reset) {
+		++resets_;
+	}
+}
+
+void disk_rates::take(disk_usage& out) noexcept {
+	for (size_t i = 0; i < counter_count; ++i) {
+		out.*usage_fields[i] = counters_[i].take_rate();
+	}
+	out.resets = resets_;
+	resets_ = 0;
+}
+
+void disk_rates::restart() noexcept {
+	for (auto& counter : counters_) {
+		counter.restart();
+		counter.take_rate();
+	}
+	resets_ = 0;
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <os.hpp>
+#include <counter_rate.hpp>
+#include <json_writer.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Cumulative counters of every physical disk and when they were read.
+ */
+struct disk_reading final {
+	std::chrono::steady_clock::time_point time;
+	unsigned long long read_bytes = 0;
+	unsigned long long write_bytes = 0;
+	unsigned long long reads = 0;
+	unsigned long long writes = 0;
+	/**
+	 * See os::snapshot::disk_generation.
+	 */
+	unsigned generation = 0;
+};
+
+/**
+ * Traffic of every physical disk, per second.
+ */
+struct disk_usage final {
+	double read_bytes = 0;
+	double write_bytes = 0;
+	double reads = 0;
+	double writes = 0;
+	/**
+	 * Readings that reset the counters, leaving their interval out.
+	 */
+	unsigned resets = 0;
+
+	/**
+	 * Writes {"read_bytes":..,"write_bytes":..,"reads":..,"writes":..,
+	 * "resets":n}, the rates rounded to integers.
+	 */
+	void write(json_writer& writer) const;
+};
+
+/**
+ * Disk rates from the readings of every sample, through a
+ * utils::counter_rate per counter: wraps, resets and disks coming or
+ * going never show as spikes. Not thread safe.
+ */
+class disk_rates final : public boost::noncopyable {
+public:
+	disk_rates() = default;
+
+	void update(const disk_reading& reading) noexcept;
+	/**
+	 * Mean rates over the readings since the previous call.
+	 */
+	void take(disk_usage& out) noexcept;
+	/**
+	 * Forgets the previous reading and the rates not yet taken.
+	 */
+	void restart() noexcept;
+
+private:
+	// read_bytes, write_bytes, reads and writes
+	utils::counter_rate counters_[4];
+	unsigned resets_ = 0;
+}; //class disk_rates
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,873 @@
+#include <history.hpp>
+
+#include <data_fields.hpp>
+#include <ddsketch.hpp>
+#include <gorilla.hpp>
+#include <log.hpp>
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <tuple>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+namespace ipc = boost::interprocess;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+static const char history_magic[8] = { 'C', 'M', 'H', 'I', 'S', 'T', 'O', '1' };
+static const uint32_t history_version = 2;
+/**
+ * The header gets its own page so blocks never share a page with it.
+ */
+static const size_t header_size = 4096;
+/**
+ * The timestamps and one stream per field.
+ */
+static const size_t stream_count = 1 + data_fields::size;
+static const size_t max_streams = 8;
+static_assert(stream_count <= max_streams, "too many history streams");
+
+/**
+ * Bucket widths of the timestamps, in milliseconds: sampling jitter takes
+ * the 7 bit bucket, a skipped deadline the 12 bit one.
+ */
+static const unsigned timestamp_widths[3] = { 7, 9, 12 };
+/**
+ * Bucket widths of the integer fields: process counts, memory in bytes
+ * and IO counters in bytes.
+ */
+static const unsigned integer_widths[3] = { 8, 20, 32 };
+
+struct history_header final {
+	char magic[8];
+	uint32_t version;
+	uint32_t block_size;
+	uint64_t capacity;
+	uint32_t streams;
+	uint32_t crc;
+};
+static_assert(sizeof(history_header) == 32, "history header layout changed");
+
+/**
+ * Of one field over a block, for queries to skip decoding it.
+ */
+struct column_stats final {
+	double min;
+	double max;
+	double sum;
+};
+
+struct block_header final {
+	/**
+	 * 1 for the first block ever written, 0 marks an unused block.
+	 */
+	uint64_t seq;
+	uint64_t first_timestamp;
+	uint64_t last_timestamp;
+	uint32_t count;
+	uint32_t streams;
+	/**
+	 * Bits in each stream; the streams follow the header, each starting
+	 * on a byte.
+	 */
+	uint16_t bits[max_streams];
+	/**
+	 * By field, in data_fields order.
+	 */
+	column_stats columns[max_streams - 1];
+	/**
+	 * CRC32 of the header before this member and of the streams.
+	 */
+	uint32_t crc;
+	uint32_t reserved;
+};
+static_assert(sizeof(block_header) == 224, "history block layout changed");
+
+static const size_t payload_size = history_block_size - sizeof(block_header);
+
+template <typename T>
+static uint32_t header_checksum(const T& value) noexcept {
+	boost::crc_32_type crc;
+	crc.process_bytes(&value, offsetof(T, crc));
+	return crc.checksum();
+}
+
+static size_t stream_bytes(const block_header& h) noexcept {
+	size_t bytes = 0;
+	for (size_t i = 0; i < stream_count; ++i) {
+		bytes += (h.bits[i] + 7u) / 8;
+	}
+	return bytes;
+}
+
+/**
+ * block must hold the header followed by its streams.
+ */
+static uint32_t block_checksum(const block_header& h,
+							   const unsigned char* block) noexcept {
+	boost::crc_32_type crc;
+	crc.process_bytes(&h, offsetof(block_header, crc));
+	crc.process_bytes(block + sizeof(block_header), stream_bytes(h));
+	return crc.checksum();
+}
+
+/**
+ * Integer fields are delta-of-delta coded.
+ */
+template <typename T>
+struct value_codec final {
+	struct encoder final {
+		utils::delta_encoder coder{ integer_widths };
+		void write(utils::bit_writer& out, T value) noexcept {
+			coder.write(out, value);
+		}
+		void reset() noexcept {
+			coder.reset();
+		}
+	};
+	struct decoder final {
+		utils::delta_decoder coder{ integer_widths };
+		bool read(utils::bit_reader& in, T& value) noexcept {
+			uint64_t v = 0;
+			if (!coder.read(in, v)) {
+				return false;
+			}
+			value = static_cast<T>(v);
+			return true;
+		}
+	};
+};
+
+/**
+ * Float fields are XOR coded.
+ */
+template <>
+struct value_codec<float> final {
+	struct encoder final {
+		utils::xor_encoder coder;
+		void write(utils::bit_writer& out, float value) noexcept {
+			coder.write(out, value);
+		}
+		void reset() noexcept {
+			coder.reset();
+		}
+	};
+	struct decoder final {
+		utils::xor_decoder coder;
+		bool read(utils::bit_reader& in, float& value) noexcept {
+			return coder.read(in, value);
+		}
+	};
+};
+
+template <typename Field>
+struct field_encoder final {
+	typename value_codec<typename Field::type>::encoder codec;
+};
+
+template <typename Field>
+struct field_decoder final {
+	typename value_codec<typename Field::type>::decoder codec;
+};
+
+/**
+ * Most bits a sample adds to a stream, whatever its codec.
+ */
+static const size_t max_sample_bits = utils::delta_encoder::max_bits;
+static_assert(utils::xor_encoder::max_bits <= max_sample_bits,
+			  "history sample bound too low");
+
+/**
+ * Appends the samples of block taken from from to to to out.
+ * Throws std::invalid_argument if the block does not decode.
+ */
+static size_t decode_block(const unsigned char* block,
+						   unsigned long long from, unsigned long long to,
+						   vector<record>& out) {
+	block_header h;
+	memcpy(&h, block, sizeof(h));
+
+	const unsigned char* stream = block + sizeof(block_header);
+	utils::bit_reader timestamps(stream, h.bits[0]);
+	stream += (h.bits[0] + 7u) / 8;
+	vector<utils::bit_reader> readers;
+	readers.reserve(data_fields::size);
+	for (size_t i = 1; i < stream_count; ++i) {
+		readers.emplace_back(stream, h.bits[i]);
+		stream += (h.bits[i] + 7u) / 8;
+	}
+
+	utils::delta_decoder timestamp_decoder(timestamp_widths);
+	tuple_of<field_decoder, data_fields>::type decoders;
+	size_t appended = 0;
+	for (uint32_t i = 0; i < h.count; ++i) {
+		uint64_t timestamp = 0;
+		if (!timestamp_decoder.read(timestamps, timestamp)) {
+			throw invalid_argument("Truncated history timestamps");
+		}
+		data::values values;
+		size_t column = 0;
+		for_each_field(data_fields(), [&](auto field) {
+			typedef decltype(field) F;
+			if (!get<field_decoder<F>>(decoders).codec.read(readers[column++],
+				get<field_index<F, data_fields>::value>(values))) {
+				throw invalid_argument("Truncated history stream");
+			}
+		});
+		const data sample(values);
+		if (timestamp > to) {
+			break;
+		}
+		if (timestamp >= from) {
+			out.emplace_back(timestamp, sample);
+			++appended;
+		}
+	}
+	return appended;
+}
+
+/**
+ * Decodes the count values of the stream of Field.
+ */
+template <typename Field>
+static bool decode_column(utils::bit_reader& in, uint32_t count,
+						  vector<double>& values) {
+	typename value_codec<typename Field::type>::decoder decoder;
+	values.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		typename Field::type v;
+		if (!decoder.read(in, v)) {
+			return false;
+		}
+		values[i] = static_cast<double>(v);
+	}
+	return true;
+}
+
+typedef bool(*column_decoder)(utils::bit_reader&, uint32_t, vector<double>&);
+
+/**
+ * decode_column of every field, in data_fields order.
+ */
+static array<column_decoder, data_fields::size> column_decoders() {
+	array<column_decoder, data_fields::size> decoders;
+	size_t column = 0;
+	for_each_field(data_fields(), [&](auto field) {
+		decoders[column++] = &decode_column<decltype(field)>;
+	});
+	return decoders;
+}
+
+/**
+ * Position of the field named name in data_fields.
+ * Throws std::invalid_argument if there is none.
+ */
+static size_t field_column(const string& name) {
+	size_t found = data_fields::size;
+	size_t column = 0;
+	string known;
+	for_each_field(data_fields(), [&](auto field) {
+		typedef decltype(field) F;
+		if (name == F::name()) {
+			found = column;
+		}
+		++column;
+		known += known.empty() ? "" : ", ";
+		known += string(F::name()) + " (" + F::unit() + ")";
+	});
+	if (found == data_fields::size) {
+		throw invalid_argument("Unknown field " + name + ", one of " + known);
+	}
+	return found;
+}
+
+/**
+ * Aggregates samples in time order into the buckets of a query, one
+ * bucket at a time.
+ */
+class bucket_builder final : public boost::noncopyable {
+public:
+	bucket_builder(unsigned long long from, unsigned long long step,
+				   vector<history_bucket>& out) :
+		from_(from), step_(step), out_(out) {
+	}
+
+	unsigned long long bucket_of(unsigned long long timestamp) const noexcept {
+		return (timestamp - from_) / step_;
+	}
+
+	void add(unsigned long long timestamp, double value) {
+		select(bucket_of(timestamp));
+		if (bucket_.count++ == 0) {
+			bucket_.min = bucket_.max = value;
+		} else {
+			bucket_.min = std::min(bucket_.min, value);
+			bucket_.max = std::max(bucket_.max, value);
+		}
+		sum_ += value;
+		sketch_.add(value);
+	}
+	/**
+	 * Adds count samples, all in the bucket of timestamp, of the given
+	 * min, max and sum; min must equal max for the p95 to be exact.
+	 */
+	void add(unsigned long long timestamp, unsigned long long count,
+			 const column_stats& stats) {
+		select(bucket_of(timestamp));
+		if (bucket_.count == 0) {
+			bucket_.min = stats.min;
+			bucket_.max = stats.max;
+		} else {
+			bucket_.min = std::min(bucket_.min, stats.min);
+			bucket_.max = std::max(bucket_.max, stats.max);
+		}
+		bucket_.count += count;
+		sum_ += stats.sum;
+		sketch_.add(stats.min, count);
+	}
+
+	/**
+	 * Appends the last bucket.
+	 * @return buckets appended.
+	 */
+	size_t finish() {
+		emit();
+		return appended_;
+	}
+
+private:
+	void select(unsigned long long index) {
+		if (index != index_) {
+			emit();
+			index_ = index;
+		}
+	}
+	void emit() {
+		if (bucket_.count == 0) {
+			return;
+		}
+		bucket_.start = from_ + index_ * step_;
+		bucket_.avg = sum_ / static_cast<double>(bucket_.count);
+		bucket_.p95 = sketch_.quantile(0.95);
+		out_.push_back(bucket_);
+		++appended_;
+		bucket_ = history_bucket();
+		sum_ = 0;
+		sketch_.clear();
+	}
+
+	const unsigned long long from_;
+	const unsigned long long step_;
+	vector<history_bucket>& out_;
+	unsigned long long index_ = 0;
+	history_bucket bucket_;
+	double sum_ = 0;
+	utils::ddsketch sketch_;
+	size_t appended_ = 0;
+};
+
+/**
+ * Creates path zero filled with the given size, replacing any old file so
+ * stale blocks can never pass as recent ones.
+ */
+static void create_file(const string& path, uintmax_t size) {
+	{
+		ofstream f(path, ios::binary | ios::trunc);
+		if (!f) {
+			throw runtime_error("Cannot create history file " + path);
+		}
+	}
+	boost::filesystem::resize_file(path, size);
+}
+
+static bool prepare_file(const string& path, uintmax_t size) {
+	boost::system::error_code err;
+	if (boost::filesystem::file_size(path, err) == size && !err) {
+		return false;
+	}
+	create_file(path, size);
+	return true;
+}
+
+static size_t checked_capacity(size_t capacity) {
+	if (capacity < 2) {
+		throw invalid_argument("History capacity must be two blocks or more");
+	}
+	return capacity;
+}
+
+struct history::impl final {
+	/**
+	 * What the index keeps of a stored block.
+	 */
+	struct block_info final {
+		uint64_t seq = 0;
+		uint64_t first_timestamp = 0;
+		uint64_t last_timestamp = 0;
+		uint32_t count = 0;
+	};
+
+	impl(const string& path, size_t capacity);
+	explicit impl(const string& path);
+
+	bool load_header() const noexcept;
+	void write_header() noexcept;
+	void load_blocks() noexcept;
+	void seal();
+	/**
+	 * Header and streams of the block being filled, as stored.
+	 */
+	void build_block(vector<unsigned char>& block) const;
+	void reset_open() noexcept;
+	void check_writable() const {
+		if (read_only) {
+			throw logic_error("History " + path + " is open read only");
+		}
+	}
+	/**
+	 * Aggregates the samples of one field of block into buckets.
+	 * Throws std::invalid_argument if the block does not decode.
+	 */
+	void aggregate(const unsigned char* block, size_t column,
+				   unsigned long long from, unsigned long long to,
+				   bucket_builder& buckets) const;
+
+	unsigned char* block_address(size_t slot) const noexcept {
+		return base + header_size + slot * history_block_size;
+	}
+
+	const string path;
+	const size_t capacity;
+	const bool read_only;
+	ipc::file_mapping file;
+	ipc::mapped_region region;
+	unsigned char* base = nullptr;
+
+	/**
+	 * By slot; slots are written in turn, so from next_slot on they are
+	 * in time order.
+	 */
+	vector<block_info> index;
+	size_t next_slot = 0;
+	uint64_t next_seq = 1;
+	size_t stored = 0;
+	mutable unsigned long long corrupted = 0;
+
+	// The block being filled
+	vector<unsigned char> streams[stream_count];
+	utils::bit_writer writers[stream_count];
+	utils::delta_encoder timestamp_encoder{ timestamp_widths };
+	tuple_of<field_encoder, data_fields>::type encoders;
+	block_info open;
+	column_stats open_columns[data_fields::size];
+	mutable vector<unsigned char> scratch;
+	mutable vector<uint64_t> timestamps;
+	mutable vector<double> values;
+};
+
+history::impl::impl(const string& path, size_t capacity) :
+	path(path),
+	capacity(checked_capacity(capacity)),
+	read_only(false),
+	index(capacity),
+	scratch(history_block_size) {
+	for (auto& s : streams) {
+		s.resize(payload_size);
+	}
+	reset_open();
+
+	const uintmax_t size = header_size +
+		static_cast<uintmax_t>(capacity) * history_block_size;
+	bool fresh = prepare_file(path, size);
+
+	file = ipc::file_mapping(path.c_str(), ipc::read_write);
+	region = ipc::mapped_region(file, ipc::read_write);
+	base = static_cast<unsigned char*>(region.get_address());
+
+	if (!fresh && !load_header()) {
+		LOG(warning) << "History file " << path << " has an invalid header, "
+					 << "starting a new one";
+		region = ipc::mapped_region();
+		file = ipc::file_mapping();
+		create_file(path, size);
+		file = ipc::file_mapping(path.c_str(), ipc::read_write);
+		region = ipc::mapped_region(file, ipc::read_write);
+		base = static_cast<unsigned char*>(region.get_address());
+		fresh = true;
+	}
+
+	if (fresh) {
+		write_header();
+		region.flush(0, header_size, false);
+	} else {
+		load_blocks();
+	}
+}
+
+static size_t file_capacity(const string& path) {
+	boost::system::error_code err;
+	const uintmax_t size = boost::filesystem::file_size(path, err);
+	if (err || size < header_size + 2 * history_block_size ||
+		(size - header_size) % history_block_size != 0) {
+		throw runtime_error("Invalid history file " + path);
+	}
+	return static_cast<size_t>((size - header_size) / history_block_size);
+}
+
+history::impl::impl(const string& path) :
+	path(path),
+	capacity(file_capacity(path)),
+	read_only(true),
+	index(capacity),
+	scratch(history_block_size) {
+	reset_open();
+	file = ipc::file_mapping(path.c_str(), ipc::read_only);
+	region = ipc::mapped_region(file, ipc::read_only);
+	base = static_cast<unsigned char*>(region.get_address());
+	if (!load_header()) {
+		throw runtime_error("Invalid history file " + path);
+	}
+	load_blocks();
+}
+
+bool history::impl::load_header() const noexcept {
+	history_header h;
+	memcpy(&h, base, sizeof(h));
+	return memcmp(h.magic, history_magic, sizeof(history_magic)) == 0 &&
+		h.version == history_version &&
+		h.block_size == history_block_size &&
+		h.capacity == capacity &&
+		h.streams == stream_count &&
+		h.crc == header_checksum(h);
+}
+
+void history::impl::write_header() noexcept {
+	history_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, history_magic, sizeof(history_magic));
+	h.version = history_version;
+	h.block_size = history_block_size;
+	h.capacity = capacity;
+	h.streams = stream_count;
+	h.crc = header_checksum(h);
+	memcpy(base, &h, sizeof(h));
+}
+
+void history::impl::load_blocks() noexcept {
+	uint64_t last_seq = 0;
+	for (size_t slot = 0; slot < capacity; ++slot) {
+		const unsigned char* block = block_address(slot);
+		block_header h;
+		memcpy(&h, block, sizeof(h));
+		if (h.seq == 0) {
+			continue;
+		}
+		bool valid = h.streams == stream_count && h.count != 0 &&
+			h.first_timestamp <= h.last_timestamp;
+		for (size_t i = 0; valid && i < stream_count; ++i) {
+			valid = h.bits[i] <= payload_size * 8;
+		}
+		if (!valid || stream_bytes(h) > payload_size ||
+			h.crc != block_checksum(h, block)) {
+			++corrupted;
+			continue;
+		}
+		index[slot].seq = h.seq;
+		index[slot].first_timestamp = h.first_timestamp;
+		index[slot].last_timestamp = h.last_timestamp;
+		index[slot].count = h.count;
+		++stored;
+		if (h.seq > last_seq) {
+			last_seq = h.seq;
+			next_slot = (slot + 1) % capacity;
+		}
+	}
+	next_seq = last_seq + 1;
+	LOG(info) << "History " << path << " holds " << stored << " blocks";
+}
+
+void history::impl::reset_open() noexcept {
+	for (size_t i = 0; i < stream_count; ++i) {
+		writers[i] = utils::bit_writer(streams[i].data(), streams[i].size());
+	}
+	timestamp_encoder.reset();
+	for_each_field(data_fields(), [this](auto field) {
+		typedef decltype(field) F;
+		get<field_encoder<F>>(encoders).codec.reset();
+	});
+	open = block_info();
+}
+
+void history::impl::build_block(vector<unsigned char>& block) const {
+	block_header h;
+	memset(&h, 0, sizeof(h));
+	h.seq = next_seq;
+	h.first_timestamp = open.first_timestamp;
+	h.last_timestamp = open.last_timestamp;
+	h.count = open.count;
+	h.streams = stream_count;
+	memcpy(h.columns, open_columns, sizeof(open_columns));
+	block.assign(history_block_size, 0);
+	unsigned char* stream = block.data() + sizeof(block_header);
+	for (size_t i = 0; i < stream_count; ++i) {
+		h.bits[i] = static_cast<uint16_t>(writers[i].bits());
+		memcpy(stream, streams[i].data(), writers[i].bytes());
+		stream += writers[i].bytes();
+	}
+	memcpy(block.data(), &h, sizeof(h));
+	h.crc = block_checksum(h, block.data());
+	memcpy(block.data(), &h, sizeof(h));
+}
+
+void history::impl::seal() {
+	build_block(scratch);
+	memcpy(block_address(next_slot), scratch.data(), history_block_size);
+	if (!region.flush(header_size + next_slot * history_block_size,
+					  history_block_size, false)) {
+		LOG(error) << "Failed to sync history file " << path;
+	}
+	if (index[next_slot].seq == 0) {
+		++stored;
+	}
+	index[next_slot] = open;
+	index[next_slot].seq = next_seq++;
+	next_slot = (next_slot + 1) % capacity;
+	reset_open();
+}
+
+void history::impl::aggregate(const unsigned char* block, size_t column,
+							  unsigned long long from, unsigned long long to,
+							  bucket_builder& buckets) const {
+	static const array<column_decoder, data_fields::size> decoders =
+		column_decoders();
+
+	block_header h;
+	memcpy(&h, block, sizeof(h));
+	const column_stats& stats = h.columns[column];
+	if (stats.min == stats.max && h.first_timestamp >= from &&
+		h.last_timestamp <= to &&
+		buckets.bucket_of(h.first_timestamp) ==
+		buckets.bucket_of(h.last_timestamp)) {
+		buckets.add(h.first_timestamp, h.count, stats);
+		return;
+	}
+
+	// Only the timestamps and, unless constant, the stream of the field
+	const unsigned char* stream = block + sizeof(block_header);
+	utils::bit_reader timestamp_reader(stream, h.bits[0]);
+	utils::delta_decoder timestamp_decoder(timestamp_widths);
+	timestamps.resize(h.count);
+	for (auto& t : timestamps) {
+		if (!timestamp_decoder.read(timestamp_reader, t)) {
+			throw invalid_argument("Truncated history timestamps");
+		}
+	}
+	if (stats.min == stats.max) {
+		values.assign(h.count, stats.min);
+	} else {
+		for (size_t i = 0; i <= column; ++i) {
+			stream += (h.bits[i] + 7u) / 8;
+		}
+		utils::bit_reader value_reader(stream, h.bits[column + 1]);
+		if (!decoders[column](value_reader, h.count, values)) {
+			throw invalid_argument("Truncated history stream");
+		}
+	}
+
+	for (uint32_t i = 0; i < h.count && timestamps[i] <= to; ++i) {
+		if (timestamps[i] >= from) {
+			buckets.add(timestamps[i], values[i]);
+		}
+	}
+}
+
+void history_bucket::write(json_writer& writer) const {
+	writer.begin_object();
+	writer.key("start");
+	writer.value(start);
+	writer.key("count");
+	writer.value(count);
+	writer.key("min");
+	writer.value(min);
+	writer.key("max");
+	writer.value(max);
+	writer.key("avg");
+	writer.value(avg);
+	writer.key("p95");
+	writer.value(p95);
+	writer.end_object();
+}
+
+history::history(const string& path, size_t capacity) :
+	pimpl_(new impl(path, capacity)) {
+}
+
+history::history(const string& path) :
+	pimpl_(new impl(path)) {
+}
+
+history::~history() {
+	if (pimpl_->read_only) {
+		return;
+	}
+	try {
+		flush();
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to store the history: " << e.what();
+	}
+}
+
+void history::push(const record& r) {
+	impl& p = *pimpl_;
+	p.check_writable();
+	// Seal when the sample might not fit, so it never spans two blocks
+	size_t worst = 0;
+	for (const auto& w : p.writers) {
+		worst += (w.bits() + max_sample_bits + 7) / 8;
+	}
+	if (p.open.count != 0 && worst > payload_size) {
+		p.seal();
+	}
+
+	p.timestamp_encoder.write(p.writers[0], r.timestamp);
+	const bool first = p.open.count == 0;
+	size_t column = 0;
+	for_each_field(data_fields(), [&](auto field) {
+		typedef decltype(field) F;
+		const typename F::type value = F::get(r.sample);
+		get<field_encoder<F>>(p.encoders).codec.write(p.writers[column + 1],
+													  value);
+		column_stats& stats = p.open_columns[column++];
+		const double v = static_cast<double>(value);
+		if (first) {
+			stats.min = stats.max = stats.sum = v;
+		} else {
+			stats.min = std::min(stats.min, v);
+			stats.max = std::max(stats.max, v);
+			stats.sum += v;
+		}
+	});
+	if (p.open.count++ == 0) {
+		p.open.first_timestamp = r.timestamp;
+	}
+	p.open.last_timestamp = r.timestamp;
+}
+
+size_t history::query(unsigned long long from, unsigned long long to,
+					  vector<record>& out) const {
+	const impl& p = *pimpl_;
+	size_t appended = 0;
+	for (size_t i = 0; i < p.capacity; ++i) {
+		const size_t slot = (p.next_slot + i) % p.capacity;
+		const impl::block_info& b = p.index[slot];
+		if (b.seq == 0 || b.last_timestamp < from || b.first_timestamp > to) {
+			continue;
+		}
+		try {
+			appended += decode_block(p.block_address(slot), from, to, out);
+		} catch (const invalid_argument&) {
+			++p.corrupted;
+		}
+	}
+	if (p.open.count != 0 && p.open.last_timestamp >= from &&
+		p.open.first_timestamp <= to) {
+		p.build_block(p.scratch);
+		appended += decode_block(p.scratch.data(), from, to, out);
+	}
+	return appended;
+}
+
+size_t history::query(const string& field, unsigned long long from,
+					  unsigned long long to, unsigned long long step,
+					  vector<history_bucket>& out) const {
+	if (step == 0 || from > to) {
+		throw invalid_argument("Invalid history query range");
+	}
+	const impl& p = *pimpl_;
+	const size_t column = field_column(field);
+	bucket_builder buckets(from, step, out);
+	for (size_t i = 0; i < p.capacity; ++i) {
+		const size_t slot = (p.next_slot + i) % p.capacity;
+		const impl::block_info& b = p.index[slot];
+		if (b.seq == 0 || b.last_timestamp < from || b.first_timestamp > to) {
+			continue;
+		}
+		try {
+			p.aggregate(p.block_address(slot), column, from, to, buckets);
+		} catch (const invalid_argument&) {
+			++p.corrupted;
+		}
+	}
+	if (p.open.count != 0 && p.open.last_timestamp >= from &&
+		p.open.first_timestamp <= to) {
+		p.build_block(p.scratch);
+		p.aggregate(p.scratch.data(), column, from, to, buckets);
+	}
+	return buckets.finish();
+}
+
+void history::flush() {
+	pimpl_->check_writable();
+	if (pimpl_->open.count != 0) {
+		pimpl_->seal();
+	}
+}
+
+unsigned long long history::size() const noexcept {
+	unsigned long long samples = pimpl_->open.count;
+	for (const auto& b : pimpl_->index) {
+		samples += b.count;
+	}
+	return samples;
+}
+
+size_t history::blocks() const noexcept {
+	return pimpl_->stored;
+}
+
+size_t history::capacity() const noexcept {
+	return pimpl_->capacity;
+}
+
+unsigned long long history::first_timestamp() const noexcept {
+	const impl& p = *pimpl_;
+	for (size_t i = 0; i < p.capacity; ++i) {
+		const impl::block_info& b = p.index[(p.next_slot + i) % p.capacity];
+		if (b.seq != 0) {
+			return b.first_timestamp;
+		}
+	}
+	return p.open.first_timestamp;
+}
+
+unsigned long long history::last_timestamp() const noexcept {
+	const impl& p = *pimpl_;
+	if (p.open.count != 0) {
+		return p.open.last_timestamp;
+	}
+	const impl::block_info& b =
+		p.index[(p.next_slot + p.capacity - 1) % p.capacity];
+	return b.seq != 0 ? b.last_timestamp : 0;
+}
+
+unsigned long long history::corrupted() const noexcept {
+	return pimpl_->corrupted;
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
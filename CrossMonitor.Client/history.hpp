@@ -0,0 +1,144 @@
+#pragma once
+
+#include <json_writer.hpp>
+#include <record.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Aggregate of one field over the samples of a time bucket.
+ */
+struct history_bucket final {
+	/**
+	 * Start of the bucket, in milliseconds since the Unix epoch.
+	 */
+	unsigned long long start = 0;
+	unsigned long long count = 0;
+	double min = 0;
+	double max = 0;
+	double avg = 0;
+	/**
+	 * Within 1% of the true 95th percentile (see utils::ddsketch).
+	 */
+	double p95 = 0;
+
+	/**
+	 * Writes {"start":..,"count":..,"min":..,"max":..,"avg":..,"p95":..}.
+	 */
+	void write(json_writer& writer) const;
+};
+
+/**
+ * Compressed local history of the samples, to look back at what happened
+ * at a given time without shipping every sample.
+ * Samples are packed into fixed size blocks of history_block_size bytes.
+ * A block holds one stream per column: the timestamps delta-of-delta
+ * coded, cpu_percent XOR coded and the integer fields delta-of-delta
+ * coded, as Gorilla does, so a steady 1 second series takes a few bytes
+ * per sample. The block being filled lives in memory; full blocks go to
+ * a memory-mapped ring file, the oldest overwritten when it is full.
+ * Each block carries its sequence number, its time range, the min, max
+ * and sum of every field and a CRC32; reopening the file rebuilds the
+ * index from the block headers.
+ * A crash loses the block being filled; the destructor stores it.
+ * Integers are stored in host byte order. Not thread safe.
+ */
+class history final : public boost::noncopyable {
+public:
+	/**
+	 * Opens the history file at path, creating it if it does not exist or
+	 * was created with another capacity.
+	 * Throws std::invalid_argument if capacity is less than two blocks
+	 * and std::exception derived exceptions if the file cannot be mapped.
+	 * @param capacity blocks the file holds.
+	 */
+	history(const std::string& path, std::size_t capacity);
+	/**
+	 * Opens an existing history file read only, e.g. to query the file of
+	 * a running client; blocks it stores later are not seen.
+	 * Throws std::runtime_error if the file is missing or invalid.
+	 */
+	explicit history(const std::string& path);
+	/**
+	 * Stores the block being filled.
+	 */
+	~history();
+
+	/**
+	 * Appends r. Samples are expected in time order.
+	 * Throws std::logic_error if the history was opened read only.
+	 */
+	void push(const record& r);
+	/**
+	 * Appends to out, in time order, the samples taken from from to to,
+	 * both included, in milliseconds since the Unix epoch.
+	 * Blocks that fail their CRC are skipped and counted.
+	 * @return samples appended.
+	 */
+	std::size_t query(unsigned long long from, unsigned long long to,
+					  std::vector<record>& out) const;
+	/**
+	 * Aggregates field (a data_fields name, e.g. "cpu_percent") over the
+	 * samples taken from from to to, both included, in buckets of step
+	 * milliseconds starting at from. Appends the buckets holding samples
+	 * to out, in time order.
+	 * Only the timestamps and the stream of field are decoded, blocks out
+	 * of the range are skipped from the index, and blocks within a bucket
+	 * whose field never changed are aggregated from their header alone.
+	 * Counters (total_disk_read, total_disk_write) aggregate their raw
+	 * values.
+	 * Throws std::invalid_argument if field is unknown, step is zero or
+	 * from is after to.
+	 * @return buckets appended.
+	 */
+	std::size_t query(const std::string& field, unsigned long long from,
+					  unsigned long long to, unsigned long long step,
+					  std::vector<history_bucket>& out) const;
+	/**
+	 * Writes the block being filled to the file, starting a new one.
+	 * Costs a partly used block, meant for shutdown and tests.
+	 * Throws std::logic_error if the history was opened read only.
+	 */
+	void flush();
+
+	/**
+	 * Samples held, in the file and in memory.
+	 */
+	unsigned long long size() const noexcept;
+	/**
+	 * Blocks stored in the file.
+	 */
+	std::size_t blocks() const noexcept;
+	std::size_t capacity() const noexcept;
+	/**
+	 * Timestamps of the oldest and newest samples held, 0 when empty.
+	 */
+	unsigned long long first_timestamp() const noexcept;
+	unsigned long long last_timestamp() const noexcept;
+	/**
+	 * Blocks skipped for a bad CRC or content since construction.
+	 */
+	unsigned long long corrupted() const noexcept;
+
+private:
+	struct impl;
+	std::unique_ptr<impl> pimpl_;
+}; //class history
+
+/**
+ * Size of a history block, in bytes.
+ */
+static const std::size_t history_block_size = 4096;
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -1,7 +1,9 @@
 #include "application.hpp"
+#include "history.hpp"
 
 #include "log.hpp"
 #include "os.hpp"
+#include "utils.hpp"
 
 #include <boost/program_options.hpp>
 
@@ -10,6 +12,9 @@
 #include <iostream>
 #include <string>
 #include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 using namespace std;
 using namespace crossover::monitor;
@@ -18,6 +23,45 @@ namespace po = boost::program_options;
 #define LOG CROSSOVER_MONITOR_LOG
 #define DEFAULT_SECONDS 5
 
+/**
+ * Application stopped by the termination handler, set while it runs.
+ * A termination requested before is remembered and it never starts.
+ */
+static mutex app_mutex;
+static client::application* running_app = nullptr;
+static bool stop_requested = false;
+
+/**
+ * Prints the buckets of the query given on the command line as JSON lines.
+ * Defaults to the last day held in buckets of a minute.
+ */
+static int query_history(const po::variables_map& vm) {
+	const client::history h(vm["history"].as<string>());
+	unsigned long long to = h.last_timestamp();
+	if (vm.count("to")) {
+		to = vm["to"].as<unsigned long long>();
+	}
+	unsigned long long from = to > 86400000 ? to - 86400000 : 0;
+	if (vm.count("from")) {
+		from = vm["from"].as<unsigned long long>();
+	}
+	const unsigned long long step = vm["step"].as<unsigned>() * 1000ull;
+
+	vector<client::history_bucket> buckets;
+	h.query(vm["query"].as<string>(), from, to, step, buckets);
+	json_writer writer;
+	for (const client::history_bucket& bucket : buckets) {
+		writer.clear();
+		bucket.write(writer);
+		cout << writer.str() << '\n';
+	}
+	cout.flush();
+	if (h.corrupted() != 0) {
+		LOG(warning) << "History blocks skipped for a bad CRC: " << h.corrupted();
+	}
+	return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
 	log::init();	
 	LOG(info) << "Crossover Monitor Client Started";
@@ -25,7 +69,67 @@ int main(int argc, char* argv[]) {
 	description.add_options()
 		("help", "Show this message")
 		("seconds", po::value<unsigned>()->default_value(2), "Period between reports in seconds")
-		("logfile", po::value<string>(), "Log file");
+		("milliseconds", po::value<unsigned>(), "Sampling period in milliseconds (10 or more), "
+			"each report summarizes the samples taken since the previous one")
+		("url", po::value<string>(), "Server URL the samples are sent to, e.g. "
+			"http://localhost:8080/ingest; samples are only logged when omitted")
+		("key", po::value<string>(), "API key sent with each request")
+		("batch-size", po::value<unsigned>()->default_value(60), "Samples per request")
+		("batch-seconds", po::value<unsigned>()->default_value(10),
+			"Longest time a sample waits before being sent")
+		("no-compression", "Send uncompressed requests")
+		("binary", "Send batches in the compact binary format rather than JSON")
+		("spool", po::value<string>(), "File keeping the samples that could not be "
+			"sent until the server is back")
+		("spool-records", po::value<unsigned>()->default_value(65536),
+			"Samples the spool file holds, the oldest are overwritten when full")
+		("keyframe-every", po::value<unsigned>()->default_value(1), "Send every given "
+			"number of samples whole and, between them, only the fields that moved "
+			"beyond their dead-band, counters as changes; 1 sends every sample whole")
+		("deadband", po::value<vector<string>>()->multitoken(), "Change of a field "
+			"below which it is not sent between whole samples, e.g. --deadband "
+			"cpu_percent=1 used_memory_in_bytes=1048576")
+		("window", po::value<vector<unsigned>>()->multitoken(), "Samples in each window "
+			"of the rolling statistics logged after every report, e.g. --window 10 60")
+		("top", po::value<unsigned>(), "Log the given number of processes using the "
+			"most CPU, memory and IO after each report")
+		("cores", "Log the use of every logical CPU after each report")
+		("network", "Log the traffic of every network interface after each report")
+		("disk-rates", "Log the bytes and operations per second of the disks after "
+			"each report")
+		("adaptive-max-seconds", po::value<unsigned>(), "Adapt the sampling period to "
+			"how much the values change: back off up to the given number of seconds "
+			"while they are stable, back to the sampling period when they move")
+		("adaptive-threshold", po::value<unsigned>()->default_value(20), "Change in "
+			"percent of a value, or of a counter's rate, that brings an adaptive "
+			"period back to the sampling period")
+		("probe-deadline-ms", po::value<vector<unsigned>>()->multitoken(), "Longest time "
+			"a sample waits for the cpu, memory, process_count and disk probes, either "
+			"one value for all or one each, half the sampling period by default; a "
+			"late probe reports its last values")
+		("self-seconds", po::value<unsigned>(), "Log what the client itself costs every "
+			"given number of seconds: its CPU, memory, handles and wakeups and the "
+			"latency of every probe, of serialization and of sending")
+		("history", po::value<string>(), "File keeping a compressed history of "
+			"every sample")
+		("history-mb", po::value<unsigned>()->default_value(16),
+			"Size of the history file, the oldest samples are overwritten when full")
+		("query", po::value<string>(), "Print the min, max, avg and p95 of the given "
+			"field (e.g. cpu_percent) from the --history file as JSON lines and exit")
+		("from", po::value<unsigned long long>(), "Start of the query in milliseconds "
+			"since the Unix epoch, one day before --to by default")
+		("to", po::value<unsigned long long>(), "End of the query in milliseconds "
+			"since the Unix epoch, the last sample by default")
+		("step", po::value<unsigned>()->default_value(60), "Query bucket in seconds")
+		("logfile", po::value<string>(), "Log file")
+		("log-flush-ms", po::value<unsigned>()->default_value(1000),
+			"Longest time a record waits before being written to the log file")
+		("log-queue-kb", po::value<unsigned>()->default_value(1024),
+			"Records waiting to be written to the log file, more are dropped")
+		("log-rotate-mb", po::value<unsigned>()->default_value(0),
+			"Size at which the log file is rotated, 0 never rotates")
+		("log-files", po::value<unsigned>()->default_value(5),
+			"Rotated log files kept");
 
 	po::variables_map vm;
 	try {
@@ -49,37 +153,168 @@ int main(int argc, char* argv[]) {
 		return EXIT_FAILURE;
 	}
 	
+	// Linux blocks the termination signals in the calling thread and the
+	// threads it starts from then on, so the handler is set before the log
+	// writer, the probe workers or any other thread is started: a signal
+	// taken by a thread that does not block it kills the process.
+	if (!vm.count("query")) {
+		os::set_termination_handler([]() {
+			const lock_guard<mutex> lock(app_mutex);
+			stop_requested = true;
+			if (running_app) {
+				running_app->stop();
+			}
+		});
+	}
+
 	if (vm.count("logfile")) {
+		log::file_options options;
+		options.flush_interval = chrono::milliseconds(vm["log-flush-ms"].as<unsigned>());
+		options.queue_bytes = static_cast<size_t>(vm["log-queue-kb"].as<unsigned>()) * 1024;
+		options.rotation_bytes = vm["log-rotate-mb"].as<unsigned>() * 1024ull * 1024;
+		options.max_files = vm["log-files"].as<unsigned>();
+		log::set_file_options(options);
 		//Please dont remove or comment this line as this argument is used in grading.
 		log::set_file(vm["logfile"].as<string>());
 	}
 
+	if (vm.count("query")) {
+		int result = EXIT_FAILURE;
+		if (!vm.count("history")) {
+			LOG(error) << "--query needs --history";
+		} else {
+			try {
+				result = query_history(vm);
+			} catch (const std::exception& e) {
+				LOG(error) << e.what();
+			}
+		}
+		log::shutdown();
+		return result;
+	}
+
 	try {
 		unsigned sec = DEFAULT_SECONDS;
 		if (vm.count("seconds")) {
 			sec = vm["seconds"].as<unsigned>();
 		}
 		chrono::seconds s(sec);
-		client::application app(s);
+		unique_ptr<client::application> app;
+		if (vm.count("milliseconds")) {
+			chrono::milliseconds ms(vm["milliseconds"].as<unsigned>());
+			app.reset(new client::application(ms, s));
+		} else {
+			app.reset(new client::application(s));
+		}
+
+		if (vm.count("window")) {
+			const vector<unsigned>& windows = vm["window"].as<vector<unsigned>>();
+			app->set_rolling_windows(vector<size_t>(windows.begin(), windows.end()));
+		}
+
+		if (vm.count("top")) {
+			app->enable_process_top(vm["top"].as<unsigned>());
+		}
+
+		if (vm.count("cores")) {
+			app->enable_core_usage();
+		}
+
+		if (vm.count("network")) {
+			app->enable_network_usage();
+		}
+
+		if (vm.count("disk-rates")) {
+			app->enable_disk_rates();
+		}
+
+		if (vm.count("adaptive-max-seconds")) {
+			client::adaptive_options options;
+			options.max_period = chrono::seconds(vm["adaptive-max-seconds"].as<unsigned>());
+			options.threshold = vm["adaptive-threshold"].as<unsigned>() / 100.0;
+			app->enable_adaptive_sampling(options);
+		}
+
+		if (vm.count("probe-deadline-ms")) {
+			const vector<unsigned>& ms = vm["probe-deadline-ms"].as<vector<unsigned>>();
+			if (ms.size() != 1 && ms.size() != client::os::probe_count) {
+				throw invalid_argument("--probe-deadline-ms takes one value or one "
+									   "per probe");
+			}
+			client::probe_deadlines deadlines;
+			for (size_t i = 0; i < deadlines.size(); ++i) {
+				deadlines[i] = chrono::milliseconds(ms[ms.size() == 1 ? 0 : i]);
+			}
+			app->set_probe_deadlines(deadlines);
+		}
+
+		if (vm.count("self-seconds")) {
+			app->enable_self_metrics(chrono::seconds(vm["self-seconds"].as<unsigned>()));
+		}
+
+		if (vm.count("history")) {
+			const size_t mb = vm["history-mb"].as<unsigned>();
+			app->enable_history(vm["history"].as<string>(),
+				mb * 1024 * 1024 / client::history_block_size);
+		}
+
+		if (vm.count("url")) {
+			client::sender_options options;
+			options.url = vm["url"].as<string>();
+			if (vm.count("key")) {
+				options.key = vm["key"].as<string>();
+			}
+			options.batch_size = vm["batch-size"].as<unsigned>();
+			options.batch_delay = chrono::seconds(vm["batch-seconds"].as<unsigned>());
+			options.compress = vm.count("no-compression") == 0;
+			options.binary = vm.count("binary") != 0;
+			if (vm.count("spool")) {
+				options.spool_path = vm["spool"].as<string>();
+				options.spool_capacity = vm["spool-records"].as<unsigned>();
+			}
+			options.delta.keyframe_every = vm["keyframe-every"].as<unsigned>();
+			if (vm.count("deadband")) {
+				for (const string& deadband : vm["deadband"].as<vector<string>>()) {
+					const size_t equals = deadband.find('=');
+					if (equals == string::npos) {
+						throw invalid_argument("--deadband takes FIELD=VALUE: " + deadband);
+					}
+					options.delta.set_deadband(deadband.substr(0, equals),
+											   stod(deadband.substr(equals + 1)));
+				}
+			}
+			app->enable_sending(options);
+		}
 		
-		os::set_termination_handler([&app]() {
-			try {
-				app.stop();
-			} catch (const std::exception& e) {
-				LOG(error) << e.what();
+		{
+			const lock_guard<mutex> lock(app_mutex);
+			if (!stop_requested) {
+				running_app = app.get();
 			}
+		}
+		const utils::scope_exit running_guard([] {
+			const lock_guard<mutex> lock(app_mutex);
+			running_app = nullptr;
 		});
 
-		app.run();
+		if (running_app) {
+			app->run();
+		}
 	} catch (const std::exception& e) {
 		LOG(error) << e.what();
+		log::shutdown();
 		return EXIT_FAILURE;
 	} catch (...) {
 		LOG(error) << "Unknown exception, exiting";
+		log::shutdown();
 		return EXIT_FAILURE;
 	}
 
+	if (log::dropped_records() != 0) {
+		LOG(warning) << "Log records dropped: " << log::dropped_records();
+	}
 	LOG(info) << "Exiting gracefully";
+	log::shutdown();
 
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "os.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+/**
+ * Reads the counters of every network interface through sources kept open
+ * between samples. Interfaces are tracked incrementally: an interface
+ * still at the position it had in the previous sample is matched by
+ * comparing its name in place, so on hosts with hundreds of container
+ * interfaces a sample neither allocates nor rebuilds names unless
+ * interfaces were added or removed. On Linux /proc/net/dev lists every
+ * interface on each read; on Windows interfaces are rediscovered every
+ * rescan period or as soon as one disappears. Loopback is left out on
+ * both, and on Windows filter drivers repeating an adapter's traffic.
+ * Thread safe.
+ */
+class net_counters final : public boost::noncopyable {
+public:
+	/**
+	 * May throw std::exception derived exceptions.
+	 * @param rescan_period time between interface rediscoveries, where
+	 *                      the OS needs them.
+	 */
+	explicit net_counters(
+		const std::chrono::seconds& rescan_period = std::chrono::seconds(30));
+	~net_counters();
+
+	/**
+	 * Reads the counters of every interface.
+	 * @param interfaces receives one entry per interface, its storage is
+	 *                   reused.
+	 * @return false if no interface could be read.
+	 */
+	bool sample(std::vector<interface_stats>& interfaces) noexcept;
+	/**
+	 * Forces interface rediscovery on the next sample.
+	 */
+	void rescan() noexcept;
+
+private:
+	struct impl;
+
+	std::unique_ptr<impl> pimpl_;
+}; //class net_counters
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,176 @@
+#include "net_counters.hpp"
+#include "proc_file.hpp"
+
+#include "log.hpp"
+
+#include <net/if_arp.h>
+
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+// Largest /proc/net/dev read, some 100000 interfaces.
+static const size_t max_buffer = 16 * 1024 * 1024;
+
+struct net_counters::impl final {
+	impl() :
+		netdev("/proc/net/dev"),
+		buffer(16 * 1024) {
+	}
+
+	/**
+	 * Reads the whole file, growing the buffer when it was filled: a full
+	 * buffer may have cut the file short.
+	 */
+	bool read_file() noexcept {
+		for (;;) {
+			const ssize_t n = netdev.read(buffer.data(), buffer.size());
+			if (n <= 0) {
+				return false;
+			}
+			if (static_cast<size_t>(n) < buffer.size() - 1 ||
+				buffer.size() >= max_buffer) {
+				return true;
+			}
+			try {
+				buffer.resize(buffer.size() * 2);
+			} catch (const std::exception& e) {
+				LOG(error) << "Failed to grow the /proc/net/dev buffer: "
+						   << e.what();
+				return true;
+			}
+		}
+	}
+
+	/**
+	 * Loopback carries no traffic in or out of the host and is left out,
+	 * as on Windows. Only checked when a line's name changes.
+	 */
+	static bool is_loopback(const string& name) noexcept {
+		char path[512];
+		snprintf(path, sizeof(path), "/sys/class/net/%s/type", name.c_str());
+		char type[32];
+		proc_file file(path);
+		if (file.read(type, sizeof(type)) <= 0) {
+			return false;
+		}
+		unsigned long long value = 0;
+		text_parser parser(type);
+		return parser.number(value) && value == ARPHRD_LOOPBACK;
+	}
+
+	bool read(vector<interface_stats>& out) noexcept {
+		const lock_guard<mutex> guard(m);
+		if (!read_file()) {
+			return false;
+		}
+
+		size_t count = 0;
+		size_t line = 0;
+		text_parser parser(buffer.data());
+		// Two lines of column titles
+		parser.skip_line();
+		parser.skip_line();
+		try {
+			for (; !parser.at_end(); parser.skip_line()) {
+				size_t len = 0;
+				const char* name = parser.field(':', len);
+				if (len == 0) {
+					continue;
+				}
+				if (lines.size() <= line) {
+					lines.emplace_back();
+				}
+				listed& entry = lines[line++];
+				if (entry.name.size() != len ||
+					entry.name.compare(0, len, name, len) != 0) {
+					entry.name.assign(name, len);
+					entry.loopback = is_loopback(entry.name);
+				}
+				if (entry.loopback) {
+					continue;
+				}
+				// rx: bytes packets errs drop fifo frame compressed multicast
+				// tx: bytes packets errs drop fifo colls carrier compressed
+				unsigned long long fields[16] = { 0 };
+				for (auto& field : fields) {
+					if (!parser.number(field)) {
+						break;
+					}
+				}
+
+				// Interfaces keep their position between reads, so names
+				// are compared in place and only copied when they moved.
+				if (out.size() <= count) {
+					out.emplace_back();
+				}
+				interface_stats& stats = out[count++];
+				if (stats.name.size() != len ||
+					stats.name.compare(0, len, name, len) != 0) {
+					stats.name.assign(name, len);
+				}
+				stats.rx_bytes = fields[0];
+				stats.rx_packets = fields[1];
+				stats.rx_errors = fields[2];
+				stats.rx_drops = fields[3];
+				stats.tx_bytes = fields[8];
+				stats.tx_packets = fields[9];
+				stats.tx_errors = fields[10];
+				stats.tx_drops = fields[11];
+			}
+		} catch (const std::exception& e) {
+			LOG(error) << "Failed to read the network interfaces: " << e.what();
+		}
+
+		out.resize(count);
+		if (count != interfaces) {
+			LOG(info) << "Monitoring " << count << " network interfaces";
+		}
+		interfaces = count;
+		return count != 0;
+	}
+
+	/**
+	 * An interface of /proc/net/dev, by line.
+	 */
+	struct listed final {
+		string name;
+		bool loopback = false;
+	};
+
+	proc_file netdev;
+	vector<char> buffer;
+	vector<listed> lines;
+	size_t interfaces = 0;
+	mutex m;
+};
+
+net_counters::net_counters(const chrono::seconds& rescan_period) :
+	pimpl_(new impl()) {
+	// /proc/net/dev lists every interface on each read
+	(void)rescan_period;
+}
+
+net_counters::~net_counters() {
+}
+
+bool net_counters::sample(vector<interface_stats>& interfaces) noexcept {
+	return pimpl_->read(interfaces);
+}
+
+void net_counters::rescan() noexcept {
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
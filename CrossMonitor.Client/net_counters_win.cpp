@@ -0,0 +1,182 @@
+#include "net_counters.hpp"
+
+// WinSock2.h goes before Windows.h, which would pull the older Winsock.h
+#include <WinSock2.h>
+#include <Windows.h>
+#include <iphlpapi.h>
+
+#include "log.hpp"
+
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+static string utf8(const wchar_t* text) {
+	char buffer[4 * (IF_MAX_STRING_SIZE + 1)];
+	if (WideCharToMultiByte(CP_UTF8, 0, text, -1, buffer, sizeof(buffer),
+							NULL, NULL) == 0) {
+		return string();
+	}
+	return buffer;
+}
+
+struct net_counters::impl final {
+	struct network_interface final {
+		NET_LUID luid;
+		string name;
+		/**
+		 * See interface_stats::generation, new for every LUID found.
+		 */
+		unsigned generation;
+	};
+
+	explicit impl(const chrono::seconds& period) : rescan_period(period) {
+	}
+
+	/**
+	 * Generation of the interface known by luid, a new one if none is.
+	 */
+	unsigned generation_of(const NET_LUID& luid) noexcept {
+		for (const auto& known : interfaces) {
+			if (known.luid.Value == luid.Value) {
+				return known.generation;
+			}
+		}
+		return ++generation;
+	}
+
+	/**
+	 * Lists the interfaces with GetIfTable2, which allocates its table:
+	 * samples in between query the known interfaces one by one with
+	 * GetIfEntry2, which does not.
+	 */
+	void discover() {
+		last_scan = chrono::steady_clock::now();
+		scan_requested = false;
+
+		PMIB_IF_TABLE2 table = NULL;
+		const DWORD status = GetIfTable2(&table);
+		if (status != NO_ERROR) {
+			LOG(error) << "Failed to list network interfaces, code: " << status;
+			return;
+		}
+
+		vector<network_interface> found;
+		try {
+			found.reserve(table->NumEntries);
+			for (ULONG i = 0; i < table->NumEntries; ++i) {
+				const MIB_IF_ROW2& row = table->Table[i];
+				// Filter drivers (QoS, WFP...) repeat the traffic of the
+				// adapter they are bound to, loopback reports none.
+				if (row.InterfaceAndOperStatusFlags.FilterInterface ||
+					row.Type == IF_TYPE_SOFTWARE_LOOPBACK) {
+					continue;
+				}
+				found.push_back(network_interface{ row.InterfaceLuid,
+												   utf8(row.Alias),
+												   generation_of(row.InterfaceLuid) });
+			}
+		} catch (...) {
+			FreeMibTable(table);
+			throw;
+		}
+		FreeMibTable(table);
+
+		if (found.size() != interfaces.size()) {
+			LOG(info) << "Monitoring " << found.size() << " network interfaces";
+		}
+		interfaces.swap(found);
+	}
+
+	bool read(vector<interface_stats>& out) noexcept {
+		const lock_guard<mutex> guard(m);
+
+		try {
+			if (scan_requested ||
+				chrono::steady_clock::now() - last_scan >= rescan_period) {
+				discover();
+			}
+		} catch (const std::exception& e) {
+			LOG(error) << "Failed to discover network interfaces: " << e.what();
+		}
+
+		size_t count = 0;
+		try {
+			for (auto it = interfaces.begin(); it != interfaces.end();) {
+				MIB_IF_ROW2 row;
+				memset(&row, 0, sizeof(row));
+				row.InterfaceLuid = it->luid;
+				const DWORD status = GetIfEntry2(&row);
+				if (status != NO_ERROR) {
+					// Most likely removed, rediscover on the next sample.
+					LOG(warning) << "Could not read network interface "
+								 << it->name << ". Error: " << status;
+					it = interfaces.erase(it);
+					scan_requested = true;
+					continue;
+				}
+
+				if (out.size() <= count) {
+					out.emplace_back();
+				}
+				interface_stats& stats = out[count++];
+				// Assigned only when the interface at this position changed
+				if (stats.name != it->name) {
+					stats.name = it->name;
+				}
+				stats.rx_bytes = row.InOctets;
+				stats.tx_bytes = row.OutOctets;
+				stats.rx_packets = row.InUcastPkts + row.InNUcastPkts;
+				stats.tx_packets = row.OutUcastPkts + row.OutNUcastPkts;
+				stats.rx_errors = row.InErrors;
+				stats.tx_errors = row.OutErrors;
+				stats.rx_drops = row.InDiscards;
+				stats.tx_drops = row.OutDiscards;
+				stats.generation = it->generation;
+				++it;
+			}
+		} catch (const std::exception& e) {
+			LOG(error) << "Failed to read the network interfaces: " << e.what();
+		}
+
+		out.resize(count);
+		return count != 0;
+	}
+
+	const chrono::seconds rescan_period;
+	vector<network_interface> interfaces;
+	chrono::steady_clock::time_point last_scan;
+	bool scan_requested = true;
+	unsigned generation = 0;
+	mutex m;
+};
+
+net_counters::net_counters(const chrono::seconds& rescan_period) :
+	pimpl_(new impl(rescan_period)) {
+}
+
+net_counters::~net_counters() {
+}
+
+bool net_counters::sample(vector<interface_stats>& interfaces) noexcept {
+	return pimpl_->read(interfaces);
+}
+
+void net_counters::rescan() noexcept {
+	const lock_guard<mutex> guard(pimpl_->m);
+	pimpl_->scan_requested = true;
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,143 @@
+#include <net_rates.hpp>
+
+#include <cmath>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+typedef unsigned long long os::interface_stats::* counter_field;
+typedef double interface_rates::* rate_field;
+
+/**
+ * The counters of an interface and their rates, in the same order.
+ */
+static const counter_field counter_fields[] = {
+	&os::interface_stats::rx_bytes,
+	&os::interface_stats::tx_bytes,
+	&os::interface_stats::rx_packets,
+	&os::interface_stats::tx_packets,
+	&os::interface_stats::rx_errors,
+	&os::interface_stats::tx_errors,
+	&os::interface_stats::rx_drops,
+	&os::interface_stats::tx_drops
+};
+static const rate_field rate_fields[] = {
+	&interface_rates::rx_bytes,
+	&interface_rates::tx_bytes,
+	&interface_rates::rx_packets,
+	&interface_rates::tx_packets,
+	&interface_rates::rx_errors,
+	&interface_rates::tx_errors,
+	&interface_rates::rx_drops,
+	&interface_rates::tx_drops
+};
+static const char* const rate_names[] = {
+	"rx_bytes",
+	"tx_bytes",
+	"rx_packets",
+	"tx_packets",
+	"rx_errors",
+	"tx_errors",
+	"rx_drops",
+	"tx_drops"
+};
+static const size_t rate_count = sizeof(rate_fields) / sizeof(rate_fields[0]);
+static_assert(sizeof(counter_fields) / sizeof(counter_fields[0]) == rate_count,
+			  "A counter per rate");
+
+static void write_rates(json_writer& writer, const interface_rates& rates) {
+	for (size_t i = 0; i < rate_count; ++i) {
+		writer.key(rate_names[i]);
+		writer.value(static_cast<unsigned long long>(llround(rates.*rate_fields[i])));
+	}
+}
+
+void net_usage::write(json_writer& writer) const {
+	writer.begin_object();
+	writer.key("interfaces");
+	writer.value(static_cast<unsigned long long>(interfaces.size()));
+	write_rates(writer, total);
+	writer.key("active");
+	writer.begin_array();
+	for (const interface_rates& rates : interfaces) {
+		bool active = false;
+		for (size_t i = 0; i < rate_count && !active; ++i) {
+			active = rates.*rate_fields[i] > 0;
+		}
+		if (active) {
+			writer.begin_object();
+			writer.key("name");
+			writer.value(rates.name.c_str());
+			write_rates(writer, rates);
+			writer.end_object();
+		}
+	}
+	writer.end_array();
+	writer.end_object();
+}
+
+bool net_rates::sample(net_usage& out) noexcept {
+	if (!os::interfaces(current_)) {
+		return false;
+	}
+	try {
+		update(current_, chrono::steady_clock::now(), out);
+	} catch (const std::exception&) {
+		return false;
+	}
+	return true;
+}
+
+void net_rates::update(const vector<os::interface_stats>& current,
+					   const chrono::steady_clock::time_point& now,
+					   net_usage& out) {
+	// Interfaces keep their positions unless some came or went, only then
+	// are the tracked ones matched by name and moved.
+	bool same = tracked_.size() == current.size();
+	for (size_t n = 0; same && n < current.size(); ++n) {
+		same = tracked_[n].name == current[n].name;
+	}
+	if (!same) {
+		matched_.clear();
+		matched_.resize(current.size());
+		const size_t count = tracked_.size();
+		size_t hint = 0;
+		for (size_t n = 0; n < current.size(); ++n) {
+			for (size_t i = 0; i < count; ++i) {
+				const size_t index = (hint + i) % count;
+				if (tracked_[index].name == current[n].name) {
+					matched_[n] = std::move(tracked_[index]);
+					hint = index + 1;
+					break;
+				}
+			}
+			matched_[n].name = current[n].name;
+		}
+		tracked_.swap(matched_);
+	}
+
+	out.interfaces.resize(current.size());
+	out.total = interface_rates();
+	out.total.name = "total";
+	for (size_t n = 0; n < current.size(); ++n) {
+		const os::interface_stats& stats = current[n];
+		tracked_interface& tracked = tracked_[n];
+		interface_rates& rates = out.interfaces[n];
+		if (rates.name != stats.name) {
+			rates.name = stats.name;
+		}
+		for (size_t i = 0; i < rate_count; ++i) {
+			tracked.counters[i].update(stats.*counter_fields[i], now,
+									   stats.generation);
+			rates.*rate_fields[i] = tracked.counters[i].rate();
+			out.total.*rate_fields[i] += rates.*rate_fields[i];
+		}
+	}
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
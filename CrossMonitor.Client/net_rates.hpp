@@ -0,0 +1,100 @@
+#pragma once
+
+#include <os.hpp>
+#include <counter_rate.hpp>
+#include <json_writer.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Traffic of a network interface between two samples, per second.
+ */
+struct interface_rates final {
+	std::string name;
+	double rx_bytes = 0;
+	double tx_bytes = 0;
+	double rx_packets = 0;
+	double tx_packets = 0;
+	double rx_errors = 0;
+	double tx_errors = 0;
+	double rx_drops = 0;
+	double tx_drops = 0;
+};
+
+/**
+ * Traffic of every network interface between two samples.
+ */
+struct net_usage final {
+	std::vector<interface_rates> interfaces;
+	/**
+	 * Sum of every interface, its name is "total". Loopback is never
+	 * listed; on Linux virtual interfaces (veth, bridges, tunnels) are,
+	 * so traffic crossing them counts once per interface it crosses.
+	 */
+	interface_rates total;
+
+	/**
+	 * Writes {"interfaces":n,"rx_bytes":..,"tx_bytes":..,"rx_packets":..,
+	 * "tx_packets":..,"rx_errors":..,"tx_errors":..,"rx_drops":..,
+	 * "tx_drops":..,"active":[{"name":..,"rx_bytes":..,...},...]}, the
+	 * totals followed by the interfaces that had any traffic, so hosts
+	 * with hundreds of idle container interfaces keep short lines. Rates
+	 * are rounded to integers.
+	 */
+	void write(json_writer& writer) const;
+};
+
+/**
+ * Per interface network rates, through a utils::counter_rate per counter
+ * of every interface: interfaces that are new, recreated or replaced (see
+ * os::interface_stats::generation) only set a baseline, never a spike.
+ * Storage is reused between samples while the interfaces stay the same.
+ * Not thread safe.
+ */
+class net_rates final : public boost::noncopyable {
+public:
+	net_rates() = default;
+
+	/**
+	 * Reads the counters and computes the rates since the previous call;
+	 * the first call only reads the counters and reports zero rates.
+	 * @return false if the counters could not be read.
+	 */
+	bool sample(net_usage& out) noexcept;
+
+	/**
+	 * Computes the rates from counters read at now. Interfaces are matched
+	 * by name, looked up from the position following the previous match,
+	 * so stable interface lists match in constant time each. Interfaces
+	 * that went away are forgotten.
+	 * May throw std::bad_alloc.
+	 */
+	void update(const std::vector<os::interface_stats>& current,
+				const std::chrono::steady_clock::time_point& now,
+				net_usage& out);
+
+private:
+	/**
+	 * Counters are in the order of the interface_rates fields.
+	 */
+	struct tracked_interface final {
+		std::string name;
+		utils::counter_rate counters[8];
+	};
+
+	std::vector<tracked_interface> tracked_;
+	std::vector<tracked_interface> matched_;
+	std::vector<os::interface_stats> current_;
+}; //class net_rates
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
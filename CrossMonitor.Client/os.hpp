@@ -2,11 +2,117 @@
 
 #include "../CrossMonitor.Shared/os.hpp"
 
+#include <cstddef>
+#include <string>
+#include <vector>
+
 namespace crossover {
 namespace monitor {
 namespace client {
 namespace os {
 
+/**
+ * The OS sources read for a sample, each filling its own snapshot fields.
+ */
+enum class probe : unsigned {
+	cpu,
+	memory,
+	process_count,
+	disk
+};
+static const std::size_t probe_count = 4;
+
+/**
+ * All metrics gathered in a single pass over the OS sources, so every field
+ * refers to the same instant.
+ */
+struct snapshot final {
+	float cpu_percent = 0;
+	unsigned long long used_memory = 0;
+	unsigned long long total_memory = 0;
+	unsigned process_count = 0;
+	unsigned long long total_disk_read = 0;
+	unsigned long long total_disk_write = 0;
+	unsigned long long total_disk_reads = 0;
+	unsigned long long total_disk_writes = 0;
+	/**
+	 * Changes whenever the disks summed in the total_disk_* fields do, so
+	 * the sums are only comparable within a generation.
+	 */
+	unsigned disk_generation = 0;
+
+	/**
+	 * Time spent reading each source, in nanoseconds.
+	 */
+	unsigned long long cpu_ns = 0;
+	unsigned long long memory_ns = 0;
+	unsigned long long process_count_ns = 0;
+	unsigned long long disk_ns = 0;
+
+	/**
+	 * Bit 1 << probe set for the probes that missed their deadline, whose
+	 * fields hold the last values they read (see probe_runner).
+	 */
+	unsigned stale = 0;
+};
+
+/**
+ * Cumulative IO counters of a single physical disk.
+ */
+struct disk_stats final {
+	std::string name;
+	unsigned long long read_bytes = 0;
+	unsigned long long write_bytes = 0;
+	unsigned long long reads = 0;
+	unsigned long long writes = 0;
+};
+
+/**
+ * Cumulative counters of a single network interface, received (rx) and
+ * transmitted (tx).
+ */
+struct interface_stats final {
+	std::string name;
+	unsigned long long rx_bytes = 0;
+	unsigned long long tx_bytes = 0;
+	unsigned long long rx_packets = 0;
+	unsigned long long tx_packets = 0;
+	unsigned long long rx_errors = 0;
+	unsigned long long tx_errors = 0;
+	unsigned long long rx_drops = 0;
+	unsigned long long tx_drops = 0;
+	/**
+	 * Changes when the interface under this name is another one, e.g. an
+	 * adapter replaced on Windows; Linux gives no such identity, there a
+	 * recreated interface shows as counters going backwards.
+	 */
+	unsigned generation = 0;
+};
+
+/**
+ * Fills every field of s reading each OS source only once.
+ * Fields whose source fails are set to zero.
+ */
+void sample(snapshot& s) noexcept;
+/**
+ * Fills the fields of s read by p, its time included.
+ * Fields whose source fails are set to zero.
+ */
+void sample(probe p, snapshot& s) noexcept;
+
+/**
+ * Gets the cumulative counters of every physical disk currently attached.
+ * Reuses the storage already held by disks.
+ */
+void disks(std::vector<disk_stats>& out) noexcept;
+
+/**
+ * Gets the cumulative counters of every network interface, see
+ * net_counters. Reuses the storage already held by out.
+ * @return false if they could not be read.
+ */
+bool interfaces(std::vector<interface_stats>& out) noexcept;
+
 /**
  * Gets the number of currently running processes.
  */
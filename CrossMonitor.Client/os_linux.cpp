@@ -0,0 +1,315 @@
+#include "os.hpp"
+#include "disk_counters.hpp"
+#include "net_counters.hpp"
+#include "proc_file.hpp"
+
+#include "log.hpp"
+#include "latency_histogram.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include <cerrno>
+#include <mutex>
+#include <vector>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+struct cpu_times final {
+	unsigned long long busy = 0;
+	unsigned long long total = 0;
+};
+
+static bool read_cpu_times(cpu_times& times) noexcept {
+	static proc_file file("/proc/stat");
+	// Only the aggregate "cpu " line at the top of the file is needed.
+	char buffer[1024];
+
+	if (file.read(buffer, sizeof(buffer)) <= 0) {
+		return false;
+	}
+
+	text_parser parser(buffer);
+	if (!parser.consume("cpu ")) {
+		LOG(error) << "Unexpected /proc/stat format";
+		return false;
+	}
+
+	// user nice system idle iowait irq softirq steal; guest time is already
+	// accounted in user and nice.
+	unsigned long long fields[8] = { 0 };
+	for (auto& field : fields) {
+		if (!parser.number(field)) {
+			break;
+		}
+	}
+
+	const unsigned long long idle = fields[3] + fields[4];
+	unsigned long long total = 0;
+	for (const auto field : fields) {
+		total += field;
+	}
+	times.total = total;
+	times.busy = total - idle;
+	return true;
+}
+
+static unsigned count_pid_entries() noexcept {
+	struct linux_dirent64 {
+		unsigned long long d_ino;
+		long long d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[1];
+	};
+
+	static const int fd = ::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	static mutex m;
+
+	if (fd < 0) {
+		LOG(error) << "Failed to open /proc, code: " << errno;
+		return 0;
+	}
+
+	const lock_guard<mutex> guard(m);
+	if (::lseek(fd, 0, SEEK_SET) < 0) {
+		LOG(error) << "Failed to rewind /proc, code: " << errno;
+		return 0;
+	}
+
+	alignas(linux_dirent64) static char buffer[32 * 1024];
+	unsigned count = 0;
+	for (;;) {
+		const long n = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+		if (n < 0) {
+			LOG(error) << "Failed to enumerate processes, code: " << errno;
+			return 0;
+		}
+		if (n == 0) {
+			break;
+		}
+		for (long offset = 0; offset < n;) {
+			const auto entry =
+				reinterpret_cast<const linux_dirent64*>(buffer + offset);
+			const char* name = entry->d_name;
+			if (*name >= '1' && *name <= '9') {
+				while (*name >= '0' && *name <= '9') {
+					++name;
+				}
+				if (*name == '\0') {
+					++count;
+				}
+			}
+			offset += entry->d_reclen;
+		}
+	}
+	return count;
+}
+
+struct memory_info final {
+	unsigned long long total = 0;
+	unsigned long long available = 0;
+};
+
+static bool read_memory_info(memory_info& info) noexcept {
+	static proc_file file("/proc/meminfo");
+	static mutex m;
+	char buffer[4096];
+
+	{
+		const lock_guard<mutex> guard(m);
+		if (file.read(buffer, sizeof(buffer)) <= 0) {
+			return false;
+		}
+	}
+
+	unsigned long long total = 0;
+	unsigned long long available = 0;
+	unsigned long long free = 0;
+	unsigned long long buffers = 0;
+	unsigned long long cached = 0;
+	bool has_available = false;
+
+	text_parser parser(buffer);
+	while (!parser.at_end()) {
+		if (parser.consume("MemTotal:")) {
+			parser.number(total);
+		} else if (parser.consume("MemAvailable:")) {
+			has_available = parser.number(available);
+		} else if (parser.consume("MemFree:")) {
+			parser.number(free);
+		} else if (parser.consume("Buffers:")) {
+			parser.number(buffers);
+		} else if (parser.consume("Cached:")) {
+			parser.number(cached);
+			// Everything needed is above this line.
+			break;
+		}
+		parser.skip_line();
+	}
+
+	if (total == 0) {
+		LOG(error) << "Unexpected /proc/meminfo format";
+		return false;
+	}
+
+	// MemAvailable is missing on kernels older than 3.14.
+	if (!has_available) {
+		available = free + buffers + cached;
+	}
+
+	// Values are reported in kB.
+	info.total = total * 1024;
+	info.available = (available > total ? total : available) * 1024;
+	return true;
+}
+
+static disk_counters& disk_counters_instance() noexcept {
+	static disk_counters counters;
+	return counters;
+}
+
+static net_counters& net_counters_instance() noexcept {
+	static net_counters counters;
+	return counters;
+}
+
+static float cpu_percent_since_last_call() noexcept {
+	static cpu_times previous;
+	static once_flag onceflag;
+	static mutex m;
+
+	const lock_guard<mutex> guard(m);
+	call_once(onceflag, []() {
+		read_cpu_times(previous);
+	});
+
+	cpu_times current;
+	if (!read_cpu_times(current)) {
+		LOG(error) << "Error collecting CPU usage data";
+		return 0;
+	}
+
+	const unsigned long long total = current.total - previous.total;
+	const unsigned long long busy = current.busy - previous.busy;
+	previous = current;
+
+	if (total == 0 || busy > total) {
+		return 0;
+	}
+	return static_cast<float>(100.0 * busy / total);
+}
+
+void sample(probe p, snapshot& s) noexcept {
+	utils::stopwatch watch;
+	switch (p) {
+	case probe::cpu:
+		s.cpu_percent = cpu_percent_since_last_call();
+		s.cpu_ns = watch.lap();
+		break;
+	case probe::memory: {
+		memory_info memory;
+		if (read_memory_info(memory)) {
+			s.total_memory = memory.total;
+			s.used_memory = memory.total - memory.available;
+		} else {
+			s.total_memory = 0;
+			s.used_memory = 0;
+		}
+		s.memory_ns = watch.lap();
+		break;
+	}
+	case probe::process_count:
+		s.process_count = count_pid_entries();
+		s.process_count_ns = watch.lap();
+		break;
+	case probe::disk: {
+		disk_stats disk;
+		disk_counters_instance().sample(disk, s.disk_generation);
+		s.total_disk_read = disk.read_bytes;
+		s.total_disk_write = disk.write_bytes;
+		s.total_disk_reads = disk.reads;
+		s.total_disk_writes = disk.writes;
+		s.disk_ns = watch.lap();
+		break;
+	}
+	}
+}
+
+void sample(snapshot& s) noexcept {
+	for (size_t p = 0; p < probe_count; ++p) {
+		sample(static_cast<probe>(p), s);
+	}
+}
+
+void disks(std::vector<disk_stats>& out) noexcept {
+	disk_stats total;
+	disk_counters_instance().sample(out, total);
+}
+
+bool interfaces(std::vector<interface_stats>& out) noexcept {
+	return net_counters_instance().sample(out);
+}
+
+unsigned process_count() noexcept {
+	return count_pid_entries();
+}
+
+float cpu_use_percent() noexcept {
+	return cpu_percent_since_last_call();
+}
+
+float memory_use_percent() noexcept {
+	memory_info info;
+	if (!read_memory_info(info)) {
+		return 0;
+	}
+
+	const float available =
+		static_cast<float>(100 * info.available / info.total);
+	const float used = 100 - available;
+	return used;
+}
+
+unsigned long long total_memory() noexcept {
+	memory_info info;
+	if (!read_memory_info(info)) {
+		return 0;
+	}
+
+	return info.total;
+}
+
+unsigned long long used_memory() noexcept {
+	memory_info info;
+	if (!read_memory_info(info)) {
+		return 0;
+	}
+
+	return info.total - info.available;
+}
+
+unsigned long long total_disk_read() noexcept {
+	disk_stats total;
+	disk_counters_instance().sample(total);
+	return total.read_bytes;
+}
+
+unsigned long long total_disk_write() noexcept {
+	disk_stats total;
+	disk_counters_instance().sample(total);
+	return total.write_bytes;
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -1,6 +1,9 @@
 #include "os.hpp"
+#include "disk_counters.hpp"
+#include "net_counters.hpp"
 
 #include "log.hpp"
+#include "latency_histogram.hpp"
 
 #include <Windows.h>
 #include <Psapi.h>
@@ -82,12 +85,80 @@ float cpu_use_percent() noexcept {
 	}
 	return static_cast<float>(value.doubleValue);
 }
-float memory_use_percent() noexcept {
-	MEMORYSTATUSEX mem;
+static bool memory_status(MEMORYSTATUSEX& mem) noexcept {
 	mem.dwLength = sizeof(mem);
-	
+
 	if (!GlobalMemoryStatusEx(&mem)) {
 		LOG(error) << "Failed to get memory info, code: " << GetLastError();
+		return false;
+	}
+	return true;
+}
+
+static disk_counters& disk_counters_instance() noexcept {
+	static disk_counters counters;
+	return counters;
+}
+
+static net_counters& net_counters_instance() noexcept {
+	static net_counters counters;
+	return counters;
+}
+
+void sample(probe p, snapshot& s) noexcept {
+	utils::stopwatch watch;
+	switch (p) {
+	case probe::cpu:
+		s.cpu_percent = cpu_use_percent();
+		s.cpu_ns = watch.lap();
+		break;
+	case probe::memory: {
+		MEMORYSTATUSEX mem;
+		if (memory_status(mem)) {
+			s.total_memory = mem.ullTotalPhys;
+			s.used_memory = mem.ullTotalPhys - mem.ullAvailPhys;
+		} else {
+			s.total_memory = 0;
+			s.used_memory = 0;
+		}
+		s.memory_ns = watch.lap();
+		break;
+	}
+	case probe::process_count:
+		s.process_count = process_count();
+		s.process_count_ns = watch.lap();
+		break;
+	case probe::disk: {
+		disk_stats disk;
+		disk_counters_instance().sample(disk, s.disk_generation);
+		s.total_disk_read = disk.read_bytes;
+		s.total_disk_write = disk.write_bytes;
+		s.total_disk_reads = disk.reads;
+		s.total_disk_writes = disk.writes;
+		s.disk_ns = watch.lap();
+		break;
+	}
+	}
+}
+
+void sample(snapshot& s) noexcept {
+	for (size_t p = 0; p < probe_count; ++p) {
+		sample(static_cast<probe>(p), s);
+	}
+}
+
+void disks(std::vector<disk_stats>& out) noexcept {
+	disk_stats total;
+	disk_counters_instance().sample(out, total);
+}
+
+bool interfaces(std::vector<interface_stats>& out) noexcept {
+	return net_counters_instance().sample(out);
+}
+
+float memory_use_percent() noexcept {
+	MEMORYSTATUSEX mem;
+	if (!memory_status(mem)) {
 		return 0;
 	}
 
@@ -99,10 +170,7 @@ float memory_use_percent() noexcept {
 
 unsigned long long total_memory() noexcept {
 	MEMORYSTATUSEX mem;
-	mem.dwLength = sizeof(mem);
-
-	if (!GlobalMemoryStatusEx(&mem)) {
-		LOG(error) << "Failed to get memory info, code: " << GetLastError();
+	if (!memory_status(mem)) {
 		return 0;
 	}
 
@@ -111,10 +179,7 @@ unsigned long long total_memory() noexcept {
 
 unsigned long long used_memory() noexcept {
 	MEMORYSTATUSEX mem;
-	mem.dwLength = sizeof(mem);
-
-	if (!GlobalMemoryStatusEx(&mem)) {
-		LOG(error) << "Failed to get memory info, code: " << GetLastError();
+	if (!memory_status(mem)) {
 		return 0;
 	}
 
@@ -122,70 +187,15 @@ unsigned long long used_memory() noexcept {
 }
 
 unsigned long long total_disk_read() noexcept {
-
-	HANDLE dev = CreateFileW(L"\\\\.\\PhysicalDrive0",
-		0,
-		FILE_SHARE_READ | FILE_SHARE_WRITE,
-		NULL,
-		OPEN_EXISTING,
-		0,
-		NULL);
-
-	if (dev == INVALID_HANDLE_VALUE) {
-		LOG(error) << "Could not open drive for reading. Error: " << GetLastError();
-		return 0;
-	}
-
-	DWORD bytes = 0;
-	DISK_PERFORMANCE disk_info = { 0 };
-	if (!DeviceIoControl(
-		dev,
-		IOCTL_DISK_PERFORMANCE,
-		NULL,
-		0,
-		&disk_info,
-		sizeof(disk_info),
-		&bytes,
-		NULL)) {
-		LOG(error) << "Could not read disk performance. Error: " << GetLastError();
-		return 0;
-	}
-
-	return disk_info.BytesRead.QuadPart;
+	disk_stats total;
+	disk_counters_instance().sample(total);
+	return total.read_bytes;
 }
 
 unsigned long long total_disk_write() noexcept {
-
-
-	HANDLE dev = CreateFileW(L"\\\\.\\PhysicalDrive0",
-		0,
-		FILE_SHARE_READ | FILE_SHARE_WRITE,
-		NULL,
-		OPEN_EXISTING,
-		0,
-		NULL);
-
-	if (dev == INVALID_HANDLE_VALUE) {
-		LOG(error) << "Could not open drive for reading. Error: " << GetLastError();
-		return 0;
-	}
-
-	DWORD bytes = 0;
-	DISK_PERFORMANCE disk_info = { 0 };
-	if (!DeviceIoControl(
-		dev,
-		IOCTL_DISK_PERFORMANCE,
-		NULL,
-		0,
-		&disk_info,
-		sizeof(disk_info),
-		&bytes,
-		NULL)) {
-		LOG(error) << "Could not read disk performance. Error: " << GetLastError();
-		return 0;
-	}
-
-	return disk_info.BytesWritten.QuadPart;
+	disk_stats total;
+	disk_counters_instance().sample(total);
+	return total.write_bytes;
 }
 
 } //namespace os
@@ -0,0 +1,222 @@
+#include "probe_runner.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+static const unsigned all_probes = (1u << os::probe_count) - 1;
+
+/**
+ * Time field of each probe.
+ */
+static unsigned long long os::snapshot::* const probe_times[os::probe_count] = {
+	&os::snapshot::cpu_ns,
+	&os::snapshot::memory_ns,
+	&os::snapshot::process_count_ns,
+	&os::snapshot::disk_ns
+};
+
+const char* probe_name(os::probe p) noexcept {
+	switch (p) {
+	case os::probe::cpu:
+		return "cpu";
+	case os::probe::memory:
+		return "memory";
+	case os::probe::process_count:
+		return "process_count";
+	case os::probe::disk:
+		return "disk";
+	}
+	return "unknown";
+}
+
+/**
+ * Copies the fields read by p from one snapshot to another.
+ */
+static void copy_fields(os::probe p, const os::snapshot& from,
+						os::snapshot& to) noexcept {
+	switch (p) {
+	case os::probe::cpu:
+		to.cpu_percent = from.cpu_percent;
+		break;
+	case os::probe::memory:
+		to.used_memory = from.used_memory;
+		to.total_memory = from.total_memory;
+		break;
+	case os::probe::process_count:
+		to.process_count = from.process_count;
+		break;
+	case os::probe::disk:
+		to.total_disk_read = from.total_disk_read;
+		to.total_disk_write = from.total_disk_write;
+		to.total_disk_reads = from.total_disk_reads;
+		to.total_disk_writes = from.total_disk_writes;
+		to.disk_generation = from.disk_generation;
+		break;
+	}
+	const size_t i = static_cast<size_t>(p);
+	to.*probe_times[i] = from.*probe_times[i];
+}
+
+static const probe_deadlines& checked_deadlines(
+	const probe_deadlines& deadlines) {
+	for (const auto& d : deadlines) {
+		if (d <= chrono::milliseconds::zero()) {
+			throw invalid_argument("Probe deadlines must be positive");
+		}
+	}
+	return deadlines;
+}
+
+struct probe_runner::impl final {
+	explicit impl(const probe_deadlines& deadlines) :
+		deadlines(checked_deadlines(deadlines)) {
+	}
+
+	void work() noexcept;
+	void stop() noexcept;
+
+	const probe_deadlines deadlines;
+
+	mutable mutex m;
+	condition_variable work_cv;
+	condition_variable done_cv;
+	/**
+	 * Bits 1 << probe: probes waiting for a worker, being run, and done
+	 * since the current sample started.
+	 */
+	unsigned pending = 0;
+	unsigned running = 0;
+	unsigned done = 0;
+	/**
+	 * Bits 1 << probe of the probes that returned at least once.
+	 */
+	unsigned read = 0;
+	bool stopping = false;
+	/**
+	 * The last values read by every probe.
+	 */
+	os::snapshot latest;
+	unsigned long long missed[os::probe_count] = {};
+
+	vector<thread> workers;
+};
+
+void probe_runner::impl::work() noexcept {
+	unique_lock<mutex> l(m);
+	for (;;) {
+		work_cv.wait(l, [this] {
+			return pending != 0 || stopping;
+		});
+		if (stopping) {
+			return;
+		}
+		size_t i = 0;
+		while ((pending & (1u << i)) == 0) {
+			++i;
+		}
+		const unsigned bit = 1u << i;
+		pending &= ~bit;
+		running |= bit;
+		l.unlock();
+
+		os::snapshot result;
+		os::sample(static_cast<os::probe>(i), result);
+
+		l.lock();
+		copy_fields(static_cast<os::probe>(i), result, latest);
+		running &= ~bit;
+		done |= bit;
+		read |= bit;
+		done_cv.notify_one();
+	}
+}
+
+void probe_runner::impl::stop() noexcept {
+	{
+		lock_guard<mutex> l(m);
+		stopping = true;
+	}
+	work_cv.notify_all();
+	for (auto& w : workers) {
+		w.join();
+	}
+}
+
+probe_runner::probe_runner(const probe_deadlines& deadlines) :
+	pimpl_(new impl(deadlines)) {
+	try {
+		for (size_t i = 0; i < os::probe_count; ++i) {
+			pimpl_->workers.emplace_back([this] {
+				pimpl_->work();
+			});
+		}
+	} catch (...) {
+		pimpl_->stop();
+		throw;
+	}
+}
+
+probe_runner::~probe_runner() {
+	pimpl_->stop();
+}
+
+bool probe_runner::sample(os::snapshot& s) noexcept {
+	impl& r = *pimpl_;
+	const auto start = chrono::steady_clock::now();
+	unique_lock<mutex> l(r.m);
+	r.done = 0;
+	// Probes still running from a previous sample are not started again
+	r.pending |= all_probes & ~r.running;
+	r.work_cv.notify_all();
+
+	for (;;) {
+		const unsigned waiting = all_probes & ~r.done;
+		const auto now = chrono::steady_clock::now();
+		auto next = chrono::steady_clock::time_point::max();
+		for (size_t i = 0; i < os::probe_count; ++i) {
+			const auto deadline = start + r.deadlines[i];
+			if ((waiting & (1u << i)) != 0 && deadline > now) {
+				next = min(next, deadline);
+			}
+		}
+		if (next == chrono::steady_clock::time_point::max()) {
+			break;
+		}
+		r.done_cv.wait_until(l, next);
+	}
+
+	s = r.latest;
+	s.stale = all_probes & ~r.done;
+	for (size_t i = 0; i < os::probe_count; ++i) {
+		if ((s.stale & (1u << i)) != 0) {
+			++r.missed[i];
+			s.*probe_times[i] = static_cast<unsigned long long>(
+				chrono::duration_cast<chrono::nanoseconds>(
+					r.deadlines[i]).count());
+		}
+	}
+	return r.read == all_probes;
+}
+
+const probe_deadlines& probe_runner::deadlines() const noexcept {
+	return pimpl_->deadlines;
+}
+
+unsigned long long probe_runner::missed(os::probe p) const noexcept {
+	lock_guard<mutex> l(pimpl_->m);
+	return pimpl_->missed[static_cast<size_t>(p)];
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <os.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <array>
+#include <chrono>
+#include <memory>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Deadline of each probe, indexed by os::probe.
+ */
+typedef std::array<std::chrono::milliseconds, os::probe_count> probe_deadlines;
+
+/**
+ * Name of p as used in reports: "cpu", "memory", "process_count", "disk".
+ */
+const char* probe_name(os::probe p) noexcept;
+
+/**
+ * Runs the probes of a sample in parallel on a fixed pool of worker
+ * threads, one per probe, each probe with its own deadline counted from
+ * the start of the sample. A probe past its deadline does not hold the
+ * sample back: its fields keep the last values it read and its stale bit
+ * is set. It goes on running and its result is used by the following
+ * samples; it is not started again until it returns, so a hung source
+ * only ever ties up its own thread. A sample thus takes at most its
+ * longest deadline rather than the sum of the probe times.
+ * Not thread safe, sample() is meant for the collector thread.
+ */
+class probe_runner final : public boost::noncopyable {
+public:
+	/**
+	 * Throws std::invalid_argument if a deadline is not positive and
+	 * std::exception derived exceptions if the threads cannot be started.
+	 */
+	explicit probe_runner(const probe_deadlines& deadlines);
+	/**
+	 * Waits for the probes still running.
+	 */
+	~probe_runner();
+
+	/**
+	 * Runs the probes and fills s, see the class description. The time
+	 * of a stale probe is the time waited for it.
+	 * @return false while a probe has never returned, its fields then
+	 *         hold no reading at all.
+	 */
+	bool sample(os::snapshot& s) noexcept;
+
+	const probe_deadlines& deadlines() const noexcept;
+	/**
+	 * Samples in which p missed its deadline, since construction.
+	 */
+	unsigned long long missed(os::probe p) const noexcept;
+
+private:
+	struct impl;
+	std::unique_ptr<impl> pimpl_;
+}; //class probe_runner
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "log.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+/**
+ * A kernel pseudo file opened once and re-read from offset zero with pread
+ * on every sample, so no open/close happens on the sampling path.
+ * path must outlive the object.
+ */
+class proc_file final : public boost::noncopyable {
+public:
+	explicit proc_file(const char* path) noexcept :
+		path_(path),
+		fd_(::open(path, O_RDONLY | O_CLOEXEC)) {
+		if (fd_ < 0) {
+			CROSSOVER_MONITOR_LOG(error) << "Failed to open " << path_
+										 << ", code: " << errno;
+		}
+	}
+	~proc_file() {
+		if (fd_ >= 0) {
+			::close(fd_);
+		}
+	}
+
+	/**
+	 * Reads the file contents into buffer and NUL terminates them.
+	 * Contents not fitting in the buffer are silently truncated.
+	 * @return number of bytes read or -1 on error.
+	 */
+	ssize_t read(char* buffer, size_t size) noexcept {
+		if (fd_ < 0 || size == 0) {
+			return -1;
+		}
+		size_t total = 0;
+		while (total < size - 1) {
+			const ssize_t n = ::pread(fd_, buffer + total, size - 1 - total,
+									  static_cast<off_t>(total));
+			if (n < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				CROSSOVER_MONITOR_LOG(error) << "Failed to read " << path_
+											 << ", code: " << errno;
+				return -1;
+			}
+			if (n == 0) {
+				break;
+			}
+			total += static_cast<size_t>(n);
+		}
+		buffer[total] = '\0';
+		return static_cast<ssize_t>(total);
+	}
+
+private:
+	const char* path_;
+	const int fd_;
+};
+
+/**
+ * Minimal forward-only cursor over a NUL terminated buffer. Never allocates.
+ */
+class text_parser final {
+public:
+	explicit text_parser(const char* text) noexcept : p_(text) {
+	}
+
+	bool at_end() const noexcept {
+		return *p_ == '\0';
+	}
+	void skip_spaces() noexcept {
+		while (*p_ == ' ' || *p_ == '\t') {
+			++p_;
+		}
+	}
+	void skip_line() noexcept {
+		while (*p_ != '\0' && *p_ != '\n') {
+			++p_;
+		}
+		if (*p_ == '\n') {
+			++p_;
+		}
+	}
+	/**
+	 * Consumes prefix if the cursor points at it.
+	 */
+	bool consume(const char* prefix) noexcept {
+		const char* p = p_;
+		while (*prefix != '\0') {
+			if (*p++ != *prefix++) {
+				return false;
+			}
+		}
+		p_ = p;
+		return true;
+	}
+	/**
+	 * Skips blanks and parses an unsigned decimal number.
+	 * Returns false if no digits were found.
+	 */
+	bool number(unsigned long long& value) noexcept {
+		skip_spaces();
+		if (*p_ < '0' || *p_ > '9') {
+			return false;
+		}
+		unsigned long long v = 0;
+		while (*p_ >= '0' && *p_ <= '9') {
+			v = v * 10 + static_cast<unsigned>(*p_++ - '0');
+		}
+		value = v;
+		return true;
+	}
+	/**
+	 * Skips blanks and the characters up to delimiter, which is consumed.
+	 * @return pointer to the field start, len receives its length, 0 if
+	 * the line ends before delimiter.
+	 */
+	const char* field(char delimiter, size_t& len) noexcept {
+		skip_spaces();
+		const char* start = p_;
+		while (*p_ != '\0' && *p_ != '\n' && *p_ != delimiter) {
+			++p_;
+		}
+		if (*p_ != delimiter) {
+			len = 0;
+			return start;
+		}
+		len = static_cast<size_t>(p_++ - start);
+		return start;
+	}
+	/**
+	 * Skips blanks and the following non blank token.
+	 * @return pointer to the token start, len receives its length.
+	 */
+	const char* token(size_t& len) noexcept {
+		skip_spaces();
+		const char* start = p_;
+		while (*p_ != '\0' && *p_ != ' ' && *p_ != '\t' && *p_ != '\n') {
+			++p_;
+		}
+		len = static_cast<size_t>(p_ - start);
+		return start;
+	}
+
+private:
+	const char* p_;
+};
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
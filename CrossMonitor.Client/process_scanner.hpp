@@ -0,0 +1,68 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+/**
+ * Cumulative counters of one process, as read from the OS.
+ */
+struct process_counters final {
+	unsigned pid = 0;
+	/**
+	 * Tells apart processes that got the same PID, in OS specific units.
+	 */
+	unsigned long long start_time = 0;
+	/**
+	 * User and kernel time, in nanoseconds.
+	 */
+	unsigned long long cpu_time = 0;
+	unsigned long long resident_bytes = 0;
+	/**
+	 * Bytes read from and written to storage; zero when the process
+	 * cannot be inspected.
+	 */
+	unsigned long long read_bytes = 0;
+	unsigned long long write_bytes = 0;
+	/**
+	 * Executable name, truncated.
+	 */
+	char name[32] = {};
+};
+
+/**
+ * Reads the counters of every running process. Handles to the processes
+ * (/proc/[pid] files on Linux) stay open between scans, up to a limit, so
+ * a scan of a known process costs no open/close.
+ * Processes that cannot be inspected are left out. Not thread safe.
+ */
+class process_scanner final : public boost::noncopyable {
+public:
+	/**
+	 * May throw std::exception derived exceptions.
+	 */
+	process_scanner();
+	~process_scanner();
+
+	/**
+	 * @param out receives one entry per process, sorted by PID. Its
+	 *            storage is reused.
+	 * @return false if processes could not be enumerated.
+	 */
+	bool scan(std::vector<process_counters>& out) noexcept;
+
+private:
+	struct impl;
+	std::unique_ptr<impl> pimpl_;
+}; //class process_scanner
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,339 @@
+#include "process_scanner.hpp"
+#include "proc_file.hpp"
+
+#include "log.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+/**
+ * Share of the open file limit the pool may use, the rest is left to
+ * sockets and logs.
+ */
+static const rlim_t pool_share = 4;
+
+static size_t max_pooled_processes() noexcept {
+	rlimit limit;
+	if (::getrlimit(RLIMIT_NOFILE, &limit) != 0 ||
+		limit.rlim_cur == RLIM_INFINITY) {
+		return 256;
+	}
+	// Two files per process
+	return static_cast<size_t>(limit.rlim_cur / pool_share / 2);
+}
+
+static void close_fd(int& fd) noexcept {
+	if (fd >= 0) {
+		::close(fd);
+		fd = -1;
+	}
+}
+
+/**
+ * pread of a whole pseudo file into buffer, NUL terminated.
+ */
+static bool read_fd(int fd, char* buffer, size_t size) noexcept {
+	ssize_t n;
+	do {
+		n = ::pread(fd, buffer, size - 1, 0);
+	} while (n < 0 && errno == EINTR);
+	if (n <= 0) {
+		return false;
+	}
+	buffer[n] = '\0';
+	return true;
+}
+
+struct process_scanner::impl final {
+	/**
+	 * Files of a process kept open between scans.
+	 */
+	struct open_process final {
+		unsigned pid;
+		int stat_fd;
+		/**
+		 * -1 when /proc/[pid]/io could not be opened, which happens for
+		 * other users' processes unless privileged; not retried while
+		 * the process stays pooled.
+		 */
+		int io_fd;
+	};
+
+	impl() :
+		proc_fd(::open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC)),
+		ticks_per_second(::sysconf(_SC_CLK_TCK)),
+		page_size(::sysconf(_SC_PAGESIZE)),
+		max_pooled(max_pooled_processes()),
+		dents(32 * 1024) {
+		if (proc_fd < 0) {
+			LOG(error) << "Failed to open /proc, code: " << errno;
+		}
+		if (ticks_per_second <= 0) {
+			ticks_per_second = 100;
+		}
+		if (page_size <= 0) {
+			page_size = 4096;
+		}
+	}
+	~impl() {
+		for (auto& p : pool) {
+			close_fd(p.stat_fd);
+			close_fd(p.io_fd);
+		}
+		if (proc_fd >= 0) {
+			::close(proc_fd);
+		}
+	}
+
+	bool list_pids() noexcept;
+	void open(open_process& p) noexcept;
+	bool read(open_process& p, process_counters& counters) noexcept;
+	bool parse_stat(const char* text, process_counters& counters) const
+		noexcept;
+	static void parse_io(const char* text, process_counters& counters)
+		noexcept;
+
+	int open_file(unsigned pid, const char* file) const noexcept {
+		char path[32];
+		snprintf(path, sizeof(path), "%u/%s", pid, file);
+		return ::openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+	}
+
+	const int proc_fd;
+	long ticks_per_second;
+	long page_size;
+	const size_t max_pooled;
+
+	vector<char> dents;
+	vector<unsigned> pids;
+	/**
+	 * Sorted by PID; rebuilt into next_pool on every scan.
+	 */
+	vector<open_process> pool;
+	vector<open_process> next_pool;
+	char buffer[4096];
+};
+
+bool process_scanner::impl::list_pids() noexcept {
+	struct linux_dirent64 {
+		unsigned long long d_ino;
+		long long d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[1];
+	};
+
+	if (proc_fd < 0) {
+		return false;
+	}
+	if (::lseek(proc_fd, 0, SEEK_SET) < 0) {
+		LOG(error) << "Failed to rewind /proc, code: " << errno;
+		return false;
+	}
+
+	pids.clear();
+	for (;;) {
+		const long n = ::syscall(SYS_getdents64, proc_fd, dents.data(),
+								 dents.size());
+		if (n < 0) {
+			LOG(error) << "Failed to enumerate processes, code: " << errno;
+			return false;
+		}
+		if (n == 0) {
+			break;
+		}
+		for (long offset = 0; offset < n;) {
+			const auto entry =
+				reinterpret_cast<const linux_dirent64*>(dents.data() + offset);
+			const char* name = entry->d_name;
+			if (*name >= '1' && *name <= '9') {
+				unsigned pid = 0;
+				while (*name >= '0' && *name <= '9') {
+					pid = pid * 10 + static_cast<unsigned>(*name++ - '0');
+				}
+				if (*name == '\0') {
+					try {
+						pids.push_back(pid);
+					} catch (const std::exception&) {
+						return false;
+					}
+				}
+			}
+			offset += entry->d_reclen;
+		}
+	}
+	// procfs lists PIDs in order already, this is linear then
+	sort(pids.begin(), pids.end());
+	return true;
+}
+
+void process_scanner::impl::open(open_process& p) noexcept {
+	p.stat_fd = open_file(p.pid, "stat");
+	p.io_fd = open_file(p.pid, "io");
+}
+
+bool process_scanner::impl::parse_stat(const char* text,
+									   process_counters& counters) const
+	noexcept {
+	// pid (comm) state ppid ... the name may hold spaces and parentheses,
+	// so fields are counted from the last ')'.
+	const char* open = strchr(text, '(');
+	const char* close = strrchr(text, ')');
+	if (!open || !close || close < open) {
+		return false;
+	}
+	const size_t length = min(static_cast<size_t>(close - open - 1),
+							  sizeof(counters.name) - 1);
+	memcpy(counters.name, open + 1, length);
+	counters.name[length] = '\0';
+
+	text_parser parser(close + 1);
+	size_t len = 0;
+	// state (3) to cmajflt (13); some may be negative, hence tokens
+	for (int field = 3; field <= 13; ++field) {
+		parser.token(len);
+	}
+	unsigned long long utime = 0;
+	unsigned long long stime = 0;
+	if (!parser.number(utime) || !parser.number(stime)) {
+		return false;
+	}
+	// cutime (16) to itrealvalue (21)
+	for (int field = 16; field <= 21; ++field) {
+		parser.token(len);
+	}
+	unsigned long long start = 0;
+	unsigned long long rss = 0;
+	if (!parser.number(start)) {
+		return false;
+	}
+	parser.token(len);
+	if (!parser.number(rss)) {
+		return false;
+	}
+
+	counters.start_time = start;
+	counters.cpu_time = (utime + stime) * 1000000000ull /
+		static_cast<unsigned long long>(ticks_per_second);
+	counters.resident_bytes = rss * static_cast<unsigned long long>(page_size);
+	return true;
+}
+
+void process_scanner::impl::parse_io(const char* text,
+									 process_counters& counters) noexcept {
+	text_parser parser(text);
+	for (; !parser.at_end(); parser.skip_line()) {
+		if (parser.consume("read_bytes:")) {
+			parser.number(counters.read_bytes);
+		} else if (parser.consume("write_bytes:")) {
+			parser.number(counters.write_bytes);
+			break;
+		}
+	}
+}
+
+bool process_scanner::impl::read(open_process& p,
+								 process_counters& counters) noexcept {
+	counters.pid = p.pid;
+	counters.read_bytes = 0;
+	counters.write_bytes = 0;
+	if (p.stat_fd < 0 || !read_fd(p.stat_fd, buffer, sizeof(buffer)) ||
+		!parse_stat(buffer, counters)) {
+		return false;
+	}
+	if (p.io_fd >= 0 && read_fd(p.io_fd, buffer, sizeof(buffer))) {
+		parse_io(buffer, counters);
+	}
+	return true;
+}
+
+process_scanner::process_scanner() :
+	pimpl_(new impl()) {
+}
+
+process_scanner::~process_scanner() {
+}
+
+bool process_scanner::scan(vector<process_counters>& out) noexcept {
+	impl& s = *pimpl_;
+	if (!s.list_pids()) {
+		return false;
+	}
+
+	try {
+		out.resize(s.pids.size());
+		s.next_pool.reserve(min(s.pids.size(), s.max_pooled));
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to scan processes: " << e.what();
+		return false;
+	}
+	s.next_pool.clear();
+
+	size_t count = 0;
+	auto pooled = s.pool.begin();
+	for (const unsigned pid : s.pids) {
+		// Processes that exited since the previous scan
+		for (; pooled != s.pool.end() && pooled->pid < pid; ++pooled) {
+			close_fd(pooled->stat_fd);
+			close_fd(pooled->io_fd);
+		}
+
+		impl::open_process p{ pid, -1, -1 };
+		bool fresh = true;
+		if (pooled != s.pool.end() && pooled->pid == pid) {
+			p = *pooled++;
+			fresh = false;
+		} else {
+			s.open(p);
+		}
+
+		bool ok = s.read(p, out[count]);
+		if (!ok && !fresh) {
+			// The files of a process that exited fail even if its PID was
+			// taken again, so open the new process and try once more.
+			close_fd(p.stat_fd);
+			close_fd(p.io_fd);
+			s.open(p);
+			ok = s.read(p, out[count]);
+		}
+		if (ok) {
+			++count;
+		}
+
+		if (ok && s.next_pool.size() < s.max_pooled) {
+			s.next_pool.push_back(p);
+		} else {
+			close_fd(p.stat_fd);
+			close_fd(p.io_fd);
+		}
+	}
+	for (; pooled != s.pool.end(); ++pooled) {
+		close_fd(pooled->stat_fd);
+		close_fd(pooled->io_fd);
+	}
+
+	out.resize(count);
+	s.pool.swap(s.next_pool);
+	return true;
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,222 @@
+#include "process_scanner.hpp"
+
+#include "log.hpp"
+
+#include <Windows.h>
+#include <Psapi.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+namespace os {
+
+/**
+ * Most process handles kept open between scans.
+ */
+static const size_t max_pooled = 4096;
+
+static unsigned long long to_ull(const FILETIME& time) noexcept {
+	return (static_cast<unsigned long long>(time.dwHighDateTime) << 32) |
+		time.dwLowDateTime;
+}
+
+struct process_scanner::impl final {
+	/**
+	 * Handle of a process kept open between scans, with what never changes
+	 * during its life.
+	 */
+	struct open_process final {
+		DWORD pid;
+		/**
+		 * NULL when the process could not be opened, e.g. protected or
+		 * system processes; not retried while its PID stays in use.
+		 */
+		HANDLE handle;
+		unsigned long long start_time;
+		char name[sizeof(process_counters::name)];
+	};
+
+	impl() : pids(1024) {
+	}
+	~impl() {
+		for (auto& p : pool) {
+			close(p);
+		}
+	}
+
+	bool list_pids() noexcept;
+	void open(open_process& p) noexcept;
+	bool read(const open_process& p, process_counters& counters) noexcept;
+
+	static void close(open_process& p) noexcept {
+		if (p.handle) {
+			CloseHandle(p.handle);
+			p.handle = NULL;
+		}
+	}
+	static bool exited(const open_process& p) noexcept {
+		return p.handle && WaitForSingleObject(p.handle, 0) == WAIT_OBJECT_0;
+	}
+
+	vector<DWORD> pids;
+	size_t pid_count = 0;
+	/**
+	 * Sorted by PID; rebuilt into next_pool on every scan.
+	 */
+	vector<open_process> pool;
+	vector<open_process> next_pool;
+};
+
+bool process_scanner::impl::list_pids() noexcept {
+	for (;;) {
+		DWORD needed = 0;
+		if (!EnumProcesses(pids.data(),
+						   static_cast<DWORD>(pids.size() * sizeof(DWORD)),
+						   &needed)) {
+			LOG(error) << "Failed to enumerate processes, code: "
+					   << GetLastError();
+			return false;
+		}
+		if (needed < pids.size() * sizeof(DWORD)) {
+			pid_count = needed / sizeof(DWORD);
+			break;
+		}
+		// A full buffer may have been truncated
+		try {
+			pids.resize(pids.size() * 2);
+		} catch (const std::exception& e) {
+			LOG(error) << "Failed to enumerate processes: " << e.what();
+			return false;
+		}
+	}
+	sort(pids.begin(), pids.begin() + pid_count);
+	return true;
+}
+
+void process_scanner::impl::open(open_process& p) noexcept {
+	p.handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, p.pid);
+	p.start_time = 0;
+	p.name[0] = '\0';
+	if (!p.handle) {
+		return;
+	}
+
+	FILETIME creation, end, kernel, user;
+	if (GetProcessTimes(p.handle, &creation, &end, &kernel, &user)) {
+		p.start_time = to_ull(creation);
+	}
+	char path[MAX_PATH];
+	DWORD size = MAX_PATH;
+	if (QueryFullProcessImageNameA(p.handle, 0, path, &size)) {
+		const char* slash = strrchr(path, '\\');
+		const char* name = slash ? slash + 1 : path;
+		strncpy_s(p.name, sizeof(p.name), name, _TRUNCATE);
+	}
+}
+
+bool process_scanner::impl::read(const open_process& p,
+								 process_counters& counters) noexcept {
+	if (!p.handle) {
+		return false;
+	}
+	FILETIME creation, end, kernel, user;
+	if (!GetProcessTimes(p.handle, &creation, &end, &kernel, &user)) {
+		return false;
+	}
+	counters.pid = p.pid;
+	counters.start_time = p.start_time;
+	// FILETIME counts 100 ns intervals
+	counters.cpu_time = (to_ull(kernel) + to_ull(user)) * 100;
+
+	PROCESS_MEMORY_COUNTERS memory;
+	counters.resident_bytes =
+		GetProcessMemoryInfo(p.handle, &memory, sizeof(memory)) ?
+		memory.WorkingSetSize : 0;
+
+	// Transfer counts include network and device IO besides files
+	IO_COUNTERS io;
+	if (GetProcessIoCounters(p.handle, &io)) {
+		counters.read_bytes = io.ReadTransferCount;
+		counters.write_bytes = io.WriteTransferCount;
+	} else {
+		counters.read_bytes = 0;
+		counters.write_bytes = 0;
+	}
+	memcpy(counters.name, p.name, sizeof(counters.name));
+	return true;
+}
+
+process_scanner::process_scanner() :
+	pimpl_(new impl()) {
+}
+
+process_scanner::~process_scanner() {
+}
+
+bool process_scanner::scan(vector<process_counters>& out) noexcept {
+	impl& s = *pimpl_;
+	if (!s.list_pids()) {
+		return false;
+	}
+
+	try {
+		out.resize(s.pid_count);
+		s.next_pool.reserve(min(s.pid_count, max_pooled));
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to scan processes: " << e.what();
+		return false;
+	}
+	s.next_pool.clear();
+
+	size_t count = 0;
+	auto pooled = s.pool.begin();
+	for (size_t i = 0; i < s.pid_count; ++i) {
+		const DWORD pid = s.pids[i];
+		// Processes that exited since the previous scan
+		for (; pooled != s.pool.end() && pooled->pid < pid; ++pooled) {
+			impl::close(*pooled);
+		}
+
+		impl::open_process p;
+		if (pooled != s.pool.end() && pooled->pid == pid) {
+			p = *pooled++;
+			if (impl::exited(p)) {
+				// Listed only because the pooled handle keeps it alive;
+				// closing it frees the PID.
+				impl::close(p);
+				continue;
+			}
+		} else {
+			p.pid = pid;
+			s.open(p);
+		}
+
+		if (s.read(p, out[count])) {
+			++count;
+		}
+		if (s.next_pool.size() < max_pooled) {
+			s.next_pool.push_back(p);
+		} else {
+			impl::close(p);
+		}
+	}
+	for (; pooled != s.pool.end(); ++pooled) {
+		impl::close(*pooled);
+	}
+
+	out.resize(count);
+	s.pool.swap(s.next_pool);
+	return true;
+}
+
+} //namespace os
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,178 @@
+#include <process_table.hpp>
+
+#include <log.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+static size_t checked_top_count(size_t top_count) {
+	if (top_count == 0) {
+		throw invalid_argument("process_table top_count cannot be zero");
+	}
+	return top_count;
+}
+
+static unsigned detected_cpus(unsigned cpus) noexcept {
+	if (cpus == 0) {
+		cpus = thread::hardware_concurrency();
+	}
+	return cpus == 0 ? 1 : cpus;
+}
+
+static void write_list(json_writer& writer, const char* name,
+					   const vector<process_usage>& processes) {
+	writer.key(name);
+	writer.begin_array();
+	for (const process_usage& p : processes) {
+		writer.begin_object();
+		writer.key("pid");
+		writer.value(p.pid);
+		writer.key("name");
+		writer.value(p.name);
+		writer.key("cpu_percent");
+		writer.value(p.cpu_percent);
+		writer.key("resident_bytes");
+		writer.value(p.resident_bytes);
+		writer.key("read_bytes_per_second");
+		writer.value(p.read_bytes_per_second);
+		writer.key("write_bytes_per_second");
+		writer.value(p.write_bytes_per_second);
+		writer.end_object();
+	}
+	writer.end_array();
+}
+
+void process_top::write(json_writer& writer) const {
+	writer.begin_object();
+	writer.key("processes");
+	writer.value(static_cast<unsigned long long>(processes));
+	write_list(writer, "cpu", cpu);
+	write_list(writer, "memory", memory);
+	write_list(writer, "io", io);
+	writer.end_object();
+}
+
+process_table::process_table(size_t top_count, unsigned cpus) :
+	top_count_(checked_top_count(top_count)),
+	cpus_(detected_cpus(cpus)) {
+}
+
+process_table::~process_table() {
+}
+
+bool process_table::sample(process_top& top) noexcept {
+	if (!scanner_.scan(scan_)) {
+		return false;
+	}
+	const auto now = chrono::steady_clock::now();
+	const chrono::nanoseconds elapsed = previous_.empty() ?
+		chrono::nanoseconds::zero() : now - last_scan_;
+	last_scan_ = now;
+	update(scan_, elapsed, top);
+	return true;
+}
+
+void process_table::update(const vector<os::process_counters>& scan,
+						   chrono::nanoseconds elapsed,
+						   process_top& top) noexcept {
+	try {
+		usage_.resize(scan.size());
+		order_.reserve(scan.size());
+		previous_.reserve(scan.size());
+		top.cpu.reserve(top_count_);
+		top.memory.reserve(top_count_);
+		top.io.reserve(top_count_);
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to update process table: " << e.what();
+		return;
+	}
+
+	const double seconds = chrono::duration<double>(elapsed).count();
+	const double cpu_seconds = seconds * cpus_;
+	auto old = previous_.cbegin();
+	for (size_t i = 0; i < scan.size(); ++i) {
+		const os::process_counters& current = scan[i];
+		process_usage& usage = usage_[i];
+		usage.pid = current.pid;
+		memcpy(usage.name, current.name, sizeof(usage.name));
+		usage.resident_bytes = current.resident_bytes;
+		usage.cpu_percent = 0;
+		usage.read_bytes_per_second = 0;
+		usage.write_bytes_per_second = 0;
+
+		// Both lists are sorted by PID, so the match is a merge step
+		while (old != previous_.cend() && old->pid < current.pid) {
+			++old;
+		}
+		if (seconds <= 0 || old == previous_.cend() ||
+			old->pid != current.pid || old->start_time != current.start_time) {
+			continue;
+		}
+		if (current.cpu_time >= old->cpu_time) {
+			const double busy = (current.cpu_time - old->cpu_time) / 1e9;
+			usage.cpu_percent =
+				static_cast<float>(min(100.0, 100 * busy / cpu_seconds));
+		}
+		if (current.read_bytes >= old->read_bytes) {
+			usage.read_bytes_per_second =
+				(current.read_bytes - old->read_bytes) / seconds;
+		}
+		if (current.write_bytes >= old->write_bytes) {
+			usage.write_bytes_per_second =
+				(current.write_bytes - old->write_bytes) / seconds;
+		}
+	}
+	previous_.assign(scan.begin(), scan.end());
+
+	top.processes = scan.size();
+	select([](const process_usage& p) {
+		return static_cast<double>(p.cpu_percent);
+	}, top.cpu);
+	select([](const process_usage& p) {
+		return static_cast<double>(p.resident_bytes);
+	}, top.memory);
+	select([](const process_usage& p) {
+		return p.read_bytes_per_second + p.write_bytes_per_second;
+	}, top.io);
+}
+
+template <typename Key>
+void process_table::select(Key key, vector<process_usage>& out) noexcept {
+	// Storage was reserved by update(), none of this allocates
+	order_.clear();
+	for (size_t i = 0; i < usage_.size(); ++i) {
+		if (key(usage_[i]) > 0) {
+			order_.push_back(i);
+		}
+	}
+	const auto heavier = [&](size_t a, size_t b) {
+		const double ka = key(usage_[a]);
+		const double kb = key(usage_[b]);
+		return ka > kb || (ka == kb && usage_[a].pid < usage_[b].pid);
+	};
+	const size_t count = min(top_count_, order_.size());
+	if (count < order_.size()) {
+		nth_element(order_.begin(), order_.begin() + count, order_.end(),
+					heavier);
+	}
+	sort(order_.begin(), order_.begin() + count, heavier);
+
+	out.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		out[i] = usage_[order_[i]];
+	}
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <json_writer.hpp>
+#include <process_scanner.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Resource use of one process between two scans.
+ */
+struct process_usage final {
+	unsigned pid = 0;
+	char name[sizeof(os::process_counters::name)] = {};
+	/**
+	 * Share of the whole machine's CPU time (0 to 100), like cpu_percent.
+	 */
+	float cpu_percent = 0;
+	unsigned long long resident_bytes = 0;
+	double read_bytes_per_second = 0;
+	double write_bytes_per_second = 0;
+};
+
+/**
+ * The heaviest processes by each resource, heaviest first. Processes
+ * using none of a resource are left out of its list.
+ */
+struct process_top final {
+	/**
+	 * Processes scanned.
+	 */
+	std::size_t processes = 0;
+	std::vector<process_usage> cpu;
+	std::vector<process_usage> memory;
+	/**
+	 * By bytes read and written per second.
+	 */
+	std::vector<process_usage> io;
+
+	/**
+	 * Writes {"processes":n,"cpu":[{"pid":..,"name":"..","cpu_percent":..,
+	 * "resident_bytes":..,"read_bytes_per_second":..,
+	 * "write_bytes_per_second":..},...],"memory":[...],"io":[...]}.
+	 */
+	void write(json_writer& writer) const;
+};
+
+/**
+ * Table of the running processes, keyed by PID and start time so a reused
+ * PID starts a new entry, turning the cumulative counters of consecutive
+ * scans into per process CPU, memory and IO use.
+ * Every buffer is reused between scans, so once the table reached its
+ * working size a scan allocates nothing, and the top processes are chosen
+ * by partial selection, O(n) per resource, rather than a sort.
+ * Not thread safe.
+ */
+class process_table final : public boost::noncopyable {
+public:
+	/**
+	 * Throws std::invalid_argument if top_count is zero and
+	 * std::exception derived exceptions if the OS cannot be queried.
+	 * @param top_count processes reported per resource.
+	 * @param cpus CPUs of the machine, 0 for the number detected.
+	 */
+	explicit process_table(std::size_t top_count, unsigned cpus = 0);
+	~process_table();
+
+	/**
+	 * Scans the running processes and fills top with their use since the
+	 * previous scan. Processes seen for the first time count no CPU or IO.
+	 * @return false if processes could not be enumerated.
+	 */
+	bool sample(process_top& top) noexcept;
+	/**
+	 * Same as sample() from counters scanned elapsed after the previous
+	 * ones, sorted by PID as os::process_scanner returns them.
+	 */
+	void update(const std::vector<os::process_counters>& scan,
+				std::chrono::nanoseconds elapsed, process_top& top) noexcept;
+
+	/**
+	 * Processes in the table.
+	 */
+	std::size_t size() const noexcept {
+		return previous_.size();
+	}
+
+private:
+	/**
+	 * Copies to out the top_count_ processes with the highest key(usage),
+	 * leaving out those where it is zero.
+	 */
+	template <typename Key>
+	void select(Key key, std::vector<process_usage>& out) noexcept;
+
+	const std::size_t top_count_;
+	const unsigned cpus_;
+	os::process_scanner scanner_;
+	std::vector<os::process_counters> scan_;
+	std::vector<os::process_counters> previous_;
+	std::vector<process_usage> usage_;
+	std::vector<std::size_t> order_;
+	std::chrono::steady_clock::time_point last_scan_;
+}; //class process_table
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
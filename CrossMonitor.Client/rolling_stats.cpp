@@ -0,0 +1,75 @@
+#include <rolling_stats.hpp>
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+rolling_stats::rolling_stats(const vector<size_t>& lengths) :
+	lengths_(lengths) {
+	if (lengths_.empty()) {
+		throw invalid_argument("rolling_stats needs at least one window");
+	}
+	stats_.reserve(lengths_.size() * data_fields::size);
+	for (size_t length : lengths_) {
+		for (size_t i = 0; i < data_fields::size; ++i) {
+			stats_.emplace_back(length);
+		}
+	}
+}
+
+void rolling_stats::push(const data& sample) noexcept {
+	for (size_t window = 0; window < lengths_.size(); ++window) {
+		utils::rolling_window* stats = &stats_[window * data_fields::size];
+		for_each_field(data_fields{}, [&](auto field) {
+			typedef decltype(field) F;
+			stats[field_index<F, data_fields>::value].push(
+				static_cast<double>(F::get(sample)));
+		});
+	}
+}
+
+void rolling_stats::clear() noexcept {
+	for (utils::rolling_window& stats : stats_) {
+		stats.clear();
+	}
+}
+
+void rolling_stats::write(json_writer& writer) const {
+	writer.begin_object();
+	writer.key("windows");
+	writer.begin_array();
+	for (size_t window = 0; window < lengths_.size(); ++window) {
+		writer.begin_object();
+		writer.key("length");
+		writer.value(static_cast<unsigned long long>(lengths_[window]));
+		writer.key("samples");
+		writer.value(static_cast<unsigned long long>(
+			stats_[window * data_fields::size].size()));
+		for_each_field(data_fields{}, [&](auto field) {
+			typedef decltype(field) F;
+			const utils::rolling_window& s = this->template get<F>(window);
+			writer.key(F::name());
+			writer.begin_object();
+			writer.key("max");
+			writer.value(s.max());
+			writer.key("mean");
+			writer.value(s.mean());
+			writer.key("min");
+			writer.value(s.min());
+			writer.key("variance");
+			writer.value(s.variance());
+			writer.end_object();
+		});
+		writer.end_object();
+	}
+	writer.end_array();
+	writer.end_object();
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
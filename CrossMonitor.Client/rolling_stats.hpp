@@ -0,0 +1,59 @@
+#pragma once
+
+#include <data.hpp>
+#include <data_fields.hpp>
+#include <json_writer.hpp>
+#include <rolling_window.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Rolling mean, variance, min and max of every data field over one or
+ * more windows, each counted in samples. Updating costs O(1) per field and
+ * window and never allocates.
+ * Owned by the thread that pushes the samples; it needs no locking.
+ */
+class rolling_stats final : public boost::noncopyable {
+public:
+	/**
+	 * Throws std::invalid_argument if lengths is empty or holds a zero.
+	 * @param lengths samples in each window.
+	 */
+	explicit rolling_stats(const std::vector<std::size_t>& lengths);
+
+	void push(const data& sample) noexcept;
+	void clear() noexcept;
+
+	std::size_t windows() const noexcept {
+		return lengths_.size();
+	}
+	/**
+	 * Statistics of Field over the given window.
+	 */
+	template <typename Field>
+	const utils::rolling_window& get(std::size_t window) const noexcept {
+		return stats_[window * data_fields::size +
+					  field_index<Field, data_fields>::value];
+	}
+
+	/**
+	 * Writes {"windows":[{"length":n,"samples":n,"cpu_percent":{"max":..,
+	 * "mean":..,"min":..,"variance":..},...},...]}.
+	 */
+	void write(json_writer& writer) const;
+
+private:
+	const std::vector<std::size_t> lengths_;
+	std::vector<utils::rolling_window> stats_;
+}; //class rolling_stats
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,61 @@
+#include <sample_buffer.hpp>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+sample_buffer::sample_buffer(size_t capacity) : samples_(capacity) {
+}
+
+void sample_buffer::push(const data& sample) noexcept {
+	// Capacity is reserved upfront, so this never reallocates.
+	samples_.push(sample);
+}
+
+void sample_buffer::summarize(data_summary& summary) const noexcept {
+	const size_t count = samples_.size();
+	summary.set_samples(count);
+	if (count == 0) {
+		return;
+	}
+
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		field_summary<F>& s = summary.template get<F>();
+
+		typename F::type value = F::get(samples_[0]);
+		s.min = value;
+		s.max = value;
+		double sum = static_cast<double>(value);
+		for (size_t i = 1; i < count; ++i) {
+			value = F::get(samples_[i]);
+			if (value < s.min) {
+				s.min = value;
+			}
+			if (value > s.max) {
+				s.max = value;
+			}
+			sum += static_cast<double>(value);
+		}
+		s.mean = sum / count;
+		s.last = F::get(samples_.back());
+	});
+}
+
+void sample_buffer::clear() noexcept {
+	samples_.clear();
+}
+
+size_t sample_buffer::size() const noexcept {
+	return samples_.size();
+}
+
+bool sample_buffer::empty() const noexcept {
+	return samples_.empty();
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
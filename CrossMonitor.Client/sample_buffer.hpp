@@ -0,0 +1,91 @@
+#pragma once
+
+#include <data.hpp>
+#include <data_fields.hpp>
+#include <ring_buffer.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <tuple>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Downsampled view of one field over a report period.
+ */
+template <typename Field>
+struct field_summary final {
+	typename Field::type min{};
+	typename Field::type max{};
+	typename Field::type last{};
+	double mean = 0;
+};
+
+/**
+ * Min/max/mean/last of every data field over a report period.
+ */
+class data_summary final {
+public:
+	template <typename Field>
+	const field_summary<Field>& get() const noexcept {
+		return std::get<field_summary<Field>>(fields_);
+	}
+	template <typename Field>
+	field_summary<Field>& get() noexcept {
+		return std::get<field_summary<Field>>(fields_);
+	}
+
+	/**
+	 * Number of samples summarized.
+	 */
+	std::size_t samples() const noexcept {
+		return samples_;
+	}
+	void set_samples(std::size_t samples) noexcept {
+		samples_ = samples;
+	}
+
+private:
+	tuple_of<field_summary, data_fields>::type fields_;
+	std::size_t samples_ = 0;
+};
+
+/**
+ * Preallocated storage for the samples taken during one report period
+ * when sampling faster than reporting.
+ */
+class sample_buffer final : public boost::noncopyable {
+public:
+	/**
+	 * Throws std::invalid_argument if capacity is zero.
+	 * @param capacity samples per report period.
+	 */
+	explicit sample_buffer(std::size_t capacity);
+
+	/**
+	 * Stores a sample, overwriting the oldest one when full. Never allocates.
+	 */
+	void push(const data& sample) noexcept;
+	/**
+	 * Computes the summary of the stored samples. Leaves summary
+	 * untouched except for its sample count if the buffer is empty.
+	 */
+	void summarize(data_summary& summary) const noexcept;
+	/**
+	 * Drops stored samples, keeping the storage.
+	 */
+	void clear() noexcept;
+
+	std::size_t size() const noexcept;
+	bool empty() const noexcept;
+
+private:
+	utils::ring_buffer<data> samples_;
+}; //class sample_buffer
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,104 @@
+#include "self_metrics.hpp"
+#include "probe_runner.hpp"
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+static void write_latency(json_writer& writer, const char* name,
+						  const utils::latency_histogram& h) {
+	writer.key(name);
+	writer.begin_object();
+	writer.key("count");
+	writer.value(h.count());
+	writer.key("mean");
+	writer.value(h.mean() / 1000);
+	writer.key("p50");
+	writer.value(h.quantile(0.5) / 1000.0);
+	writer.key("p99");
+	writer.value(h.quantile(0.99) / 1000.0);
+	writer.key("max");
+	writer.value(h.max() / 1000.0);
+	writer.end_object();
+}
+
+self_metrics::self_metrics() :
+	wakeups_(0),
+	since_(chrono::steady_clock::now()) {
+	for (auto& n : stale_) {
+		n = 0;
+	}
+	monitor::os::read_self_usage(previous_);
+}
+
+void self_metrics::record_probes(const os::snapshot& s) noexcept {
+	cpu_.record(s.cpu_ns);
+	memory_.record(s.memory_ns);
+	process_count_.record(s.process_count_ns);
+	disk_.record(s.disk_ns);
+	for (size_t i = 0; i < os::probe_count; ++i) {
+		if ((s.stale & (1u << i)) != 0) {
+			stale_[i].fetch_add(1, memory_order_relaxed);
+		}
+	}
+}
+
+void self_metrics::write(json_writer& writer, utils::latency_histogram* send) {
+	const auto now = chrono::steady_clock::now();
+	const double seconds = chrono::duration<double>(now - since_).count();
+	monitor::os::self_usage usage;
+	monitor::os::read_self_usage(usage);
+	const unsigned long long wakeups = wakeups_.exchange(0, memory_order_relaxed);
+
+	writer.begin_object();
+	writer.key("agent");
+	writer.begin_object();
+	writer.key("cpu_percent");
+	writer.value(seconds > 0 && usage.cpu_time >= previous_.cpu_time ?
+		(usage.cpu_time - previous_.cpu_time) / (seconds * 1e7) : 0.0);
+	writer.key("resident_bytes");
+	writer.value(usage.resident_bytes);
+	writer.key("handles");
+	writer.value(usage.handles);
+	writer.key("wakeups_per_second");
+	writer.value(seconds > 0 ? wakeups / seconds : 0.0);
+	writer.end_object();
+
+	writer.key("latency_us");
+	writer.begin_object();
+	write_latency(writer, "cpu", cpu_);
+	write_latency(writer, "memory", memory_);
+	write_latency(writer, "process_count", process_count_);
+	write_latency(writer, "disk", disk_);
+	write_latency(writer, "serialize", serialize_);
+	if (send) {
+		write_latency(writer, "send", *send);
+	}
+	writer.end_object();
+
+	writer.key("stale");
+	writer.begin_object();
+	for (size_t i = 0; i < os::probe_count; ++i) {
+		writer.key(probe_name(static_cast<os::probe>(i)));
+		writer.value(stale_[i].exchange(0, memory_order_relaxed));
+	}
+	writer.end_object();
+	writer.end_object();
+
+	cpu_.reset();
+	memory_.reset();
+	process_count_.reset();
+	disk_.reset();
+	serialize_.reset();
+	if (send) {
+		send->reset();
+	}
+	previous_ = usage;
+	since_ = now;
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
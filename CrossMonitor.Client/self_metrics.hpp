@@ -0,0 +1,74 @@
+#pragma once
+
+#include <json_writer.hpp>
+#include <latency_histogram.hpp>
+#include <os.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <chrono>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * What the agent itself costs: the latency of every probe of a sample,
+ * of serialization and of sending, its own CPU time, memory and handles,
+ * and how often its threads wake up. Latencies go to latency histograms,
+ * so recording them is a few atomic additions and may be done from any
+ * thread.
+ */
+class self_metrics final : public boost::noncopyable {
+public:
+	self_metrics();
+
+	/**
+	 * Records the time taken by each probe of s and counts the stale ones.
+	 */
+	void record_probes(const os::snapshot& s) noexcept;
+	/**
+	 * Records the time taken to serialize a report line.
+	 */
+	void record_serialize(unsigned long long ns) noexcept {
+		serialize_.record(ns);
+	}
+	/**
+	 * Counts a wakeup of one of the agent's threads.
+	 */
+	void wakeup() noexcept {
+		wakeups_.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Writes the record of the period since the previous call, or since
+	 * construction, and starts a new period, resetting the histograms,
+	 * send included:
+	 * {"agent":{"cpu_percent":..,"resident_bytes":..,"handles":..,
+	 * "wakeups_per_second":..},"latency_us":{"cpu":{"count":..,"mean":..,
+	 * "p50":..,"p99":..,"max":..},"memory":{..},"process_count":{..},
+	 * "disk":{..},"serialize":{..},"send":{..}},"stale":{"cpu":..,
+	 * "memory":..,"process_count":..,"disk":..}}
+	 * cpu_percent is the share of one CPU. Latencies are in microseconds;
+	 * send is left out when null. stale counts the samples in which each
+	 * probe missed its deadline.
+	 */
+	void write(json_writer& writer, utils::latency_histogram* send);
+
+private:
+	utils::latency_histogram cpu_;
+	utils::latency_histogram memory_;
+	utils::latency_histogram process_count_;
+	utils::latency_histogram disk_;
+	utils::latency_histogram serialize_;
+	std::atomic<unsigned long long> wakeups_;
+	std::atomic<unsigned long long> stale_[os::probe_count];
+
+	monitor::os::self_usage previous_;
+	std::chrono::steady_clock::time_point since_;
+}; //class self_metrics
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
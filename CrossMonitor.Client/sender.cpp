@@ -0,0 +1,391 @@
+#include <sender.hpp>
+#include <spool.hpp>
+
+#include <gzip.hpp>
+#include <json_writer.hpp>
+#include <latency_histogram.hpp>
+#include <log.hpp>
+#include <utils.hpp>
+#include <wire_format.hpp>
+
+#include <cpprest/http_client.h>
+#include <cpprest/asyncrt_utils.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+using namespace web;
+using namespace web::http;
+using namespace web::http::client;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+enum class send_result {
+	sent,
+	retry,
+	rejected
+};
+
+static uri checked_uri(const string& url) {
+	try {
+		uri result(utility::conversions::to_string_t(url));
+		if (result.scheme() != U("http") && result.scheme() != U("https")) {
+			throw invalid_argument("Unsupported URL scheme: " + url);
+		}
+		return result;
+	} catch (const uri_exception& e) {
+		throw invalid_argument(string("Invalid URL: ") + e.what());
+	}
+}
+
+static uri base_uri(const uri& url) {
+	uri_builder builder;
+	builder.set_scheme(url.scheme());
+	builder.set_user_info(url.user_info());
+	builder.set_host(url.host());
+	builder.set_port(url.port());
+	return builder.to_uri();
+}
+
+static const sender_options& checked_options(const sender_options& options) {
+	if (options.batch_size == 0 ||
+		options.batch_delay <= chrono::milliseconds::zero() ||
+		options.max_attempts == 0 ||
+		options.min_backoff <= chrono::milliseconds::zero() ||
+		options.max_backoff < options.min_backoff ||
+		options.timeout <= chrono::seconds::zero()) {
+		throw invalid_argument("Invalid sender options");
+	}
+	return options;
+}
+
+static http_client_config client_config(const sender_options& options) {
+	http_client_config config;
+	config.set_timeout(utility::seconds(options.timeout.count()));
+	return config;
+}
+
+struct sender::impl final {
+	impl(const sender_options& options, const sent_callback& on_sent) :
+		options(checked_options(options)),
+		on_sent(on_sent),
+		url(checked_uri(options.url)),
+		// A single client reuses its connection between requests.
+		client(base_uri(url), client_config(options)),
+		resource(url.resource().to_string()),
+		encoder(options.delta),
+		random(random_device{}()) {
+		batch.reserve(options.batch_size);
+		if (!options.spool_path.empty()) {
+			spooled.reset(new client::spool(
+				options.spool_path, options.spool_capacity));
+			replayed.reserve(options.batch_size);
+		}
+	}
+
+	send_result post();
+	/**
+	 * Writes records to out, a json_writer or a binary_writer, as delta
+	 * frames when delta reporting is on.
+	 */
+	template <typename Writer>
+	void write_records(Writer& out, const vector<record>& records) {
+		if (options.delta.keyframe_every == 1) {
+			for (const record& r : records) {
+				out.write(r);
+			}
+			return;
+		}
+		// Every request starts with a keyframe, so the server can rebuild
+		// a batch whatever happened to the previous ones.
+		encoder.reset();
+		for (const record& r : records) {
+			encoder.encode(r, frame);
+			out.write(frame);
+		}
+	}
+	void encode(const vector<record>& records);
+	send_result deliver(const vector<record>& records, unsigned max_attempts);
+	bool send_batch();
+	void replay();
+	bool wait_backoff(unsigned retry);
+
+	const sender_options options;
+	const sent_callback on_sent;
+	const uri url;
+	http_client client;
+	const utility::string_t resource;
+	delta_encoder encoder;
+	delta_frame frame;
+
+	vector<record> batch;
+	chrono::steady_clock::time_point batch_start;
+	json_writer writer;
+	binary_writer binary;
+	/**
+	 * Size of the encoded batch, before compression.
+	 */
+	size_t encoded_size = 0;
+	vector<unsigned char> body;
+	minstd_rand random;
+
+	unique_ptr<client::spool> spooled;
+	vector<record> replayed;
+
+	mutable mutex m;
+	condition_variable cv;
+	bool stopped = false;
+	sender_stats stats;
+	utils::latency_histogram request_latency;
+};
+
+send_result sender::impl::post() {
+	http_request request(methods::POST);
+	request.set_request_uri(resource);
+	request.set_body(body);
+	request.headers().set_content_type(options.binary ?
+		utility::conversions::to_string_t(wire_content_type) : U("application/json"));
+	if (options.compress) {
+		request.headers().add(U("Content-Encoding"), U("gzip"));
+	}
+	if (!options.key.empty()) {
+		request.headers().add(U("X-Api-Key"),
+			utility::conversions::to_string_t(options.key));
+	}
+
+	utils::stopwatch watch;
+	try {
+		const http_response response = client.request(request).get();
+		request_latency.record(watch.lap());
+		const status_code status = response.status_code();
+		if (status >= 200 && status < 300) {
+			return send_result::sent;
+		}
+		LOG(warning) << "Server answered " << status << " to a batch of "
+					 << batch.size() << " records";
+		return status == 429 || status >= 500 ?
+			send_result::retry : send_result::rejected;
+	} catch (const std::exception& e) {
+		request_latency.record(watch.lap());
+		LOG(warning) << "Failed to send batch to " << options.url << ": "
+					 << e.what();
+		return send_result::retry;
+	}
+}
+
+bool sender::impl::wait_backoff(unsigned retry) {
+	chrono::milliseconds backoff = options.min_backoff;
+	for (unsigned i = 1; i < retry && backoff < options.max_backoff; ++i) {
+		backoff *= 2;
+	}
+	backoff = min(backoff, options.max_backoff);
+	// Jitter keeps agents that failed together from retrying in lockstep.
+	uniform_int_distribution<long long> jitter(
+		backoff.count() / 2, backoff.count());
+	const chrono::milliseconds wait(jitter(random));
+
+	unique_lock<mutex> l(m);
+	return !cv.wait_for(l, wait, [this] { return stopped; });
+}
+
+void sender::impl::encode(const vector<record>& records) {
+	const char* encoded;
+	if (options.binary) {
+		binary.begin(wire_kind::batch);
+		write_records(binary, records);
+		encoded = reinterpret_cast<const char*>(binary.bytes().data());
+		encoded_size = binary.size();
+	} else {
+		writer.clear();
+		writer.begin_array();
+		write_records(writer, records);
+		writer.end_array();
+		encoded = writer.c_str();
+		encoded_size = writer.size();
+	}
+
+	if (options.compress) {
+		utils::gzip_compress(encoded, encoded_size, body);
+	} else {
+		body.assign(encoded, encoded + encoded_size);
+	}
+}
+
+send_result sender::impl::deliver(const vector<record>& records,
+								  unsigned max_attempts) {
+	try {
+		encode(records);
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to compress batch: " << e.what();
+		return send_result::rejected;
+	}
+
+	for (unsigned attempt = 1; ; ++attempt) {
+		const send_result result = post();
+		{
+			lock_guard<mutex> l(m);
+			++stats.requests;
+			stats.bytes_sent += body.size();
+			if (result == send_result::sent) {
+				stats.records_sent += records.size();
+				stats.encoded_bytes += encoded_size;
+			} else {
+				++stats.failed_requests;
+			}
+		}
+
+		if (result == send_result::sent) {
+			LOG(debug) << "Sent " << records.size() << " records in "
+					   << body.size() << " bytes to " << options.url;
+			if (on_sent) {
+				for (const record& r : records) {
+					on_sent(r);
+				}
+			}
+			return result;
+		}
+		if (result == send_result::rejected || attempt >= max_attempts ||
+			!wait_backoff(attempt)) {
+			return result;
+		}
+	}
+}
+
+void sender::impl::replay() {
+	// Bounded, so catching up after a long outage does not stall the
+	// caller; the rest goes with the next batches.
+	for (unsigned i = 0; i < 16 && !spooled->empty(); ++i) {
+		replayed.clear();
+		const size_t slots = spooled->peek(replayed, options.batch_size);
+		const send_result result = replayed.empty() ?
+			send_result::sent : deliver(replayed, 1);
+		if (result == send_result::retry) {
+			return;
+		}
+
+		spooled->pop(slots);
+		lock_guard<mutex> l(m);
+		if (result == send_result::sent) {
+			stats.records_replayed += replayed.size();
+		} else {
+			LOG(error) << "Dropping batch of " << replayed.size()
+					   << " spooled records";
+			stats.records_dropped += replayed.size();
+		}
+	}
+	if (spooled->empty()) {
+		spooled->sync();
+	}
+}
+
+bool sender::impl::send_batch() {
+	const size_t count = batch.size();
+	utils::scope_exit clear_batch([this] { batch.clear(); });
+
+	if (spooled && !spooled->empty()) {
+		// Queue behind the spooled records to keep the order.
+		for (const record& r : batch) {
+			spooled->push(r);
+		}
+		{
+			lock_guard<mutex> l(m);
+			stats.records_spooled += count;
+		}
+		replay();
+		return true;
+	}
+
+	const send_result result = deliver(batch, options.max_attempts);
+	if (result == send_result::sent) {
+		return true;
+	}
+	if (result == send_result::retry && spooled) {
+		LOG(warning) << "Spooling batch of " << count << " records";
+		for (const record& r : batch) {
+			spooled->push(r);
+		}
+		spooled->sync();
+		lock_guard<mutex> l(m);
+		stats.records_spooled += count;
+		return true;
+	}
+
+	LOG(error) << "Dropping batch of " << count << " records";
+	lock_guard<mutex> l(m);
+	stats.records_dropped += count;
+	return false;
+}
+
+sender::sender(const sender_options& options, const sent_callback& on_sent) :
+	pimpl_(new impl(options, on_sent)) {
+}
+
+sender::~sender() {
+	stop();
+	try {
+		flush();
+	} catch (const std::exception& e) {
+		LOG(error) << "Failed to flush records: " << e.what();
+	}
+}
+
+bool sender::add(const record& r) {
+	const auto now = chrono::steady_clock::now();
+	if (pimpl_->batch.empty()) {
+		pimpl_->batch_start = now;
+	}
+	pimpl_->batch.push_back(r);
+
+	if (pimpl_->batch.size() >= pimpl_->options.batch_size) {
+		return pimpl_->send_batch();
+	}
+	return send_due();
+}
+
+bool sender::send_due() {
+	if (!pimpl_->batch.empty() && chrono::steady_clock::now() -
+		pimpl_->batch_start >= pimpl_->options.batch_delay) {
+		return pimpl_->send_batch();
+	}
+	return true;
+}
+
+bool sender::flush() {
+	if (pimpl_->batch.empty()) {
+		if (pimpl_->spooled && !pimpl_->spooled->empty()) {
+			pimpl_->replay();
+		}
+		return true;
+	}
+	return pimpl_->send_batch();
+}
+
+void sender::stop() noexcept {
+	{
+		lock_guard<mutex> l(pimpl_->m);
+		pimpl_->stopped = true;
+	}
+	pimpl_->cv.notify_all();
+}
+
+sender_stats sender::stats() const noexcept {
+	lock_guard<mutex> l(pimpl_->m);
+	return pimpl_->stats;
+}
+
+utils::latency_histogram& sender::request_latency() noexcept {
+	return pimpl_->request_latency;
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
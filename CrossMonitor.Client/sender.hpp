@@ -0,0 +1,174 @@
+#pragma once
+
+#include <delta_frame.hpp>
+#include <latency_histogram.hpp>
+#include <record.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Settings of a sender.
+ */
+struct sender_options final {
+	/**
+	 * Full URL the batches are POSTed to, e.g. http://host:8080/ingest.
+	 */
+	std::string url;
+	/**
+	 * Sent as the X-Api-Key header when not empty.
+	 */
+	std::string key;
+	/**
+	 * Records per request; a batch is sent as soon as it is full.
+	 */
+	std::size_t batch_size = 60;
+	/**
+	 * Longest time a record waits in a batch that is not full.
+	 */
+	std::chrono::milliseconds batch_delay = std::chrono::seconds(10);
+	/**
+	 * Compress request bodies with gzip.
+	 */
+	bool compress = true;
+	/**
+	 * Attempts per batch before it is dropped, the first one included.
+	 */
+	unsigned max_attempts = 5;
+	/**
+	 * Wait before the first retry, doubled on each following one up to
+	 * max_backoff.
+	 */
+	std::chrono::milliseconds min_backoff = std::chrono::milliseconds(250);
+	std::chrono::milliseconds max_backoff = std::chrono::seconds(30);
+	/**
+	 * Timeout of a single request.
+	 */
+	std::chrono::seconds timeout = std::chrono::seconds(10);
+	/**
+	 * When not empty, batches that could not be delivered are kept in a
+	 * spool file at this path and replayed once the server is back.
+	 */
+	std::string spool_path;
+	/**
+	 * Records the spool file holds; the oldest are overwritten when full.
+	 */
+	std::size_t spool_capacity = 65536;
+	/**
+	 * Delta reporting: each batch starts with a keyframe, the records
+	 * between keyframes carry only the fields that moved beyond their
+	 * dead-band. The default sends every record whole.
+	 */
+	delta_options delta;
+	/**
+	 * Send batches in the binary wire format (see binary_writer) rather
+	 * than as JSON.
+	 */
+	bool binary = false;
+};
+
+/**
+ * Counters of a sender, since construction.
+ */
+struct sender_stats final {
+	unsigned long long requests = 0;
+	unsigned long long failed_requests = 0;
+	unsigned long long records_sent = 0;
+	unsigned long long records_dropped = 0;
+	/**
+	 * Records written to the spool and sent from it.
+	 */
+	unsigned long long records_spooled = 0;
+	unsigned long long records_replayed = 0;
+	/**
+	 * Request body bytes as sent, after compression.
+	 */
+	unsigned long long bytes_sent = 0;
+	/**
+	 * Request body bytes before compression, JSON or binary.
+	 */
+	unsigned long long encoded_bytes = 0;
+};
+
+/**
+ * Sends records to the server in batches, each batch a single POST of a
+ * JSON array of records: [{"timestamp":ms,"cpu_percent":...},...], or of
+ * delta frames (see delta_frame) when delta reporting is on, or of the
+ * same in the binary wire format.
+ * The HTTP connection is kept alive between requests. Failed requests
+ * (connection errors, 429 and 5xx responses) are retried with a bounded,
+ * jittered exponential backoff. Batches rejected by the server are dropped
+ * and counted, as are batches failing every attempt unless a spool is
+ * configured. With a spool, those are written to it instead and, as
+ * long as it is not empty, new batches are queued behind the spooled
+ * records so the server receives everything in order. Each batch sent
+ * from the spool gets a single attempt, the next batch being the retry.
+ * Sending happens on the thread calling add(), send_due() or flush().
+ */
+class sender final : public boost::noncopyable {
+public:
+	/**
+	 * Called for each record of a batch the server accepted.
+	 */
+	typedef std::function<void(const record&)> sent_callback;
+
+	/**
+	 * Throws std::invalid_argument if the options, delta ones included,
+	 * are invalid and
+	 * std::exception derived exceptions if the spool cannot be opened.
+	 */
+	explicit sender(const sender_options& options,
+					const sent_callback& on_sent = sent_callback());
+	/**
+	 * Makes one attempt to send the records still queued.
+	 */
+	~sender();
+
+	/**
+	 * Queues r, then sends the batch if it is full or its oldest record
+	 * waited for batch_delay. Blocks while sending and retrying.
+	 * @return false if records had to be dropped.
+	 */
+	bool add(const record& r);
+	/**
+	 * Sends the batch if its oldest record waited for batch_delay, so a
+	 * batch that is not full goes out without a further add(). Call it
+	 * regularly. Blocks while sending and retrying.
+	 * @return false if records had to be dropped.
+	 */
+	bool send_due();
+	/**
+	 * Sends the queued records now, if any, and the spooled ones.
+	 * @return false if records had to be dropped.
+	 */
+	bool flush();
+	/**
+	 * Cuts short retries in progress and makes the following batches get
+	 * a single attempt. May be called from any thread.
+	 */
+	void stop() noexcept;
+
+	sender_stats stats() const noexcept;
+	/**
+	 * Durations of the requests made, failed ones included. May be read
+	 * and reset from any thread.
+	 */
+	utils::latency_histogram& request_latency() noexcept;
+
+private:
+	struct impl;
+	std::unique_ptr<impl> pimpl_;
+}; //class sender
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,330 @@
+#include <spool.hpp>
+
+#include <log.hpp>
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+namespace ipc = boost::interprocess;
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+static const char spool_magic[8] = { 'C', 'M', 'S', 'P', 'O', 'O', 'L', '1' };
+static const uint32_t spool_version = 4;
+/**
+ * The header gets its own page so slots never share a page with it.
+ */
+static const size_t header_size = 4096;
+
+struct spool_header final {
+	char magic[8];
+	uint32_t version;
+	uint32_t slot_size;
+	uint64_t capacity;
+	uint64_t read_seq;
+	uint64_t write_seq;
+	uint32_t crc;
+	uint32_t reserved;
+};
+static_assert(sizeof(spool_header) == 48, "spool header layout changed");
+
+/**
+ * The fields are packed by data::pack(), so the slot follows data_fields;
+ * a file written with other fields has another slot size and is replaced.
+ */
+struct spool_slot final {
+	uint64_t seq;
+	uint64_t timestamp;
+	unsigned char fields[data::packed_size];
+	uint32_t period_ms;
+	uint32_t stale;
+	uint32_t crc;
+	uint32_t reserved;
+};
+static_assert(sizeof(spool_slot) == 32 + data::packed_size,
+			  "spool slots must not be padded");
+
+/**
+ * CRC32 of everything before the crc member.
+ */
+template <typename T>
+static uint32_t checksum(const T& value) noexcept {
+	boost::crc_32_type crc;
+	crc.process_bytes(&value, offsetof(T, crc));
+	return crc.checksum();
+}
+
+struct spool::impl final {
+	impl(const string& path, size_t capacity, size_t sync_every);
+
+	bool load_header();
+	void recover();
+	void write_header() noexcept;
+	bool read_slot(uint64_t seq, spool_slot& slot) const noexcept;
+
+	char* slot_address(uint64_t seq) const noexcept {
+		return base + header_size + (seq % capacity) * sizeof(spool_slot);
+	}
+	void flush_slots(uint64_t first, uint64_t last) noexcept;
+
+	const string path;
+	const size_t capacity;
+	const size_t sync_every;
+	ipc::file_mapping file;
+	ipc::mapped_region region;
+	char* base = nullptr;
+
+	uint64_t read_seq = 0;
+	uint64_t write_seq = 0;
+	uint64_t synced_seq = 0;
+	bool header_dirty = false;
+	unsigned long long overwritten = 0;
+	unsigned long long corrupted = 0;
+};
+
+static size_t checked_capacity(size_t capacity, size_t sync_every) {
+	if (capacity == 0 || sync_every == 0) {
+		throw invalid_argument("Invalid spool arguments");
+	}
+	return capacity;
+}
+
+/**
+ * Creates path zero filled with the given size, replacing any old file so
+ * stale slots can never pass as recent ones.
+ */
+static void create_file(const string& path, uintmax_t size) {
+	{
+		ofstream f(path, ios::binary | ios::trunc);
+		if (!f) {
+			throw runtime_error("Cannot create spool file " + path);
+		}
+	}
+	boost::filesystem::resize_file(path, size);
+}
+
+static bool prepare_file(const string& path, uintmax_t size) {
+	boost::system::error_code err;
+	if (boost::filesystem::file_size(path, err) == size && !err) {
+		return false;
+	}
+	create_file(path, size);
+	return true;
+}
+
+spool::impl::impl(const string& path, size_t capacity, size_t sync_every) :
+	path(path),
+	capacity(checked_capacity(capacity, sync_every)),
+	sync_every(sync_every) {
+	const uintmax_t size = header_size + capacity * sizeof(spool_slot);
+	bool fresh = prepare_file(path, size);
+
+	file = ipc::file_mapping(path.c_str(), ipc::read_write);
+	region = ipc::mapped_region(file, ipc::read_write);
+	base = static_cast<char*>(region.get_address());
+
+	if (!fresh && !load_header()) {
+		LOG(warning) << "Spool file " << path << " has an invalid header, "
+					 << "starting a new one";
+		region = ipc::mapped_region();
+		file = ipc::file_mapping();
+		create_file(path, size);
+		file = ipc::file_mapping(path.c_str(), ipc::read_write);
+		region = ipc::mapped_region(file, ipc::read_write);
+		base = static_cast<char*>(region.get_address());
+		fresh = true;
+	}
+
+	if (fresh) {
+		write_header();
+		region.flush(0, header_size, false);
+	} else {
+		recover();
+	}
+	synced_seq = write_seq;
+}
+
+bool spool::impl::load_header() {
+	spool_header h;
+	memcpy(&h, base, sizeof(h));
+	if (memcmp(h.magic, spool_magic, sizeof(spool_magic)) != 0 ||
+		h.version != spool_version ||
+		h.slot_size != sizeof(spool_slot) ||
+		h.capacity != capacity ||
+		h.crc != checksum(h) ||
+		h.write_seq < h.read_seq ||
+		h.write_seq - h.read_seq > capacity) {
+		return false;
+	}
+	read_seq = h.read_seq;
+	write_seq = h.write_seq;
+	return true;
+}
+
+void spool::impl::recover() {
+	// Slots written after the last sync may have reached the disk; take
+	// every one that carries the next sequence number and a valid CRC.
+	spool_slot slot;
+	size_t found = 0;
+	while (found < capacity && read_slot(write_seq, slot)) {
+		++write_seq;
+		++found;
+	}
+	if (write_seq - read_seq > capacity) {
+		read_seq = write_seq - capacity;
+	}
+	if (found != 0) {
+		header_dirty = true;
+	}
+	LOG(info) << "Spool " << path << " holds " << write_seq - read_seq
+			  << " records, " << found << " recovered past the last sync";
+}
+
+void spool::impl::write_header() noexcept {
+	spool_header h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, spool_magic, sizeof(spool_magic));
+	h.version = spool_version;
+	h.slot_size = sizeof(spool_slot);
+	h.capacity = capacity;
+	h.read_seq = read_seq;
+	h.write_seq = write_seq;
+	h.crc = checksum(h);
+	memcpy(base, &h, sizeof(h));
+	header_dirty = false;
+}
+
+bool spool::impl::read_slot(uint64_t seq, spool_slot& slot) const noexcept {
+	memcpy(&slot, slot_address(seq), sizeof(slot));
+	return slot.seq == seq && slot.crc == checksum(slot);
+}
+
+void spool::impl::flush_slots(uint64_t first, uint64_t last) noexcept {
+	if (last - first >= capacity) {
+		region.flush(header_size, capacity * sizeof(spool_slot), false);
+		return;
+	}
+	const size_t begin = static_cast<size_t>(first % capacity);
+	const size_t end = static_cast<size_t>(last % capacity);
+	if (begin < end) {
+		region.flush(header_size + begin * sizeof(spool_slot),
+					 (end - begin) * sizeof(spool_slot), false);
+	} else {
+		// The range wraps around the end of the file
+		region.flush(header_size + begin * sizeof(spool_slot),
+					 (capacity - begin) * sizeof(spool_slot), false);
+		if (end != 0) {
+			region.flush(header_size, end * sizeof(spool_slot), false);
+		}
+	}
+}
+
+spool::spool(const string& path, size_t capacity, size_t sync_every) :
+	pimpl_(new impl(path, capacity, sync_every)) {
+}
+
+spool::~spool() {
+	sync();
+}
+
+void spool::push(const record& r) {
+	impl& p = *pimpl_;
+	if (p.write_seq - p.read_seq == p.capacity) {
+		++p.read_seq;
+		++p.overwritten;
+	}
+
+	spool_slot slot;
+	memset(&slot, 0, sizeof(slot));
+	slot.seq = p.write_seq;
+	slot.timestamp = r.timestamp;
+	r.sample.pack(slot.fields);
+	slot.period_ms = r.period_ms;
+	slot.stale = r.stale;
+	slot.crc = checksum(slot);
+	memcpy(p.slot_address(p.write_seq), &slot, sizeof(slot));
+	++p.write_seq;
+	p.header_dirty = true;
+
+	if (p.write_seq - p.synced_seq >= p.sync_every) {
+		sync();
+	}
+}
+
+size_t spool::peek(vector<record>& out, size_t max) {
+	impl& p = *pimpl_;
+	const uint64_t end = min<uint64_t>(p.write_seq, p.read_seq + max);
+	spool_slot slot;
+	for (uint64_t seq = p.read_seq; seq < end; ++seq) {
+		if (!p.read_slot(seq, slot)) {
+			++p.corrupted;
+			continue;
+		}
+		try {
+			out.emplace_back(slot.timestamp, data::unpack(slot.fields),
+							 slot.period_ms, slot.stale);
+		} catch (const invalid_argument&) {
+			++p.corrupted;
+		}
+	}
+	return static_cast<size_t>(end - p.read_seq);
+}
+
+void spool::pop(size_t count) noexcept {
+	impl& p = *pimpl_;
+	p.read_seq += min<uint64_t>(count, p.write_seq - p.read_seq);
+	p.header_dirty = true;
+}
+
+void spool::sync() noexcept {
+	impl& p = *pimpl_;
+	if (p.write_seq != p.synced_seq) {
+		// Slots go first, so the header never points past durable slots.
+		p.flush_slots(p.synced_seq, p.write_seq);
+		p.synced_seq = p.write_seq;
+	}
+	if (p.header_dirty) {
+		p.write_header();
+		if (!p.region.flush(0, header_size, false)) {
+			LOG(error) << "Failed to sync spool file " << p.path;
+		}
+	}
+}
+
+size_t spool::size() const noexcept {
+	return static_cast<size_t>(pimpl_->write_seq - pimpl_->read_seq);
+}
+
+bool spool::empty() const noexcept {
+	return pimpl_->write_seq == pimpl_->read_seq;
+}
+
+size_t spool::capacity() const noexcept {
+	return pimpl_->capacity;
+}
+
+unsigned long long spool::overwritten() const noexcept {
+	return pimpl_->overwritten;
+}
+
+unsigned long long spool::corrupted() const noexcept {
+	return pimpl_->corrupted;
+}
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
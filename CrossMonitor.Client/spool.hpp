@@ -0,0 +1,85 @@
+#pragma once
+
+#include <record.hpp>
+
+#include <boost/noncopyable.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace client {
+
+/**
+ * Fixed size on-disk ring of records, memory-mapped, holding the samples
+ * that could not be sent while the server was unreachable.
+ * Each record is a slot of its packed fields (72 bytes with the current
+ * ones), its sequence number, its stale probes mask and a CRC32.
+ * The file header holds the replay position and the write position as of
+ * the last sync(), so reopening after a crash only checks the slots
+ * written since then. When full, the oldest record is overwritten.
+ * Records are synced to disk every sync_every pushes, so a crash loses at
+ * most that many; records popped since the last sync may be replayed
+ * again after a crash. Integers are stored in host byte order.
+ * Not thread safe.
+ */
+class spool final : public boost::noncopyable {
+public:
+	/**
+	 * Opens the spool file at path, creating it if it does not exist or
+	 * was created with another capacity.
+	 * Throws std::invalid_argument if capacity or sync_every is zero and
+	 * std::exception derived exceptions if the file cannot be mapped.
+	 * @param capacity records the file holds.
+	 * @param sync_every pushes between syncs.
+	 */
+	spool(const std::string& path, std::size_t capacity,
+		  std::size_t sync_every = 64);
+	/**
+	 * Syncs the file.
+	 */
+	~spool();
+
+	/**
+	 * Appends r, overwriting the oldest record if the spool is full.
+	 */
+	void push(const record& r);
+	/**
+	 * Appends the oldest records to out, without removing them.
+	 * Records that fail their CRC are skipped and counted.
+	 * @param max most slots to read.
+	 * @return slots read, to be passed to pop() once out was sent.
+	 */
+	std::size_t peek(std::vector<record>& out, std::size_t max);
+	/**
+	 * Removes the count oldest records.
+	 */
+	void pop(std::size_t count) noexcept;
+	/**
+	 * Writes the pending records and the header to disk.
+	 */
+	void sync() noexcept;
+
+	std::size_t size() const noexcept;
+	bool empty() const noexcept;
+	std::size_t capacity() const noexcept;
+	/**
+	 * Records lost to overwriting since construction.
+	 */
+	unsigned long long overwritten() const noexcept;
+	/**
+	 * Records skipped for a bad CRC since construction.
+	 */
+	unsigned long long corrupted() const noexcept;
+
+private:
+	struct impl;
+	std::unique_ptr<impl> pimpl_;
+}; //class spool
+
+} //namespace client
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,63 @@
+#include "counter_rate.hpp"
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+counter_change counter_rate::update(unsigned long long value,
+									const clock::time_point& now,
+									unsigned generation) noexcept {
+	counter_change change;
+	if (!has_previous_) {
+		change = counter_change::first;
+	} else if (generation != generation_) {
+		change = counter_change::reset;
+	} else if (now <= previous_time_) {
+		return counter_change::repeated;
+	} else if (value >= previous_) {
+		change = counter_change::increased;
+	} else if (previous_ <= max_value_ &&
+			   (max_value_ - previous_) + value + 1 <= max_value_ / 2) {
+		// Unsigned arithmetic, so 64 bits counters wrap back as well
+		change = counter_change::wrapped;
+	} else {
+		change = counter_change::reset;
+	}
+
+	if (change == counter_change::increased ||
+		change == counter_change::wrapped) {
+		delta_ = change == counter_change::wrapped ?
+			(max_value_ - previous_) + value + 1 : value - previous_;
+		seconds_ = chrono::duration<double>(now - previous_time_).count();
+		pending_delta_ += delta_;
+		pending_seconds_ += seconds_;
+	} else {
+		delta_ = 0;
+		seconds_ = 0;
+	}
+	previous_ = value;
+	previous_time_ = now;
+	generation_ = generation;
+	has_previous_ = true;
+	return change;
+}
+
+void counter_rate::restart() noexcept {
+	has_previous_ = false;
+	delta_ = 0;
+	seconds_ = 0;
+}
+
+double counter_rate::take_rate() noexcept {
+	const double rate = pending_seconds_ > 0 ?
+		pending_delta_ / pending_seconds_ : 0;
+	pending_delta_ = 0;
+	pending_seconds_ = 0;
+	return rate;
+}
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <chrono>
+#include <climits>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * What counter_rate::update() made of a reading.
+	 */
+	enum class counter_change {
+		/**
+		 * First reading, or first since restart(): only a baseline.
+		 */
+		first,
+		/**
+		 * Grew or stayed since the previous reading, the increase counts.
+		 */
+		increased,
+		/**
+		 * Went past its maximum and started over from zero, the increase
+		 * across the wrap counts.
+		 */
+		wrapped,
+		/**
+		 * Went backwards or its source changed: the reading is a new
+		 * baseline and the interval since the previous one does not count.
+		 */
+		reset,
+		/**
+		 * Not newer than the previous reading, ignored.
+		 */
+		repeated
+	};
+
+	/**
+	 * Turns the readings of a cumulative counter, one that only grows until
+	 * it wraps or its source restarts, into rates per second. Keeps the
+	 * previous raw value and the monotonic time it was read at, so rates
+	 * hold across missed samples and clock changes.
+	 *
+	 * A reading below the previous one is a wrap when the increase across
+	 * max_value is under half the counter's range, a reset otherwise (a
+	 * reboot, a driver reloaded...). Sources that reopen their handles or
+	 * change what they sum pass a new generation instead, as the counter
+	 * may then jump either way. A reset or a new generation only sets a new
+	 * baseline: the interval is left out of every rate rather than counted
+	 * as a spike or a drop.
+	 * Meant to be owned by a single thread, which needs no locking.
+	 */
+	class counter_rate final {
+	public:
+		typedef std::chrono::steady_clock clock;
+
+		/**
+		 * @param max_value highest value the counter reaches before it
+		 *                  wraps to zero, e.g. UINT_MAX for 32 bits ones.
+		 */
+		explicit counter_rate(unsigned long long max_value = ULLONG_MAX) noexcept :
+			max_value_(max_value) {
+		}
+
+		/**
+		 * Feeds a reading of the counter.
+		 * @param value raw value of the counter.
+		 * @param now when it was read.
+		 * @param generation identifies the source of the value, a change
+		 *                   means the counter cannot be compared to the
+		 *                   previous reading.
+		 */
+		counter_change update(unsigned long long value,
+							  const clock::time_point& now,
+							  unsigned generation = 0) noexcept;
+		/**
+		 * Forgets the previous reading, so the next one is a baseline.
+		 * Rates not yet taken are kept.
+		 */
+		void restart() noexcept;
+
+		/**
+		 * Increase counted by the last update(), 0 unless it increased or
+		 * wrapped.
+		 */
+		unsigned long long delta() const noexcept {
+			return delta_;
+		}
+		/**
+		 * Rate per second over the interval ended by the last update(), 0
+		 * unless it increased or wrapped.
+		 */
+		double rate() const noexcept {
+			return seconds_ > 0 ? delta_ / seconds_ : 0;
+		}
+		/**
+		 * Mean rate per second over the intervals counted since the
+		 * previous call, 0 if none was.
+		 */
+		double take_rate() noexcept;
+
+	private:
+		unsigned long long max_value_;
+		unsigned long long previous_ = 0;
+		clock::time_point previous_time_;
+		unsigned generation_ = 0;
+		bool has_previous_ = false;
+
+		unsigned long long delta_ = 0;
+		double seconds_ = 0;
+		double pending_delta_ = 0;
+		double pending_seconds_ = 0;
+	}; //class counter_rate
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
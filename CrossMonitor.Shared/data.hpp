@@ -1,17 +1,31 @@
 #pragma once
 
+#include "data_fields.hpp"
+
+#include <cstring>
 #include <stdexcept>
 #include <string>
+#include <tuple>
 
 namespace crossover {
 namespace monitor {
 
 /**
- * Class representing the data sent and received 
+ * Class representing the data sent and received
  * by both client and server components.
+ * Holds one value per field of data_fields, see fields for their ranges.
  */
 class data final {
 public:
+	/**
+	 * The values of every field, in data_fields order.
+	 */
+	typedef tuple_of<field_type, data_fields>::type values;
+	/**
+	 * Bytes taken by pack().
+	 */
+	static const std::size_t packed_size = data_fields::packed_size;
+
 	/**
 	 * Constructor. Throws std::invalid_argument in case any arguments
 	 * are out of range.
@@ -33,22 +47,72 @@ public:
 		set_total_disk_read(total_disk_read);
 		set_total_disk_write(total_disk_write);
 	}
+	/**
+	 * Constructor from the value of every field. Throws
+	 * std::invalid_argument in case any value is out of range.
+	 */
+	explicit data(const values& v) {
+		for_each_field(data_fields{}, [&](auto field) {
+			typedef decltype(field) F;
+			set<F>(std::get<field_index<F, data_fields>::value>(v));
+		});
+	}
 	data(const data& other) = default;
-	data& operator=(const data& rhs) = default;	
+	data& operator=(const data& rhs) = default;
+
+	/**
+	 * Value of the field described by Field.
+	 */
+	template <typename Field>
+	typename Field::type get() const noexcept {
+		return std::get<field_index<Field, data_fields>::value>(values_);
+	}
+	/**
+	 * Setter of the field described by Field.
+	 * Throws std::invalid_argument if the argument is out of range.
+	 */
+	template <typename Field>
+	void set(typename Field::type v) {
+		Field::validate(v);
+		std::get<field_index<Field, data_fields>::value>(values_) = v;
+	}
+
+	/**
+	 * Writes the fields in data_fields order to packed_size bytes at out,
+	 * in host byte order.
+	 */
+	void pack(unsigned char* out) const noexcept {
+		for_each_field(data_fields{}, [&](auto field) {
+			typedef decltype(field) F;
+			const typename F::type v = get<F>();
+			std::memcpy(out, &v, sizeof(v));
+			out += sizeof(v);
+		});
+	}
+	/**
+	 * Reads what pack() wrote. Throws std::invalid_argument in case any
+	 * value is out of range.
+	 */
+	static data unpack(const unsigned char* in) {
+		values v;
+		for_each_field(data_fields{}, [&](auto field) {
+			typedef decltype(field) F;
+			std::memcpy(&std::get<field_index<F, data_fields>::value>(v), in,
+						sizeof(typename F::type));
+			in += sizeof(typename F::type);
+		});
+		return data(v);
+	}
 
 	/**
 	 * Setter. Throws std::invalid_argument if the argument is out of range.
 	 * @param cpu_percent CPU use percentage (0 to 100).
 	 */
 	void set_cpu_percent(float cpu_percent) {
-		if (cpu_percent < 0 || cpu_percent > 100) {
-			throw std::invalid_argument(
-				"cpu_percent out of range: " + std::to_string(cpu_percent));
-		}
-		cpu_percent_ = cpu_percent;
+		set<fields::cpu_percent>(cpu_percent);
 	}
 	float get_cpu_percent() const noexcept {
-		return cpu_percent_;
+		return get<fields::cpu_percent>();
 	}
 
 	/**
@@ -56,13 +120,10 @@ public:
 	* @param process_count Process count (1 to UINT_MAX).
 	*/
 	void set_process_count(unsigned process_count) {
-		if (process_count == 0) {
-			throw std::invalid_argument("process_count cannot be zero");
-		}
-		process_count_ = process_count;
+		set<fields::process_count>(process_count);
 	}
 	unsigned get_process_count() const noexcept {
-		return process_count_;
+		return get<fields::process_count>();
 	}
 
 	/**
@@ -70,10 +131,10 @@ public:
 	* @param total_memory Total memory in bytes (0 to UINT_MAX).
 	*/
 	void set_total_memory(unsigned long long total_memory) {
-		total_memory_ = total_memory;
+		set<fields::total_memory>(total_memory);
 	}
 	unsigned long long get_total_memory() const noexcept {
-		return total_memory_;
+		return get<fields::total_memory>();
 	}
 
 	/**
@@ -81,10 +142,10 @@ public:
 	* @param total_memory Used memory in bytes (0 to UINT_MAX).
 	*/
 	void set_used_memory(unsigned long long used_memory) {
-		used_memory_ = used_memory;
+		set<fields::used_memory>(used_memory);
 	}
 	unsigned long long get_used_memory() const noexcept {
-		return used_memory_;
+		return get<fields::used_memory>();
 	}
 
 	/**
@@ -92,10 +153,10 @@ public:
 	* @param total_disk_read Total read bytes from disk
 	*/
 	void set_total_disk_read(unsigned long long total_disk_read) {
-		total_disk_read_ = total_disk_read;
+		set<fields::total_disk_read>(total_disk_read);
 	}
 	unsigned long long get_total_disk_read() const noexcept {
-		return total_disk_read_;
+		return get<fields::total_disk_read>();
 	}
 
 	/**
@@ -103,19 +164,14 @@ public:
 	* @param total_disk_write Total write bytes to disk.
 	*/
 	void set_total_disk_write(unsigned long long total_disk_write) {
-		total_disk_write_ = total_disk_write;
+		set<fields::total_disk_write>(total_disk_write);
 	}
 	unsigned long long get_total_disk_write() const noexcept {
-		return total_disk_write_;
+		return get<fields::total_disk_write>();
 	}
 
 private:
-	float cpu_percent_;
-	unsigned long long used_memory_;
-	unsigned long long total_memory_;
-	unsigned process_count_;
-	unsigned long long total_disk_read_;
-	unsigned long long total_disk_write_;
+	values values_;
 }; //struct data
 
 } //namespace monitor
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+
+namespace crossover {
+namespace monitor {
+
+/**
+ * Compile-time descriptors of the data fields, the one place a field is
+ * declared. Each descriptor names the field's type, its wire name, its
+ * unit, whether it is a counter that only grows (its rate being what
+ * matters) and the values it accepts. The storage of data, its accessors
+ * and validation, and every serializer (JSON, spool, history) are
+ * generated from data_fields, so code that handles every field is written
+ * once and expanded by the compiler with no virtual calls nor runtime
+ * lookups. Adding a field takes a descriptor and an entry in data_fields.
+ */
+namespace fields {
+
+	/**
+	 * Base of the descriptors: a gauge accepting any value, read and
+	 * written through data::get<Self> and data::set<Self>.
+	 */
+	template <typename Self, typename T>
+	struct field {
+		typedef T type;
+		static constexpr bool counter = false;
+
+		/**
+		 * Throws std::invalid_argument if v is out of range.
+		 */
+		static void validate(type v) {
+			(void)v;
+		}
+		template <typename Data>
+		static type get(const Data& d) noexcept {
+			return d.template get<Self>();
+		}
+		template <typename Data>
+		static void set(Data& d, type v) {
+			d.template set<Self>(v);
+		}
+	};
+
+	struct cpu_percent final : field<cpu_percent, float> {
+		static const char* name() noexcept { return "cpu_percent"; }
+		static const char* unit() noexcept { return "percent"; }
+		static void validate(type v) {
+			if (v < 0 || v > 100) {
+				throw std::invalid_argument(
+					"cpu_percent out of range: " + std::to_string(v));
+			}
+		}
+	};
+
+	struct process_count final : field<process_count, unsigned> {
+		static const char* name() noexcept { return "process_count"; }
+		static const char* unit() noexcept { return "processes"; }
+		static void validate(type v) {
+			if (v == 0) {
+				throw std::invalid_argument("process_count cannot be zero");
+			}
+		}
+	};
+
+	struct total_disk_read final : field<total_disk_read, unsigned long long> {
+		static constexpr bool counter = true;
+		static const char* name() noexcept { return "total_disk_read"; }
+		static const char* unit() noexcept { return "bytes"; }
+	};
+
+	struct total_disk_write final : field<total_disk_write, unsigned long long> {
+		static constexpr bool counter = true;
+		static const char* name() noexcept { return "total_disk_write"; }
+		static const char* unit() noexcept { return "bytes"; }
+	};
+
+	struct total_memory final : field<total_memory, unsigned long long> {
+		static const char* name() noexcept { return "total_memory_in_bytes"; }
+		static const char* unit() noexcept { return "bytes"; }
+	};
+
+	struct used_memory final : field<used_memory, unsigned long long> {
+		static const char* name() noexcept { return "used_memory_in_bytes"; }
+		static const char* unit() noexcept { return "bytes"; }
+	};
+
+} //namespace fields
+
+/**
+ * A compile-time list of field descriptors.
+ */
+template <typename... Fields>
+struct field_list;
+
+template <>
+struct field_list<> final {
+	static constexpr std::size_t size = 0;
+	/**
+	 * Bytes the values of the fields take packed one after the other.
+	 */
+	static constexpr std::size_t packed_size = 0;
+};
+
+template <typename First, typename... Rest>
+struct field_list<First, Rest...> final {
+	static constexpr std::size_t size = 1 + sizeof...(Rest);
+	static constexpr std::size_t packed_size = sizeof(typename First::type) +
+		field_list<Rest...>::packed_size;
+};
+
+/**
+ * Every data field, sorted by name. Serializers walk the fields in this
+ * order, which matches the key order of the original cpprest JSON output.
+ */
+typedef field_list<
+	fields::cpu_percent,
+	fields::process_count,
+	fields::total_disk_read,
+	fields::total_disk_write,
+	fields::total_memory,
+	fields::used_memory
+> data_fields;
+
+/**
+ * Position of Field in a field list, as an integral constant.
+ */
+template <typename Field, typename List>
+struct field_index;
+
+template <typename Field, typename... Rest>
+struct field_index<Field, field_list<Field, Rest...>> :
+	std::integral_constant<std::size_t, 0> {
+};
+
+template <typename Field, typename First, typename... Rest>
+struct field_index<Field, field_list<First, Rest...>> :
+	std::integral_constant<std::size_t,
+		1 + field_index<Field, field_list<Rest...>>::value> {
+};
+
+/**
+ * Calls f(Field{}) for every field in the list, in order.
+ * Use decltype on the argument of a generic lambda to get the descriptor.
+ */
+template <typename F, typename... Fields>
+void for_each_field(field_list<Fields...>, F&& f) {
+	const int expand[] = { 0, (f(Fields{}), 0)... };
+	(void)expand;
+}
+
+/**
+ * std::tuple holding one Wrapper<Field> per field of a list, for per field
+ * state such as summaries or statistics. Access with std::get<Wrapper<F>>.
+ */
+template <template <typename> class Wrapper, typename List>
+struct tuple_of;
+
+template <template <typename> class Wrapper, typename... Fields>
+struct tuple_of<Wrapper, field_list<Fields...>> {
+	typedef std::tuple<Wrapper<Fields>...> type;
+};
+
+/**
+ * The value type of a field, to get a tuple of the values of a list:
+ * tuple_of<field_type, List>::type.
+ */
+template <typename Field>
+using field_type = typename Field::type;
+
+} //namespace monitor
+} //namespace crossover
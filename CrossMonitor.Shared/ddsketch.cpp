@@ -0,0 +1,192 @@
+#include "ddsketch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+const double ddsketch::min_value = 1e-9;
+
+static double checked_accuracy(double relative_accuracy, size_t max_bins) {
+	if (!(relative_accuracy > 0 && relative_accuracy < 1) || max_bins == 0) {
+		throw invalid_argument("Invalid ddsketch arguments");
+	}
+	return relative_accuracy;
+}
+
+ddsketch::ddsketch(double relative_accuracy, size_t max_bins) :
+	relative_accuracy_(checked_accuracy(relative_accuracy, max_bins)),
+	gamma_((1 + relative_accuracy) / (1 - relative_accuracy)),
+	log_gamma_(log(gamma_)),
+	bins_(max_bins) {
+}
+
+int ddsketch::key(double value) const noexcept {
+	return static_cast<int>(ceil(log(value) / log_gamma_));
+}
+
+double ddsketch::value_of(int key) const noexcept {
+	// The point of the bin whose relative distance to both ends is the
+	// relative accuracy
+	return 2 * pow(gamma_, key) / (gamma_ + 1);
+}
+
+int ddsketch::reserve(int key) noexcept {
+	const int size = static_cast<int>(bins_.size());
+	if (min_key_ > max_key_) {
+		// First bin: center the window so it has room on both sides
+		offset_ = key - size / 2;
+		min_key_ = max_key_ = key;
+		return key;
+	}
+
+	if (key < offset_ || key >= offset_ + size) {
+		const int low = std::min(min_key_, key);
+		const int high = std::max(max_key_, key);
+		// Leave the free room on the side the values grew to
+		const int offset = high - low < size && key > max_key_ ?
+			low : high - size + 1;
+
+		if (offset > offset_) {
+			// Bins falling off the low end are merged into the lowest kept
+			unsigned long long collapsed = 0;
+			for (int k = min_key_; k < offset && k <= max_key_; ++k) {
+				collapsed += slot(k);
+			}
+			const size_t shift = static_cast<size_t>(offset - offset_);
+			if (shift < bins_.size()) {
+				copy(bins_.begin() + shift, bins_.end(), bins_.begin());
+				fill(bins_.end() - shift, bins_.end(), 0);
+			} else {
+				fill(bins_.begin(), bins_.end(), 0);
+			}
+			offset_ = offset;
+			slot(offset) += collapsed;
+			min_key_ = std::max(min_key_, offset);
+			max_key_ = std::max(max_key_, offset);
+		} else {
+			const size_t shift = static_cast<size_t>(offset_ - offset);
+			if (shift < bins_.size()) {
+				copy_backward(bins_.begin(), bins_.end() - shift, bins_.end());
+				fill(bins_.begin(), bins_.begin() + shift, 0);
+			} else {
+				fill(bins_.begin(), bins_.end(), 0);
+			}
+			offset_ = offset;
+		}
+		// Values below the window go to its lowest bin
+		key = std::max(key, offset_);
+	}
+
+	min_key_ = std::min(min_key_, key);
+	max_key_ = std::max(max_key_, key);
+	return key;
+}
+
+void ddsketch::add(double value) noexcept {
+	add(value, 1);
+}
+
+void ddsketch::add(double value, unsigned long long count) noexcept {
+	if (!isfinite(value) || count == 0) {
+		return;
+	}
+	value = std::max(value, 0.0);
+	if (count_ == 0) {
+		min_ = max_ = value;
+	} else {
+		min_ = std::min(min_, value);
+		max_ = std::max(max_, value);
+	}
+	count_ += count;
+
+	if (value < min_value) {
+		zero_count_ += count;
+		return;
+	}
+	slot(reserve(key(value))) += count;
+}
+
+void ddsketch::merge(const ddsketch& other) {
+	if (other.relative_accuracy_ != relative_accuracy_) {
+		throw invalid_argument("Cannot merge sketches of different accuracy");
+	}
+	if (&other == this) {
+		const ddsketch copy(other);
+		merge(copy);
+		return;
+	}
+	if (other.empty()) {
+		return;
+	}
+
+	if (empty()) {
+		min_ = other.min_;
+		max_ = other.max_;
+	} else {
+		min_ = std::min(min_, other.min_);
+		max_ = std::max(max_, other.max_);
+	}
+	count_ += other.count_;
+	zero_count_ += other.zero_count_;
+	for (int k = other.min_key_; k <= other.max_key_; ++k) {
+		const unsigned long long count = other.bin(k);
+		if (count != 0) {
+			slot(reserve(k)) += count;
+		}
+	}
+}
+
+void ddsketch::clear() noexcept {
+	if (min_key_ <= max_key_) {
+		fill(bins_.begin(), bins_.end(), 0);
+	}
+	min_key_ = 1;
+	max_key_ = 0;
+	count_ = 0;
+	zero_count_ = 0;
+	min_ = 0;
+	max_ = 0;
+}
+
+double ddsketch::quantile(double q) const noexcept {
+	if (count_ == 0) {
+		return 0;
+	}
+	// The extremes are known exactly
+	if (q <= 0) {
+		return min_;
+	}
+	if (q >= 1) {
+		return max_;
+	}
+	const double rank = q * static_cast<double>(count_ - 1);
+
+	unsigned long long seen = zero_count_;
+	if (rank < seen) {
+		return min_;
+	}
+	for (int k = min_key_; k <= max_key_; ++k) {
+		seen += bin(k);
+		if (rank < seen) {
+			return std::min(std::max(value_of(k), min_), max_);
+		}
+	}
+	return max_;
+}
+
+unsigned long long ddsketch::bin(int key) const noexcept {
+	if (key < min_key_ || key > max_key_) {
+		return 0;
+	}
+	return bins_[static_cast<size_t>(key - offset_)];
+}
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * Streaming quantile sketch with a fixed relative error (DDSketch).
+	 * Values are counted in logarithmic bins: bin key k holds the values
+	 * in (gamma^(k-1), gamma^k], gamma = (1 + a) / (1 - a), so any quantile
+	 * is answered within a relative error a of the true value. Values
+	 * below min_value, zero included, are counted apart.
+	 * Bins live in a window of max_bins consecutive keys allocated at
+	 * construction, so add() is O(1) and never allocates. When values
+	 * span more keys than that, the lowest bins are merged together,
+	 * which only loses accuracy on the lowest quantiles.
+	 * Two sketches with the same relative accuracy merge into the sketch
+	 * of the union of their values, which is how the server combines the
+	 * sketches of several hosts or periods. Not thread safe.
+	 */
+	class ddsketch final {
+	public:
+		/**
+		 * Smallest value counted in a bin.
+		 */
+		static const double min_value;
+
+		/**
+		 * Throws std::invalid_argument if relative_accuracy is not in
+		 * (0, 1) or max_bins is zero.
+		 */
+		explicit ddsketch(double relative_accuracy = 0.01,
+						  std::size_t max_bins = 2048);
+
+		/**
+		 * Counts value; negative values count as zero and NaN is ignored.
+		 */
+		void add(double value) noexcept;
+		/**
+		 * Counts value count times, in constant time.
+		 */
+		void add(double value, unsigned long long count) noexcept;
+		/**
+		 * Adds the values counted by other.
+		 * Throws std::invalid_argument if the relative accuracies differ.
+		 */
+		void merge(const ddsketch& other);
+		/**
+		 * Forgets every value, keeping the storage.
+		 */
+		void clear() noexcept;
+
+		/**
+		 * Estimate of the q quantile, q in [0, 1]; 0 when empty.
+		 * Quantiles 0 and 1 are the exact min() and max().
+		 */
+		double quantile(double q) const noexcept;
+
+		unsigned long long count() const noexcept {
+			return count_;
+		}
+		bool empty() const noexcept {
+			return count_ == 0;
+		}
+		/**
+		 * Values counted below min_value.
+		 */
+		unsigned long long zero_count() const noexcept {
+			return zero_count_;
+		}
+		/**
+		 * Exact extremes of the values counted; 0 when empty.
+		 */
+		double min() const noexcept {
+			return empty() ? 0 : min_;
+		}
+		double max() const noexcept {
+			return empty() ? 0 : max_;
+		}
+		double relative_accuracy() const noexcept {
+			return relative_accuracy_;
+		}
+
+		/**
+		 * Range of the keys that may hold values, for serialization.
+		 * Empty (min_key() > max_key()) when no value reached a bin.
+		 */
+		int min_key() const noexcept {
+			return min_key_;
+		}
+		int max_key() const noexcept {
+			return max_key_;
+		}
+		/**
+		 * Values counted in the bin of key; 0 outside the key range.
+		 */
+		unsigned long long bin(int key) const noexcept;
+
+	private:
+		int key(double value) const noexcept;
+		double value_of(int key) const noexcept;
+		/**
+		 * Makes room for key in the window and returns the key the
+		 * value must be counted under, lower than key if collapsed.
+		 */
+		int reserve(int key) noexcept;
+		unsigned long long& slot(int key) noexcept {
+			return bins_[static_cast<std::size_t>(key - offset_)];
+		}
+
+		const double relative_accuracy_;
+		const double gamma_;
+		const double log_gamma_;
+		std::vector<unsigned long long> bins_;
+		/**
+		 * Key of bins_[0].
+		 */
+		int offset_ = 0;
+		int min_key_ = 1;
+		int max_key_ = 0;
+		unsigned long long count_ = 0;
+		unsigned long long zero_count_ = 0;
+		double min_ = 0;
+		double max_ = 0;
+	}; //class ddsketch
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
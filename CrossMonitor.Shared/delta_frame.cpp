@@ -0,0 +1,112 @@
+#include "delta_frame.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+
+void delta_options::set_deadband(const string& name, double deadband) {
+	if (!(deadband >= 0)) {
+		throw invalid_argument("Invalid dead-band for " + name);
+	}
+	bool found = false;
+	size_t i = 0;
+	for_each_field(data_fields{}, [&](auto field) {
+		if (name == decltype(field)::name()) {
+			deadbands[i] = deadband;
+			found = true;
+		}
+		++i;
+	});
+	if (!found) {
+		throw invalid_argument("Unknown field " + name);
+	}
+}
+
+static const delta_options& checked_options(const delta_options& options) {
+	if (options.keyframe_every == 0) {
+		throw invalid_argument("keyframe_every cannot be zero");
+	}
+	for (double deadband : options.deadbands) {
+		if (!(deadband >= 0)) {
+			throw invalid_argument("Dead-bands cannot be negative");
+		}
+	}
+	return options;
+}
+
+delta_encoder::delta_encoder(const delta_options& options) :
+	options_(checked_options(options)) {
+}
+
+void delta_encoder::encode(const record& r, delta_frame& frame) noexcept {
+	frame.timestamp = r.timestamp;
+	frame.period_ms = r.period_ms;
+	frame.stale = r.stale;
+	frame.keyframe = count_ == 0;
+	frame.mask = 0;
+	if (++count_ == options_.keyframe_every) {
+		count_ = 0;
+	}
+
+	size_t i = 0;
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		typedef typename F::type T;
+		const size_t index = field_index<F, data_fields>::value;
+		const T value = F::get(r.sample);
+		T& sent = get<index>(sent_);
+		T& out = get<index>(frame.values);
+		const double deadband = options_.deadbands[i];
+		const unsigned bit = 1u << i++;
+
+		if (frame.keyframe) {
+			out = sent = value;
+			frame.mask |= bit;
+			return;
+		}
+		if (value == sent) {
+			return;
+		}
+		// The difference is taken modulo 2^n for counters, as a signed
+		// number it is exact for resets and wraps too.
+		const double moved = F::counter ?
+			static_cast<double>(static_cast<long long>(value - sent)) :
+			static_cast<double>(value) - static_cast<double>(sent);
+		if (deadband > 0 && abs(moved) <= deadband) {
+			return;
+		}
+		out = F::counter ? static_cast<T>(value - sent) : value;
+		sent = value;
+		frame.mask |= bit;
+	});
+}
+
+record delta_decoder::decode(const delta_frame& frame) {
+	if (frame.keyframe) {
+		values_ = frame.values;
+		started_ = true;
+	} else if (!started_) {
+		throw invalid_argument("Delta frame without a keyframe");
+	} else {
+		for_each_field(data_fields{}, [&](auto field) {
+			typedef decltype(field) F;
+			const size_t index = field_index<F, data_fields>::value;
+			if (frame.mask & (1u << index)) {
+				if (F::counter) {
+					get<index>(values_) += get<index>(frame.values);
+				} else {
+					get<index>(values_) = get<index>(frame.values);
+				}
+			}
+		});
+	}
+	return record(frame.timestamp, data(values_), frame.period_ms,
+				  frame.stale);
+}
+
+} //namespace monitor
+} //namespace crossover
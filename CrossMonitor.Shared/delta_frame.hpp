@@ -0,0 +1,124 @@
+#pragma once
+
+#include "data.hpp"
+#include "data_fields.hpp"
+#include "record.hpp"
+
+#include <array>
+#include <string>
+
+namespace crossover {
+namespace monitor {
+
+/**
+ * Settings of delta reporting.
+ */
+struct delta_options final {
+	/**
+	 * Every keyframe_every-th record of a batch, the first included, is
+	 * sent whole; 1 sends every record whole.
+	 */
+	unsigned keyframe_every = 1;
+	/**
+	 * Per field, in data_fields order, how far the receiver's copy may be
+	 * off before the field is sent again; 0 sends every change.
+	 */
+	std::array<double, data_fields::size> deadbands;
+
+	delta_options() noexcept {
+		deadbands.fill(0);
+	}
+
+	/**
+	 * Sets the dead-band of the field named name (its wire name).
+	 * Throws std::invalid_argument if there is no such field or the
+	 * dead-band is negative.
+	 */
+	void set_deadband(const std::string& name, double deadband);
+};
+
+/**
+ * A record as sent in delta reporting. A keyframe carries every field. A
+ * delta frame carries the fields whose mask bit (1 << position in
+ * data_fields) is set: gauges with their value, counters with their
+ * change since the previous frame, modulo 2^64 so counter resets are
+ * carried exactly too. Fields left out keep their previous value.
+ */
+struct delta_frame final {
+	unsigned long long timestamp = 0;
+	unsigned period_ms = 0;
+	/**
+	 * See record::stale.
+	 */
+	unsigned stale = 0;
+	bool keyframe = true;
+	unsigned mask = 0;
+	data::values values;
+};
+
+static_assert(data_fields::size <= 32, "delta_frame mask too narrow");
+
+/**
+ * Turns records into delta frames. The encoder tracks what the receiver
+ * rebuilt rather than the last record, so a field drifting slowly is sent
+ * once the receiver's copy is off by more than its dead-band: the error is
+ * bounded by the dead-band and never accumulates, and zero dead-bands
+ * rebuild the records exactly.
+ * Deltas only hold within a batch: call reset() before each one, so a
+ * lost batch never corrupts the next.
+ */
+class delta_encoder final {
+public:
+	/**
+	 * Throws std::invalid_argument if keyframe_every is zero or a
+	 * dead-band is negative.
+	 */
+	explicit delta_encoder(const delta_options& options);
+
+	/**
+	 * Fills frame with the next record.
+	 */
+	void encode(const record& r, delta_frame& frame) noexcept;
+	/**
+	 * Makes the next frame a keyframe.
+	 */
+	void reset() noexcept {
+		count_ = 0;
+	}
+
+	const delta_options& options() const noexcept {
+		return options_;
+	}
+
+private:
+	const delta_options options_;
+	unsigned count_ = 0;
+	/**
+	 * The receiver's copy of every field.
+	 */
+	data::values sent_;
+};
+
+/**
+ * Rebuilds records from the frames of a delta_encoder, on the receiving
+ * side.
+ */
+class delta_decoder final {
+public:
+	/**
+	 * Throws std::invalid_argument if frame is a delta frame with no
+	 * keyframe before it since construction or reset(), or if a rebuilt
+	 * value is out of range.
+	 */
+	record decode(const delta_frame& frame);
+	void reset() noexcept {
+		started_ = false;
+	}
+
+private:
+	bool started_ = false;
+	data::values values_;
+};
+
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,228 @@
+#include "gorilla.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	void bit_writer::write(uint64_t value, unsigned count) noexcept {
+		while (count > 0) {
+			const unsigned used = static_cast<unsigned>(bits_ % 8);
+			const unsigned room = 8 - used;
+			const unsigned n = count < room ? count : room;
+			const unsigned chunk =
+				static_cast<unsigned>(value >> (count - n)) & ((1u << n) - 1);
+			unsigned char& byte = data_[bits_ / 8];
+			if (used == 0) {
+				byte = 0;
+			}
+			byte |= static_cast<unsigned char>(chunk << (room - n));
+			bits_ += n;
+			count -= n;
+		}
+	}
+
+	bool bit_reader::read(unsigned count, uint64_t& value) noexcept {
+		if (count > remaining()) {
+			return false;
+		}
+		uint64_t v = 0;
+		while (count > 0) {
+			const unsigned used = static_cast<unsigned>(position_ % 8);
+			const unsigned room = 8 - used;
+			const unsigned n = count < room ? count : room;
+			const unsigned byte = data_[position_ / 8];
+			v = (v << n) | ((byte >> (room - n)) & ((1u << n) - 1));
+			position_ += n;
+			count -= n;
+		}
+		value = v;
+		return true;
+	}
+
+	static uint64_t zigzag(uint64_t v) noexcept {
+		return (v << 1) ^ (0 - (v >> 63));
+	}
+
+	static uint64_t unzigzag(uint64_t v) noexcept {
+		return (v >> 1) ^ (0 - (v & 1));
+	}
+
+	delta_encoder::delta_encoder(const unsigned(&widths)[3]) noexcept {
+		memcpy(widths_, widths, sizeof(widths_));
+	}
+
+	void delta_encoder::write(bit_writer& out, uint64_t value) noexcept {
+		if (count_++ == 0) {
+			out.write(value, 64);
+			previous_ = value;
+			delta_ = 0;
+			return;
+		}
+		// Differences wrap around, so counters going backwards cost no
+		// more than forwards.
+		const uint64_t delta = value - previous_;
+		const uint64_t z = zigzag(delta - delta_);
+		previous_ = value;
+		delta_ = delta;
+		if (z == 0) {
+			out.write(0, 1);
+		} else if (z < (1ull << widths_[0])) {
+			out.write(2, 2);
+			out.write(z, widths_[0]);
+		} else if (z < (1ull << widths_[1])) {
+			out.write(6, 3);
+			out.write(z, widths_[1]);
+		} else if (z < (1ull << widths_[2])) {
+			out.write(14, 4);
+			out.write(z, widths_[2]);
+		} else {
+			out.write(15, 4);
+			out.write(z, 64);
+		}
+	}
+
+	delta_decoder::delta_decoder(const unsigned(&widths)[3]) noexcept {
+		memcpy(widths_, widths, sizeof(widths_));
+	}
+
+	bool delta_decoder::read(bit_reader& in, uint64_t& value) noexcept {
+		if (count_ == 0) {
+			if (!in.read(64, previous_)) {
+				return false;
+			}
+			++count_;
+			delta_ = 0;
+			value = previous_;
+			return true;
+		}
+		unsigned bucket = 0;
+		uint64_t bit = 1;
+		while (bucket < 4 && in.read(1, bit) && bit == 1) {
+			++bucket;
+		}
+		if (bit == 1 && bucket < 4) {
+			// The stream ended within the prefix
+			return false;
+		}
+		uint64_t z = 0;
+		if (bucket > 0 && !in.read(bucket < 4 ? widths_[bucket - 1] : 64, z)) {
+			return false;
+		}
+		delta_ += unzigzag(z);
+		previous_ += delta_;
+		++count_;
+		value = previous_;
+		return true;
+	}
+
+	static unsigned leading_zeros(uint32_t v) noexcept {
+		unsigned n = 0;
+		for (uint32_t mask = 0x80000000u; mask != 0 && (v & mask) == 0;
+			 mask >>= 1) {
+			++n;
+		}
+		return n;
+	}
+
+	static unsigned trailing_zeros(uint32_t v) noexcept {
+		unsigned n = 0;
+		for (uint32_t mask = 1; mask != 0 && (v & mask) == 0; mask <<= 1) {
+			++n;
+		}
+		return n;
+	}
+
+	static uint32_t float_bits(float value) noexcept {
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	static float bits_float(uint32_t bits) noexcept {
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	void xor_encoder::write(bit_writer& out, float value) noexcept {
+		const uint32_t bits = float_bits(value);
+		if (count_++ == 0) {
+			out.write(bits, 32);
+			previous_ = bits;
+			// No window yet: forces the first change to carry one
+			leading_ = 32;
+			trailing_ = 0;
+			return;
+		}
+		const uint32_t x = bits ^ previous_;
+		previous_ = bits;
+		if (x == 0) {
+			out.write(0, 1);
+			return;
+		}
+		const unsigned leading = leading_zeros(x);
+		const unsigned trailing = trailing_zeros(x);
+		if (leading >= leading_ && trailing >= trailing_) {
+			out.write(2, 2);
+			out.write(x >> trailing_, 32 - leading_ - trailing_);
+			return;
+		}
+		const unsigned meaningful = 32 - leading - trailing;
+		out.write(3, 2);
+		out.write(leading, 5);
+		out.write(meaningful - 1, 5);
+		out.write(x >> trailing, meaningful);
+		leading_ = leading;
+		trailing_ = trailing;
+	}
+
+	bool xor_decoder::read(bit_reader& in, float& value) noexcept {
+		uint64_t v = 0;
+		if (count_ == 0) {
+			if (!in.read(32, v)) {
+				return false;
+			}
+			++count_;
+			previous_ = static_cast<uint32_t>(v);
+			leading_ = 32;
+			trailing_ = 0;
+			value = bits_float(previous_);
+			return true;
+		}
+		uint64_t control = 0;
+		if (!in.read(1, control)) {
+			return false;
+		}
+		if (control == 1) {
+			if (!in.read(1, control)) {
+				return false;
+			}
+			if (control == 1) {
+				uint64_t leading = 0;
+				uint64_t meaningful = 0;
+				if (!in.read(5, leading) || !in.read(5, meaningful) ||
+					leading + meaningful + 1 > 32) {
+					return false;
+				}
+				leading_ = static_cast<unsigned>(leading);
+				trailing_ = 32 - leading_ - static_cast<unsigned>(meaningful) - 1;
+			} else if (leading_ >= 32) {
+				return false;
+			}
+			if (!in.read(32 - leading_ - trailing_, v)) {
+				return false;
+			}
+			previous_ ^= static_cast<uint32_t>(v) << trailing_;
+		}
+		++count_;
+		value = bits_float(previous_);
+		return true;
+	}
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * Appends bits, most significant first, to a caller owned buffer.
+	 * Callers check capacity before writing, so writes never fail.
+	 */
+	class bit_writer final {
+	public:
+		bit_writer() noexcept = default;
+		bit_writer(unsigned char* data, std::size_t bytes) noexcept :
+			data_(data), capacity_(bytes * 8) {
+		}
+
+		/**
+		 * Appends the low count bits of value, count up to 64.
+		 * bits() + count must not exceed capacity().
+		 */
+		void write(std::uint64_t value, unsigned count) noexcept;
+
+		std::size_t bits() const noexcept {
+			return bits_;
+		}
+		std::size_t bytes() const noexcept {
+			return (bits_ + 7) / 8;
+		}
+		std::size_t capacity() const noexcept {
+			return capacity_;
+		}
+		std::size_t remaining() const noexcept {
+			return capacity_ - bits_;
+		}
+
+	private:
+		unsigned char* data_ = nullptr;
+		std::size_t capacity_ = 0;
+		std::size_t bits_ = 0;
+	};
+
+	/**
+	 * Reads back what a bit_writer wrote.
+	 */
+	class bit_reader final {
+	public:
+		bit_reader(const unsigned char* data, std::size_t bits) noexcept :
+			data_(data), size_(bits) {
+		}
+
+		/**
+		 * Reads count bits, count up to 64, into value.
+		 * @return false, reading nothing, past the end.
+		 */
+		bool read(unsigned count, std::uint64_t& value) noexcept;
+
+		std::size_t remaining() const noexcept {
+			return size_ - position_;
+		}
+
+	private:
+		const unsigned char* data_;
+		std::size_t size_;
+		std::size_t position_ = 0;
+	};
+
+	/**
+	 * Delta-of-delta coding of an integer series, as Gorilla codes its
+	 * timestamps: the first value is written whole, the next ones as the
+	 * change of their difference to the previous value, zigzag coded in
+	 * the smallest of four buckets:
+	 * '0' for no change, '10', '110' and '1110' followed by widths[0],
+	 * widths[1] and widths[2] bits, or '1111' followed by 64 bits.
+	 * Regular series, such as timestamps or counters growing at a steady
+	 * rate, take one or a few bits per value.
+	 */
+	class delta_encoder final {
+	public:
+		/**
+		 * Most bits written for a value.
+		 */
+		static const unsigned max_bits = 4 + 64;
+
+		explicit delta_encoder(const unsigned(&widths)[3]) noexcept;
+
+		void write(bit_writer& out, std::uint64_t value) noexcept;
+		/**
+		 * Starts a new series: the next value is written whole.
+		 */
+		void reset() noexcept {
+			count_ = 0;
+		}
+
+	private:
+		unsigned widths_[3];
+		std::uint64_t previous_ = 0;
+		std::uint64_t delta_ = 0;
+		unsigned long long count_ = 0;
+	};
+
+	class delta_decoder final {
+	public:
+		explicit delta_decoder(const unsigned(&widths)[3]) noexcept;
+
+		/**
+		 * @return false if the stream ended or is malformed.
+		 */
+		bool read(bit_reader& in, std::uint64_t& value) noexcept;
+
+	private:
+		unsigned widths_[3];
+		std::uint64_t previous_ = 0;
+		std::uint64_t delta_ = 0;
+		unsigned long long count_ = 0;
+	};
+
+	/**
+	 * XOR coding of a float series (Gorilla): the first value is written
+	 * whole, the next ones as their XOR with the previous value:
+	 * '0' when equal, '10' and the meaningful bits when they fall within
+	 * the previous leading and trailing zeros, or '11', 5 bits of leading
+	 * zeros, 5 bits of meaningful bit count minus one and the meaningful
+	 * bits. Slowly changing values share their sign, exponent and high
+	 * mantissa bits, which the XOR turns into leading zeros.
+	 */
+	class xor_encoder final {
+	public:
+		/**
+		 * Most bits written for a value.
+		 */
+		static const unsigned max_bits = 2 + 5 + 5 + 32;
+
+		void write(bit_writer& out, float value) noexcept;
+		void reset() noexcept {
+			count_ = 0;
+		}
+
+	private:
+		std::uint32_t previous_ = 0;
+		unsigned leading_ = 0;
+		unsigned trailing_ = 0;
+		unsigned long long count_ = 0;
+	};
+
+	class xor_decoder final {
+	public:
+		/**
+		 * @return false if the stream ended or is malformed.
+		 */
+		bool read(bit_reader& in, float& value) noexcept;
+
+	private:
+		std::uint32_t previous_ = 0;
+		unsigned leading_ = 0;
+		unsigned trailing_ = 0;
+		unsigned long long count_ = 0;
+	};
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,55 @@
+#include "gzip.hpp"
+
+#include <boost/iostreams/copy.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/concepts.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+using namespace std;
+namespace io = boost::iostreams;
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+/**
+ * Sink appending to a byte vector, which back_inserter does not support.
+ */
+class byte_sink final : public io::sink {
+public:
+	explicit byte_sink(vector<unsigned char>& out) noexcept : out_(&out) {
+	}
+
+	streamsize write(const char* s, streamsize n) {
+		out_->insert(out_->end(), s, s + n);
+		return n;
+	}
+
+private:
+	vector<unsigned char>* out_;
+};
+
+void gzip_compress(const char* in, size_t size, vector<unsigned char>& out) {
+	out.clear();
+	// Reports are small and sent often, trading some ratio for speed.
+	io::filtering_ostream stream;
+	stream.push(io::gzip_compressor(io::gzip_params(io::gzip::best_speed)));
+	stream.push(byte_sink(out));
+	stream.write(in, static_cast<streamsize>(size));
+	// Popping the compressor flushes it and writes the gzip trailer.
+	stream.reset();
+}
+
+void gzip_decompress(const unsigned char* in, size_t size, string& out) {
+	out.clear();
+	io::filtering_istream stream;
+	stream.push(io::gzip_decompressor());
+	stream.push(io::array_source(reinterpret_cast<const char*>(in), size));
+	io::copy(stream, io::back_inserter(out));
+}
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+/**
+ * Replaces the contents of out with the gzip (RFC 1952) compressed form of
+ * the size bytes at in. out keeps its capacity, so reusing it between calls
+ * avoids reallocations once it reached its working size.
+ * Throws std::exception derived exceptions on failure.
+ */
+void gzip_compress(const char* in, std::size_t size,
+				   std::vector<unsigned char>& out);
+
+/**
+ * Replaces the contents of out with the decompressed form of the gzip
+ * stream of size bytes at in.
+ * Throws std::exception derived exceptions if the stream is corrupt.
+ */
+void gzip_decompress(const unsigned char* in, std::size_t size,
+					 std::string& out);
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,225 @@
+#include "json_writer.hpp"
+#include "data_fields.hpp"
+#include "delta_frame.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+
+static const char digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+char* format_unsigned(unsigned long long v, char* end) noexcept {
+	char* p = end;
+	while (v >= 100) {
+		const unsigned i = static_cast<unsigned>(v % 100) * 2;
+		v /= 100;
+		*--p = digit_pairs[i + 1];
+		*--p = digit_pairs[i];
+	}
+	if (v >= 10) {
+		const unsigned i = static_cast<unsigned>(v) * 2;
+		*--p = digit_pairs[i + 1];
+		*--p = digit_pairs[i];
+	} else {
+		*--p = static_cast<char>('0' + v);
+	}
+	return p;
+}
+
+json_writer::json_writer() {
+	buffer_.reserve(512);
+}
+
+void json_writer::clear() noexcept {
+	buffer_.clear();
+	first_ = true;
+	after_key_ = false;
+}
+
+void json_writer::separator() {
+	if (after_key_) {
+		after_key_ = false;
+	} else if (!first_) {
+		buffer_.push_back(',');
+	}
+	first_ = false;
+}
+
+void json_writer::begin_object() {
+	separator();
+	buffer_.push_back('{');
+	first_ = true;
+}
+
+void json_writer::end_object() {
+	buffer_.push_back('}');
+	first_ = false;
+}
+
+void json_writer::begin_array() {
+	separator();
+	buffer_.push_back('[');
+	first_ = true;
+}
+
+void json_writer::end_array() {
+	buffer_.push_back(']');
+	first_ = false;
+}
+
+void json_writer::key(const char* name) {
+	separator();
+	buffer_.push_back('"');
+	buffer_.append(name);
+	buffer_.append("\":", 2);
+	after_key_ = true;
+}
+
+void json_writer::value(unsigned v) {
+	value(static_cast<unsigned long long>(v));
+}
+
+void json_writer::value(unsigned long long v) {
+	separator();
+	char digits[20];
+	char* const end = digits + sizeof(digits);
+	const char* start = format_unsigned(v, end);
+	buffer_.append(start, static_cast<size_t>(end - start));
+}
+
+void json_writer::value(long long v) {
+	if (v >= 0) {
+		value(static_cast<unsigned long long>(v));
+		return;
+	}
+
+	separator();
+	char digits[21];
+	char* const end = digits + sizeof(digits);
+	// Negated as unsigned, which also holds the magnitude of LLONG_MIN
+	char* start = format_unsigned(0ULL - static_cast<unsigned long long>(v), end);
+	*--start = '-';
+	buffer_.append(start, static_cast<size_t>(end - start));
+}
+
+void json_writer::value(float v) {
+	value(static_cast<double>(v));
+}
+
+void json_writer::value(double v) {
+	// Integral values (the common case for percentages read from counters
+	// and every value below 2^53) print the same under "%.17g" as integers.
+	if (v >= 0 && v < 9007199254740992.0 && !signbit(v) &&
+		v == floor(v)) {
+		value(static_cast<unsigned long long>(v));
+		return;
+	}
+
+	separator();
+	// The application never changes the C locale, so the decimal point is
+	// always '.', as cpprest produces.
+	char number[32];
+	const int n = snprintf(number, sizeof(number), "%.17g", v);
+	if (n > 0) {
+		buffer_.append(number, static_cast<size_t>(n));
+	}
+}
+
+void json_writer::value(const char* s) {
+	separator();
+	buffer_.push_back('"');
+	for (; *s != '\0'; ++s) {
+		const unsigned char c = static_cast<unsigned char>(*s);
+		if (c == '"' || c == '\\') {
+			buffer_.push_back('\\');
+			buffer_.push_back(static_cast<char>(c));
+		} else if (c < 0x20) {
+			static const char hex[] = "0123456789abcdef";
+			const char escaped[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf] };
+			buffer_.append(escaped, sizeof(escaped));
+		} else {
+			buffer_.push_back(static_cast<char>(c));
+		}
+	}
+	buffer_.push_back('"');
+}
+
+void json_writer::fields(const data& d) {
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		key(F::name());
+		value(F::get(d));
+	});
+}
+
+void json_writer::write(const data& d) {
+	begin_object();
+	fields(d);
+	end_object();
+}
+
+void json_writer::write(const record& r) {
+	begin_object();
+	key("timestamp");
+	value(r.timestamp);
+	if (r.period_ms != 0) {
+		key("period_ms");
+		value(r.period_ms);
+	}
+	if (r.stale != 0) {
+		key("stale");
+		value(r.stale);
+	}
+	fields(r.sample);
+	end_object();
+}
+
+void json_writer::write(const delta_frame& frame) {
+	begin_object();
+	key("timestamp");
+	value(frame.timestamp);
+	if (frame.period_ms != 0) {
+		key("period_ms");
+		value(frame.period_ms);
+	}
+	if (frame.stale != 0) {
+		key("stale");
+		value(frame.stale);
+	}
+	if (!frame.keyframe) {
+		key("delta");
+		value(1u);
+	}
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		const size_t index = field_index<F, data_fields>::value;
+		if (frame.keyframe || (frame.mask & (1u << index))) {
+			const typename F::type v = get<index>(frame.values);
+			key(F::name());
+			if (F::counter && !frame.keyframe) {
+				value(static_cast<long long>(v));
+			} else {
+				value(v);
+			}
+		}
+	});
+	end_object();
+}
+
+} //namespace monitor
+} //namespace crossover
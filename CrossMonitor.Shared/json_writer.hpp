@@ -0,0 +1,96 @@
+#pragma once
+
+#include "data.hpp"
+#include "record.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace crossover {
+namespace monitor {
+
+struct delta_frame;
+
+/**
+ * Streaming JSON writer appending to a buffer that is reused between
+ * documents, so once it reached its working size no further allocations
+ * happen. Output is compact and numbers are formatted the way cpprest's
+ * json::value::to_string does (integers verbatim, doubles as "%.17g"), so
+ * documents are byte for byte identical to the ones built with cpprest.
+ * Keys are written as given, they must not need escaping.
+ */
+class json_writer final {
+public:
+	json_writer();
+
+	/**
+	 * Starts a new document, keeping the buffer capacity.
+	 */
+	void clear() noexcept;
+
+	void begin_object();
+	void end_object();
+	void begin_array();
+	void end_array();
+	/**
+	 * Writes an object key, preceded by a comma if needed.
+	 */
+	void key(const char* name);
+
+	void value(unsigned v);
+	void value(unsigned long long v);
+	void value(long long v);
+	void value(float v);
+	void value(double v);
+	/**
+	 * Writes s as a JSON string, escaping quotes, backslashes and control
+	 * characters.
+	 */
+	void value(const char* s);
+
+	/**
+	 * Writes every data field as a key/value pair of the current object.
+	 */
+	void fields(const data& d);
+	/**
+	 * Writes d as a complete object.
+	 */
+	void write(const data& d);
+	/**
+	 * Writes r as a complete object, its timestamp first, followed by its
+	 * period_ms unless unknown and its stale probes mask unless none was.
+	 */
+	void write(const record& r);
+	/**
+	 * Writes frame as a complete object. A keyframe is written as its
+	 * record; a delta frame adds "delta":1 and holds only the fields of its
+	 * mask, counters as signed changes.
+	 */
+	void write(const delta_frame& frame);
+
+	const std::string& str() const noexcept {
+		return buffer_;
+	}
+	const char* c_str() const noexcept {
+		return buffer_.c_str();
+	}
+	std::size_t size() const noexcept {
+		return buffer_.size();
+	}
+
+private:
+	void separator();
+
+	std::string buffer_;
+	bool first_ = true;
+	bool after_key_ = false;
+}; //class json_writer
+
+/**
+ * Writes the decimal representation of v ending at end, returns its start.
+ * Needs 20 chars of room.
+ */
+char* format_unsigned(unsigned long long v, char* end) noexcept;
+
+} //namespace monitor
+} //namespace crossover
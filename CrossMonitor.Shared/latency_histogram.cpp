@@ -0,0 +1,124 @@
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * Buckets per power of two, as a number of bits.
+	 */
+	static const unsigned sub_bits = 4;
+	static const unsigned long long sub_count = 1ull << sub_bits;
+	/**
+	 * Values from 2^max_bits on count in the last bucket.
+	 */
+	static const unsigned max_bits = 40;
+
+	static_assert(latency_histogram::bucket_count ==
+		sub_count + (max_bits - sub_bits) * sub_count,
+		"Bucket count does not match the range");
+
+	/**
+	 * Position of the highest bit set in v, v not zero.
+	 */
+	static unsigned highest_bit(unsigned long long v) noexcept {
+		unsigned n = 0;
+		for (unsigned shift = 32; shift != 0; shift /= 2) {
+			if (v >> shift) {
+				v >>= shift;
+				n += shift;
+			}
+		}
+		return n;
+	}
+
+	size_t latency_histogram::bucket(unsigned long long ns) noexcept {
+		if (ns < sub_count) {
+			return static_cast<size_t>(ns);
+		}
+		const unsigned msb = highest_bit(ns);
+		if (msb >= max_bits) {
+			return bucket_count - 1;
+		}
+		const unsigned shift = msb - sub_bits;
+		return static_cast<size_t>(sub_count + shift * sub_count +
+			((ns >> shift) - sub_count));
+	}
+
+	unsigned long long latency_histogram::bucket_low(size_t b) noexcept {
+		if (b < sub_count) {
+			return b;
+		}
+		const size_t shift = (b - sub_count) / sub_count;
+		return (sub_count + (b - sub_count) % sub_count) << shift;
+	}
+
+	unsigned long long latency_histogram::bucket_width(size_t b) noexcept {
+		return b < sub_count ? 1 : 1ull << ((b - sub_count) / sub_count);
+	}
+
+	latency_histogram::latency_histogram() noexcept {
+		reset();
+	}
+
+	void latency_histogram::record(unsigned long long ns) noexcept {
+		counts_[bucket(ns)].fetch_add(1, memory_order_relaxed);
+		count_.fetch_add(1, memory_order_relaxed);
+		sum_.fetch_add(ns, memory_order_relaxed);
+		unsigned long long m = max_.load(memory_order_relaxed);
+		while (ns > m &&
+			   !max_.compare_exchange_weak(m, ns, memory_order_relaxed)) {
+		}
+	}
+
+	double latency_histogram::mean() const noexcept {
+		const unsigned long long n = count();
+		return n == 0 ? 0 :
+			static_cast<double>(sum_.load(memory_order_relaxed)) / n;
+	}
+
+	unsigned long long latency_histogram::quantile(double q) const noexcept {
+		// Ranks are taken from the buckets themselves so a value being
+		// recorded cannot make the walk run past the last one.
+		unsigned long long total = 0;
+		for (const auto& c : counts_) {
+			total += c.load(memory_order_relaxed);
+		}
+		if (total == 0) {
+			return 0;
+		}
+		if (q >= 1) {
+			return max();
+		}
+		q = std::max(0.0, q);
+		const unsigned long long rank = std::max(1ull,
+			static_cast<unsigned long long>(ceil(q * total)));
+
+		unsigned long long seen = 0;
+		size_t b = 0;
+		for (; b < bucket_count - 1; ++b) {
+			seen += counts_[b].load(memory_order_relaxed);
+			if (seen >= rank) {
+				break;
+			}
+		}
+		return min(bucket_low(b) + bucket_width(b) / 2, max());
+	}
+
+	void latency_histogram::reset() noexcept {
+		for (auto& c : counts_) {
+			c.store(0, memory_order_relaxed);
+		}
+		count_.store(0, memory_order_relaxed);
+		sum_.store(0, memory_order_relaxed);
+		max_.store(0, memory_order_relaxed);
+	}
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
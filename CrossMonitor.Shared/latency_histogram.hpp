@@ -0,0 +1,104 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * Histogram of durations in nanoseconds with fixed log-linear buckets,
+	 * as HDR histograms have: below 16 ns one bucket per nanosecond, then
+	 * 16 buckets per power of two, so a value is known within 1/16th of
+	 * itself, up to 2^40 ns (about 18 minutes); longer ones count in the
+	 * last bucket. The maximum is kept exactly.
+	 * Recording is three relaxed atomic additions and a compare exchange
+	 * at most, it never allocates nor blocks, so values may be recorded
+	 * from any thread while another reads the histogram.
+	 */
+	class latency_histogram final : public boost::noncopyable {
+	public:
+		static const std::size_t bucket_count = 592;
+
+		latency_histogram() noexcept;
+
+		void record(unsigned long long ns) noexcept;
+
+		unsigned long long count() const noexcept {
+			return count_.load(std::memory_order_relaxed);
+		}
+		unsigned long long max() const noexcept {
+			return max_.load(std::memory_order_relaxed);
+		}
+		/**
+		 * Mean of the values recorded, 0 when empty.
+		 */
+		double mean() const noexcept;
+		/**
+		 * Estimate of the q quantile, q in [0, 1]: the middle of the bucket
+		 * holding it, within 1/32nd of the true value, or the exact max()
+		 * if lower; quantile 1 is the exact max(). 0 when empty.
+		 */
+		unsigned long long quantile(double q) const noexcept;
+
+		/**
+		 * Forgets every value. Values recorded meanwhile by other threads
+		 * may be partly forgotten.
+		 */
+		void reset() noexcept;
+
+		/**
+		 * Bucket a value counts in.
+		 */
+		static std::size_t bucket(unsigned long long ns) noexcept;
+		/**
+		 * Smallest value counted in bucket b.
+		 */
+		static unsigned long long bucket_low(std::size_t b) noexcept;
+		/**
+		 * Values counted in bucket b, 1 up to bucket 31 then doubling every
+		 * 16 buckets.
+		 */
+		static unsigned long long bucket_width(std::size_t b) noexcept;
+
+	private:
+		std::atomic<unsigned long long> counts_[bucket_count];
+		std::atomic<unsigned long long> count_;
+		std::atomic<unsigned long long> sum_;
+		std::atomic<unsigned long long> max_;
+	};
+
+	/**
+	 * Measures consecutive steps with the steady clock, the monotonic
+	 * clock with the lowest overhead on each platform (QueryPerformance-
+	 * Counter on Windows, clock_gettime on Linux).
+	 */
+	class stopwatch final {
+	public:
+		stopwatch() noexcept : start_(std::chrono::steady_clock::now()) {
+		}
+
+		/**
+		 * Nanoseconds since construction or the previous lap, which
+		 * starts the next one.
+		 */
+		unsigned long long lap() noexcept {
+			const auto now = std::chrono::steady_clock::now();
+			const auto elapsed = now - start_;
+			start_ = now;
+			return static_cast<unsigned long long>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					elapsed).count());
+		}
+
+	private:
+		std::chrono::steady_clock::time_point start_;
+	};
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
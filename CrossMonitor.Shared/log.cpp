@@ -3,30 +3,95 @@
 #include <boost/log/core.hpp>
 #include <boost/log/trivial.hpp>
 #include <boost/log/expressions.hpp>
-#include <boost/log/sinks/text_file_backend.hpp>
-#include <boost/log/utility/setup/file.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/unlocked_frontend.hpp>
 #include <boost/log/utility/setup/common_attributes.hpp>
 #include <boost/log/sources/severity_logger.hpp>
 #include <boost/log/sources/record_ostream.hpp>
 
+#include <memory>
+#include <mutex>
+
 #define LOG CROSSOVER_MONITOR_LOG
 
 namespace logging = boost::log;
-namespace keywords = boost::log::keywords;
+namespace sinks = boost::log::sinks;
 
 namespace crossover {
 	namespace monitor {
 		namespace log {
 
+			/**
+			 * Hands formatted records to the writer thread; the writer
+			 * synchronizes, so records are fed concurrently.
+			 */
+			class file_backend final :
+				public sinks::basic_formatted_sink_backend<char,
+					sinks::concurrent_feeding> {
+			public:
+				explicit file_backend(const file_options& options) :
+					writer_(options) {
+				}
+
+				void consume(const logging::record_view&,
+							 const string_type& message) {
+					writer_.write(message.data(), message.size());
+				}
+				void flush() {
+					writer_.flush();
+				}
+
+				async_file_writer& writer() noexcept {
+					return writer_;
+				}
+
+			private:
+				async_file_writer writer_;
+			};
+
+			typedef sinks::unlocked_sink<file_backend> file_sink;
+
+			static std::mutex file_mutex;
+			static boost::shared_ptr<file_sink> file;
+			static file_options defaults;
+
 			void init() noexcept {
 				//Left blank for now
 			}
+
+			void set_file_options(const file_options& options) noexcept {
+				const std::lock_guard<std::mutex> lock(file_mutex);
+				defaults.queue_bytes = options.queue_bytes;
+				defaults.flush_interval = options.flush_interval;
+				defaults.rotation_bytes = options.rotation_bytes;
+				defaults.max_files = options.max_files;
+			}
+
 			void set_file(const std::string& filename) noexcept {
-				logging::add_file_log
-				(
-					keywords::file_name = filename,
-					keywords::auto_flush = true
-				);
+				try {
+					file_options options;
+					{
+						const std::lock_guard<std::mutex> lock(file_mutex);
+						options = defaults;
+					}
+					options.filename = filename;
+					set_file(options);
+				}
+				catch (const std::exception& e) {
+					LOG(error) << "Failed to set the log file: " << e.what();
+				}
+			}
+
+			void set_file(const file_options& options) {
+				auto sink = boost::make_shared<file_sink>(
+					boost::make_shared<file_backend>(options));
+				const std::lock_guard<std::mutex> lock(file_mutex);
+				if (file) {
+					logging::core::get()->remove_sink(file);
+				}
+				logging::core::get()->add_sink(sink);
+				// The previous backend writes what it queued when released
+				file = sink;
 
 				logging::core::get()->set_filter
 				(
@@ -34,6 +99,26 @@ namespace crossover {
 				);
 			}
 
+			void flush() noexcept {
+				const std::lock_guard<std::mutex> lock(file_mutex);
+				if (file) {
+					file->locked_backend()->flush();
+				}
+			}
+
+			void shutdown() noexcept {
+				const std::lock_guard<std::mutex> lock(file_mutex);
+				if (file) {
+					logging::core::get()->remove_sink(file);
+					file.reset();
+				}
+			}
+
+			unsigned long long dropped_records() noexcept {
+				const std::lock_guard<std::mutex> lock(file_mutex);
+				return file ? file->locked_backend()->writer().dropped() : 0;
+			}
+
 		} //namespace log
 	} //namespace monitor
 } //namespace crossover
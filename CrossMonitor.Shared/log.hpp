@@ -1,5 +1,7 @@
 #pragma once
 
+#include "log_file.hpp"
+
 #include <boost/log/trivial.hpp>
 
 #include <string>
@@ -23,9 +25,37 @@ namespace log {
 	void init() noexcept;
 	/**
 	 * If called logs will be written to a file as well as the console.
+	 * Records are written by a background thread, see async_file_writer,
+	 * with the options given to set_file_options().
 	 * @param filename path to the log file.
 	 */
 	void set_file(const std::string& filename) noexcept;
+	/**
+	 * Queue, flush interval and rotation used by set_file(filename); the
+	 * file name in options is ignored. Call before set_file().
+	 */
+	void set_file_options(const file_options& options) noexcept;
+	/**
+	 * Same as set_file(filename) with the queue, flush interval and
+	 * rotation of options. Replaces a file set before.
+	 * Throws std::invalid_argument if the options are invalid and
+	 * std::runtime_error if the file cannot be opened.
+	 */
+	void set_file(const file_options& options);
+	/**
+	 * Blocks until every record logged so far is written to the file.
+	 */
+	void flush() noexcept;
+	/**
+	 * Writes what is queued, closes the file and stops its thread.
+	 * Call before exiting the application.
+	 */
+	void shutdown() noexcept;
+	/**
+	 * Records lost by the log file because its queue was full or it could
+	 * not be written.
+	 */
+	unsigned long long dropped_records() noexcept;
 
 } //namespace log
 } //namespace monitor
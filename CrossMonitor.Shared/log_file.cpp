@@ -0,0 +1,167 @@
+#include "log_file.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace log {
+
+	static const file_options& checked_options(const file_options& options) {
+		if (options.filename.empty()) {
+			throw invalid_argument("Log file name cannot be empty");
+		}
+		if (options.queue_bytes == 0) {
+			throw invalid_argument("Log queue size cannot be zero");
+		}
+		if (options.flush_interval.count() <= 0) {
+			throw invalid_argument("Log flush interval must be positive");
+		}
+		return options;
+	}
+
+	static string rotated_name(const string& filename, unsigned index) {
+		return filename + "." + to_string(index);
+	}
+
+	async_file_writer::async_file_writer(const file_options& options) :
+		options_(checked_options(options)),
+		file_(options.filename, ios::out | ios::trunc) {
+		if (!file_) {
+			throw runtime_error("Failed to open log file " + options.filename);
+		}
+		pending_.reserve(options.queue_bytes);
+		batch_.reserve(options.queue_bytes);
+		thread_ = thread([this]() { run(); });
+	}
+
+	async_file_writer::~async_file_writer() {
+		{
+			const lock_guard<mutex> lock(m_);
+			stopping_ = true;
+		}
+		wake_.notify_one();
+		thread_.join();
+	}
+
+	bool async_file_writer::write(const char* text, size_t size) noexcept {
+		bool wake = false;
+		{
+			const lock_guard<mutex> lock(m_);
+			if (pending_.size() + size + 1 > options_.queue_bytes) {
+				++dropped_;
+				return false;
+			}
+			// Fits in the reserved storage, so this does not allocate
+			pending_.append(text, size);
+			pending_ += '\n';
+			++queued_;
+			wake = pending_.size() >= options_.queue_bytes / 2;
+		}
+		if (wake) {
+			wake_.notify_one();
+		}
+		return true;
+	}
+
+	void async_file_writer::flush() noexcept {
+		unique_lock<mutex> lock(m_);
+		const unsigned long long target = queued_;
+		flush_requested_ = true;
+		wake_.notify_one();
+		done_.wait(lock, [&]() { return processed_ >= target; });
+	}
+
+	unsigned long long async_file_writer::written() const noexcept {
+		const lock_guard<mutex> lock(m_);
+		return written_;
+	}
+
+	unsigned long long async_file_writer::dropped() const noexcept {
+		const lock_guard<mutex> lock(m_);
+		return dropped_;
+	}
+
+	unsigned long long async_file_writer::rotations() const noexcept {
+		const lock_guard<mutex> lock(m_);
+		return rotations_;
+	}
+
+	void async_file_writer::run() noexcept {
+		unique_lock<mutex> lock(m_);
+		for (;;) {
+			wake_.wait_for(lock, options_.flush_interval, [this]() {
+				return stopping_ || flush_requested_ ||
+					pending_.size() >= options_.queue_bytes / 2;
+			});
+			flush_requested_ = false;
+
+			if (!pending_.empty()) {
+				batch_.swap(pending_);
+				const unsigned long long records = queued_ - processed_;
+				lock.unlock();
+				const bool ok = write_batch();
+				batch_.clear();
+				lock.lock();
+				processed_ += records;
+				if (ok) {
+					written_ += records;
+				} else {
+					dropped_ += records;
+				}
+				if (ok && options_.rotation_bytes != 0 &&
+					file_bytes_ >= options_.rotation_bytes) {
+					lock.unlock();
+					rotate();
+					lock.lock();
+					++rotations_;
+				}
+			}
+			done_.notify_all();
+
+			if (stopping_ && pending_.empty()) {
+				break;
+			}
+		}
+	}
+
+	bool async_file_writer::write_batch() noexcept {
+		if (!file_.is_open()) {
+			return false;
+		}
+		file_.write(batch_.data(), static_cast<streamsize>(batch_.size()));
+		file_.flush();
+		if (!file_) {
+			file_.clear();
+			return false;
+		}
+		file_bytes_ += batch_.size();
+		return true;
+	}
+
+	void async_file_writer::rotate() noexcept {
+		file_.close();
+		const string& name = options_.filename;
+		try {
+			if (options_.max_files != 0) {
+				// rename fails on Windows if the target exists
+				remove(rotated_name(name, options_.max_files).c_str());
+				for (unsigned i = options_.max_files - 1; i >= 1; --i) {
+					rename(rotated_name(name, i).c_str(),
+						   rotated_name(name, i + 1).c_str());
+				}
+				rename(name.c_str(), rotated_name(name, 1).c_str());
+			}
+		} catch (const std::exception&) {
+			// Out of memory for the names: start over in the same file
+		}
+		file_.clear();
+		file_.open(name, ios::out | ios::trunc);
+		file_bytes_ = 0;
+	}
+
+} //namespace log
+} //namespace monitor
+} //namespace crossover
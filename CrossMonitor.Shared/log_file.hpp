@@ -0,0 +1,118 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace crossover {
+namespace monitor {
+namespace log {
+
+	struct file_options final {
+		std::string filename;
+		/**
+		 * Bytes of formatted records waiting for the writer thread; records
+		 * that do not fit are dropped and counted.
+		 */
+		std::size_t queue_bytes = 1024 * 1024;
+		/**
+		 * Longest time a record waits before being written and flushed.
+		 */
+		std::chrono::milliseconds flush_interval{ 1000 };
+		/**
+		 * Size in bytes at which the file is renamed to filename.1, the
+		 * older ones shifted to filename.2 and on, and a new one started.
+		 * 0 never rotates.
+		 */
+		unsigned long long rotation_bytes = 0;
+		/**
+		 * Rotated files kept besides the current one.
+		 */
+		unsigned max_files = 5;
+	};
+
+	/**
+	 * Log file written by a dedicated thread, so logging never waits for
+	 * the disk. Records are appended to a bounded in memory batch under a
+	 * short lock; the writer thread swaps the batch out, writes it at once
+	 * and flushes every flush_interval, or sooner when the batch is half
+	 * full. When the batch is full new records are dropped and counted.
+	 * Both batches keep their storage, so a steady load allocates nothing.
+	 */
+	class async_file_writer final : public boost::noncopyable {
+	public:
+		/**
+		 * Truncates the file and starts the writer thread.
+		 * Throws std::invalid_argument if the file name is empty, or
+		 * queue_bytes or flush_interval are zero, and std::runtime_error if
+		 * the file cannot be opened.
+		 */
+		explicit async_file_writer(const file_options& options);
+		/**
+		 * Writes whatever is queued and stops the writer thread.
+		 */
+		~async_file_writer();
+
+		/**
+		 * Queues text as one line. May be called from any thread.
+		 * @return false if the record did not fit in the queue and was
+		 *         dropped.
+		 */
+		bool write(const char* text, std::size_t size) noexcept;
+		/**
+		 * Blocks until every record queued before the call is written and
+		 * flushed to the file.
+		 */
+		void flush() noexcept;
+
+		/**
+		 * Records written to the file since construction.
+		 */
+		unsigned long long written() const noexcept;
+		/**
+		 * Records lost since construction, because the queue was full or
+		 * the file could not be written.
+		 */
+		unsigned long long dropped() const noexcept;
+		unsigned long long rotations() const noexcept;
+
+	private:
+		void run() noexcept;
+		/**
+		 * Writer thread only, without the lock.
+		 */
+		bool write_batch() noexcept;
+		void rotate() noexcept;
+
+		const file_options options_;
+		std::ofstream file_;
+		unsigned long long file_bytes_ = 0;
+
+		mutable std::mutex m_;
+		std::condition_variable wake_;
+		std::condition_variable done_;
+		/**
+		 * Filled by write(), swapped with batch_ by the writer thread.
+		 */
+		std::string pending_;
+		std::string batch_;
+		unsigned long long queued_ = 0;
+		unsigned long long written_ = 0;
+		unsigned long long processed_ = 0;
+		unsigned long long dropped_ = 0;
+		unsigned long long rotations_ = 0;
+		bool flush_requested_ = false;
+		bool stopping_ = false;
+
+		std::thread thread_;
+	}; //class async_file_writer
+
+} //namespace log
+} //namespace monitor
+} //namespace crossover
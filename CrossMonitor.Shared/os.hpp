@@ -13,6 +13,28 @@ namespace os {
  */
 void set_termination_handler(const std::function<void()>& handler) noexcept;
 
+/**
+ * Resources used by this process.
+ */
+struct self_usage final {
+	/**
+	 * User and system CPU time of every thread since start, in nanoseconds.
+	 */
+	unsigned long long cpu_time = 0;
+	unsigned long long resident_bytes = 0;
+	/**
+	 * Open handles on Windows, open file descriptors elsewhere.
+	 */
+	unsigned handles = 0;
+};
+
+/**
+ * Reads the resources used by this process, the fields that cannot be
+ * read set to zero.
+ * @return false if none could be read.
+ */
+bool read_self_usage(self_usage& out) noexcept;
+
 } //namespace os
 } //namespace monitor
 } //namespace crossover
@@ -0,0 +1,124 @@
+#include "os.hpp"
+#include "log.hpp"
+
+#include <dirent.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <cstdio>
+
+#include <mutex>
+#include <thread>
+
+#define LOG CROSSOVER_MONITOR_LOG
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace os {
+
+static mutex mutex_;
+function<void()> handler_;
+
+/**
+ * Termination signals are blocked and consumed by a dedicated thread with
+ * sigwait, so the handler runs in a normal thread context and may lock
+ * mutexes or notify condition variables.
+ * set_termination_handler must be called before any other thread is started
+ * for the signal mask to be inherited by them.
+ */
+static void signal_thread(sigset_t set) noexcept {
+	for (;;) {
+		int signal = 0;
+		if (sigwait(&set, &signal) != 0) {
+			LOG(error) << "sigwait failed, termination handler disabled";
+			return;
+		}
+		try {
+			lock_guard<mutex> lock(mutex_);
+			if (handler_) {
+				handler_();
+			}
+		} catch (const std::exception& e) {
+			LOG(error) << "Termination handler threw an exception: "
+					   << e.what();
+		} catch (...) {
+			LOG(error) << "Termination handler threw an unknown exception: ";
+		}
+	}
+}
+
+void set_termination_handler(const std::function<void()>& handler) noexcept {
+	lock_guard<mutex> lock(mutex_);
+	handler_ = handler;
+
+	static once_flag once;
+	call_once(once, [] {
+		sigset_t set;
+		sigemptyset(&set);
+		sigaddset(&set, SIGINT);
+		sigaddset(&set, SIGTERM);
+		sigaddset(&set, SIGHUP);
+
+		const int error = pthread_sigmask(SIG_BLOCK, &set, nullptr);
+		if (error != 0) {
+			LOG(error) << "Failed to set termination handler, code: "
+					   << error;
+			return;
+		}
+		try {
+			thread(signal_thread, set).detach();
+		} catch (const std::exception& e) {
+			LOG(error) << "Failed to set termination handler: " << e.what();
+		}
+	});
+}
+
+static unsigned count_open_fds() noexcept {
+	DIR* dir = opendir("/proc/self/fd");
+	if (!dir) {
+		return 0;
+	}
+	unsigned count = 0;
+	while (const dirent* entry = readdir(dir)) {
+		if (entry->d_name[0] != '.') {
+			++count;
+		}
+	}
+	closedir(dir);
+	// Less the descriptor of dir itself
+	return count > 0 ? count - 1 : 0;
+}
+
+static unsigned long long resident_bytes() noexcept {
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (!f) {
+		return 0;
+	}
+	unsigned long long size = 0, resident = 0;
+	const int read = fscanf(f, "%llu %llu", &size, &resident);
+	fclose(f);
+	return read == 2 ?
+		resident * static_cast<unsigned long long>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+bool read_self_usage(self_usage& out) noexcept {
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+		out.cpu_time =
+			(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ull +
+			(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ull;
+	} else {
+		out.cpu_time = 0;
+	}
+	out.resident_bytes = resident_bytes();
+	out.handles = count_open_fds();
+	return out.cpu_time != 0 || out.resident_bytes != 0 || out.handles != 0;
+}
+
+} //namespace os
+} //namespace monitor
+} //namespace crossover
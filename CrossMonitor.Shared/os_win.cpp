@@ -2,6 +2,7 @@
 #include "log.hpp"
 
 #include <Windows.h>
+#include <Psapi.h>
 
 #include <mutex>
 #include <thread>
@@ -52,6 +53,42 @@ void set_termination_handler(const std::function<void()>& handler) noexcept {
 	});
 }
 
+static unsigned long long to_ull(const FILETIME& time) noexcept {
+	return (static_cast<unsigned long long>(time.dwHighDateTime) << 32) |
+		time.dwLowDateTime;
+}
+
+bool read_self_usage(self_usage& out) noexcept {
+	const HANDLE self = GetCurrentProcess();
+	bool read = false;
+
+	FILETIME creation, end, kernel, user;
+	if (GetProcessTimes(self, &creation, &end, &kernel, &user)) {
+		// FILETIME counts 100 ns intervals
+		out.cpu_time = (to_ull(kernel) + to_ull(user)) * 100;
+		read = true;
+	} else {
+		out.cpu_time = 0;
+	}
+
+	PROCESS_MEMORY_COUNTERS memory;
+	if (GetProcessMemoryInfo(self, &memory, sizeof(memory))) {
+		out.resident_bytes = memory.WorkingSetSize;
+		read = true;
+	} else {
+		out.resident_bytes = 0;
+	}
+
+	DWORD handles = 0;
+	if (GetProcessHandleCount(self, &handles)) {
+		out.handles = handles;
+		read = true;
+	} else {
+		out.handles = 0;
+	}
+	return read;
+}
+
 } //namespace os
 } //namespace monitor
 } //namespace crossover
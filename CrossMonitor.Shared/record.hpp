@@ -0,0 +1,46 @@
+#pragma once
+
+#include "data.hpp"
+
+#include <chrono>
+
+namespace crossover {
+namespace monitor {
+
+/**
+ * A data sample and the time it was taken.
+ */
+struct record final {
+	/**
+	 * @param timestamp milliseconds since the Unix epoch.
+	 * @param sample the collected data.
+	 * @param period_ms sampling period in effect when it was taken, 0 if
+	 *                  unknown.
+	 * @param stale bit 1 << probe (see client::os::probe) set for the
+	 *              probes that missed their deadline: their fields repeat
+	 *              the last values read rather than fresh ones.
+	 */
+	record(unsigned long long timestamp, const data& sample,
+		   unsigned period_ms = 0, unsigned stale = 0) :
+		timestamp(timestamp), sample(sample), period_ms(period_ms),
+		stale(stale) {
+	}
+
+	unsigned long long timestamp;
+	data sample;
+	unsigned period_ms;
+	unsigned stale;
+};
+
+/**
+ * Milliseconds since the Unix epoch of a system clock time point.
+ */
+inline unsigned long long unix_milliseconds(
+	std::chrono::system_clock::time_point time) noexcept {
+	return static_cast<unsigned long long>(
+		std::chrono::duration_cast<std::chrono::milliseconds>(
+			time.time_since_epoch()).count());
+}
+
+} //namespace monitor
+} //namespace crossover
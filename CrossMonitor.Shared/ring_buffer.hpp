@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * Fixed capacity circular buffer. Storage is allocated once at
+	 * construction; pushing into a full buffer overwrites the oldest
+	 * element. Not thread safe.
+	 */
+	template <typename T>
+	class ring_buffer final {
+	public:
+		/**
+		 * Throws std::invalid_argument if capacity is zero.
+		 */
+		explicit ring_buffer(std::size_t capacity) : capacity_(capacity) {
+			if (capacity_ == 0) {
+				throw std::invalid_argument("ring_buffer capacity cannot be zero");
+			}
+			storage_.reserve(capacity_);
+		}
+
+		void push(const T& value) {
+			if (storage_.size() < capacity_) {
+				storage_.push_back(value);
+			} else {
+				storage_[head_] = value;
+			}
+			head_ = (head_ + 1) % capacity_;
+		}
+
+		/**
+		 * Element i counting from the oldest one, i must be below size().
+		 */
+		const T& operator[](std::size_t i) const noexcept {
+			if (storage_.size() < capacity_) {
+				return storage_[i];
+			}
+			return storage_[(head_ + i) % capacity_];
+		}
+		/**
+		 * Most recently pushed element, the buffer must not be empty.
+		 */
+		const T& back() const noexcept {
+			return storage_[(head_ + capacity_ - 1) % capacity_];
+		}
+
+		std::size_t size() const noexcept {
+			return storage_.size();
+		}
+		std::size_t capacity() const noexcept {
+			return capacity_;
+		}
+		bool empty() const noexcept {
+			return storage_.empty();
+		}
+		bool full() const noexcept {
+			return storage_.size() == capacity_;
+		}
+		/**
+		 * Drops all elements, keeping the storage.
+		 */
+		void clear() noexcept {
+			storage_.clear();
+			head_ = 0;
+		}
+
+	private:
+		const std::size_t capacity_;
+		std::vector<T> storage_;
+		std::size_t head_ = 0;
+	};
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
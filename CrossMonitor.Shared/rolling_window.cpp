@@ -0,0 +1,114 @@
+#include "rolling_window.hpp"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+static size_t checked_length(size_t length) {
+	if (length == 0) {
+		throw invalid_argument("rolling_window length cannot be zero");
+	}
+	return length;
+}
+
+rolling_window::rolling_window(size_t length) :
+	length_(checked_length(length)),
+	values_(length),
+	min_queue_(length),
+	max_queue_(length) {
+}
+
+void rolling_window::push(double value) noexcept {
+	const size_t position = pushed_;
+
+	if (size_ == length_) {
+		const size_t oldest = position - length_;
+		if (min_queue_.front() == oldest) {
+			min_queue_.pop_front();
+		}
+		if (max_queue_.front() == oldest) {
+			max_queue_.pop_front();
+		}
+		// Welford backwards for the value leaving the window
+		if (size_ == 1) {
+			mean_ = 0;
+			m2_ = 0;
+		} else {
+			const double old = value_at(oldest);
+			const double delta = old - mean_;
+			mean_ -= delta / (size_ - 1);
+			m2_ -= delta * (old - mean_);
+		}
+		--size_;
+	}
+
+	values_[position % length_] = value;
+	++pushed_;
+	++size_;
+	const double delta = value - mean_;
+	mean_ += delta / size_;
+	m2_ += delta * (value - mean_);
+
+	while (!min_queue_.empty() && value_at(min_queue_.back()) >= value) {
+		min_queue_.pop_back();
+	}
+	min_queue_.push_back(position);
+	while (!max_queue_.empty() && value_at(max_queue_.back()) <= value) {
+		max_queue_.pop_back();
+	}
+	max_queue_.push_back(position);
+
+	// Removing values lets rounding errors build up; starting over from
+	// the stored values once per window keeps the cost O(1) amortized.
+	if (pushed_ % length_ == 0) {
+		recompute();
+	}
+}
+
+void rolling_window::recompute() noexcept {
+	double mean = 0;
+	double m2 = 0;
+	size_t n = 0;
+	for (size_t position = pushed_ - size_; position != pushed_; ++position) {
+		const double value = value_at(position);
+		++n;
+		const double delta = value - mean;
+		mean += delta / n;
+		m2 += delta * (value - mean);
+	}
+	mean_ = mean;
+	m2_ = m2;
+}
+
+void rolling_window::clear() noexcept {
+	min_queue_.clear();
+	max_queue_.clear();
+	pushed_ = 0;
+	size_ = 0;
+	mean_ = 0;
+	m2_ = 0;
+}
+
+double rolling_window::variance() const noexcept {
+	// Rounding leaves a residue when every value is the same
+	if (size_ < 2 || m2_ <= 0 || min() == max()) {
+		return 0;
+	}
+	return m2_ / size_;
+}
+
+double rolling_window::min() const noexcept {
+	return min_queue_.empty() ? 0 : value_at(min_queue_.front());
+}
+
+double rolling_window::max() const noexcept {
+	return max_queue_.empty() ? 0 : value_at(max_queue_.front());
+}
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * Mean, variance, min and max of the last length values pushed, updated
+	 * in O(1) per value: Welford's recurrence, run forwards for the new
+	 * value and backwards for the one leaving the window, and monotonic
+	 * deques of candidate minimums and maximums.
+	 * Storage is allocated once at construction, so push() never
+	 * allocates. Meant to be owned by a single thread, which needs no
+	 * locking.
+	 */
+	class rolling_window final {
+	public:
+		/**
+		 * Throws std::invalid_argument if length is zero.
+		 */
+		explicit rolling_window(std::size_t length);
+
+		void push(double value) noexcept;
+		/**
+		 * Drops all values, keeping the storage.
+		 */
+		void clear() noexcept;
+
+		/**
+		 * Values in the window, up to length().
+		 */
+		std::size_t size() const noexcept {
+			return size_;
+		}
+		std::size_t length() const noexcept {
+			return length_;
+		}
+		bool empty() const noexcept {
+			return size_ == 0;
+		}
+
+		/**
+		 * The statistics below are 0 when the window is empty.
+		 */
+		double mean() const noexcept {
+			return mean_;
+		}
+		/**
+		 * Population variance of the values in the window.
+		 */
+		double variance() const noexcept;
+		double min() const noexcept;
+		double max() const noexcept;
+
+	private:
+		/**
+		 * Fixed capacity deque of positions whose values are monotonic,
+		 * positions counting every value ever pushed.
+		 */
+		class monotonic_queue final {
+		public:
+			explicit monotonic_queue(std::size_t capacity) :
+				slots_(capacity) {
+			}
+
+			bool empty() const noexcept {
+				return head_ == tail_;
+			}
+			std::size_t front() const noexcept {
+				return slots_[head_ % slots_.size()];
+			}
+			std::size_t back() const noexcept {
+				return slots_[(tail_ - 1) % slots_.size()];
+			}
+			void pop_front() noexcept {
+				++head_;
+			}
+			void pop_back() noexcept {
+				--tail_;
+			}
+			void push_back(std::size_t position) noexcept {
+				slots_[tail_++ % slots_.size()] = position;
+			}
+			void clear() noexcept {
+				head_ = tail_ = 0;
+			}
+
+		private:
+			std::vector<std::size_t> slots_;
+			std::size_t head_ = 0;
+			std::size_t tail_ = 0;
+		};
+
+		double value_at(std::size_t position) const noexcept {
+			return values_[position % length_];
+		}
+		void recompute() noexcept;
+
+		const std::size_t length_;
+		std::vector<double> values_;
+		monotonic_queue min_queue_;
+		monotonic_queue max_queue_;
+		std::size_t pushed_ = 0;
+		std::size_t size_ = 0;
+		double mean_ = 0;
+		double m2_ = 0;
+	}; //class rolling_window
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
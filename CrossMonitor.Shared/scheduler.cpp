@@ -0,0 +1,95 @@
+#include "scheduler.hpp"
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+deadline_scheduler::deadline_scheduler(const chrono::milliseconds& period) :
+	period_(period) {
+	if (period_ <= chrono::milliseconds::zero()) {
+		throw invalid_argument("deadline_scheduler period must be positive");
+	}
+	next_ = aligned_deadline();
+}
+
+chrono::steady_clock::time_point
+deadline_scheduler::aligned_deadline() const noexcept {
+	const auto steady_now = chrono::steady_clock::now();
+	const auto wall_now = chrono::system_clock::now().time_since_epoch();
+	const auto phase = chrono::duration_cast<chrono::steady_clock::duration>(
+		wall_now % chrono::duration_cast<chrono::system_clock::duration>(period_));
+	return steady_now + period_ - phase;
+}
+
+interruptible_sleep_result deadline_scheduler::wait_next() noexcept {
+	unique_lock<mutex> lock(m_);
+
+	const auto now = chrono::steady_clock::now();
+	if (now > next_) {
+		// Skip deadlines that already passed instead of sliding the grid.
+		const auto late = now - next_;
+		const auto skipped = late / period_ + 1;
+		missed_ += static_cast<unsigned long long>(skipped);
+		next_ += skipped * period_;
+	}
+
+	if (cv_.wait_until(lock, next_, [this] { return stopped_; })) {
+		return interruptible_sleep_result::interrupted;
+	}
+
+	last_ = next_;
+	next_ += period_;
+	return interruptible_sleep_result::timeout;
+}
+
+void deadline_scheduler::stop() noexcept {
+	{
+		const lock_guard<mutex> lock(m_);
+		stopped_ = true;
+	}
+	cv_.notify_all();
+}
+
+void deadline_scheduler::reset() noexcept {
+	const lock_guard<mutex> lock(m_);
+	stopped_ = false;
+	next_ = aligned_deadline();
+}
+
+void deadline_scheduler::set_period(const chrono::milliseconds& period) {
+	if (period <= chrono::milliseconds::zero()) {
+		throw invalid_argument("deadline_scheduler period must be positive");
+	}
+	const lock_guard<mutex> lock(m_);
+	const auto now = chrono::steady_clock::now();
+	next_ += period - period_;
+	if (next_ < now) {
+		// Shrinking the period must not count as missing deadlines.
+		next_ = now;
+	}
+	period_ = period;
+}
+
+chrono::milliseconds deadline_scheduler::period() const noexcept {
+	const lock_guard<mutex> lock(m_);
+	return period_;
+}
+
+unsigned long long deadline_scheduler::missed_deadlines() const noexcept {
+	const lock_guard<mutex> lock(m_);
+	return missed_;
+}
+
+chrono::steady_clock::time_point
+deadline_scheduler::last_deadline() const noexcept {
+	const lock_guard<mutex> lock(m_);
+	return last_;
+}
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "utils.hpp"
+
+#include <boost/noncopyable.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * Periodic scheduler sleeping until absolute steady_clock deadlines,
+	 * so the time spent between waits does not make the period drift.
+	 * Deadlines are aligned to multiples of the period on the system clock,
+	 * so hosts with synchronized clocks tick at the same instants.
+	 * Deadlines that already passed when wait_next() is called are skipped
+	 * and counted instead of being run back to back.
+	 * stop() wakes a blocked wait_next() immediately and may be called
+	 * from any thread.
+	 */
+	class deadline_scheduler final : public boost::noncopyable {
+	public:
+		/**
+		 * May throw std::invalid_argument if period is not positive.
+		 * @param period time between deadlines.
+		 */
+		explicit deadline_scheduler(const std::chrono::milliseconds& period);
+
+		/**
+		 * Blocks until the next deadline or until stop() is called.
+		 * Returns immediately with interrupted if stop() was called before.
+		 */
+		interruptible_sleep_result wait_next() noexcept;
+		/**
+		 * Wakes the waiting thread; every following wait_next() returns
+		 * interrupted until reset() is called.
+		 */
+		void stop() noexcept;
+		/**
+		 * Clears a previous stop() and realigns the next deadline.
+		 */
+		void reset() noexcept;
+
+		/**
+		 * Changes the period, taking effect from the next deadline.
+		 * May throw std::invalid_argument if period is not positive.
+		 */
+		void set_period(const std::chrono::milliseconds& period);
+		std::chrono::milliseconds period() const noexcept;
+
+		/**
+		 * Number of deadlines skipped because they had already passed
+		 * when wait_next() was called, since construction.
+		 */
+		unsigned long long missed_deadlines() const noexcept;
+		/**
+		 * The deadline the last wait_next() woke up for.
+		 */
+		std::chrono::steady_clock::time_point last_deadline() const noexcept;
+
+	private:
+		std::chrono::steady_clock::time_point aligned_deadline() const noexcept;
+
+		mutable std::mutex m_;
+		std::condition_variable cv_;
+		std::chrono::milliseconds period_;
+		std::chrono::steady_clock::time_point next_;
+		std::chrono::steady_clock::time_point last_;
+		unsigned long long missed_ = 0;
+		bool stopped_ = false;
+	};
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
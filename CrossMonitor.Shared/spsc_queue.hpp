@@ -0,0 +1,142 @@
+#pragma once
+
+#include <boost/noncopyable.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+namespace crossover {
+namespace monitor {
+namespace utils {
+
+	/**
+	 * Bounded lock-free queue for exactly one producer thread and one
+	 * consumer thread. Storage is allocated once at construction.
+	 * Pushing into a full queue drops the new element and counts it, so
+	 * the producer never waits for the consumer.
+	 * Indices grow forever and are masked into the storage, which is why
+	 * the capacity is rounded up to a power of two.
+	 */
+	template <typename T>
+	class spsc_queue final : public boost::noncopyable {
+	public:
+		/**
+		 * Throws std::invalid_argument if capacity is zero.
+		 * @param capacity minimum number of queued elements, rounded up
+		 *                 to a power of two.
+		 */
+		explicit spsc_queue(std::size_t capacity) :
+			mask_(round_up(capacity) - 1),
+			slots_(new slot[mask_ + 1]) {
+		}
+
+		~spsc_queue() {
+			consume_all([](const T&) {});
+		}
+
+		/**
+		 * Producer side. Copies value into the queue.
+		 * @return false if the queue was full and value was dropped.
+		 */
+		bool try_push(const T& value) {
+			const std::size_t tail = tail_.load(std::memory_order_relaxed);
+			if (tail - head_cache_ > mask_) {
+				head_cache_ = head_.load(std::memory_order_acquire);
+				if (tail - head_cache_ > mask_) {
+					dropped_.store(dropped_.load(std::memory_order_relaxed) + 1,
+								   std::memory_order_relaxed);
+					return false;
+				}
+			}
+			new (&slots_[tail & mask_]) T(value);
+			tail_.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		/**
+		 * Consumer side. Calls f(const T&) on every queued element, oldest
+		 * first, and removes them.
+		 * @return the number of elements consumed.
+		 */
+		template <typename F>
+		std::size_t consume_all(F&& f) {
+			const std::size_t head = head_.load(std::memory_order_relaxed);
+			const std::size_t tail = tail_.load(std::memory_order_acquire);
+			std::size_t i = head;
+			// Releases the consumed slots even if f throws.
+			struct release final {
+				std::atomic<std::size_t>& head;
+				std::size_t& i;
+				~release() {
+					head.store(i, std::memory_order_release);
+				}
+			} guard{ head_, i };
+			while (i != tail) {
+				T& value = *reinterpret_cast<T*>(&slots_[i & mask_]);
+				++i;
+				// Destroys the element even if f throws.
+				struct destroy final {
+					T& value;
+					~destroy() {
+						value.~T();
+					}
+				} d{ value };
+				f(static_cast<const T&>(value));
+			}
+			return i - head;
+		}
+
+		/**
+		 * Consumer side. Approximate when called from the producer.
+		 */
+		bool empty() const noexcept {
+			return head_.load(std::memory_order_acquire) ==
+				tail_.load(std::memory_order_acquire);
+		}
+		std::size_t capacity() const noexcept {
+			return mask_ + 1;
+		}
+		/**
+		 * Elements dropped because the queue was full, since construction.
+		 * May be read from any thread.
+		 */
+		unsigned long long dropped() const noexcept {
+			return dropped_.load(std::memory_order_relaxed);
+		}
+
+	private:
+		typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot;
+		static const std::size_t cache_line = 64;
+
+		static std::size_t round_up(std::size_t capacity) {
+			if (capacity == 0) {
+				throw std::invalid_argument("spsc_queue capacity cannot be zero");
+			}
+			std::size_t result = 1;
+			while (result < capacity) {
+				result <<= 1;
+			}
+			return result;
+		}
+
+		const std::size_t mask_;
+		const std::unique_ptr<slot[]> slots_;
+
+		// Producer and consumer indices live on separate cache lines so
+		// the two threads do not keep stealing each other's line.
+		char pad0_[cache_line];
+		std::atomic<std::size_t> tail_{ 0 };
+		std::size_t head_cache_ = 0;
+		std::atomic<unsigned long long> dropped_{ 0 };
+		char pad1_[cache_line];
+		std::atomic<std::size_t> head_{ 0 };
+		char pad2_[cache_line];
+	}; //class spsc_queue
+
+} //namespace utils
+} //namespace monitor
+} //namespace crossover
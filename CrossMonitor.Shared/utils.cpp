@@ -1,5 +1,6 @@
 #include "utils.hpp"
 
+#include <algorithm>
 #include <thread>
 
 using namespace std;
@@ -12,16 +13,18 @@ interruptible_sleep_result
 interruptible_sleep(const std::chrono::milliseconds& time,
 					const std::chrono::milliseconds& check_period,
 					const std::atomic<bool>& interrupt) noexcept {
-	chrono::milliseconds elapsed(0);
-	bool sleeping = false;
-	
-	while ((sleeping = elapsed < time) && !interrupt.load()) {
-		this_thread::sleep_for(check_period);
-		elapsed += check_period;
+	const auto deadline = chrono::steady_clock::now() + time;
+
+	while (!interrupt.load()) {
+		const auto now = chrono::steady_clock::now();
+		if (now >= deadline) {
+			return interruptible_sleep_result::timeout;
+		}
+		this_thread::sleep_for(min<chrono::steady_clock::duration>(
+			check_period, deadline - now));
 	}
 
-	return sleeping ? interruptible_sleep_result::interrupted : 
-					  interruptible_sleep_result::timeout;
+	return interruptible_sleep_result::interrupted;
 }
 
 } //namespace utils
@@ -27,6 +27,8 @@ namespace utils {
 	/**
 	 * Sleep for a certain amount of time while periodically
 	 * checking a variable to interrupt the sleep.
+	 * Prefer deadline_scheduler (scheduler.hpp) for periodic work, it does
+	 * not poll and does not drift.
 	 * @param time Max time to wait before returning with a timeout value.
 	 * @param check_period Amount of time between interrupt checks.
 	 *					   The thread is asleep between checks.
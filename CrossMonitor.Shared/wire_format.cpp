@@ -0,0 +1,290 @@
+#include "wire_format.hpp"
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace std;
+
+namespace crossover {
+namespace monitor {
+
+static const size_t header_size = 6;
+
+/**
+ * Flag of a delta frame in the frame flags.
+ */
+static const uint64_t delta_flag = 1;
+/**
+ * Flag of a frame followed by its stale probes mask.
+ */
+static const uint64_t stale_flag = 2;
+
+static const unsigned all_fields = (1u << data_fields::size) - 1;
+
+static uint64_t zigzag(uint64_t v) noexcept {
+	return (v << 1) ^ (0 - (v >> 63));
+}
+
+static uint64_t unzigzag(uint64_t v) noexcept {
+	return (v >> 1) ^ (0 - (v & 1));
+}
+
+uint32_t wire_schema_id() noexcept {
+	static const uint32_t id = [] {
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		const auto add = [&hash](unsigned char c) {
+			hash = (hash ^ c) * 16777619u;
+		};
+		for_each_field(data_fields{}, [&](auto field) {
+			typedef decltype(field) F;
+			for (const char* c = F::name(); *c != '\0'; ++c) {
+				add(static_cast<unsigned char>(*c));
+			}
+			add(0);
+			add(static_cast<unsigned char>(sizeof(typename F::type)));
+			add(std::is_floating_point<typename F::type>::value ? 1 : 0);
+			add(F::counter ? 1 : 0);
+		});
+		return hash;
+	}();
+	return id;
+}
+
+static void put_varint(vector<unsigned char>& out, uint64_t v) {
+	while (v >= 0x80) {
+		out.push_back(static_cast<unsigned char>(v | 0x80));
+		v >>= 7;
+	}
+	out.push_back(static_cast<unsigned char>(v));
+}
+
+static void put_fixed32(vector<unsigned char>& out, uint32_t v) {
+	const unsigned char bytes[] = {
+		static_cast<unsigned char>(v),
+		static_cast<unsigned char>(v >> 8),
+		static_cast<unsigned char>(v >> 16),
+		static_cast<unsigned char>(v >> 24)
+	};
+	out.insert(out.end(), bytes, bytes + sizeof(bytes));
+}
+
+static void put_value(vector<unsigned char>& out, float v) {
+	uint32_t bits;
+	static_assert(sizeof(bits) == sizeof(v), "float is not 32 bits");
+	memcpy(&bits, &v, sizeof(bits));
+	put_fixed32(out, bits);
+}
+
+static void put_value(vector<unsigned char>& out, unsigned v) {
+	put_varint(out, v);
+}
+
+static void put_value(vector<unsigned char>& out, unsigned long long v) {
+	put_varint(out, v);
+}
+
+static uint64_t get_varint(const unsigned char*& p, const unsigned char* end) {
+	uint64_t v = 0;
+	for (unsigned shift = 0; shift < 64; shift += 7) {
+		if (p == end) {
+			throw invalid_argument("Truncated varint");
+		}
+		const unsigned char byte = *p++;
+		if (shift == 63 && byte > 1) {
+			throw invalid_argument("Varint too large");
+		}
+		v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return v;
+		}
+	}
+	throw invalid_argument("Varint too long");
+}
+
+static uint32_t get_fixed32(const unsigned char*& p, const unsigned char* end) {
+	if (end - p < 4) {
+		throw invalid_argument("Truncated value");
+	}
+	const uint32_t v = static_cast<uint32_t>(p[0]) |
+		static_cast<uint32_t>(p[1]) << 8 |
+		static_cast<uint32_t>(p[2]) << 16 |
+		static_cast<uint32_t>(p[3]) << 24;
+	p += 4;
+	return v;
+}
+
+static unsigned get_unsigned(const unsigned char*& p, const unsigned char* end) {
+	const uint64_t v = get_varint(p, end);
+	if (v > UINT_MAX) {
+		throw invalid_argument("Value out of range");
+	}
+	return static_cast<unsigned>(v);
+}
+
+static void get_value(const unsigned char*& p, const unsigned char* end,
+					  float& v) {
+	const uint32_t bits = get_fixed32(p, end);
+	memcpy(&v, &bits, sizeof(v));
+}
+
+static void get_value(const unsigned char*& p, const unsigned char* end,
+					  unsigned& v) {
+	v = get_unsigned(p, end);
+}
+
+static void get_value(const unsigned char*& p, const unsigned char* end,
+					  unsigned long long& v) {
+	v = get_varint(p, end);
+}
+
+binary_writer::binary_writer() {
+	buffer_.reserve(512);
+}
+
+void binary_writer::begin(wire_kind kind) {
+	buffer_.clear();
+	buffer_.push_back(wire_version);
+	put_fixed32(buffer_, wire_schema_id());
+	buffer_.push_back(static_cast<unsigned char>(kind));
+	timestamp_ = 0;
+	first_ = true;
+}
+
+void binary_writer::write(const data& d) {
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		put_value(buffer_, F::get(d));
+	});
+}
+
+void binary_writer::write(const record& r) {
+	put_varint(buffer_, r.stale != 0 ? stale_flag : 0);
+	put_varint(buffer_, first_ ? r.timestamp : zigzag(r.timestamp - timestamp_));
+	put_varint(buffer_, r.period_ms);
+	if (r.stale != 0) {
+		put_varint(buffer_, r.stale);
+	}
+	write(r.sample);
+	timestamp_ = r.timestamp;
+	first_ = false;
+}
+
+void binary_writer::write(const delta_frame& frame) {
+	put_varint(buffer_, (frame.keyframe ? 0 : delta_flag) |
+					   (frame.stale != 0 ? stale_flag : 0));
+	if (!frame.keyframe) {
+		put_varint(buffer_, frame.mask);
+	}
+	put_varint(buffer_, first_ ?
+		frame.timestamp : zigzag(frame.timestamp - timestamp_));
+	put_varint(buffer_, frame.period_ms);
+	if (frame.stale != 0) {
+		put_varint(buffer_, frame.stale);
+	}
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		const size_t index = field_index<F, data_fields>::value;
+		if (frame.keyframe || (frame.mask & (1u << index))) {
+			const typename F::type v = get<index>(frame.values);
+			if (F::counter && !frame.keyframe) {
+				put_varint(buffer_, zigzag(static_cast<uint64_t>(v)));
+			} else {
+				put_value(buffer_, v);
+			}
+		}
+	});
+	timestamp_ = frame.timestamp;
+	first_ = false;
+}
+
+binary_reader::binary_reader(const unsigned char* data, size_t size) :
+	position_(data), end_(data + size) {
+	if (size < header_size) {
+		throw invalid_argument("Truncated header");
+	}
+	if (position_[0] != wire_version) {
+		throw invalid_argument("Unsupported wire format version " +
+							   to_string(position_[0]));
+	}
+	++position_;
+	if (get_fixed32(position_, end_) != wire_schema_id()) {
+		throw invalid_argument("Unknown schema");
+	}
+	const unsigned char kind = *position_++;
+	if (kind > static_cast<unsigned char>(wire_kind::batch)) {
+		throw invalid_argument("Unknown document kind " + to_string(kind));
+	}
+	kind_ = static_cast<wire_kind>(kind);
+}
+
+data binary_reader::read_data() {
+	if (kind_ != wire_kind::data) {
+		throw invalid_argument("Not a data document");
+	}
+	data::values values;
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		get_value(position_, end_,
+				  get<field_index<F, data_fields>::value>(values));
+	});
+	if (position_ != end_) {
+		throw invalid_argument("Trailing bytes after data");
+	}
+	return data(values);
+}
+
+bool binary_reader::next(delta_frame& frame) {
+	if (kind_ != wire_kind::batch) {
+		throw invalid_argument("Not a batch document");
+	}
+	if (position_ == end_) {
+		return false;
+	}
+
+	const uint64_t flags = get_varint(position_, end_);
+	if ((flags & ~(delta_flag | stale_flag)) != 0) {
+		throw invalid_argument("Unknown frame flags");
+	}
+	frame.keyframe = (flags & delta_flag) == 0;
+	if (frame.keyframe) {
+		frame.mask = all_fields;
+	} else {
+		const uint64_t mask = get_varint(position_, end_);
+		if (mask > all_fields) {
+			throw invalid_argument("Unknown fields in frame mask");
+		}
+		frame.mask = static_cast<unsigned>(mask);
+	}
+	const uint64_t timestamp = get_varint(position_, end_);
+	frame.timestamp = first_ ? timestamp : timestamp_ + unzigzag(timestamp);
+	frame.period_ms = get_unsigned(position_, end_);
+	frame.stale = 0;
+	if (flags & stale_flag) {
+		frame.stale = get_unsigned(position_, end_);
+		if (frame.stale == 0) {
+			throw invalid_argument("Stale flag without stale probes");
+		}
+	}
+	for_each_field(data_fields{}, [&](auto field) {
+		typedef decltype(field) F;
+		const size_t index = field_index<F, data_fields>::value;
+		if (frame.mask & (1u << index)) {
+			typename F::type& v = get<index>(frame.values);
+			if (F::counter && !frame.keyframe) {
+				v = static_cast<typename F::type>(
+					unzigzag(get_varint(position_, end_)));
+			} else {
+				get_value(position_, end_, v);
+			}
+		}
+	});
+	timestamp_ = frame.timestamp;
+	first_ = false;
+	return true;
+}
+
+} //namespace monitor
+} //namespace crossover
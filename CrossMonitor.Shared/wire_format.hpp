@@ -0,0 +1,129 @@
+#pragma once
+
+#include "data.hpp"
+#include "delta_frame.hpp"
+#include "record.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace crossover {
+namespace monitor {
+
+/**
+ * Version of the binary wire format, first byte of every document.
+ */
+const unsigned char wire_version = 2;
+
+/**
+ * Content type of requests holding a binary batch.
+ */
+const char* const wire_content_type = "application/x-crossover-monitor";
+
+/**
+ * What a binary document holds.
+ */
+enum class wire_kind : unsigned char {
+	/**
+	 * The fields of a single data.
+	 */
+	data = 0,
+	/**
+	 * Records or delta frames, until the end of the document.
+	 */
+	batch = 1
+};
+
+/**
+ * Identifies data_fields: a hash of the name, size and kind of every
+ * field, so documents written with other fields are told apart.
+ */
+std::uint32_t wire_schema_id() noexcept;
+
+/**
+ * Writes the binary wire format, to a buffer reused between documents.
+ * A document starts with a 6 bytes header: the version, the schema id
+ * (4 bytes, little endian) and the kind. Fields follow in data_fields
+ * order: floats as 4 bytes little endian, integers as varints (7 bits a
+ * byte, least significant first, the high bit set on all but the last).
+ * Each frame of a batch is a varint of flags (1 for a delta frame, 2 when
+ * probes were stale), the field mask as a varint for delta frames, the
+ * timestamp, whole for the first frame and then as the zigzag coded change
+ * to the previous one, the period_ms, the stale probes mask when flagged
+ * and the fields of the frame, counter changes zigzag coded.
+ * A typical record takes 30 to 40 bytes, a delta frame a few.
+ */
+class binary_writer final {
+public:
+	binary_writer();
+
+	/**
+	 * Starts a new document, keeping the buffer capacity.
+	 */
+	void begin(wire_kind kind);
+	/**
+	 * Writes the fields of d, the body of a data document.
+	 */
+	void write(const data& d);
+	/**
+	 * Appends r to a batch, as a keyframe.
+	 */
+	void write(const record& r);
+	/**
+	 * Appends frame to a batch.
+	 */
+	void write(const delta_frame& frame);
+
+	const std::vector<unsigned char>& bytes() const noexcept {
+		return buffer_;
+	}
+	std::size_t size() const noexcept {
+		return buffer_.size();
+	}
+
+private:
+	std::vector<unsigned char> buffer_;
+	unsigned long long timestamp_ = 0;
+	bool first_ = true;
+};
+
+/**
+ * Reads a binary document in place: nothing is copied and the buffer must
+ * outlive the reader. Every read is bounds checked and every value range
+ * checked, so any input, truncated or corrupted, either decodes or throws
+ * std::invalid_argument.
+ */
+class binary_reader final {
+public:
+	/**
+	 * Throws std::invalid_argument unless the header is of this version
+	 * and schema.
+	 */
+	binary_reader(const unsigned char* data, std::size_t size);
+
+	wire_kind kind() const noexcept {
+		return kind_;
+	}
+	/**
+	 * Reads the data of a data document.
+	 * Throws std::invalid_argument if it is malformed or out of range.
+	 */
+	data read_data();
+	/**
+	 * Reads the next frame of a batch.
+	 * @return false at the end of the document.
+	 * Throws std::invalid_argument if it is malformed.
+	 */
+	bool next(delta_frame& frame);
+
+private:
+	const unsigned char* position_;
+	const unsigned char* const end_;
+	wire_kind kind_;
+	unsigned long long timestamp_ = 0;
+	bool first_ = true;
+};
+
+} //namespace monitor
+} //namespace crossover